@@ -2,8 +2,12 @@
 
 #include "Hydra/Core/Log.h"
 #include "Hydra/Core/json.h"
+#include "Hydra/Core/FileWatcher.h"
+#include "Hydra/Core/Timing.h"
+#include "Hydra/EngineContext.h"
 
 #include "Hydra/Render/Technique.h"
+#include "Hydra/Render/ShaderIncludeCache.h"
 
 #include "Hydra/Assets/Importers/TextureImporter.h"
 #include "Hydra/Core/Stream/FileStream.h"
@@ -53,12 +57,14 @@ Vector4 ToVec4(Json& json)
 	return Vector4(json["x"].get<float>(), json["y"].get<float>(), json["z"].get<float>(), json["w"].get<float>());
 }
 
-AssetManager::AssetManager(EngineContext* context) : _Context(context)
+AssetManager::AssetManager(EngineContext* context) : _Context(context), _ShaderWatcher(nullptr)
 {
 }
 
 AssetManager::~AssetManager()
 {
+	delete _ShaderWatcher;
+
 	for (HStaticMesh* mesh : _TemporalStaticMeshContainer)
 	{
 		OnMeshDeleted.Invoke(mesh);
@@ -101,6 +107,35 @@ NVRHI::TextureHandle AssetManager::GetTexture(const String & path)
 	return nullptr;
 }
 
+Json ReadJson(const File& file)
+{
+	std::ifstream i(file.GetPath());
+	if (!i.is_open())
+	{
+		return NULL;
+	}
+	Json json;
+	i >> json;
+	i.close();
+	return json;
+}
+
+// Import options of a model can be set in a json file next to it, named like the model with .meta appended
+static void ReadModelImportOptions(const String& path, ModelImportOptions& options)
+{
+	Json json = ReadJson(path + ".meta");
+
+	if (json.find("CombineMeshes") != json.end())
+	{
+		options.CombineMeshes = json["CombineMeshes"].get<bool>();
+	}
+
+	if (json.find("LODTriangleRatios") != json.end())
+	{
+		options.LODTriangleRatios = json["LODTriangleRatios"].get<List<float>>();
+	}
+}
+
 HStaticMesh* AssetManager::GetMesh(const String& path)
 {
 	auto iter = _TemportalStaticMeshMap.find(path);
@@ -113,31 +148,56 @@ HStaticMesh* AssetManager::GetMesh(const String& path)
 	FileStream stream = FileStream(path);
 	Blob* data = stream.Read();
 
+	if (data == nullptr)
+	{
+		LogError("AssetManager::GetMesh", path, "Could not read the file !");
+		return nullptr;
+	}
+
 	List<HAsset*> assets;
 
 	ModelImporter importer;
 
 	ModelImportOptions options;
 	options.CombineMeshes = true;
+	options.LODTriangleRatios = ASSET_MANAGER_DEFAULT_LOD_TRIANGLE_RATIOS;
+	options.CachePath = path;
 	options.Name = path;
 
-	if (importer.Import(*data, options, assets))
+	ReadModelImportOptions(path, options);
+
+	bool imported = importer.Import(*data, options, assets);
+
+	delete data;
+
+	if (!imported)
 	{
-		for (HAsset* asset : assets)
+		return nullptr;
+	}
+
+	for (size_t i = 0; i < assets.size(); i++)
+	{
+		HStaticMesh* mesh = assets[i]->SafeCast<HStaticMesh>();
+
+		if (mesh == nullptr)
 		{
-			HStaticMesh* mesh = asset->SafeCast<HStaticMesh>();
+			delete assets[i];
+			continue;
+		}
 
-			_TemporalStaticMeshContainer.push_back(mesh);
+		// Colliders are cooked next to the model, so only the first load after a change builds them
+		mesh->CreateComplexCollider(_Context->GetThreadPool(), path + "." + ToString((int)i) + ".bih");
 
-			OnMeshLoaded.Invoke(mesh);
+		_TemporalStaticMeshContainer.push_back(mesh);
 
-			_TemportalStaticMeshMap[path].push_back(mesh);
-		}
+		OnMeshLoaded.Invoke(mesh);
 
-		return assets[0]->SafeCast<HStaticMesh>();
+		_TemportalStaticMeshMap[path].push_back(mesh);
 	}
 
-	return nullptr;
+	iter = _TemportalStaticMeshMap.find(path);
+
+	return iter != _TemportalStaticMeshMap.end() ? iter->second[0] : nullptr;
 }
 
 List<HStaticMesh*> AssetManager::GetMeshParts(const String path)
@@ -193,19 +253,6 @@ void AssetManager::LoadProjectFiles()
 	}
 }
 
-Json ReadJson(const File& file)
-{
-	std::ifstream i(file.GetPath());
-	if (!i.is_open())
-	{
-		return NULL;
-	}
-	Json json;
-	i >> json;
-	i.close();
-	return json;
-}
-
 SharedPtr<Technique> AssetManager::LoadTechnique(const File& file)
 {
 	auto iter = _Techniques.find(file);
@@ -222,6 +269,81 @@ SharedPtr<Technique> AssetManager::LoadTechnique(const File& file)
 	return technique;
 }
 
+int AssetManager::ReloadShaderFile(const File& file)
+{
+	ShaderIncludeCache* includeCache = _Context->GetShaderIncludeCache();
+
+	if (includeCache != nullptr)
+	{
+		includeCache->Invalidate(file);
+	}
+
+	int reloaded = 0;
+
+	ITER(_Techniques, it)
+	{
+		if (it->second->DependsOn(file))
+		{
+			it->second->Reload();
+			reloaded++;
+		}
+	}
+
+	return reloaded;
+}
+
+void AssetManager::WatchShaderFiles(const File& folder)
+{
+	if (_ShaderWatcher == nullptr)
+	{
+		_ShaderWatcher = new FileWatcher();
+	}
+
+	if (_ShaderWatcher->Watch(folder))
+	{
+		Log("AssetManager::WatchShaderFiles", folder.GetPath(), "Watching for changes.");
+	}
+}
+
+void AssetManager::UpdateShaderFiles()
+{
+	if (_ShaderWatcher != nullptr)
+	{
+		List<File> changedFiles;
+		_ShaderWatcher->Poll(changedFiles);
+
+		double time = Time::getTime();
+
+		for (const File& file : changedFiles)
+		{
+			_ChangedShaderFiles[file.GetPath()] = time;
+		}
+
+		for (auto it = _ChangedShaderFiles.begin(); it != _ChangedShaderFiles.end();)
+		{
+			if (time - it->second < ASSET_MANAGER_SHADER_RELOAD_DELAY)
+			{
+				it++;
+				continue;
+			}
+
+			int reloaded = ReloadShaderFile(File(it->first));
+
+			if (reloaded > 0)
+			{
+				Log("AssetManager::UpdateShaderFiles", it->first, "Reloading " + ToString(reloaded) + " techniques.");
+			}
+
+			it = _ChangedShaderFiles.erase(it);
+		}
+	}
+
+	ITER(_Techniques, it)
+	{
+		it->second->UpdateReload();
+	}
+}
+
 void AssetManager::LoadMaterial(const File& file)
 {
 	auto iter = _Materials.find(file);
@@ -250,7 +372,7 @@ void AssetManager::LoadMaterial(const File& file)
 			std::string defineName = it.key();
 			bool defineValue = it->get<bool>();
 
-			//TODO: Defines
+			mat->SetDefine(defineName, defineValue ? "1" : "0");
 		}
 
 		for (auto it = json["Params"].begin(); it != json["Params"].end(); it++)
@@ -15,6 +15,16 @@
 class EngineContext;
 class Technique;
 class HStaticMesh;
+class FileWatcher;
+
+// Folder the techniques and the files they include are watched in
+#define ASSET_MANAGER_SHADER_FOLDER "Assets/Shaders"
+
+// Seconds a changed shader file has to stay untouched before it is reloaded, editors often write a file more than once
+#define ASSET_MANAGER_SHADER_RELOAD_DELAY 0.2
+
+// LODs of models without LODTriangleRatios in their .meta file, as triangle counts relative to LOD 0
+#define ASSET_MANAGER_DEFAULT_LOD_TRIANGLE_RATIOS { 0.5f, 0.25f, 0.125f }
 
 class HYDRA_API AssetManager
 {
@@ -27,6 +37,11 @@ private:
 
 	List<HStaticMesh*> _TemporalStaticMeshContainer;
 	Map<String, List<HStaticMesh*>> _TemportalStaticMeshMap;
+
+	FileWatcher* _ShaderWatcher;
+
+	// Time each changed shader file was last written at, by path
+	Map<String, double> _ChangedShaderFiles;
 public:
 	DelegateEvent<void, HStaticMesh*> OnMeshLoaded;
 	DelegateEvent<void, HStaticMesh*> OnMeshDeleted;
@@ -48,6 +63,17 @@ public:
 	List<HStaticMesh*> GetMeshParts(const String path);
 
 	// BLOCK end
+
+	// Starts reloading the techniques that are compiled from the shader file or include it, returns how many. They keep
+	// their old shaders until UpdateShaderFiles swaps the new ones in.
+	int ReloadShaderFile(const File& file);
+
+	// Reloads techniques when the files in the folder change
+	void WatchShaderFiles(const File& folder);
+
+	// Called once per frame before drawing, reloads the changed shader files and swaps in the techniques that finished
+	// compiling. Never waits for a compile.
+	void UpdateShaderFiles();
 private:
 
 	SharedPtr<Technique> LoadTechnique(const File& file); // TODO: These methods are only temporal, we need to create methods or importers that are compatible with compressed or hashed files.
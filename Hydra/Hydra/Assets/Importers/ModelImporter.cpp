@@ -62,8 +62,18 @@ bool ModelImporter::Import(Blob& dataBlob, const AssetImportOptions& options, Li
 
 	ProcessNode(scene, scene->mRootNode, embeddedTextures, String_None, *modelOptions, staticMeshes, materialSlotIndex);
 
-	for (HStaticMesh* mesh : staticMeshes)
+	for (size_t i = 0; i < staticMeshes.size(); i++)
 	{
+		HStaticMesh* mesh = staticMeshes[i];
+
+		if (modelOptions->LODTriangleRatios.size() > 0)
+		{
+			// Named after the mesh index like the colliders cached next to the model
+			mesh->GenerateLODs(modelOptions->LODTriangleRatios, modelOptions->CachePath.empty() ? String() : modelOptions->CachePath + "." + ToString((int)i) + ".lods");
+		}
+
+		mesh->UpdateBounds();
+
 		out_Assets.push_back(mesh);
 	}
 
@@ -253,9 +263,10 @@ void ModelImporter::ProcessMesh(aiMesh* mesh, aiNode* node, HStaticMesh* staticM
 
 	meshSection.MaxVertexIndex = meshResources.VertexData.size();
 	
-	int lastIndex = meshResources.LastIndex;
+	// Face indices are relative to this mesh, its vertices start after the ones of meshes combined before it
+	uint32 baseVertex = meshSection.MinVertexIndex;
 	
-	meshSection.FirstIndex = lastIndex;
+	meshSection.FirstIndex = meshResources.Indices.size();
 
 	for (std::uint32_t faceIdx = 0u; faceIdx < mesh->mNumFaces; faceIdx++)
 	{
@@ -263,7 +274,7 @@ void ModelImporter::ProcessMesh(aiMesh* mesh, aiNode* node, HStaticMesh* staticM
 		{
 			uint32 index = mesh->mFaces[faceIdx].mIndices[id];
 
-			uint32 newIndex = lastIndex + index;
+			uint32 newIndex = baseVertex + index;
 			
 			meshResources.Indices.push_back(newIndex);
 
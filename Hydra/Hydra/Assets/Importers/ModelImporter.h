@@ -19,6 +19,12 @@ class ModelImportOptions : public AssetImportOptions
 	HCLASS_GENERATED_BODY()
 public:
 	bool CombineMeshes;
+
+	// Triangle count of each generated LOD relative to LOD 0, empty imports only LOD 0
+	List<float> LODTriangleRatios;
+
+	// Generated LODs are cached in files next to this path, named after the mesh index. Empty generates them on every import.
+	String CachePath;
 };
 
 class ModelImporter : public IAssetImporter
@@ -0,0 +1,327 @@
+#include "Hydra/Core/FileWatcher.h"
+
+#include "Hydra/Core/Log.h"
+#include "Hydra/Core/Platform.h"
+
+#if defined(OPERATING_SYSTEM_LINUX)
+
+#include <sys/inotify.h>
+#include <dirent.h>
+#include <unistd.h>
+
+struct FFileWatcherPlatform
+{
+	int Descriptor;
+
+	// Directories by watch descriptor, inotify only watches the directory itself so every sub directory has one
+	Map<int, String> Directories;
+
+	alignas(inotify_event) char Buffer[FILE_WATCHER_BUFFER_SIZE];
+};
+
+static const uint32 WatchMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR;
+
+static void AddWatches(FFileWatcherPlatform& platform, const String& directory)
+{
+	int watch = inotify_add_watch(platform.Descriptor, directory.c_str(), WatchMask);
+
+	if (watch < 0)
+	{
+		LogError("FileWatcher::Watch", directory, "Could not watch the directory !");
+		return;
+	}
+
+	platform.Directories[watch] = directory;
+
+	DIR* dir = opendir(directory.c_str());
+
+	if (dir == nullptr)
+	{
+		return;
+	}
+
+	while (dirent* entry = readdir(dir))
+	{
+		String name = entry->d_name;
+
+		if (name == "." || name == "..")
+		{
+			continue;
+		}
+
+		String path = directory + "/" + name;
+
+		if (File(path).IsDirectory())
+		{
+			AddWatches(platform, path);
+		}
+	}
+
+	closedir(dir);
+}
+
+static FFileWatcherPlatform* StartWatching(const File& directory)
+{
+	FFileWatcherPlatform* platform = new FFileWatcherPlatform();
+	platform->Descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+	if (platform->Descriptor < 0)
+	{
+		delete platform;
+		return nullptr;
+	}
+
+	AddWatches(*platform, directory.GetPath());
+
+	if (platform->Directories.empty())
+	{
+		close(platform->Descriptor);
+		delete platform;
+		return nullptr;
+	}
+
+	return platform;
+}
+
+static void StopWatching(FFileWatcherPlatform* platform)
+{
+	// Closing the descriptor removes every watch
+	close(platform->Descriptor);
+	delete platform;
+}
+
+static void ReadChanges(FFileWatcherPlatform& platform, const File& directory, List<File>& outChanged)
+{
+	for (;;)
+	{
+		ssize_t length = read(platform.Descriptor, platform.Buffer, sizeof(platform.Buffer));
+
+		// Nothing left, the descriptor does not block
+		if (length <= 0)
+		{
+			break;
+		}
+
+		for (char* data = platform.Buffer; data < platform.Buffer + length; data += sizeof(inotify_event) + ((inotify_event*)data)->len)
+		{
+			const inotify_event* event = (const inotify_event*)data;
+
+			if (event->mask & IN_Q_OVERFLOW)
+			{
+				LogError("FileWatcher::Poll", directory.GetPath(), "Too many changes, some were lost !");
+				continue;
+			}
+
+			// The directory was deleted or moved away
+			if (event->mask & IN_IGNORED)
+			{
+				platform.Directories.erase(event->wd);
+				continue;
+			}
+
+			auto iter = platform.Directories.find(event->wd);
+
+			if (iter == platform.Directories.end() || event->len == 0)
+			{
+				continue;
+			}
+
+			String path = iter->second + "/" + event->name;
+
+			if (event->mask & IN_ISDIR)
+			{
+				if (event->mask & (IN_CREATE | IN_MOVED_TO))
+				{
+					AddWatches(platform, path);
+				}
+
+				continue;
+			}
+
+			// Files are reported once written and closed, not when they are created empty
+			if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+			{
+				outChanged.push_back(File(path));
+			}
+		}
+	}
+}
+
+#elif defined(OPERATING_SYSTEM_WINDOWS)
+
+#include <Windows.h>
+
+struct FFileWatcherPlatform
+{
+	HANDLE Directory;
+	OVERLAPPED Overlapped;
+
+	// ReadDirectoryChangesW needs a DWORD aligned buffer
+	DWORD Buffer[FILE_WATCHER_BUFFER_SIZE / sizeof(DWORD)];
+};
+
+static bool RequestChanges(FFileWatcherPlatform& platform)
+{
+	ResetEvent(platform.Overlapped.hEvent);
+
+	return ReadDirectoryChangesW(platform.Directory, platform.Buffer, sizeof(platform.Buffer), TRUE, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME, nullptr, &platform.Overlapped, nullptr) != 0;
+}
+
+static FFileWatcherPlatform* StartWatching(const File& directory)
+{
+	HANDLE handle = CreateFileA(directory.GetPath().c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+
+	if (handle == INVALID_HANDLE_VALUE)
+	{
+		return nullptr;
+	}
+
+	FFileWatcherPlatform* platform = new FFileWatcherPlatform();
+	platform->Directory = handle;
+	ZeroMemory(&platform->Overlapped, sizeof(OVERLAPPED));
+	platform->Overlapped.hEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+
+	if (!RequestChanges(*platform))
+	{
+		CloseHandle(platform->Overlapped.hEvent);
+		CloseHandle(handle);
+		delete platform;
+		return nullptr;
+	}
+
+	return platform;
+}
+
+static void StopWatching(FFileWatcherPlatform* platform)
+{
+	DWORD bytes = 0;
+
+	// The buffer is written until the pending read is cancelled
+	CancelIo(platform->Directory);
+	GetOverlappedResult(platform->Directory, &platform->Overlapped, &bytes, TRUE);
+
+	CloseHandle(platform->Overlapped.hEvent);
+	CloseHandle(platform->Directory);
+	delete platform;
+}
+
+static void ReadChanges(FFileWatcherPlatform& platform, const File& directory, List<File>& outChanged)
+{
+	DWORD bytes = 0;
+
+	while (GetOverlappedResult(platform.Directory, &platform.Overlapped, &bytes, FALSE))
+	{
+		if (bytes == 0)
+		{
+			LogError("FileWatcher::Poll", directory.GetPath(), "Too many changes, some were lost !");
+		}
+		else
+		{
+			const uint8* data = (const uint8*)platform.Buffer;
+
+			for (;;)
+			{
+				const FILE_NOTIFY_INFORMATION* info = (const FILE_NOTIFY_INFORMATION*)data;
+
+				if (info->Action == FILE_ACTION_MODIFIED || info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_RENAMED_NEW_NAME)
+				{
+					int wideLength = info->FileNameLength / sizeof(WCHAR);
+					int length = WideCharToMultiByte(CP_UTF8, 0, info->FileName, wideLength, nullptr, 0, nullptr, nullptr);
+
+					String name = String(length, '\0');
+					WideCharToMultiByte(CP_UTF8, 0, info->FileName, wideLength, &name[0], length, nullptr, nullptr);
+
+					File file = File(directory, name);
+
+					// Directories are modified when a file in them is
+					if (!file.IsDirectory())
+					{
+						outChanged.push_back(file);
+					}
+				}
+
+				if (info->NextEntryOffset == 0)
+				{
+					break;
+				}
+
+				data += info->NextEntryOffset;
+			}
+		}
+
+		if (!RequestChanges(platform))
+		{
+			LogError("FileWatcher::Poll", directory.GetPath(), "Could not watch the directory anymore !");
+			break;
+		}
+	}
+}
+
+#else
+
+struct FFileWatcherPlatform
+{
+};
+
+static FFileWatcherPlatform* StartWatching(const File& directory)
+{
+	return nullptr;
+}
+
+static void StopWatching(FFileWatcherPlatform* platform)
+{
+	delete platform;
+}
+
+static void ReadChanges(FFileWatcherPlatform& platform, const File& directory, List<File>& outChanged)
+{
+}
+
+#endif
+
+FileWatcher::FileWatcher() : _Platform(nullptr)
+{
+}
+
+FileWatcher::~FileWatcher()
+{
+	Stop();
+}
+
+bool FileWatcher::Watch(const File& directory)
+{
+	Stop();
+
+	_Directory = directory;
+	_Platform = StartWatching(directory);
+
+	if (_Platform == nullptr)
+	{
+		LogError("FileWatcher::Watch", directory.GetPath(), "Could not watch the directory !");
+		return false;
+	}
+
+	return true;
+}
+
+void FileWatcher::Stop()
+{
+	if (_Platform != nullptr)
+	{
+		StopWatching(_Platform);
+		_Platform = nullptr;
+	}
+}
+
+bool FileWatcher::IsWatching() const
+{
+	return _Platform != nullptr;
+}
+
+void FileWatcher::Poll(List<File>& outChanged)
+{
+	if (_Platform != nullptr)
+	{
+		ReadChanges(*_Platform, _Directory, outChanged);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Hydra/Core/Library.h"
+#include "Hydra/Core/Common.h"
+#include "Hydra/Core/Container.h"
+#include "Hydra/Core/File.h"
+
+struct FFileWatcherPlatform;
+
+// Size of the buffer the changes are read into, changes that do not fit before the next poll are lost
+#define FILE_WATCHER_BUFFER_SIZE (64 * 1024)
+
+// Reports files written, created or moved into a directory and its sub directories. Polled, so it never blocks and
+// needs no thread of its own. Uses inotify on Linux and ReadDirectoryChangesW on Windows, elsewhere nothing is watched.
+class HYDRA_API FileWatcher
+{
+private:
+	File _Directory;
+	FFileWatcherPlatform* _Platform;
+
+public:
+	FileWatcher();
+	~FileWatcher();
+
+	// Stops watching the previous directory, false when the directory can not be watched
+	bool Watch(const File& directory);
+	void Stop();
+
+	bool IsWatching() const;
+
+	// Adds the files that changed since the last poll, paths start with the watched directory. A file saved more than
+	// once is added every time.
+	void Poll(List<File>& outChanged);
+};
\ No newline at end of file
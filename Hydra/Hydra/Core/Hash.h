@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Hydra/Core/Common.h"
+
+// Start value of HashBytes and HashString
+#define HASH_SEED 14695981039346656037ull
+
+// FNV-1a, the same on every run and platform so the hashes can be saved. Chain calls by passing the last hash in.
+inline uint64 HashBytes(uint64 hash, const void* data, size_t size)
+{
+	const uint8* bytes = (const uint8*)data;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+inline uint64 HashString(uint64 hash, const String& value)
+{
+	// The terminator keeps "ab" + "c" apart from "a" + "bc"
+	return HashBytes(hash, value.c_str(), value.size() + 1);
+}
\ No newline at end of file
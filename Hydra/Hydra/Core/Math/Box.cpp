@@ -46,56 +46,101 @@ void Box::CheckMinMax(glm::vec3 & min, glm::vec3 & max, glm::vec3 & point)
 		max.z = point.z;
 	}
 }
-int Box::CollideWithRay(const Ray & ray, CollisionResults & results)
+int Box::CollideWithRay(const Ray & ray, CollisionResults & results) const
 {
 	glm::vec3 diff = ray.Origin - Origin;
 	glm::vec3 direction = ray.Direction;
 
-	_ClipTemp[0] = 0;
-	_ClipTemp[1] = FloatInf;
+	float clip[2];
+	clip[0] = 0;
+	clip[1] = FloatInf;
 
-	float saveT0 = _ClipTemp[0];
-	float saveT1 = _ClipTemp[1];
+	float saveT0 = clip[0];
+	float saveT1 = clip[1];
 
 	bool notEntirelyClipped =
-		Clip(+direction.x, -diff.x - Extent.x, _ClipTemp) &&
-		Clip(-direction.x, +diff.x - Extent.x, _ClipTemp) &&
+		Clip(+direction.x, -diff.x - Extent.x, clip) &&
+		Clip(-direction.x, +diff.x - Extent.x, clip) &&
 
-		Clip(+direction.y, -diff.y - Extent.y, _ClipTemp) &&
-		Clip(-direction.y, +diff.y - Extent.y, _ClipTemp) &&
+		Clip(+direction.y, -diff.y - Extent.y, clip) &&
+		Clip(-direction.y, +diff.y - Extent.y, clip) &&
 
-		Clip(+direction.z, -diff.z - Extent.z, _ClipTemp) &&
-		Clip(-direction.z, +diff.z - Extent.z, _ClipTemp);
-	if (notEntirelyClipped && (_ClipTemp[0] != saveT0 || _ClipTemp[1] != saveT1))
+		Clip(+direction.z, -diff.z - Extent.z, clip) &&
+		Clip(-direction.z, +diff.z - Extent.z, clip);
+	if (notEntirelyClipped && (clip[0] != saveT0 || clip[1] != saveT1))
 	{
-		if (_ClipTemp[1] > _ClipTemp[0])
+		if (clip[1] > clip[0])
 		{
-			glm::vec3 point0 = (ray.Direction * _ClipTemp[0]) + ray.Origin;
-			glm::vec3 point1 = (ray.Direction * _ClipTemp[1]) + ray.Origin;
+			glm::vec3 point0 = (ray.Direction * clip[0]) + ray.Origin;
+			glm::vec3 point1 = (ray.Direction * clip[1]) + ray.Origin;
 
 			CollisionResult result;
 			result.IsNull = false;
 			result.ContactPoint = point0;
-			result.Distance = _ClipTemp[0];
+			result.Distance = clip[0];
 			results.AddCollision(result);
 
 			CollisionResult result2;
 			result2.IsNull = false;
 			result2.ContactPoint = point1;
-			result2.Distance = _ClipTemp[1];
+			result2.Distance = clip[1];
 			results.AddCollision(result2);
 		}
-		glm::vec3 point = (ray.Direction * _ClipTemp[0]) + ray.Origin;
+		glm::vec3 point = (ray.Direction * clip[0]) + ray.Origin;
 		CollisionResult result;
 		result.IsNull = false;
 		result.ContactPoint = point;
-		result.Distance = _ClipTemp[0];
+		result.Distance = clip[0];
 		results.AddCollision(result);
 		return 1;
 	}
 	return 0;
 }
 
+bool Box::IntersectRay(const Ray& ray, float& tNear, float& tFar) const
+{
+	tNear = 0.0f;
+	tFar = FloatInf;
+
+	for (int a = 0; a < 3; a++)
+	{
+		float origin = ray.Origin[a] - Origin[a];
+		float direction = ray.Direction[a];
+		float extent = Extent[a];
+
+		if (direction == 0.0f)
+		{
+			if (origin < -extent || origin > extent)
+			{
+				return false;
+			}
+
+			continue;
+		}
+
+		float invDirection = 1.0f / direction;
+		float t0 = (-extent - origin) * invDirection;
+		float t1 = (extent - origin) * invDirection;
+
+		if (t0 > t1)
+		{
+			float tmp = t0;
+			t0 = t1;
+			t1 = tmp;
+		}
+
+		tNear = glm::max(tNear, t0);
+		tFar = glm::min(tFar, t1);
+
+		if (tNear > tFar)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
 Box Box::Transform(const glm::vec3 & location, const glm::vec3 & rotation, const glm::vec3 & scale)
 {
 	glm::vec3 center = Origin * scale;
@@ -127,6 +172,23 @@ Box Box::Transform(const glm::vec3 & location, const glm::vec3 & rotation, const
 	return Box(center, glm::abs(vect2));
 }
 
+Box Box::Transform(const Matrix4& matrix) const
+{
+	glm::vec3 center = matrix * glm::vec4(Origin, 1.0f);
+
+	glm::mat3 rot = glm::mat3(matrix);
+
+	for (int i = 0; i < 3; i++)
+	{
+		for (int a = 0; a < 3; a++)
+		{
+			rot[i][a] = glm::abs(rot[i][a]);
+		}
+	}
+
+	return Box(center, rot * Extent);
+}
+
 glm::vec3 Box::GetMin() const
 {
 	return Origin - Extent;
@@ -12,8 +12,6 @@
 
 class HYDRA_API Box
 {
-private:
-	float _ClipTemp[3];
 public:
 	Vector3 Origin;
 	Vector3 Extent;
@@ -26,10 +24,16 @@ public:
 
 	static void CheckMinMax(glm::vec3 &min, glm::vec3 &max, glm::vec3 &point);
 
-	int CollideWithRay(const Ray& ray, CollisionResults& results);
+	int CollideWithRay(const Ray& ray, CollisionResults& results) const;
+
+	// Clips the ray against the box without producing any results, tNear is clamped to the ray origin
+	bool IntersectRay(const Ray& ray, float& tNear, float& tFar) const;
 
 	Box Transform(const glm::vec3& location, const glm::vec3& rotation, const glm::vec3& scale);
 
+	// Axis aligned box around this box transformed by the matrix
+	Box Transform(const Matrix4& matrix) const;
+
 	glm::vec3 GetMin() const;
 	glm::vec3 GetMax() const;
 
@@ -51,5 +55,5 @@ public:
 	String Print();
 
 private:
-	bool Clip(float denom, float numer, float t[]);
+	static bool Clip(float denom, float numer, float t[]);
 };
\ No newline at end of file
@@ -0,0 +1,324 @@
+#include "Hydra/Core/Math/BoxBatch.h"
+#include "Hydra/Core/Math/Box.h"
+#include "Hydra/Core/Math/Frustum.h"
+#include "Hydra/Physics/Collisons/Ray.h"
+
+#include <cstring>
+#include <xmmintrin.h>
+
+// The operand order of the min and max calls below keeps the results of glm::min and glm::max on ties,
+// so even the sign of a zero distance matches Box::IntersectRay.
+
+// Number of set bits of every four lane mask
+static const int LaneHitCounts[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+BoxBatch::BoxBatch() : _Count(0)
+{
+}
+
+void BoxBatch::Clear()
+{
+	for (int a = 0; a < 3; a++)
+	{
+		_Origins[a].clear();
+		_Extents[a].clear();
+	}
+
+	_Count = 0;
+}
+
+void BoxBatch::Reserve(int count)
+{
+	int padded = (count + BOX_BATCH_LANES - 1) / BOX_BATCH_LANES * BOX_BATCH_LANES;
+
+	for (int a = 0; a < 3; a++)
+	{
+		_Origins[a].reserve(padded);
+		_Extents[a].reserve(padded);
+	}
+}
+
+int BoxBatch::Add(const Box& box)
+{
+	int index = _Count++;
+
+	if (index % BOX_BATCH_LANES == 0)
+	{
+		// Padding boxes are never reported, an empty box at the origin keeps their math finite
+		for (int a = 0; a < 3; a++)
+		{
+			_Origins[a].resize(index + BOX_BATCH_LANES, 0.0f);
+			_Extents[a].resize(index + BOX_BATCH_LANES, 0.0f);
+		}
+	}
+
+	Set(index, box);
+
+	return index;
+}
+
+void BoxBatch::Set(int index, const Box& box)
+{
+	assertCheck(index >= 0 && index < _Count);
+
+	for (int a = 0; a < 3; a++)
+	{
+		_Origins[a][index] = box.Origin[a];
+		_Extents[a][index] = box.Extent[a];
+	}
+}
+
+Box BoxBatch::Get(int index) const
+{
+	assertCheck(index >= 0 && index < _Count);
+
+	return Box(Vector3(_Origins[0][index], _Origins[1][index], _Origins[2][index]), Vector3(_Extents[0][index], _Extents[1][index], _Extents[2][index]));
+}
+
+int BoxBatch::Size() const
+{
+	return _Count;
+}
+
+int BoxBatch::GetMaskSize(int count)
+{
+	return (count + 31) / 32;
+}
+
+int BoxBatch::IntersectRay(const Ray& ray, uint32* outMask, float* outNear) const
+{
+	memset(outMask, 0, GetMaskSize(_Count) * sizeof(uint32));
+
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+
+	__m128 rayOrigins[3];
+	__m128 invDirections[3];
+	bool parallel[3];
+
+	for (int a = 0; a < 3; a++)
+	{
+		rayOrigins[a] = _mm_set1_ps(ray.Origin[a]);
+		parallel[a] = ray.Direction[a] == 0.0f;
+		invDirections[a] = _mm_set1_ps(1.0f / ray.Direction[a]);
+	}
+
+	int hits = 0;
+
+	for (int i = 0; i < _Count; i += BOX_BATCH_LANES)
+	{
+		__m128 tNear = _mm_setzero_ps();
+		__m128 tFar = _mm_set1_ps(ray.Limit);
+		__m128 outside = _mm_setzero_ps();
+
+		for (int a = 0; a < 3; a++)
+		{
+			__m128 origin = _mm_sub_ps(rayOrigins[a], _mm_loadu_ps(&_Origins[a][i]));
+			__m128 extent = _mm_loadu_ps(&_Extents[a][i]);
+			__m128 negExtent = _mm_xor_ps(extent, signMask);
+
+			// The ray never crosses the slab, it has to start inside
+			if (parallel[a])
+			{
+				outside = _mm_or_ps(outside, _mm_or_ps(_mm_cmplt_ps(origin, negExtent), _mm_cmpgt_ps(origin, extent)));
+				continue;
+			}
+
+			__m128 t0 = _mm_mul_ps(_mm_sub_ps(negExtent, origin), invDirections[a]);
+			__m128 t1 = _mm_mul_ps(_mm_sub_ps(extent, origin), invDirections[a]);
+
+			__m128 tEnter = _mm_min_ps(t1, t0);
+			__m128 tExit = _mm_max_ps(t0, t1);
+
+			tNear = _mm_max_ps(tNear, tEnter);
+			tFar = _mm_min_ps(tFar, tExit);
+		}
+
+		int mask = _mm_movemask_ps(_mm_andnot_ps(outside, _mm_cmple_ps(tNear, tFar)));
+
+		int valid = glm::min(_Count - i, BOX_BATCH_LANES);
+		mask &= (1 << valid) - 1;
+
+		if (outNear)
+		{
+			float nears[BOX_BATCH_LANES];
+			_mm_storeu_ps(nears, tNear);
+
+			for (int lane = 0; lane < valid; lane++)
+			{
+				outNear[i + lane] = nears[lane];
+			}
+		}
+
+		if (mask != 0)
+		{
+			outMask[i / 32] |= (uint32)mask << (i % 32);
+			hits += LaneHitCounts[mask];
+		}
+	}
+
+	return hits;
+}
+
+int BoxBatch::IntersectFrustum(const Frustum& frustum, uint32* outMask, int first, int count) const
+{
+	assertCheck(first % 32 == 0);
+
+	int end = count < 0 ? _Count : glm::min(first + count, _Count);
+
+	if (first >= end)
+	{
+		return 0;
+	}
+
+	memset(outMask + first / 32, 0, GetMaskSize(end - first) * sizeof(uint32));
+
+	__m128 normals[6][3];
+	__m128 absNormals[6][3];
+	__m128 distances[6];
+
+	for (int p = 0; p < 6; p++)
+	{
+		const Vector4& plane = frustum.Planes[p];
+
+		for (int a = 0; a < 3; a++)
+		{
+			normals[p][a] = _mm_set1_ps(plane[a]);
+			absNormals[p][a] = _mm_set1_ps(glm::abs(plane[a]));
+		}
+
+		distances[p] = _mm_set1_ps(plane.w);
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+
+	int inside = 0;
+
+	for (int i = first; i < end; i += BOX_BATCH_LANES)
+	{
+		__m128 origins[3];
+		__m128 extents[3];
+
+		for (int a = 0; a < 3; a++)
+		{
+			origins[a] = _mm_loadu_ps(&_Origins[a][i]);
+			extents[a] = _mm_loadu_ps(&_Extents[a][i]);
+		}
+
+		__m128 outside = zero;
+
+		// The corner furthest along the plane normal is the origin plus the extent projected on the normal
+		for (int p = 0; p < 6; p++)
+		{
+			__m128 distance = _mm_add_ps(distances[p], _mm_mul_ps(normals[p][0], origins[0]));
+			distance = _mm_add_ps(distance, _mm_mul_ps(normals[p][1], origins[1]));
+			distance = _mm_add_ps(distance, _mm_mul_ps(normals[p][2], origins[2]));
+
+			__m128 radius = _mm_mul_ps(absNormals[p][0], extents[0]);
+			radius = _mm_add_ps(radius, _mm_mul_ps(absNormals[p][1], extents[1]));
+			radius = _mm_add_ps(radius, _mm_mul_ps(absNormals[p][2], extents[2]));
+
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+		}
+
+		int mask = ~_mm_movemask_ps(outside) & 0xF;
+
+		int valid = glm::min(end - i, BOX_BATCH_LANES);
+		mask &= (1 << valid) - 1;
+
+		if (mask != 0)
+		{
+			outMask[i / 32] |= (uint32)mask << (i % 32);
+			inside += LaneHitCounts[mask];
+		}
+	}
+
+	return inside;
+}
+
+int BoxBatch::IntersectRays(const Box& box, const Ray* rays, int rayCount, uint32* outMask, float* outNear, float* outFar)
+{
+	memset(outMask, 0, GetMaskSize(rayCount) * sizeof(uint32));
+
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	const __m128 zero = _mm_setzero_ps();
+
+	__m128 boxOrigins[3];
+	__m128 extents[3];
+	__m128 negExtents[3];
+
+	for (int a = 0; a < 3; a++)
+	{
+		boxOrigins[a] = _mm_set1_ps(box.Origin[a]);
+		extents[a] = _mm_set1_ps(box.Extent[a]);
+		negExtents[a] = _mm_xor_ps(extents[a], signMask);
+	}
+
+	int hits = 0;
+
+	for (int i = 0; i < rayCount; i += BOX_BATCH_LANES)
+	{
+		int valid = glm::min(rayCount - i, BOX_BATCH_LANES);
+
+		// The last rays repeat to fill the register, only valid lanes are reported
+		const Ray* lanes[BOX_BATCH_LANES];
+		for (int lane = 0; lane < BOX_BATCH_LANES; lane++)
+		{
+			lanes[lane] = &rays[i + glm::min(lane, valid - 1)];
+		}
+
+		__m128 tNear = zero;
+		__m128 tFar = _mm_setr_ps(lanes[0]->Limit, lanes[1]->Limit, lanes[2]->Limit, lanes[3]->Limit);
+		__m128 outside = zero;
+
+		for (int a = 0; a < 3; a++)
+		{
+			__m128 rayOrigin = _mm_setr_ps(lanes[0]->Origin[a], lanes[1]->Origin[a], lanes[2]->Origin[a], lanes[3]->Origin[a]);
+			__m128 direction = _mm_setr_ps(lanes[0]->Direction[a], lanes[1]->Direction[a], lanes[2]->Direction[a], lanes[3]->Direction[a]);
+
+			__m128 origin = _mm_sub_ps(rayOrigin, boxOrigins[a]);
+			__m128 parallel = _mm_cmpeq_ps(direction, zero);
+			__m128 invDirection = _mm_div_ps(_mm_set1_ps(1.0f), direction);
+
+			__m128 t0 = _mm_mul_ps(_mm_sub_ps(negExtents[a], origin), invDirection);
+			__m128 t1 = _mm_mul_ps(_mm_sub_ps(extents[a], origin), invDirection);
+
+			__m128 tEnter = _mm_min_ps(t1, t0);
+			__m128 tExit = _mm_max_ps(t0, t1);
+
+			// Rays parallel to the slab keep their interval and have to start inside it
+			tNear = _mm_or_ps(_mm_and_ps(parallel, tNear), _mm_andnot_ps(parallel, _mm_max_ps(tNear, tEnter)));
+			tFar = _mm_or_ps(_mm_and_ps(parallel, tFar), _mm_andnot_ps(parallel, _mm_min_ps(tFar, tExit)));
+
+			__m128 outsideSlab = _mm_or_ps(_mm_cmplt_ps(origin, negExtents[a]), _mm_cmpgt_ps(origin, extents[a]));
+			outside = _mm_or_ps(outside, _mm_and_ps(parallel, outsideSlab));
+		}
+
+		int mask = _mm_movemask_ps(_mm_andnot_ps(outside, _mm_cmple_ps(tNear, tFar)));
+		mask &= (1 << valid) - 1;
+
+		float nears[BOX_BATCH_LANES];
+		float fars[BOX_BATCH_LANES];
+		_mm_storeu_ps(nears, tNear);
+		_mm_storeu_ps(fars, tFar);
+
+		for (int lane = 0; lane < valid; lane++)
+		{
+			if (outNear)
+			{
+				outNear[i + lane] = nears[lane];
+			}
+			if (outFar)
+			{
+				outFar[i + lane] = fars[lane];
+			}
+		}
+
+		if (mask != 0)
+		{
+			outMask[i / 32] |= (uint32)mask << (i % 32);
+			hits += LaneHitCounts[mask];
+		}
+	}
+
+	return hits;
+}
\ No newline at end of file
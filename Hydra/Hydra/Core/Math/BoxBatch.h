@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Hydra/Core/Library.h"
+#include "Hydra/Core/Common.h"
+#include "Hydra/Core/Vector.h"
+
+class Box;
+class Ray;
+class Frustum;
+
+// Boxes per SSE register
+constexpr int BOX_BATCH_LANES = 4;
+
+// Boxes stored as separate origin and extent arrays, padded to whole SSE registers, so one ray is clipped
+// against four boxes at a time. The math is the same as Box::IntersectRay, hits and distances match it exactly.
+class HYDRA_API BoxBatch
+{
+private:
+	List<float> _Origins[3];
+	List<float> _Extents[3];
+	int _Count;
+public:
+	BoxBatch();
+
+	void Clear();
+	void Reserve(int count);
+
+	// Returns the index of the box
+	int Add(const Box& box);
+	void Set(int index, const Box& box);
+	Box Get(int index) const;
+
+	int Size() const;
+
+	// Number of uint32 words a hit mask needs for count boxes or rays
+	static int GetMaskSize(int count);
+
+	// Clips the ray against every box, up to the ray limit. Bit i of outMask is set when box i is hit.
+	// outMask needs GetMaskSize(Size()) words, outNear, if not null, Size() floats. Returns the number of hit boxes.
+	int IntersectRay(const Ray& ray, uint32* outMask, float* outNear = nullptr) const;
+
+	// Clips every ray against the box, up to its own limit, four rays at a time. Bit i of outMask is set when ray i hits.
+	// outNear and outFar may be null. Returns the number of rays that hit.
+	static int IntersectRays(const Box& box, const Ray* rays, int rayCount, uint32* outMask, float* outNear = nullptr, float* outFar = nullptr);
+
+	// Sets bit i of outMask when box i is at least partially inside the frustum, the same test as Frustum::IntersectsBox.
+	// Only the count boxes from first on are tested, first has to start a mask word so threads can split the boxes
+	// into whole words. A count below zero tests the rest. Returns the number of boxes inside.
+	int IntersectFrustum(const Frustum& frustum, uint32* outMask, int first = 0, int count = -1) const;
+};
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include "Hydra/Core/Math/Frustum.h"
+#include "Hydra/Core/Math/Box.h"
+
+Frustum::Frustum()
+{
+	for (int i = 0; i < 6; i++)
+	{
+		Planes[i] = Vector4(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+}
+
+Frustum::Frustum(const Matrix4& projectionView)
+{
+	SetFromMatrix(projectionView);
+}
+
+void Frustum::SetFromMatrix(const Matrix4& projectionView)
+{
+	// glm is column major, row i of the matrix is (m[0][i], m[1][i], m[2][i], m[3][i])
+	Matrix4 m = glm::transpose(projectionView);
+
+	Planes[0] = m[3] + m[0];
+	Planes[1] = m[3] - m[0];
+	Planes[2] = m[3] + m[1];
+	Planes[3] = m[3] - m[1];
+	Planes[4] = m[3] + m[2];
+	Planes[5] = m[3] - m[2];
+
+	for (int i = 0; i < 6; i++)
+	{
+		float length = glm::length(Vector3(Planes[i]));
+
+		if (length > 0.0f)
+		{
+			Planes[i] /= length;
+		}
+	}
+}
+
+FrustumTest::Enum Frustum::TestBox(const Vector3& min, const Vector3& max) const
+{
+	FrustumTest::Enum result = FrustumTest::Inside;
+
+	for (int i = 0; i < 6; i++)
+	{
+		const Vector4& plane = Planes[i];
+
+		// Corner furthest along the plane normal, and the one furthest against it
+		Vector3 positive = Vector3(plane.x >= 0.0f ? max.x : min.x, plane.y >= 0.0f ? max.y : min.y, plane.z >= 0.0f ? max.z : min.z);
+		Vector3 negative = Vector3(plane.x >= 0.0f ? min.x : max.x, plane.y >= 0.0f ? min.y : max.y, plane.z >= 0.0f ? min.z : max.z);
+
+		if (glm::dot(Vector3(plane), positive) + plane.w < 0.0f)
+		{
+			return FrustumTest::Outside;
+		}
+
+		if (glm::dot(Vector3(plane), negative) + plane.w < 0.0f)
+		{
+			result = FrustumTest::Intersect;
+		}
+	}
+
+	return result;
+}
+
+FrustumTest::Enum Frustum::TestBox(const Box& box) const
+{
+	return TestBox(box.GetMin(), box.GetMax());
+}
+
+bool Frustum::IntersectsBox(const Box& box) const
+{
+	return TestBox(box) != FrustumTest::Outside;
+}
+
+bool Frustum::ContainsPoint(const Vector3& point) const
+{
+	for (int i = 0; i < 6; i++)
+	{
+		if (glm::dot(Vector3(Planes[i]), point) + Planes[i].w < 0.0f)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Hydra/Core/Library.h"
+#include "Hydra/Core/Vector.h"
+
+class Box;
+
+struct FrustumTest
+{
+	enum Enum
+	{
+		Outside,
+		Intersect,
+		Inside
+	};
+};
+
+// Six planes pointing into the volume, extracted from a projection * view matrix with clip space z in [-1, 1]
+class HYDRA_API Frustum
+{
+public:
+	// Left, right, bottom, top, near, far. xyz is the normal, w the distance.
+	Vector4 Planes[6];
+
+public:
+	Frustum();
+	Frustum(const Matrix4& projectionView);
+
+	void SetFromMatrix(const Matrix4& projectionView);
+
+	FrustumTest::Enum TestBox(const Vector3& min, const Vector3& max) const;
+	FrustumTest::Enum TestBox(const Box& box) const;
+
+	bool IntersectsBox(const Box& box) const;
+	bool ContainsPoint(const Vector3& point) const;
+};
\ No newline at end of file
@@ -23,3 +23,17 @@ Blob* FileStream::Read()
 
 	return nullptr;
 }
+
+bool FileStream::Write(const void* data, size_t size)
+{
+	std::ofstream file(_File.GetPath(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (file.is_open())
+	{
+		file.write((const char*)data, size);
+		file.close();
+
+		return !file.fail();
+	}
+
+	return false;
+}
@@ -11,4 +11,5 @@ public:
 	FileStream(const File& file);
 
 	Blob* Read();
+	bool Write(const void* data, size_t size);
 };
\ No newline at end of file
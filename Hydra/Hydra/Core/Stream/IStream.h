@@ -9,4 +9,7 @@ class IFileStream
 {
 public:
 	virtual Blob* Read() = 0;
+
+	// Replaces the content
+	virtual bool Write(const void* data, size_t size) = 0;
 };
\ No newline at end of file
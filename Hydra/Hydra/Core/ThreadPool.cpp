@@ -0,0 +1,152 @@
+#include "Hydra/Core/ThreadPool.h"
+#include "Hydra/Core/Vector.h"
+
+#include <atomic>
+
+struct ParallelForJob
+{
+	const Function<void(int, int)>* Body;
+
+	int Count;
+	int BatchSize;
+	int BatchCount;
+
+	std::atomic<int> NextBatch;
+	std::atomic<int> FinishedBatches;
+
+	std::mutex Mutex;
+	std::condition_variable Finished;
+};
+
+static void RunParallelForBatches(ParallelForJob& job)
+{
+	int finished = 0;
+
+	for (int batch = job.NextBatch++; batch < job.BatchCount; batch = job.NextBatch++)
+	{
+		int begin = batch * job.BatchSize;
+		int end = glm::min(begin + job.BatchSize, job.Count);
+
+		(*job.Body)(begin, end);
+
+		finished++;
+	}
+
+	if (finished > 0 && (job.FinishedBatches += finished) == job.BatchCount)
+	{
+		std::lock_guard<std::mutex> lock(job.Mutex);
+		job.Finished.notify_all();
+	}
+}
+
+ThreadPool::ThreadPool(int threadCount) : _Stopping(false)
+{
+	if (threadCount <= 0)
+	{
+		threadCount = glm::max((int)std::thread::hardware_concurrency() - 1, 1);
+	}
+
+	for (int i = 0; i < threadCount; i++)
+	{
+		_Workers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+
+	Log("ThreadPool", ToString(threadCount) + " workers");
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(_Mutex);
+		_Stopping = true;
+	}
+
+	_Condition.notify_all();
+
+	for (std::thread& worker : _Workers)
+	{
+		worker.join();
+	}
+}
+
+int ThreadPool::GetWorkerCount() const
+{
+	return (int)_Workers.size();
+}
+
+void ThreadPool::Enqueue(const Function<void()>& task)
+{
+	{
+		std::lock_guard<std::mutex> lock(_Mutex);
+		_Tasks.push(task);
+	}
+
+	_Condition.notify_one();
+}
+
+void ThreadPool::ParallelFor(int count, int minBatchSize, const Function<void(int begin, int end)>& body)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+
+	int threads = GetWorkerCount() + 1;
+
+	// A few batches per thread so uneven batches still spread out
+	int batchSize = glm::max(glm::max(minBatchSize, 1), (count + threads * 4 - 1) / (threads * 4));
+	int batchCount = (count + batchSize - 1) / batchSize;
+
+	if (batchCount == 1)
+	{
+		body(0, count);
+		return;
+	}
+
+	// Shared because workers may pick up their task after all batches are finished and this call returned
+	SharedPtr<ParallelForJob> job = MakeShared<ParallelForJob>();
+	job->Body = &body;
+	job->Count = count;
+	job->BatchSize = batchSize;
+	job->BatchCount = batchCount;
+	job->NextBatch = 0;
+	job->FinishedBatches = 0;
+
+	int helpers = glm::min(GetWorkerCount(), batchCount - 1);
+
+	for (int i = 0; i < helpers; i++)
+	{
+		Enqueue([job]()
+		{
+			RunParallelForBatches(*job);
+		});
+	}
+
+	RunParallelForBatches(*job);
+
+	std::unique_lock<std::mutex> lock(job->Mutex);
+	job->Finished.wait(lock, [&job]() { return job->FinishedBatches == job->BatchCount; });
+}
+
+void ThreadPool::WorkerLoop()
+{
+	while (true)
+	{
+		Function<void()> task;
+
+		{
+			std::unique_lock<std::mutex> lock(_Mutex);
+			_Condition.wait(lock, [this]() { return _Stopping || !_Tasks.empty(); });
+
+			if (_Stopping && _Tasks.empty())
+			{
+				return;
+			}
+
+			task = std::move(_Tasks.front());
+			_Tasks.pop();
+		}
+
+		task();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Hydra/Core/Common.h"
+#include "Hydra/Core/Function.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+
+// Fixed set of worker threads shared by the engine systems that split work per frame
+class HYDRA_API ThreadPool
+{
+private:
+	List<std::thread> _Workers;
+	std::queue<Function<void()>> _Tasks;
+
+	std::mutex _Mutex;
+	std::condition_variable _Condition;
+	bool _Stopping;
+
+public:
+	// With a thread count of 0 one worker is started per hardware thread, minus the calling thread
+	ThreadPool(int threadCount = 0);
+	~ThreadPool();
+
+	int GetWorkerCount() const;
+
+	void Enqueue(const Function<void()>& task);
+
+	// Calls body for batches of at least minBatchSize items of [0, count) and returns once every batch is done.
+	// The calling thread works on the batches too, so nested calls from inside a task can not dead lock.
+	void ParallelFor(int count, int minBatchSize, const Function<void(int begin, int end)>& body);
+
+private:
+	void WorkerLoop();
+};
\ No newline at end of file
@@ -1,6 +1,6 @@
 #include "Hydra/EngineContext.h"
 
-EngineContext::EngineContext() : _RenderInterface(nullptr), _RenderManager(nullptr), _DeviceManager(nullptr), _InputManager(nullptr), _Graphics(nullptr), _UIRenderer(nullptr), _AssetManager(nullptr)
+EngineContext::EngineContext() : _RenderInterface(nullptr), _RenderManager(nullptr), _DeviceManager(nullptr), _InputManager(nullptr), _Graphics(nullptr), _UIRenderer(nullptr), _AssetManager(nullptr), _ThreadPool(nullptr), _ShaderCache(nullptr), _ShaderIncludeCache(nullptr)
 {
 
 }
@@ -73,4 +73,34 @@ void EngineContext::SetAssetManager(AssetManager* assetManager)
 AssetManager* EngineContext::GetAssetManager()
 {
 	return _AssetManager;
+}
+
+void EngineContext::SetThreadPool(ThreadPool* threadPool)
+{
+	_ThreadPool = threadPool;
+}
+
+ThreadPool* EngineContext::GetThreadPool()
+{
+	return _ThreadPool;
+}
+
+void EngineContext::SetShaderCache(ShaderCache* shaderCache)
+{
+	_ShaderCache = shaderCache;
+}
+
+ShaderCache* EngineContext::GetShaderCache()
+{
+	return _ShaderCache;
+}
+
+void EngineContext::SetShaderIncludeCache(ShaderIncludeCache* shaderIncludeCache)
+{
+	_ShaderIncludeCache = shaderIncludeCache;
+}
+
+ShaderIncludeCache* EngineContext::GetShaderIncludeCache()
+{
+	return _ShaderIncludeCache;
 }
\ No newline at end of file
@@ -13,6 +13,9 @@
 typedef NVRHI::IRendererInterface* IRendererInterface;
 
 class FGraphics;
+class ThreadPool;
+class ShaderCache;
+class ShaderIncludeCache;
 
 class HYDRA_API EngineContext
 {
@@ -24,6 +27,9 @@ private:
 	FGraphics* _Graphics;
 	UIRenderer* _UIRenderer;
 	AssetManager* _AssetManager;
+	ThreadPool* _ThreadPool;
+	ShaderCache* _ShaderCache;
+	ShaderIncludeCache* _ShaderIncludeCache;
 public:
 	Vector2i ScreenSize;
 
@@ -50,4 +56,13 @@ public:
 
 	void SetAssetManager(AssetManager* assetManager);
 	AssetManager* GetAssetManager();
+
+	void SetThreadPool(ThreadPool* threadPool);
+	ThreadPool* GetThreadPool();
+
+	void SetShaderCache(ShaderCache* shaderCache);
+	ShaderCache* GetShaderCache();
+
+	void SetShaderIncludeCache(ShaderIncludeCache* shaderIncludeCache);
+	ShaderIncludeCache* GetShaderIncludeCache();
 };
\ No newline at end of file
@@ -82,16 +82,22 @@ Vector3& AActor::GetScale()
 void AActor::SetLocation(const Vector3& location)
 {
 	RootComponent->Location = location;
+
+	RootComponent->MarkTransformDirty();
 }
 
 void AActor::SetRotation(const Vector3& rotation)
 {
 	RootComponent->Rotation = rotation;
+
+	RootComponent->MarkTransformDirty();
 }
 
 void AActor::SetScale(const Vector3& scale)
 {
 	RootComponent->Scale = scale;
+
+	RootComponent->MarkTransformDirty();
 }
 
 void AActor::SetLocation(float x, float y, float z)
@@ -99,6 +105,8 @@ void AActor::SetLocation(float x, float y, float z)
 	RootComponent->Location.x = x;
 	RootComponent->Location.y = y;
 	RootComponent->Location.z = z;
+
+	RootComponent->MarkTransformDirty();
 }
 
 void AActor::SetRotation(float x, float y, float z)
@@ -106,6 +114,8 @@ void AActor::SetRotation(float x, float y, float z)
 	RootComponent->Rotation.x = x;
 	RootComponent->Rotation.y = y;
 	RootComponent->Rotation.z = z;
+
+	RootComponent->MarkTransformDirty();
 }
 
 void AActor::SetScale(float x, float y, float z)
@@ -113,21 +123,29 @@ void AActor::SetScale(float x, float y, float z)
 	RootComponent->Scale.x = x;
 	RootComponent->Scale.y = y;
 	RootComponent->Scale.z = z;
+
+	RootComponent->MarkTransformDirty();
 }
 
 void AActor::AddLocation(const Vector3& location)
 {
 	RootComponent->Location += location;
+
+	RootComponent->MarkTransformDirty();
 }
 
 void AActor::AddRotation(const Vector3& rotation)
 {
 	RootComponent->Rotation += rotation;
+
+	RootComponent->MarkTransformDirty();
 }
 
 void AActor::AddScale(const Vector3& scale)
 {
 	RootComponent->Scale += scale;
+
+	RootComponent->MarkTransformDirty();
 }
 
 void AActor::AddLocation(float x, float y, float z)
@@ -135,6 +153,8 @@ void AActor::AddLocation(float x, float y, float z)
 	RootComponent->Location.x += x;
 	RootComponent->Location.y += y;
 	RootComponent->Location.z += z;
+
+	RootComponent->MarkTransformDirty();
 }
 
 void AActor::AddRotation(float x, float y, float z)
@@ -142,6 +162,8 @@ void AActor::AddRotation(float x, float y, float z)
 	RootComponent->Rotation.x += x;
 	RootComponent->Rotation.y += y;
 	RootComponent->Rotation.z += z;
+
+	RootComponent->MarkTransformDirty();
 }
 
 void AActor::AddScale(float x, float y, float z)
@@ -149,6 +171,8 @@ void AActor::AddScale(float x, float y, float z)
 	RootComponent->Scale.x += x;
 	RootComponent->Scale.y += y;
 	RootComponent->Scale.z += z;
+
+	RootComponent->MarkTransformDirty();
 }
 
 Matrix4 AActor::GetTransformMatrix()
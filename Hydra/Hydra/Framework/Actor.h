@@ -66,6 +66,7 @@ public:
 
 	virtual void Destroy();
 
+	// Writing through these needs a RootComponent->MarkTransformDirty() afterwards, the setters below do it
 	Vector3& GetLocation();
 	Vector3& GetRotation();
 	Vector3& GetScale();
@@ -1,9 +1,53 @@
 #include "PrimitiveComponent.h"
 
-HPrimitiveComponent::HPrimitiveComponent() : HSceneComponent()
+#include "Hydra/Framework/World.h"
+
+HPrimitiveComponent::HPrimitiveComponent() : HSceneComponent(), LDMaxDrawDistance(0.0f), _BoundsProxy(BVH_NULL_NODE), _BoundsDirty(false)
 {
 }
 
 HPrimitiveComponent::~HPrimitiveComponent()
 {
 }
+
+
+bool HPrimitiveComponent::GetLocalBounds(Box& outBounds) const
+{
+	return false;
+}
+
+bool HPrimitiveComponent::GetWorldBounds(Box& outBounds) const
+{
+	Box localBounds;
+
+	if (!GetLocalBounds(localBounds))
+	{
+		return false;
+	}
+
+	outBounds = localBounds.Transform(GetTransformMatrix());
+	return true;
+}
+
+BIHTree* HPrimitiveComponent::GetComplexCollider() const
+{
+	return nullptr;
+}
+
+void HPrimitiveComponent::MarkBoundsDirty()
+{
+	// Components get their bounds when they are registered, until then there is nothing to update
+	if (_BoundsDirty || World == nullptr)
+	{
+		return;
+	}
+
+	_BoundsDirty = true;
+
+	World->MarkBoundsDirty(this);
+}
+
+void HPrimitiveComponent::OnTransformChanged()
+{
+	MarkBoundsDirty();
+}
\ No newline at end of file
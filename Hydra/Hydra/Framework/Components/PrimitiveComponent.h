@@ -1,16 +1,19 @@
 #pragma once
 
 #include "Hydra/Framework/Components/SceneComponent.h"
+#include "Hydra/Core/Math/Box.h"
 #include "PrimitiveComponent.generated.h"
 
 
 class Material;
+class BIHTree;
 
 HCLASS()
 class HYDRA_API HPrimitiveComponent : public HSceneComponent
 {
 	HCLASS_GENERATED_BODY()
 public:
+	/** Beyond this distance from the camera the component is not drawn, 0 draws it at any distance. */
 	float LDMaxDrawDistance;
 
 	uint8 Registered : 1;
@@ -24,6 +27,20 @@ public:
 	uint8 SelfShadowOnly : 1;
 	uint8 CastFarShadow : 1;
 	uint8 CastShadowAsTwoSided : 1;
+private:
+	friend class FWorld;
+
+	/** Leaf of the component in the world bounding volume hierarchy, BVH_NULL_NODE while it is not in the tree. */
+	int32 _BoundsProxy;
+
+	/** Queued for the next FWorld bounds update. */
+	uint8 _BoundsDirty : 1;
+
+	/** Transform and local bounds the world bounds were last computed from. */
+	Matrix4 _BoundsTransform;
+	Matrix4 _BoundsInverseTransform;
+	Box _BoundsLocal;
+	Box _BoundsWorld;
 public:
 	HPrimitiveComponent();
 	virtual ~HPrimitiveComponent();
@@ -42,4 +59,24 @@ public:
 	void UnregisterComponent();*/
 
 	FORCEINLINE bool IsRegistered() const { return Registered; }
+
+	/** Bounds in the space of the component, false when the primitive has no geometry. */
+	virtual bool GetLocalBounds(Box& outBounds) const;
+	/** Local bounds transformed by the transform matrix of the component. */
+	bool GetWorldBounds(Box& outBounds) const;
+
+	/** Triangle tree in the space of the component used by the world ray queries. */
+	virtual BIHTree* GetComplexCollider() const;
+
+	/** Queues the world bounds for the next update, call after changing what GetLocalBounds returns. */
+	void MarkBoundsDirty();
+
+	/** World state as of the last FWorld bounds update, these are what the world queries use. */
+	FORCEINLINE int32 GetBoundsProxy() const { return _BoundsProxy; }
+	FORCEINLINE const Matrix4& GetCachedTransform() const { return _BoundsTransform; }
+	FORCEINLINE const Matrix4& GetCachedInverseTransform() const { return _BoundsInverseTransform; }
+	FORCEINLINE const Box& GetCachedWorldBounds() const { return _BoundsWorld; }
+
+protected:
+	virtual void OnTransformChanged() override;
 };
@@ -50,6 +50,8 @@ bool HSceneComponent::AttachToComponent(HSceneComponent* InParent)
 	Parent = InParent;
 	InParent->Childrens.push_back(this);
 
+	MarkTransformDirty();
+
 	return true;
 }
 
@@ -59,6 +61,8 @@ void HSceneComponent::DetachFromComponent()
 	{
 		List_Remove(Parent->Childrens, this);
 		Parent = nullptr;
+
+		MarkTransformDirty();
 	}
 }
 
@@ -107,6 +111,21 @@ Matrix4 HSceneComponent::GetTransformMatrix() const
 	return transform;
 }
 
+void HSceneComponent::MarkTransformDirty()
+{
+	OnTransformChanged();
+
+	for (HSceneComponent* child : Childrens)
+	{
+		child->MarkTransformDirty();
+	}
+}
+
+void HSceneComponent::OnTransformChanged()
+{
+
+}
+
 Vector3 HSceneComponent::GetForwardVector() const
 {
 	return GetRotationColumn(GetTransformMatrix() , 2);
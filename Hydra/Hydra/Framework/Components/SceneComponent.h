@@ -49,10 +49,17 @@ public:
 
 	virtual Matrix4 GetTransformMatrix() const;
 
+	// Call after changing Location, Rotation or Scale directly, the AActor setters already do. Tells the component
+	// and its children that their world transform changed.
+	void MarkTransformDirty();
+
 	Vector3 GetForwardVector() const;
 	Vector3 GetUpVector() const;
 	Vector3 GetLeftVector() const;
 
+protected:
+	virtual void OnTransformChanged();
+
 private:
 	static Vector3 GetRotationColumn(const Matrix4& mat, int i);
 };
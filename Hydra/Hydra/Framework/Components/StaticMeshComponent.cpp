@@ -1,8 +1,49 @@
 #include "StaticMeshComponent.h"
 
-HStaticMeshComponent::HStaticMeshComponent() : HMeshComponent(), StaticMesh(nullptr)
+#include "Hydra/EngineContext.h"
+
+HStaticMeshComponent::HStaticMeshComponent() : HMeshComponent(), _StaticMesh(nullptr)
 {
 }
 HStaticMeshComponent::~HStaticMeshComponent()
 {
+}
+
+void HStaticMeshComponent::SetStaticMesh(HStaticMesh* staticMesh)
+{
+	if (_StaticMesh == staticMesh)
+	{
+		return;
+	}
+
+	_StaticMesh = staticMesh;
+
+	// Built here so the ray queries on the worker threads never have to create it, the tree is shared by all users of the mesh
+	if (_StaticMesh != nullptr)
+	{
+		_StaticMesh->CreateComplexCollider(Engine != nullptr ? Engine->GetThreadPool() : nullptr);
+	}
+
+	MarkBoundsDirty();
+}
+
+bool HStaticMeshComponent::GetLocalBounds(Box& outBounds) const
+{
+	if (_StaticMesh == nullptr)
+	{
+		return false;
+	}
+
+	outBounds = _StaticMesh->GetBounds();
+	return true;
+}
+
+BIHTree* HStaticMeshComponent::GetComplexCollider() const
+{
+	if (_StaticMesh == nullptr)
+	{
+		return nullptr;
+	}
+
+	return _StaticMesh->GetComplexCollider();
 }
\ No newline at end of file
@@ -9,10 +9,17 @@ HCLASS()
 class HYDRA_API HStaticMeshComponent final : public HMeshComponent
 {
 	HCLASS_GENERATED_BODY()
-public:
-	HStaticMesh* StaticMesh;
+private:
+	HStaticMesh* _StaticMesh;
 
 public:
 	HStaticMeshComponent();
 	virtual ~HStaticMeshComponent();
+
+	/** Builds the complex collider of the mesh if it has none yet and queues the bounds for the next world update. */
+	void SetStaticMesh(HStaticMesh* staticMesh);
+	FORCEINLINE HStaticMesh* GetStaticMesh() const { return _StaticMesh; }
+
+	virtual bool GetLocalBounds(Box& outBounds) const override;
+	virtual BIHTree* GetComplexCollider() const override;
 };
@@ -1,6 +1,9 @@
 #include "StaticMesh.h"
 #include "StaticMeshResources.h"
 
+#include "Hydra/Physics/Collisons/BIH/BIHTree.h"
+#include "Hydra/Render/MeshSimplifier.h"
+#include "Hydra/Core/File.h"
 
 HStaticMesh::HStaticMesh()
 {
@@ -11,7 +14,87 @@ HStaticMesh::HStaticMesh()
 
 HStaticMesh::~HStaticMesh()
 {
+	delete RenderData->ComplexCollider;
 	delete RenderData;
 
 	Log("deleted HStaticMesh");
 }
+
+
+void HStaticMesh::UpdateBounds()
+{
+	float floatMax = FloatMax;
+	float floatMin = -FloatMax;
+
+	Vector3 maxBounds = Vector3(floatMin, floatMin, floatMin);
+	Vector3 minBounds = Vector3(floatMax, floatMax, floatMax);
+
+	if (RenderData->LODResources.size() > 0)
+	{
+		for (VertexBufferEntry& vb : RenderData->LODResources[0].VertexData)
+		{
+			minBounds = glm::min(minBounds, vb.Position);
+			maxBounds = glm::max(maxBounds, vb.Position);
+		}
+	}
+
+	if (minBounds.x > maxBounds.x)
+	{
+		minBounds = maxBounds = Vector3(0.0f);
+	}
+
+	RenderData->Bounds = {};
+	RenderData->Bounds.Origin = (minBounds + maxBounds) * 0.5f;
+	RenderData->Bounds.Extent = maxBounds - RenderData->Bounds.Origin;
+}
+
+const Box& HStaticMesh::GetBounds() const
+{
+	return RenderData->Bounds;
+}
+
+void HStaticMesh::CreateComplexCollider(ThreadPool* threadPool, const String& cachePath)
+{
+	if (RenderData->ComplexCollider == nullptr && RenderData->LODResources.size() > 0)
+	{
+		FStaticMeshLODResources& lod = RenderData->LODResources[0];
+
+		if (cachePath.empty())
+		{
+			RenderData->ComplexCollider = new BIHTree(lod.VertexData, lod.Indices, BIH_MESH_COLLIDER_MAX_TRIS_PER_NODE, BIH_MESH_COLLIDER_LAYOUT, BIH_MESH_COLLIDER_SPLIT_METHOD, threadPool);
+			return;
+		}
+
+		uint64 sourceHash = BIHTree::GetSourceHash(lod.VertexData, lod.Indices, BIH_MESH_COLLIDER_MAX_TRIS_PER_NODE, BIH_MESH_COLLIDER_LAYOUT, BIH_MESH_COLLIDER_SPLIT_METHOD);
+
+		RenderData->ComplexCollider = BIHTree::Load(cachePath, sourceHash);
+
+		if (RenderData->ComplexCollider == nullptr)
+		{
+			RenderData->ComplexCollider = new BIHTree(lod.VertexData, lod.Indices, BIH_MESH_COLLIDER_MAX_TRIS_PER_NODE, BIH_MESH_COLLIDER_LAYOUT, BIH_MESH_COLLIDER_SPLIT_METHOD, threadPool);
+			RenderData->ComplexCollider->Save(cachePath, sourceHash);
+		}
+	}
+}
+
+void HStaticMesh::GenerateLODs(const List<float>& triangleRatios, const String& cachePath)
+{
+	if (cachePath.empty())
+	{
+		MeshSimplifier::GenerateLODs(*RenderData, triangleRatios);
+		return;
+	}
+
+	uint64 sourceHash = RenderData->GetLODSourceHash(triangleRatios);
+
+	if (!RenderData->LoadLODs(cachePath, sourceHash))
+	{
+		MeshSimplifier::GenerateLODs(*RenderData, triangleRatios);
+		RenderData->SaveLODs(cachePath, sourceHash);
+	}
+}
+
+BIHTree* HStaticMesh::GetComplexCollider() const
+{
+	return RenderData->ComplexCollider;
+}
\ No newline at end of file
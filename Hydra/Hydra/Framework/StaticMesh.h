@@ -28,4 +28,16 @@ public:
 public:
 	HStaticMesh();
 	virtual ~HStaticMesh();
+
+	void UpdateBounds();
+	const class Box& GetBounds() const;
+
+	// Big meshes are built in parallel when a thread pool is given. With a cache path the tree is loaded
+	// from there when the mesh did not change since it was saved, otherwise it is built and saved again.
+	void CreateComplexCollider(class ThreadPool* threadPool = nullptr, const String& cachePath = String());
+
+	// Replaces the LODs after LOD 0 with simplified ones, see MeshSimplifier::GenerateLODs. With a cache path they are
+	// loaded from there when LOD 0 and the ratios did not change since they were saved, otherwise generated and saved again.
+	void GenerateLODs(const List<float>& triangleRatios, const String& cachePath = String());
+	class BIHTree* GetComplexCollider() const;
 };
@@ -0,0 +1,276 @@
+#include "StaticMeshResources.h"
+
+#include "Hydra/Core/File.h"
+#include "Hydra/Core/Hash.h"
+#include "Hydra/Core/Stream/FileStream.h"
+
+#include <cstring>
+
+int FStaticMeshRenderData::GetLODIndex(float screenSize, int lastLOD) const
+{
+	int lodCount = glm::min((int)LODResources.size(), MAX_STATIC_MESH_LODS);
+	int lod = 0;
+
+	// A LOD coarser than the last one only takes over a bit below its threshold, and gives way again only a bit above it
+	while (lod + 1 < lodCount)
+	{
+		float threshold = LODResources[lod + 1].ScreenSize;
+		threshold *= lod + 1 <= lastLOD ? 1.0f + STATIC_MESH_LOD_HYSTERESIS : 1.0f - STATIC_MESH_LOD_HYSTERESIS;
+
+		if (screenSize >= threshold)
+		{
+			break;
+		}
+
+		lod++;
+	}
+
+	return lod;
+}
+
+float ComputeBoundsScreenSize(float radius, float distance, const Matrix4& projection)
+{
+	// The projection scales x and y by these at a distance of one, the screen is two units high after it
+	float screenMultiple = glm::max(glm::abs(projection[0][0]), glm::abs(projection[1][1])) * 0.5f;
+
+	// An orthographic projection does not divide by the distance
+	if (projection[2][3] == 0.0f)
+	{
+		distance = 1.0f;
+	}
+
+	return 2.0f * screenMultiple * radius / glm::max(distance, 1.0f);
+}
+
+// 'HLOD' read as a little endian uint32
+constexpr uint32 STATIC_MESH_LOD_FILE_MAGIC = 0x444F4C48;
+
+struct FStaticMeshLODFileHeader
+{
+	uint32 Magic;
+	uint32 Version;
+	uint64 SourceHash;
+	uint32 LODCount;
+};
+
+struct FStaticMeshLODFileEntry
+{
+	float ScreenSize;
+	uint32 LastIndex;
+	uint32 VertexCount;
+	uint32 IndexCount;
+	uint32 SectionCount;
+};
+
+uint64 FStaticMeshRenderData::GetLODSourceHash(const List<float>& triangleRatios) const
+{
+	uint64 hash = HASH_SEED;
+
+	if (LODResources.empty())
+	{
+		return hash;
+	}
+
+	const FStaticMeshLODResources& baseLod = LODResources[0];
+
+	// The LODs copy whole vertices, not only the positions the simplifier looks at
+	if (!baseLod.VertexData.empty())
+	{
+		hash = HashBytes(hash, baseLod.VertexData.data(), sizeof(VertexBufferEntry) * baseLod.VertexData.size());
+	}
+
+	if (!baseLod.Indices.empty())
+	{
+		hash = HashBytes(hash, baseLod.Indices.data(), sizeof(uint32) * baseLod.Indices.size());
+	}
+
+	for (const FStaticMeshSection& section : baseLod.Sections)
+	{
+		uint32 range[] = { section.FirstIndex, section.NumTriangles };
+		hash = HashBytes(hash, range, sizeof(range));
+	}
+
+	if (!triangleRatios.empty())
+	{
+		hash = HashBytes(hash, triangleRatios.data(), sizeof(float) * triangleRatios.size());
+	}
+
+	int32 settings[] = { (int32)baseLod.VertexData.size(), (int32)baseLod.Indices.size(), (int32)baseLod.Sections.size(), (int32)triangleRatios.size(), MAX_STATIC_MESH_LODS };
+	return HashBytes(hash, settings, sizeof(settings));
+}
+
+bool FStaticMeshRenderData::SaveLODs(const File& file, uint64 sourceHash) const
+{
+	FStaticMeshLODFileHeader header = {};
+	header.Magic = STATIC_MESH_LOD_FILE_MAGIC;
+	header.Version = STATIC_MESH_LOD_FILE_VERSION;
+	header.SourceHash = sourceHash;
+	header.LODCount = LODResources.empty() ? 0 : (uint32)LODResources.size() - 1;
+
+	size_t size = sizeof(FStaticMeshLODFileHeader);
+
+	for (size_t i = 1; i < LODResources.size(); i++)
+	{
+		const FStaticMeshLODResources& lod = LODResources[i];
+		size += sizeof(FStaticMeshLODFileEntry) + sizeof(VertexBufferEntry) * lod.VertexData.size() + sizeof(uint32) * lod.Indices.size() + sizeof(FStaticMeshSection) * lod.Sections.size();
+	}
+
+	// Same layout LoadLODs reads back
+	List<char> data(size);
+	char* target = data.data();
+
+	memcpy(target, &header, sizeof(FStaticMeshLODFileHeader));
+	target += sizeof(FStaticMeshLODFileHeader);
+
+	for (size_t i = 1; i < LODResources.size(); i++)
+	{
+		const FStaticMeshLODResources& lod = LODResources[i];
+
+		FStaticMeshLODFileEntry entry = {};
+		entry.ScreenSize = lod.ScreenSize;
+		entry.LastIndex = lod.LastIndex;
+		entry.VertexCount = (uint32)lod.VertexData.size();
+		entry.IndexCount = (uint32)lod.Indices.size();
+		entry.SectionCount = (uint32)lod.Sections.size();
+
+		memcpy(target, &entry, sizeof(FStaticMeshLODFileEntry));
+		target += sizeof(FStaticMeshLODFileEntry);
+
+		memcpy(target, lod.VertexData.data(), sizeof(VertexBufferEntry) * lod.VertexData.size());
+		target += sizeof(VertexBufferEntry) * lod.VertexData.size();
+
+		memcpy(target, lod.Indices.data(), sizeof(uint32) * lod.Indices.size());
+		target += sizeof(uint32) * lod.Indices.size();
+
+		memcpy(target, lod.Sections.data(), sizeof(FStaticMeshSection) * lod.Sections.size());
+		target += sizeof(FStaticMeshSection) * lod.Sections.size();
+	}
+
+	FileStream stream = FileStream(file);
+
+	if (!stream.Write(data.data(), data.size()))
+	{
+		Log("FStaticMeshRenderData::SaveLODs", file.GetPath(), "Could not write the file.");
+		return false;
+	}
+
+	return true;
+}
+
+// Every index and section range of a loaded LOD must stay inside its arrays, the renderer does not check them
+static bool IsValidLOD(const FStaticMeshLODResources& lod, size_t sectionCount)
+{
+	if (lod.Sections.size() != sectionCount)
+	{
+		return false;
+	}
+
+	for (uint32 index : lod.Indices)
+	{
+		if (index >= lod.VertexData.size())
+		{
+			return false;
+		}
+	}
+
+	for (const FStaticMeshSection& section : lod.Sections)
+	{
+		if ((uint64)section.FirstIndex + section.NumTriangles > lod.Indices.size() || section.MinVertexIndex > section.MaxVertexIndex || section.MaxVertexIndex > lod.VertexData.size())
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool FStaticMeshRenderData::LoadLODs(const File& file, uint64 sourceHash)
+{
+	if (LODResources.empty() || !file.IsExist())
+	{
+		return false;
+	}
+
+	FileStream stream = FileStream(file);
+	Blob* data = stream.Read();
+
+	if (data == nullptr)
+	{
+		return false;
+	}
+
+	FStaticMeshLODFileHeader header;
+	bool valid = data->GetDataSize() >= sizeof(FStaticMeshLODFileHeader);
+
+	if (valid)
+	{
+		memcpy(&header, data->GetData(), sizeof(FStaticMeshLODFileHeader));
+
+		valid = header.Magic == STATIC_MESH_LOD_FILE_MAGIC && header.Version == STATIC_MESH_LOD_FILE_VERSION && header.SourceHash == sourceHash &&
+			header.LODCount < MAX_STATIC_MESH_LODS;
+	}
+
+	List<FStaticMeshLODResources> lods;
+
+	const char* source = data->GetData() + (valid ? sizeof(FStaticMeshLODFileHeader) : 0);
+	const char* end = data->GetData() + data->GetDataSize();
+
+	for (uint32 i = 0; valid && i < header.LODCount; i++)
+	{
+		FStaticMeshLODFileEntry entry;
+
+		if ((size_t)(end - source) < sizeof(FStaticMeshLODFileEntry))
+		{
+			valid = false;
+			break;
+		}
+
+		memcpy(&entry, source, sizeof(FStaticMeshLODFileEntry));
+		source += sizeof(FStaticMeshLODFileEntry);
+
+		uint64 vertexSize = sizeof(VertexBufferEntry) * (uint64)entry.VertexCount;
+		uint64 indexSize = sizeof(uint32) * (uint64)entry.IndexCount;
+		uint64 sectionSize = sizeof(FStaticMeshSection) * (uint64)entry.SectionCount;
+
+		if ((uint64)(end - source) < vertexSize + indexSize + sectionSize)
+		{
+			valid = false;
+			break;
+		}
+
+		FStaticMeshLODResources lod = {};
+		lod.ScreenSize = entry.ScreenSize;
+		lod.LastIndex = entry.LastIndex;
+
+		lod.VertexData.resize(entry.VertexCount);
+		memcpy(lod.VertexData.data(), source, vertexSize);
+		source += vertexSize;
+
+		lod.Indices.resize(entry.IndexCount);
+		memcpy(lod.Indices.data(), source, indexSize);
+		source += indexSize;
+
+		lod.Sections.resize(entry.SectionCount);
+		memcpy(lod.Sections.data(), source, sectionSize);
+		source += sectionSize;
+
+		valid = IsValidLOD(lod, LODResources[0].Sections.size());
+
+		lods.push_back(lod);
+	}
+
+	valid = valid && source == end;
+
+	delete data;
+
+	if (!valid)
+	{
+		Log("FStaticMeshRenderData::LoadLODs", file.GetPath(), "Outdated or invalid file, the LODs will be generated again.");
+		return false;
+	}
+
+	LODResources.resize(1);
+	LODResources.insert(LODResources.end(), lods.begin(), lods.end());
+
+	return true;
+}
\ No newline at end of file
@@ -1,8 +1,21 @@
 #pragma once
 
+#include "Hydra/Core/Common.h"
 #include "Hydra/Render/VertexBuffer.h"
+#include "Hydra/Core/Math/Box.h"
 
 struct FMeshBufferDataInternal;
+class BIHTree;
+class File;
+
+/** Most LODs a static mesh is drawn with, further LODs are ignored. */
+#define MAX_STATIC_MESH_LODS 8
+
+/** How far, relative to the threshold, the screen size has to move back past a LOD threshold before the LOD changes back. */
+#define STATIC_MESH_LOD_HYSTERESIS 0.1f
+
+/** Bump when the saved LOD format or the output of the MeshSimplifier changes, files of other versions are generated again. */
+#define STATIC_MESH_LOD_FILE_VERSION 1
 
 struct FStaticMeshSection
 {
@@ -44,10 +57,36 @@ struct FStaticMeshLODResources
 	List<FStaticMeshSection> Sections;
 
 	FMeshBufferDataInternal* InternalBufferData;
+
+	/** Screen size below which this LOD replaces the one before it, unused for LOD 0. */
+	float ScreenSize = 0.0f;
 };
 
 class FStaticMeshRenderData
 {
 public:
 	List<FStaticMeshLODResources> LODResources;
-};
\ No newline at end of file
+
+	/** Local space bounds of LOD 0. */
+	Box Bounds;
+
+	/** Triangle tree of LOD 0 used for ray queries, created on demand. */
+	BIHTree* ComplexCollider;
+
+	FStaticMeshRenderData() : ComplexCollider(nullptr) {}
+
+	/** LOD to draw at the screen size, lastLOD is the one drawn before and keeps the LOD from flickering at a threshold. */
+	int GetLODIndex(float screenSize, int lastLOD) const;
+
+	/** Hash of LOD 0 and the ratios the other LODs are generated with, saved LODs are only loaded while it stays the same. */
+	uint64 GetLODSourceHash(const List<float>& triangleRatios) const;
+
+	/** Saves every LOD after LOD 0. */
+	bool SaveLODs(const File& file, uint64 sourceHash) const;
+
+	/** Replaces the LODs after LOD 0 with the saved ones, false when the file is missing, outdated or invalid. */
+	bool LoadLODs(const File& file, uint64 sourceHash);
+};
+
+/** Fraction of the screen height covered by a sphere at the distance from the view, the unit of the LOD screen sizes. */
+float ComputeBoundsScreenSize(float radius, float distance, const Matrix4& projection);
\ No newline at end of file
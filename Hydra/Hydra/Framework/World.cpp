@@ -5,6 +5,43 @@
 #include "Hydra/Framework/Components/CameraComponent.h"
 #include "Hydra/Framework/Pawn.h"
 
+#include "Hydra/Core/ThreadPool.h"
+#include "Hydra/Physics/Collisons/BIH/BIHTree.h"
+
+static void RaycastTree(const DynamicBVH& tree, const Ray& ray, FRaycastHit& outHit, CollisionResults& results)
+{
+	outHit = FRaycastHit();
+
+	tree.QueryRay(ray, ray.Limit, [&](int32 proxy, float tNear) -> float
+	{
+		HPrimitiveComponent* component = static_cast<HPrimitiveComponent*>(tree.GetUserData(proxy));
+		BIHTree* collider = component->GetComplexCollider();
+
+		if (collider == nullptr)
+		{
+			return outHit.Distance;
+		}
+
+		results.Clear();
+
+		if (collider->CollideWithRay(ray, component->GetCachedTransform(), component->GetCachedInverseTransform(), &component->GetCachedWorldBounds(), results, BIHQueryMode::ClosestHit) > 0)
+		{
+			CollisionResult result = results.GetCollisonDirect(0);
+
+			if (result.Distance < outHit.Distance)
+			{
+				outHit.Component = component;
+				outHit.Location = result.ContactPoint;
+				outHit.Normal = result.ContactNormal;
+				outHit.Distance = result.Distance;
+				outHit.TriangleIndex = result.TriangleIndex;
+			}
+		}
+
+		return outHit.Distance;
+	});
+}
+
 FWorld::FWorld(EngineContext* context)
 {
 	_Engine = context;
@@ -64,6 +101,8 @@ void FWorld::RegisterComponent(HSceneComponent* component)
 	if (HPrimitiveComponent* cmp = component->SafeCast<HPrimitiveComponent>())
 	{
 		_PrimitiveComponents.push_back(cmp);
+
+		UpdateComponentBounds(cmp);
 	}
 
 	if (HCameraComponent* cmp = component->SafeCast<HCameraComponent>())
@@ -79,6 +118,18 @@ void FWorld::UnregisterComponent(HSceneComponent* component)
 	if (HPrimitiveComponent* cmp = component->SafeCast<HPrimitiveComponent>())
 	{
 		List_Remove(_PrimitiveComponents, cmp);
+
+		if (cmp->_BoundsDirty)
+		{
+			List_Remove(_DirtyPrimitiveComponents, cmp);
+			cmp->_BoundsDirty = false;
+		}
+
+		if (cmp->_BoundsProxy != BVH_NULL_NODE)
+		{
+			_PrimitiveTree.DestroyProxy(cmp->_BoundsProxy);
+			cmp->_BoundsProxy = BVH_NULL_NODE;
+		}
 	}
 
 	if (HCameraComponent* cmp = component->SafeCast<HCameraComponent>())
@@ -107,4 +158,214 @@ const List<HCameraComponent*>& FWorld::GetCameraComponents()
 HGameModeBase* FWorld::GetGameMode()
 {
 	return _GameMode;
+}
+
+void FWorld::UpdatePrimitiveBounds()
+{
+	for (HPrimitiveComponent* component : _DirtyPrimitiveComponents)
+	{
+		component->_BoundsDirty = false;
+
+		UpdateComponentBounds(component);
+	}
+
+	_DirtyPrimitiveComponents.clear();
+}
+
+void FWorld::MarkBoundsDirty(HPrimitiveComponent* component)
+{
+	_DirtyPrimitiveComponents.push_back(component);
+}
+
+void FWorld::UpdateComponentBounds(HPrimitiveComponent* component)
+{
+	Box localBounds;
+
+	if (!component->GetLocalBounds(localBounds))
+	{
+		if (component->_BoundsProxy != BVH_NULL_NODE)
+		{
+			_PrimitiveTree.DestroyProxy(component->_BoundsProxy);
+			component->_BoundsProxy = BVH_NULL_NODE;
+		}
+
+		return;
+	}
+
+	Matrix4 transform = component->GetTransformMatrix();
+
+	if (component->_BoundsProxy != BVH_NULL_NODE && transform == component->_BoundsTransform &&
+		localBounds.Origin == component->_BoundsLocal.Origin && localBounds.Extent == component->_BoundsLocal.Extent)
+	{
+		return;
+	}
+
+	component->_BoundsTransform = transform;
+	component->_BoundsInverseTransform = glm::inverse(transform);
+	component->_BoundsLocal = localBounds;
+	component->_BoundsWorld = localBounds.Transform(transform);
+
+	if (component->_BoundsProxy == BVH_NULL_NODE)
+	{
+		component->_BoundsProxy = _PrimitiveTree.CreateProxy(component->_BoundsWorld, component);
+	}
+	else
+	{
+		_PrimitiveTree.MoveProxy(component->_BoundsProxy, component->_BoundsWorld);
+	}
+}
+
+const DynamicBVH& FWorld::GetPrimitiveTree() const
+{
+	return _PrimitiveTree;
+}
+
+void FWorld::QueryFrustum(const Frustum& frustum, List<HPrimitiveComponent*>& outComponents) const
+{
+	_PrimitiveTree.QueryFrustum(frustum, [&](int32 proxy)
+	{
+		outComponents.push_back(static_cast<HPrimitiveComponent*>(_PrimitiveTree.GetUserData(proxy)));
+	});
+}
+
+void FWorld::QueryOverlap(const Box& bounds, List<HPrimitiveComponent*>& outComponents) const
+{
+	Vector3 min = bounds.GetMin();
+	Vector3 max = bounds.GetMax();
+
+	_PrimitiveTree.QueryOverlap(bounds, [&](int32 proxy)
+	{
+		HPrimitiveComponent* component = static_cast<HPrimitiveComponent*>(_PrimitiveTree.GetUserData(proxy));
+
+		// The tree stores fattened bounds
+		Vector3 componentMin = component->GetCachedWorldBounds().GetMin();
+		Vector3 componentMax = component->GetCachedWorldBounds().GetMax();
+
+		if (glm::all(glm::lessThanEqual(componentMin, max)) && glm::all(glm::greaterThanEqual(componentMax, min)))
+		{
+			outComponents.push_back(component);
+		}
+
+		return true;
+	});
+}
+
+bool FWorld::Raycast(const Ray& ray, FRaycastHit& outHit)
+{
+	CollisionResults results(CollisionResultMode::Closest);
+	RaycastTree(_PrimitiveTree, ray, outHit, results);
+
+	return outHit.IsValidHit();
+}
+
+void FWorld::RaycastBatch(const List<Ray>& rays, List<FRaycastHit>& outHits, int minBatchSize)
+{
+	outHits.resize(rays.size());
+
+	auto raycastRange = [&](int begin, int end)
+	{
+		CollisionResults results(CollisionResultMode::Closest);
+
+		for (int i = begin; i < end; i++)
+		{
+			RaycastTree(_PrimitiveTree, rays[i], outHits[i], results);
+		}
+	};
+
+	ThreadPool* threadPool = _Engine->GetThreadPool();
+
+	if (threadPool)
+	{
+		threadPool->ParallelFor((int)rays.size(), minBatchSize, raycastRange);
+	}
+	else
+	{
+		raycastRange(0, (int)rays.size());
+	}
+}
+
+bool FWorld::SweepSphere(const Vector3& center, float radius, const Vector3& direction, float maxDistance, FRaycastHit& outHit)
+{
+	return SweepCapsule(center, center, radius, direction, maxDistance, outHit);
+}
+
+bool FWorld::SweepCapsule(const Vector3& start, const Vector3& end, float radius, const Vector3& direction, float maxDistance, FRaycastHit& outHit)
+{
+	outHit = FRaycastHit();
+
+	Vector3 move = direction * maxDistance;
+	Vector3 min = glm::min(glm::min(start, end), glm::min(start + move, end + move)) - Vector3(radius);
+	Vector3 max = glm::max(glm::max(start, end), glm::max(start + move, end + move)) + Vector3(radius);
+
+	List<HPrimitiveComponent*> components;
+	QueryOverlap(Box(BBMM min, max), components);
+
+	CollisionResults results(CollisionResultMode::Closest);
+
+	for (HPrimitiveComponent* component : components)
+	{
+		BIHTree* collider = component->GetComplexCollider();
+
+		if (collider == nullptr)
+		{
+			continue;
+		}
+
+		results.Clear();
+
+		// Later contacts than the closest one so far can not win
+		float distance = glm::min(maxDistance, outHit.Distance);
+
+		if (collider->SweepCapsule(start, end, radius, direction, distance, component->GetCachedTransform(), component->GetCachedInverseTransform(), results, BIHQueryMode::ClosestHit) > 0)
+		{
+			CollisionResult result = results.GetCollisonDirect(0);
+
+			if (result.Distance < outHit.Distance)
+			{
+				outHit.Component = component;
+				outHit.Location = result.ContactPoint;
+				outHit.Normal = result.ContactNormal;
+				outHit.Distance = result.Distance;
+				outHit.TriangleIndex = result.TriangleIndex;
+			}
+		}
+	}
+
+	return outHit.IsValidHit();
+}
+
+void FWorld::OverlapSphere(const Vector3& center, float radius, List<FRaycastHit>& outHits)
+{
+	List<HPrimitiveComponent*> components;
+	QueryOverlap(Box(BBMM center - Vector3(radius), center + Vector3(radius)), components);
+
+	CollisionResults results;
+
+	for (HPrimitiveComponent* component : components)
+	{
+		BIHTree* collider = component->GetComplexCollider();
+
+		if (collider == nullptr)
+		{
+			continue;
+		}
+
+		results.Clear();
+
+		int hits = collider->OverlapSphere(center, radius, component->GetCachedTransform(), component->GetCachedInverseTransform(), results);
+
+		for (int i = 0; i < hits; i++)
+		{
+			CollisionResult result = results.GetCollisonDirect(i);
+
+			FRaycastHit hit;
+			hit.Component = component;
+			hit.Location = result.ContactPoint;
+			hit.Normal = result.ContactNormal;
+			hit.Distance = result.Distance;
+			hit.TriangleIndex = result.TriangleIndex;
+
+			outHits.push_back(hit);
+		}
+	}
 }
\ No newline at end of file
@@ -6,6 +6,8 @@
 #include "Hydra/Core/Delegate.h"
 
 #include "Hydra/Framework/Actor.h"
+#include "Hydra/Physics/Collisons/Ray.h"
+#include "Hydra/Physics/Collisons/BVH/DynamicBVH.h"
 
 
 class EngineContext;
@@ -13,6 +15,20 @@ class HGameModeBase;
 class HPrimitiveComponent;
 class HCameraComponent;
 
+struct FRaycastHit
+{
+	HPrimitiveComponent* Component;
+
+	Vector3 Location;
+	Vector3 Normal;
+	float Distance;
+	int TriangleIndex;
+
+	FRaycastHit() : Component(nullptr), Location(), Normal(), Distance(FloatInf), TriangleIndex(-1) {}
+
+	FORCEINLINE bool IsValidHit() const { return Component != nullptr; }
+};
+
 class HYDRA_API FWorld : public HObject
 {
 	HCLASS_BODY_NO_FNC_POINTER(FWorld)
@@ -22,6 +38,12 @@ private:
 	List<HPrimitiveComponent*> _PrimitiveComponents;
 	List<HCameraComponent*> _CameraComponents;
 	HGameModeBase* _GameMode;
+
+	// Broad phase over the world bounds of _PrimitiveComponents
+	DynamicBVH _PrimitiveTree;
+
+	// Components whose transform or local bounds changed since the last UpdatePrimitiveBounds
+	List<HPrimitiveComponent*> _DirtyPrimitiveComponents;
 public:
 	DelegateEvent<void, HCameraComponent*> OnCameraComponentAdded;
 	DelegateEvent<void, HCameraComponent*> OnCameraComponentRemoved;
@@ -93,4 +115,35 @@ public:
 	const List<HCameraComponent*>& GetCameraComponents();
 
 	HGameModeBase* GetGameMode();
+
+	// Refits the tree entries of the primitive components marked dirty since the last call, once per tick
+	void UpdatePrimitiveBounds();
+
+	// Queues the component for the next UpdatePrimitiveBounds, see HPrimitiveComponent::MarkBoundsDirty
+	void MarkBoundsDirty(HPrimitiveComponent* component);
+
+	// Refits a single component right away, for queries issued in the same tick it moved
+	void UpdateComponentBounds(HPrimitiveComponent* component);
+
+	const DynamicBVH& GetPrimitiveTree() const;
+
+	// Components whose bounds are at least partially inside the frustum
+	void QueryFrustum(const Frustum& frustum, List<HPrimitiveComponent*>& outComponents) const;
+
+	// Components whose world bounds overlap the box
+	void QueryOverlap(const Box& bounds, List<HPrimitiveComponent*>& outComponents) const;
+
+	// Closest hit of the ray over all primitive components
+	bool Raycast(const Ray& ray, FRaycastHit& outHit);
+
+	// Closest hit of every ray, outHits gets one entry per ray. The rays are spread over the
+	// engine thread pool, so thousands of queries can be issued at once from the game thread.
+	void RaycastBatch(const List<Ray>& rays, List<FRaycastHit>& outHits, int minBatchSize = 64);
+
+	// First contact of the sphere moved along the normalized direction, the hit distance is how far it can move
+	bool SweepSphere(const Vector3& center, float radius, const Vector3& direction, float maxDistance, FRaycastHit& outHit);
+	bool SweepCapsule(const Vector3& start, const Vector3& end, float radius, const Vector3& direction, float maxDistance, FRaycastHit& outHit);
+
+	// Every triangle the sphere touches, the hit distance is negative by how deep the sphere is inside
+	void OverlapSphere(const Vector3& center, float radius, List<FRaycastHit>& outHits);
 };
@@ -3,6 +3,9 @@
 #include "Hydra/Render/Pipeline/View/UIRenderView.h"
 
 #include "Hydra/Framework/World.h"
+#include "Hydra/Core/ThreadPool.h"
+#include "Hydra/Render/ShaderCache.h"
+#include "Hydra/Render/ShaderIncludeCache.h"
 
 
 
@@ -13,6 +16,19 @@
 
 HydraEngine::~HydraEngine()
 {
+	if (Context)
+	{
+		delete Context->GetThreadPool();
+
+		if (ShaderCache* shaderCache = Context->GetShaderCache())
+		{
+			shaderCache->Save(File(SHADER_CACHE_FILE));
+			delete shaderCache;
+		}
+
+		delete Context->GetShaderIncludeCache();
+	}
+
 	delete Context;
 }
 
@@ -24,6 +40,13 @@ HydraEngine::HydraEngine()
 void HydraEngine::Start()
 {
 	Context = new EngineContext();
+	Context->SetThreadPool(new ThreadPool());
+
+	// Loaded before the device, the first techniques compile while it is created
+	ShaderCache* shaderCache = new ShaderCache();
+	shaderCache->Load(File(SHADER_CACHE_FILE));
+	Context->SetShaderCache(shaderCache);
+	Context->SetShaderIncludeCache(new ShaderIncludeCache());
 
 	DeviceManager* deviceManager = DeviceManager::CreateDeviceManagerForPlatform();
 	Context->SetDeviceManager(deviceManager);
@@ -0,0 +1,734 @@
+#include "Hydra/Physics/Collisons/BIH/BIHBenchmark.h"
+#include "Hydra/Physics/Collisons/BIH/BIHTree.h"
+
+#include "Hydra/Core/Timing.h"
+#include "Hydra/Core/Random.h"
+#include "Hydra/Core/Math/Box.h"
+#include "Hydra/Core/Math/BoxBatch.h"
+
+#include "Hydra/Physics/Collisons/Testing.h"
+
+#include "Hydra/Render/Mesh.h"
+
+#include <cstring>
+
+void BIHBenchmark::CompareLayouts(const String& name, Mesh* mesh, int rayCount, int maxTrisPerNode)
+{
+	mesh->UpdateBounds();
+
+	List<Ray> rays = GenerateRays(mesh, rayCount);
+
+	BIHTree pointerTree(mesh, maxTrisPerNode, BIHLayout::Pointer);
+	BIHTree flatTree(mesh, maxTrisPerNode, BIHLayout::Flat);
+
+	BIHBenchmarkResult pointerResult = MeasureRays(name + " [Pointer]", &pointerTree, mesh, rays);
+	BIHBenchmarkResult flatResult = MeasureRays(name + " [Flat]", &flatTree, mesh, rays);
+	BIHBenchmarkResult closestResult = MeasureRays(name + " [Flat, Closest]", &flatTree, mesh, rays, BIHQueryMode::ClosestHit);
+
+	LogResult(pointerResult);
+	LogResult(flatResult);
+	LogResult(closestResult);
+
+	Log("BIHBenchmark::CompareLayouts", name, "Flat nodes: " + ToString(flatTree.GetNodeCount()) + " (" + ToString(flatTree.GetNodeCount() * sizeof(BIHFlatNode)) + " bytes), speedup: " + ToString(flatResult.RaysPerSecond / glm::max(pointerResult.RaysPerSecond, 1.0)));
+
+	if (pointerResult.HitCount != flatResult.HitCount)
+	{
+		LogError("BIHBenchmark::CompareLayouts", name, "Layouts returned different hit counts (" + ToString(pointerResult.HitCount) + " vs " + ToString(flatResult.HitCount) + ") !");
+	}
+}
+
+void BIHBenchmark::CompareSplitMethods(const String& name, Mesh* mesh, int rayCount, int maxTrisPerNode)
+{
+	mesh->UpdateBounds();
+
+	List<Ray> rays = GenerateRays(mesh, rayCount);
+
+	BIHTree centreTree(mesh, maxTrisPerNode, BIHLayout::Flat, BIHSplitMethod::Centre);
+	BIHTree sahTree(mesh, maxTrisPerNode, BIHLayout::Flat, BIHSplitMethod::SAH);
+
+	centreTree.LogBuildStats(name + " [Centre]");
+	sahTree.LogBuildStats(name + " [SAH]");
+
+	BIHBenchmarkResult centreResult = MeasureRays(name + " [Centre]", &centreTree, mesh, rays);
+	BIHBenchmarkResult sahResult = MeasureRays(name + " [SAH]", &sahTree, mesh, rays);
+
+	LogResult(centreResult);
+	LogResult(sahResult);
+
+	if (centreResult.HitCount != sahResult.HitCount)
+	{
+		LogError("BIHBenchmark::CompareSplitMethods", name, "Split methods returned different hit counts (" + ToString(centreResult.HitCount) + " vs " + ToString(sahResult.HitCount) + ") !");
+	}
+}
+
+void BIHBenchmark::CompareParallelBuild(const String& name, Mesh* mesh, ThreadPool* threadPool, int maxTrisPerNode)
+{
+	BIHLayout::Enum layouts[] = { BIHLayout::Pointer, BIHLayout::Flat };
+
+	for (BIHLayout::Enum layout : layouts)
+	{
+		String layoutName = layout == BIHLayout::Flat ? "Flat" : "Pointer";
+
+		BIHTree serialTree(mesh, maxTrisPerNode, layout, BIHSplitMethod::SAH);
+		BIHTree parallelTree(mesh, maxTrisPerNode, layout, BIHSplitMethod::SAH, threadPool);
+
+		serialTree.LogBuildStats(name + " [" + layoutName + ", Serial]");
+		parallelTree.LogBuildStats(name + " [" + layoutName + ", Parallel]");
+
+		Log("BIHBenchmark::CompareParallelBuild", name, layoutName + " build speedup: " + ToString(serialTree.GetBuildStats().BuildTime / glm::max(parallelTree.GetBuildStats().BuildTime, 1e-9)));
+
+		if (!serialTree.IsIdentical(parallelTree))
+		{
+			LogError("BIHBenchmark::CompareParallelBuild", name, "Parallel " + layoutName + " tree differs from the serial one !");
+		}
+	}
+}
+
+void BIHBenchmark::CompareRefit(const String& name, Mesh* mesh, int rayCount, ThreadPool* threadPool, int maxTrisPerNode)
+{
+	mesh->UpdateBounds();
+
+	BIHTree tree(mesh, maxTrisPerNode, BIHLayout::Flat, BIHSplitMethod::SAH, threadPool);
+
+	{
+		BIHTree builtTree(mesh, maxTrisPerNode, BIHLayout::Flat, BIHSplitMethod::SAH);
+		tree.Refit(mesh->VertexData, mesh->Indices, BIH_REFIT_REBUILD_RATIO, threadPool);
+
+		if (!tree.IsIdentical(builtTree))
+		{
+			LogError("BIHBenchmark::CompareRefit", name, "Refit without changes did not give back the built tree !");
+		}
+	}
+
+	// Raise a hill over the middle of the mesh, like a terrain edit that moves vertices but keeps the triangles
+	Mesh deformed;
+	deformed.VertexData = mesh->VertexData;
+	deformed.Indices = mesh->Indices;
+
+	Vector3 center = mesh->Bounds.GetOrigin();
+	Vector3 extent = mesh->Bounds.GetExtent();
+	float radius = glm::max(glm::max(extent.x, extent.z) * 0.5f, 0.001f);
+	float height = glm::max(glm::max(extent.x, extent.z) * 0.1f, 0.001f);
+
+	for (VertexBufferEntry& vertex : deformed.VertexData)
+	{
+		float distance = glm::length(Vector2(vertex.Position.x - center.x, vertex.Position.z - center.z)) / radius;
+
+		if (distance < 1.0f)
+		{
+			vertex.Position.y += height * (1.0f - distance * distance);
+		}
+	}
+
+	deformed.UpdateBounds();
+
+	double refitStart = Time::getTime();
+	bool rebuilt = tree.Refit(deformed.VertexData, deformed.Indices, BIH_REFIT_REBUILD_RATIO, threadPool);
+	double refitTime = Time::getTime() - refitStart;
+
+	BIHTree rebuiltTree(&deformed, maxTrisPerNode, BIHLayout::Flat, BIHSplitMethod::SAH, threadPool);
+	double rebuildTime = rebuiltTree.GetBuildStats().BuildTime;
+
+	Log("BIHBenchmark::CompareRefit", name, "Refit: " + ToString(refitTime * 1000.0) + " ms" + (rebuilt ? " (rebuilt)" : "") + ", rebuild: " + ToString(rebuildTime * 1000.0) + " ms, speedup: " + ToString(rebuildTime / glm::max(refitTime, 1e-9)));
+
+	List<Ray> rays = GenerateRays(&deformed, rayCount);
+
+	BIHBenchmarkResult refitResult = MeasureRays(name + " [Refit]", &tree, &deformed, rays);
+	BIHBenchmarkResult rebuildResult = MeasureRays(name + " [Rebuild]", &rebuiltTree, &deformed, rays);
+
+	LogResult(refitResult);
+	LogResult(rebuildResult);
+
+	if (refitResult.HitCount != rebuildResult.HitCount)
+	{
+		LogError("BIHBenchmark::CompareRefit", name, "Refit tree returned different hit counts than the rebuilt one (" + ToString(refitResult.HitCount) + " vs " + ToString(rebuildResult.HitCount) + ") !");
+	}
+}
+
+void BIHBenchmark::CompareBoxBatch(const String& name, int boxCount, int rayCount, unsigned int seed)
+{
+	Random random(seed);
+
+	const float range = 100.0f;
+
+	BoxBatch batch;
+	batch.Reserve(boxCount);
+
+	for (int i = 0; i < boxCount; i++)
+	{
+		Vector3 origin = Vector3(random.GetFloat(-range, range), random.GetFloat(-range, range), random.GetFloat(-range, range));
+		Vector3 extent = Vector3(random.GetFloat(0.0f, 10.0f), random.GetFloat(0.0f, 10.0f), random.GetFloat(0.0f, 10.0f));
+
+		// Flat boxes, like the bounds of a plane
+		if (random.GetByPercent(10.0f))
+		{
+			extent[random.GetInt(0, 2)] = 0.0f;
+		}
+
+		batch.Add(Box(origin, extent));
+	}
+
+	List<Ray> rays;
+	rays.reserve(rayCount);
+
+	for (int i = 0; i < rayCount; i++)
+	{
+		Ray ray;
+
+		// Some rays start inside or on a box
+		if (boxCount > 0 && random.GetByPercent(10.0f))
+		{
+			Box box = batch.Get(random.GetInt(0, boxCount - 1));
+			ray.Origin = box.Origin + box.Extent * Vector3(random.GetInt(-1, 1), random.GetInt(-1, 1), random.GetInt(-1, 1));
+		}
+		else
+		{
+			ray.Origin = Vector3(random.GetFloat(-range, range), random.GetFloat(-range, range), random.GetFloat(-range, range)) * 1.5f;
+		}
+
+		ray.Direction = random.GetRandomUnitVector3();
+
+		// Axis parallel rays never cross the slabs of the zero axes
+		if (random.GetByPercent(20.0f))
+		{
+			ray.Direction[random.GetInt(0, 2)] = 0.0f;
+		}
+		if (random.GetByPercent(5.0f))
+		{
+			ray.Direction = Vector3();
+			ray.Direction[random.GetInt(0, 2)] = random.GetByPercent(50.0f) ? 1.0f : -1.0f;
+		}
+
+		if (random.GetByPercent(30.0f))
+		{
+			ray.Limit = random.GetFloat(0.0f, range);
+		}
+
+		rays.push_back(ray);
+	}
+
+	List<Box> boxes;
+	boxes.reserve(boxCount);
+
+	for (int i = 0; i < boxCount; i++)
+	{
+		boxes.push_back(batch.Get(i));
+	}
+
+	// One ray against every box
+	List<uint32> mask(BoxBatch::GetMaskSize(boxCount));
+	List<float> nears(boxCount);
+
+	int scalarHits = 0;
+	double scalarStart = Time::getTime();
+
+	for (const Ray& ray : rays)
+	{
+		for (const Box& box : boxes)
+		{
+			float tNear;
+			float tFar;
+
+			if (box.IntersectRay(ray, tNear, tFar) && tNear <= glm::min(tFar, ray.Limit))
+			{
+				scalarHits++;
+			}
+		}
+	}
+
+	double scalarTime = Time::getTime() - scalarStart;
+
+	int batchHits = 0;
+	double batchStart = Time::getTime();
+
+	for (const Ray& ray : rays)
+	{
+		batchHits += batch.IntersectRay(ray, mask.data(), nears.data());
+	}
+
+	double batchTime = Time::getTime() - batchStart;
+
+	Log("BIHBenchmark::CompareBoxBatch", name, ToString(rayCount) + " rays against " + ToString(boxCount) + " boxes, scalar: " + ToString(scalarTime * 1000.0) + " ms, batch: " + ToString(batchTime * 1000.0) + " ms, speedup: " + ToString(scalarTime / glm::max(batchTime, 1e-9)));
+
+	if (scalarHits != batchHits)
+	{
+		LogError("BIHBenchmark::CompareBoxBatch", name, "Batch returned different hit counts (" + ToString(scalarHits) + " vs " + ToString(batchHits) + ") !");
+	}
+
+	// Exact check, every ray against every box and every box against every ray
+	List<uint32> rayMask(BoxBatch::GetMaskSize(rayCount));
+	List<float> rayNears(rayCount);
+	List<float> rayFars(rayCount);
+
+	int mismatches = 0;
+
+	for (int r = 0; r < rayCount; r++)
+	{
+		batch.IntersectRay(rays[r], mask.data(), nears.data());
+
+		for (int b = 0; b < boxCount; b++)
+		{
+			float tNear;
+			float tFar;
+			bool hit = boxes[b].IntersectRay(rays[r], tNear, tFar) && tNear <= glm::min(tFar, rays[r].Limit);
+			bool batchHit = (mask[b / 32] & (1u << (b % 32))) != 0;
+
+			if (hit != batchHit || (hit && memcmp(&tNear, &nears[b], sizeof(float)) != 0))
+			{
+				mismatches++;
+			}
+		}
+	}
+
+	for (int b = 0; b < boxCount; b++)
+	{
+		BoxBatch::IntersectRays(boxes[b], rays.data(), rayCount, rayMask.data(), rayNears.data(), rayFars.data());
+
+		for (int r = 0; r < rayCount; r++)
+		{
+			float tNear;
+			float tFar;
+			bool hit = boxes[b].IntersectRay(rays[r], tNear, tFar) && tNear <= glm::min(tFar, rays[r].Limit);
+			bool batchHit = (rayMask[r / 32] & (1u << (r % 32))) != 0;
+
+			tFar = glm::min(tFar, rays[r].Limit);
+
+			if (hit != batchHit || (hit && (memcmp(&tNear, &rayNears[r], sizeof(float)) != 0 || memcmp(&tFar, &rayFars[r], sizeof(float)) != 0)))
+			{
+				mismatches++;
+			}
+		}
+	}
+
+	if (mismatches > 0)
+	{
+		LogError("BIHBenchmark::CompareBoxBatch", name, ToString(mismatches) + " ray box pairs differ from Box::IntersectRay !");
+	}
+}
+
+struct FBruteForceSweep
+{
+	// First distance at which the sphere touches the triangle
+	float Contact;
+
+	// First distance at which the sphere is deeper in the triangle than the sweep tolerance, sweeps have to report these
+	float Deep;
+};
+
+static float GetSphereGap(const Vector3& center, float radius, const Vector3& v1, const Vector3& v2, const Vector3& v3)
+{
+	Vector3 onSegment;
+	Vector3 onTriangle;
+
+	return glm::sqrt(Testing::ClosestPointsSegmentTriangle(center, center, v1, v2, v3, onSegment, onTriangle)) - radius;
+}
+
+// Moves the sphere in small steps over the part of the sweep that reaches the bounds of the triangle
+static FBruteForceSweep MarchSweep(const Ray& sweep, float radius, float maxDistance, float step, float tolerance, const Vector3& v1, const Vector3& v2, const Vector3& v3)
+{
+	FBruteForceSweep result = { FloatInf, FloatInf };
+
+	Vector3 reach = Vector3(radius + tolerance);
+	Box bounds = Box(0, glm::min(glm::min(v1, v2), v3) - reach, glm::max(glm::max(v1, v2), v3) + reach);
+
+	float tNear;
+	float tFar;
+
+	if (!bounds.IntersectRay(sweep, tNear, tFar) || tNear > maxDistance)
+	{
+		return result;
+	}
+
+	tFar = glm::min(tFar, maxDistance);
+
+	float previous = tNear;
+
+	for (float t = tNear; ; t = glm::min(t + step, tFar))
+	{
+		float gap = GetSphereGap(sweep.Origin + sweep.Direction * t, radius, v1, v2, v3);
+
+		if (result.Contact == FloatInf && gap <= 0.0f)
+		{
+			// Halve the last step until the contact is found to float precision
+			float lower = previous;
+			float upper = t;
+
+			for (int i = 0; i < 32 && t > tNear; i++)
+			{
+				float middle = (lower + upper) * 0.5f;
+
+				if (GetSphereGap(sweep.Origin + sweep.Direction * middle, radius, v1, v2, v3) <= 0.0f)
+				{
+					upper = middle;
+				}
+				else
+				{
+					lower = middle;
+				}
+			}
+
+			result.Contact = upper;
+		}
+
+		if (gap <= -tolerance)
+		{
+			result.Deep = t;
+			break;
+		}
+
+		if (t >= tFar)
+		{
+			break;
+		}
+
+		previous = t;
+	}
+
+	return result;
+}
+
+void BIHBenchmark::CompareSweeps(const String& name, Mesh* mesh, int sweepCount, int maxTrisPerNode)
+{
+	mesh->UpdateBounds();
+
+	List<Ray> sweeps = GenerateRays(mesh, sweepCount);
+
+	BIHTree tree(mesh, maxTrisPerNode, BIHLayout::Flat, BIHSplitMethod::SAH);
+
+	Matrix4 worldMatrix = Matrix4();
+	Matrix4 worldToLocal = glm::inverse(worldMatrix);
+
+	// The sweeps start outside the bounds, far enough to pass through the whole mesh
+	float size = glm::max(glm::length(mesh->Bounds.GetExtent()), 0.001f);
+	float radius = size * 0.02f;
+	float maxDistance = size * 4.0f;
+
+	float tolerance = radius * BIH_SWEEP_TOLERANCE;
+	float step = radius * 0.02f;
+	float slack = tolerance + size * 1e-5f;
+
+	int triangleCount = (int)mesh->Indices.size() / 3;
+
+	List<FBruteForceSweep> expected(triangleCount);
+	List<bool> reported(triangleCount);
+
+	CollisionResults allResults;
+	CollisionResults closestResults;
+
+	double treeTime = 0.0;
+	double bruteForceTime = 0.0;
+
+	int hits = 0;
+	int mismatches = 0;
+
+	for (const Ray& sweep : sweeps)
+	{
+		allResults.Clear();
+		closestResults.Clear();
+
+		double treeStart = Time::getTime();
+
+		hits += tree.SweepSphere(sweep.Origin, radius, sweep.Direction, maxDistance, worldMatrix, worldToLocal, allResults, BIHQueryMode::AllHits);
+		tree.SweepSphere(sweep.Origin, radius, sweep.Direction, maxDistance, worldMatrix, worldToLocal, closestResults, BIHQueryMode::ClosestHit);
+
+		treeTime += Time::getTime() - treeStart;
+
+		double bruteForceStart = Time::getTime();
+
+		float closestContact = FloatInf;
+		float closestDeep = FloatInf;
+
+		for (int i = 0; i < triangleCount; i++)
+		{
+			const Vector3& v1 = mesh->VertexData[mesh->Indices[i * 3]].Position;
+			const Vector3& v2 = mesh->VertexData[mesh->Indices[i * 3 + 1]].Position;
+			const Vector3& v3 = mesh->VertexData[mesh->Indices[i * 3 + 2]].Position;
+
+			expected[i] = MarchSweep(sweep, radius, maxDistance, step, tolerance, v1, v2, v3);
+			reported[i] = false;
+
+			closestContact = glm::min(closestContact, expected[i].Contact);
+			closestDeep = glm::min(closestDeep, expected[i].Deep);
+		}
+
+		bruteForceTime += Time::getTime() - bruteForceStart;
+
+		// A contact has to touch its triangle, without passing through the triangle before
+		auto checkContact = [&](const CollisionResult& contact, float firstContact)
+		{
+			int i = contact.TriangleIndex;
+
+			const Vector3& v1 = mesh->VertexData[mesh->Indices[i * 3]].Position;
+			const Vector3& v2 = mesh->VertexData[mesh->Indices[i * 3 + 1]].Position;
+			const Vector3& v3 = mesh->VertexData[mesh->Indices[i * 3 + 2]].Position;
+
+			float gap = GetSphereGap(sweep.Origin + sweep.Direction * contact.Distance, radius, v1, v2, v3);
+
+			return gap <= tolerance + slack && contact.Distance <= firstContact + slack;
+		};
+
+		for (int k = 0; k < allResults.Size(); k++)
+		{
+			CollisionResult contact = allResults.GetCollisonDirect(k);
+			reported[contact.TriangleIndex] = true;
+
+			if (!checkContact(contact, expected[contact.TriangleIndex].Contact))
+			{
+				mismatches++;
+			}
+		}
+
+		for (int i = 0; i < triangleCount; i++)
+		{
+			if (!reported[i] && expected[i].Deep <= maxDistance)
+			{
+				mismatches++;
+			}
+		}
+
+		if (closestResults.Size() > 0)
+		{
+			if (!checkContact(closestResults.GetCollisonDirect(0), closestContact))
+			{
+				mismatches++;
+			}
+		}
+		else if (closestDeep <= maxDistance)
+		{
+			mismatches++;
+		}
+	}
+
+	Log("BIHBenchmark::CompareSweeps", name, ToString(sweepCount) + " sweeps, " + ToString(hits) + " hits, tree: " + ToString(treeTime * 1000.0) + " ms, brute force: " + ToString(bruteForceTime * 1000.0) + " ms");
+
+	if (mismatches > 0)
+	{
+		LogError("BIHBenchmark::CompareSweeps", name, ToString(mismatches) + " sweep contacts differ from the brute force march !");
+	}
+}
+
+void BIHBenchmark::CreateTerrain(Mesh& mesh, int quadsPerSide, float cellSize, unsigned int seed)
+{
+	Random random(seed);
+
+	// A few random waves give hills of different size in every direction
+	const int waveCount = 4;
+	Vector3 waves[waveCount];
+
+	for (int i = 0; i < waveCount; i++)
+	{
+		waves[i] = Vector3(random.GetFloat(0.01f, 0.2f), random.GetFloat(0.01f, 0.2f), random.GetFloat(0.5f, 4.0f) * cellSize);
+	}
+
+	int verticesPerSide = quadsPerSide + 1;
+
+	mesh.VertexData.clear();
+	mesh.Indices.clear();
+
+	mesh.VertexData.reserve(verticesPerSide * verticesPerSide);
+	mesh.Indices.reserve(quadsPerSide * quadsPerSide * 6);
+
+	for (int z = 0; z < verticesPerSide; z++)
+	{
+		for (int x = 0; x < verticesPerSide; x++)
+		{
+			float height = 0.0f;
+
+			for (int i = 0; i < waveCount; i++)
+			{
+				height += glm::sin(x * waves[i].x) * glm::cos(z * waves[i].y) * waves[i].z;
+			}
+
+			VertexBufferEntry vertex = {};
+			vertex.Position = Vector3(x * cellSize, height, z * cellSize);
+
+			mesh.VertexData.push_back(vertex);
+		}
+	}
+
+	for (int z = 0; z < quadsPerSide; z++)
+	{
+		for (int x = 0; x < quadsPerSide; x++)
+		{
+			uint32 a = z * verticesPerSide + x;
+			uint32 b = a + 1;
+			uint32 c = a + verticesPerSide;
+			uint32 d = c + 1;
+
+			mesh.Indices.push_back(a);
+			mesh.Indices.push_back(c);
+			mesh.Indices.push_back(b);
+
+			mesh.Indices.push_back(b);
+			mesh.Indices.push_back(c);
+			mesh.Indices.push_back(d);
+		}
+	}
+
+	mesh.UpdateBounds();
+}
+
+void BIHBenchmark::ComparePackets(const String& name, Mesh* mesh, int rayCount, int maxTrisPerNode)
+{
+	mesh->UpdateBounds();
+
+	List<Ray> rays = GenerateRayPackets(mesh, rayCount);
+
+	BIHTree tree(mesh, maxTrisPerNode, BIHLayout::Flat, BIHSplitMethod::SAH);
+
+	BIHQueryMode::Enum modes[] = { BIHQueryMode::AllHits, BIHQueryMode::ClosestHit };
+
+	for (BIHQueryMode::Enum mode : modes)
+	{
+		String modeName = mode == BIHQueryMode::ClosestHit ? ", Closest" : "";
+
+		List<CollisionResults> scalarResults(rays.size());
+		List<CollisionResults> packetResults(rays.size());
+
+		BIHBenchmarkResult scalarResult = MeasureRayBatch(name + " [Scalar" + modeName + "]", &tree, mesh, rays, scalarResults, mode, false);
+		BIHBenchmarkResult packetResult = MeasureRayBatch(name + " [Packet" + modeName + "]", &tree, mesh, rays, packetResults, mode, true);
+
+		LogResult(scalarResult);
+		LogResult(packetResult);
+
+		Log("BIHBenchmark::ComparePackets", name, "Packet speedup: " + ToString(packetResult.RaysPerSecond / glm::max(scalarResult.RaysPerSecond, 1.0)));
+
+		for (size_t i = 0; i < rays.size(); i++)
+		{
+			CollisionResults& scalar = scalarResults[i];
+			CollisionResults& packet = packetResults[i];
+
+			bool same = scalar.Size() == packet.Size();
+
+			for (int k = 0; same && k < scalar.Size(); k++)
+			{
+				CollisionResult a = scalar.GetCollisonDirect(k);
+				CollisionResult b = packet.GetCollisonDirect(k);
+
+				same = a.TriangleIndex == b.TriangleIndex && memcmp(&a.Distance, &b.Distance, sizeof(float)) == 0;
+			}
+
+			if (!same)
+			{
+				LogError("BIHBenchmark::ComparePackets", name, "Packet hits of ray " + ToString((int)i) + " differ from the scalar hits !");
+				break;
+			}
+		}
+	}
+}
+
+List<Ray> BIHBenchmark::GenerateRays(Mesh* mesh, int rayCount, unsigned int seed)
+{
+	Random random(seed);
+
+	Vector3 center = mesh->Bounds.GetOrigin();
+	Vector3 extent = mesh->Bounds.GetExtent();
+	float radius = glm::max(glm::length(extent) * 2.0f, 0.001f);
+
+	List<Ray> rays;
+	rays.reserve(rayCount);
+
+	for (int i = 0; i < rayCount; i++)
+	{
+		Vector3 origin = center + random.GetRandomUnitVector3() * radius;
+		Vector3 target = center + Vector3(random.GetFloat(-1.0f, 1.0f), random.GetFloat(-1.0f, 1.0f), random.GetFloat(-1.0f, 1.0f)) * extent;
+
+		rays.emplace_back(origin, glm::normalize(target - origin));
+	}
+
+	return rays;
+}
+
+List<Ray> BIHBenchmark::GenerateRayPackets(Mesh* mesh, int rayCount, float spread, unsigned int seed)
+{
+	Random random(seed);
+
+	Vector3 center = mesh->Bounds.GetOrigin();
+	Vector3 extent = mesh->Bounds.GetExtent();
+	float radius = glm::max(glm::length(extent) * 2.0f, 0.001f);
+
+	List<Ray> rays;
+	rays.reserve(rayCount);
+
+	while ((int)rays.size() < rayCount)
+	{
+		Vector3 origin = center + random.GetRandomUnitVector3() * radius;
+		Vector3 target = center + Vector3(random.GetFloat(-1.0f, 1.0f), random.GetFloat(-1.0f, 1.0f), random.GetFloat(-1.0f, 1.0f)) * extent;
+
+		for (int i = 0; i < BIH_PACKET_SIZE && (int)rays.size() < rayCount; i++)
+		{
+			Vector3 offset = Vector3(random.GetFloat(-spread, spread), random.GetFloat(-spread, spread), random.GetFloat(-spread, spread)) * radius;
+
+			rays.emplace_back(origin, glm::normalize(target + offset - origin));
+		}
+	}
+
+	return rays;
+}
+
+BIHBenchmarkResult BIHBenchmark::MeasureRays(const String& name, BIHTree* tree, Mesh* mesh, const List<Ray>& rays, BIHQueryMode::Enum mode)
+{
+	Matrix4 worldMatrix = Matrix4();
+	Matrix4 worldToLocal = glm::inverse(worldMatrix);
+	Box worldBound = mesh->Bounds;
+
+	CollisionResults results;
+
+	BIHBenchmarkResult result = {};
+	result.Name = name;
+	result.RayCount = (int)rays.size();
+
+	double start = Time::getTime();
+
+	for (const Ray& ray : rays)
+	{
+		results.Clear();
+
+		result.HitCount += tree->CollideWithRay(ray, worldMatrix, worldToLocal, &worldBound, results, mode);
+	}
+
+	result.Seconds = Time::getTime() - start;
+	result.RaysPerSecond = result.Seconds > 0.0 ? result.RayCount / result.Seconds : 0.0;
+
+	return result;
+}
+
+BIHBenchmarkResult BIHBenchmark::MeasureRayBatch(const String& name, BIHTree* tree, Mesh* mesh, const List<Ray>& rays, List<CollisionResults>& results, BIHQueryMode::Enum mode, bool packets)
+{
+	Matrix4 worldMatrix = Matrix4();
+	Matrix4 worldToLocal = glm::inverse(worldMatrix);
+	Box worldBound = mesh->Bounds;
+
+	for (CollisionResults& res : results)
+	{
+		res.Clear();
+	}
+
+	BIHBenchmarkResult result = {};
+	result.Name = name;
+	result.RayCount = (int)rays.size();
+
+	double start = Time::getTime();
+
+	if (packets)
+	{
+		result.HitCount = tree->CollideWithRayPacket(rays.data(), (int)rays.size(), worldMatrix, worldToLocal, &worldBound, results.data(), mode);
+	}
+	else
+	{
+		for (size_t i = 0; i < rays.size(); i++)
+		{
+			result.HitCount += tree->CollideWithRay(rays[i], worldMatrix, worldToLocal, &worldBound, results[i], mode);
+		}
+	}
+
+	result.Seconds = Time::getTime() - start;
+	result.RaysPerSecond = result.Seconds > 0.0 ? result.RayCount / result.Seconds : 0.0;
+
+	return result;
+}
+
+void BIHBenchmark::LogResult(const BIHBenchmarkResult& result)
+{
+	Log("BIHBenchmark", result.Name, ToString(result.RayCount) + " rays, " + ToString(result.HitCount) + " hits, " + ToString(result.Seconds * 1000.0) + " ms, " + ToString((int64)result.RaysPerSecond) + " rays/s");
+}
\ No newline at end of file
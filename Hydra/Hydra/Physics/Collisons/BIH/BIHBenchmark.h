@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Hydra/Core/Common.h"
+#include "Hydra/Core/Vector.h"
+#include "Hydra/Physics/Collisons/Ray.h"
+#include "Hydra/Physics/Collisons/BIH/BIHNode.h"
+
+class Mesh;
+class BIHTree;
+class ThreadPool;
+
+struct BIHBenchmarkResult
+{
+	String Name;
+	int RayCount;
+	int HitCount;
+	double Seconds;
+	double RaysPerSecond;
+};
+
+// Micro benchmarks for the BIH collider, results are written to the log
+class HYDRA_API BIHBenchmark
+{
+public:
+	// Builds the collider of the mesh in both layouts and casts the same rays against each, also measures closest hit queries
+	static void CompareLayouts(const String& name, Mesh* mesh, int rayCount, int maxTrisPerNode = 21);
+
+	// Builds the collider with the centre split and the SAH split and logs build cost against query speed
+	static void CompareSplitMethods(const String& name, Mesh* mesh, int rayCount, int maxTrisPerNode = 21);
+
+	// Casts the same coherent ray bundles one by one and as packets, logs both and checks that the hits match exactly
+	static void ComparePackets(const String& name, Mesh* mesh, int rayCount, int maxTrisPerNode = 21);
+
+	// Builds the collider of both layouts serially and on the thread pool, logs the build speedup and checks that the trees are identical
+	static void CompareParallelBuild(const String& name, Mesh* mesh, ThreadPool* threadPool, int maxTrisPerNode = 21);
+
+	// Refits the collider to a raised part of the mesh and rebuilds it from scratch, logs both times and checks
+	// that both trees return the same hits. Also checks that a refit without changes gives back the built tree.
+	static void CompareRefit(const String& name, Mesh* mesh, int rayCount, ThreadPool* threadPool = nullptr, int maxTrisPerNode = 21);
+
+	// Clips rays against a batch of boxes with the SSE kernels of BoxBatch and with Box::IntersectRay, logs both
+	// and checks that hits and distances match exactly. Axis parallel rays, rays starting inside and flat boxes are included.
+	static void CompareBoxBatch(const String& name, int boxCount, int rayCount, unsigned int seed = 1337);
+
+	// Sweeps spheres through the mesh in both query modes and checks every contact against a brute force march of
+	// the sphere over all triangles. A contact has to touch its triangle and come before any contact the march finds,
+	// and every triangle the sphere would sink into has to be reported.
+	static void CompareSweeps(const String& name, Mesh* mesh, int sweepCount, int maxTrisPerNode = 21);
+
+	// Rolling height field of quadsPerSide * quadsPerSide quads with two triangles each, like a terrain patch
+	static void CreateTerrain(Mesh& mesh, int quadsPerSide, float cellSize = 1.0f, unsigned int seed = 1337);
+
+	// Deterministic set of rays shot from around the mesh bounds towards its inside
+	static List<Ray> GenerateRays(Mesh* mesh, int rayCount, unsigned int seed = 1337);
+
+	// Groups of BIH_PACKET_SIZE rays from one origin towards close targets, like a sensor cone
+	static List<Ray> GenerateRayPackets(Mesh* mesh, int rayCount, float spread = 0.02f, unsigned int seed = 1337);
+
+	static BIHBenchmarkResult MeasureRays(const String& name, BIHTree* tree, Mesh* mesh, const List<Ray>& rays, BIHQueryMode::Enum mode = BIHQueryMode::AllHits);
+
+	// Keeps the results of every ray, with packets the rays go through CollideWithRayPacket
+	static BIHBenchmarkResult MeasureRayBatch(const String& name, BIHTree* tree, Mesh* mesh, const List<Ray>& rays, List<CollisionResults>& results, BIHQueryMode::Enum mode, bool packets);
+
+	static void LogResult(const BIHBenchmarkResult& result);
+};
\ No newline at end of file
@@ -1,14 +1,17 @@
 #include "Hydra/Physics/Collisons/BIH/BIHNode.h"
 #include "Hydra/Physics/Collisons/BIH/BIHTree.h"
 
-#include "Hydra/Core/Math/Triangle.h"
-
 struct BIHStackData
 {
 	BIHNode* Node;
 	float Min;
 	float Max;
 
+	inline BIHStackData()
+	{
+
+	}
+
 	inline BIHStackData(BIHNode* node, float min, float max) : Node(node), Min(min), Max(max)
 	{
 
@@ -78,58 +81,27 @@ void BIHNode::SetRightPlane(float rightPlane)
 	RightPlane = rightPlane;
 }
 
-int BIHNode::IntersectWhere(const Ray & rr, const Matrix4 & worldMatrix, BIHTree* tree, float sceneMin, float sceneMax, CollisionResults & results)
+int BIHNode::IntersectWhere(BIHRayTraversal& traversal, BIHTree* tree, float sceneMin, float sceneMax)
 {
-	List<BIHStackData> stack;
-
-	Ray ray(rr);
-
-	Vector3 o = ray.Origin;
-	Vector3 d = ray.Direction;
-
-	Matrix4 inv = glm::inverse(worldMatrix);
-	//Quaternion rotation = glm::toQuat(inv);
-
-	Vector4 invOrigin = inv * Vector4(ray.Origin, 1.0f);
-	Vector4 invDir = inv * Vector4(ray.Direction, 1.0f);
-
-	ray.Origin = Vector3(invOrigin.x, invOrigin.y, invOrigin.z) / invOrigin.w;
-	ray.Direction = Vector3(invDir.x, invDir.y, invDir.z) / invDir.w;
+	BIHStackData stack[BIH_TRAVERSAL_STACK_SIZE];
+	int stackSize = 0;
 
-	ray.Direction = glm::normalize(ray.Direction);
+	const float* origins = traversal.Origins;
+	const float* invDirections = traversal.InvDirections;
 
-	float origins[3] = {
-		ray.Origin.x,
-		ray.Origin.y,
-		ray.Origin.z
-	};
-
-	float invDirections[3] = {
-		1.0f / ray.Direction.x,
-		1.0f / ray.Direction.y,
-		1.0f / ray.Direction.z
-	};
-
-	Vector3 v1;
-	Vector3 v2;
-	Vector3 v3;
-	int cols = 0;
-
-	stack.push_back(BIHStackData(this, sceneMin, sceneMax));
+	stack[stackSize++] = BIHStackData(this, sceneMin, sceneMax);
 
 stackloop:
-	while (stack.size() > 0)
+	while (stackSize > 0)
 	{
-		BIHStackData data = stack[stack.size() - 1];
-		stack.erase(stack.begin() + stack.size() - 1);
+		BIHStackData& data = stack[--stackSize];
 		BIHNode* node = data.Node;
-		float tMin = data.Min, tMax = data.Max;
+		float tMin = data.Min, tMax = glm::min(data.Max, traversal.Closest);
 		if (tMax < tMin)
 		{
 			continue;
 		}
 
-	leafloop:
 		while (node->Axis != 3)
 		{
 			int a = node->Axis;
@@ -175,48 +147,17 @@ stackloop:
 			}
 			else
 			{
-				stack.push_back(BIHStackData(farNode, glm::max(tMin, tFarSplit), tMax));
+				assertCheck(stackSize < BIH_TRAVERSAL_STACK_SIZE);
+
+				stack[stackSize++] = BIHStackData(farNode, glm::max(tMin, tFarSplit), tMax);
 				tMax = glm::min(tMax, tNearSplit);
 				node = nearNode;
 			}
 		}
 
 		// a leaf
-		for (int i = node->LeftIndex; i <= node->RightIndex; i++)
-		{
-			tree->GetTriangle(i, v1, v2, v3);
-
-			float t = 0;
-			if (ray.IntersectWithTriangle(v1, v2, v3, t))
-			{
-				if (true)
-				{
-					v1 = worldMatrix * glm::vec4(v1, 1.0f);
-					v2 = worldMatrix * glm::vec4(v2, 1.0f);
-					v3 = worldMatrix * glm::vec4(v3, 1.0f);
-
-					float t_world = 0;
-
-					if (!(new Ray(o, d))->IntersectWithTriangle(v1, v2, v3, t_world))
-					{
-						continue;
-					}
-					t = t_world;
-				}
-				Vector3 contactNormal = Triangle::ComputeTriangleNormal(v1, v2, v3);
-				Vector3 contactPoint = (Vector3(d) * t) + o;
-
-				CollisionResult res;
-				res.IsNull = false;
-				res.ContactNormal = contactNormal;
-				res.ContactPoint = contactPoint;
-				res.Distance = glm::distance(o, contactPoint);
-				res.TriangleIndex = tree->GetTriangleIndex(i);
-				results.AddCollision(res);
-				cols++;
-			}
-		}
+		tree->IntersectLeaf(traversal, node->LeftIndex, node->RightIndex);
 	}
-	stack.clear();
-	return cols;
+
+	return traversal.Hits;
 }
\ No newline at end of file
@@ -1,10 +1,47 @@
 #pragma once
 
+#include "Hydra/Core/Common.h"
 #include "Hydra/Physics/Collisons/Ray.h"
 #include "Hydra/Physics/Collisons/CollisionResults.h"
 
 class BIHTree;
 
+constexpr int BIH_MAX_TREE_DEPTH = 100;
+
+// One entry per tree level is enough, so the traversal stack can live on the call stack
+constexpr int BIH_TRAVERSAL_STACK_SIZE = BIH_MAX_TREE_DEPTH + 4;
+
+struct BIHQueryMode
+{
+	enum Enum
+	{
+		// Every intersection is added to the results
+		AllHits,
+		// Only the nearest intersection is added, the search range shrinks with every hit
+		ClosestHit
+	};
+};
+
+// State of one ray query, prepared once before the tree is walked
+struct BIHRayTraversal
+{
+	// Ray in the local space of the tree. The direction is not normalized so a distance
+	// along it is the same as the distance along the world ray.
+	Ray LocalRay;
+	float Origins[3];
+	float InvDirections[3];
+
+	const Ray* WorldRay;
+	const Matrix4* WorldMatrix;
+
+	BIHQueryMode::Enum Mode;
+	float Closest;
+	int ClosestTriangle;
+
+	int Hits;
+	CollisionResults* Results;
+};
+
 class HYDRA_API BIHNode
 {
 public:
@@ -29,5 +66,59 @@ public:
 	float GetRightPlane();
 	void SetRightPlane(float rightPlane);
 
-	int IntersectWhere(const Ray& r, const Matrix4& worldMatrix, BIHTree* tree, float sceneMin, float sceneMax, CollisionResults &results);
-};
\ No newline at end of file
+	int IntersectWhere(BIHRayTraversal& traversal, BIHTree* tree, float sceneMin, float sceneMax);
+};
+
+constexpr uint32 BIH_FLAT_LEAF_AXIS = 3;
+
+// Compact node of the flat layout. Nodes are stored depth first, so the left child
+// of an inner node is always the next node in the array and only the right child
+// index has to be stored. Leaves reuse the plane slots for their triangle range.
+struct BIHFlatNode
+{
+	union
+	{
+		float LeftPlane;
+		int32 LeftIndex;
+	};
+
+	union
+	{
+		float RightPlane;
+		int32 RightIndex;
+	};
+
+	// Bits 0-1: axis (BIH_FLAT_LEAF_AXIS for leaves), bits 2-31: index of the right child
+	uint32 AxisAndRightChild;
+
+	FORCEINLINE uint32 GetAxis() const
+	{
+		return AxisAndRightChild & 3;
+	}
+
+	FORCEINLINE uint32 GetRightChild() const
+	{
+		return AxisAndRightChild >> 2;
+	}
+
+	FORCEINLINE bool IsLeaf() const
+	{
+		return GetAxis() == BIH_FLAT_LEAF_AXIS;
+	}
+
+	FORCEINLINE void SetLeaf(int l, int r)
+	{
+		LeftIndex = l;
+		RightIndex = r;
+		AxisAndRightChild = BIH_FLAT_LEAF_AXIS;
+	}
+
+	FORCEINLINE void SetInner(uint32 axis, float leftPlane, float rightPlane, uint32 rightChild)
+	{
+		LeftPlane = leftPlane;
+		RightPlane = rightPlane;
+		AxisAndRightChild = (rightChild << 2) | axis;
+	}
+};
+
+static_assert(sizeof(BIHFlatNode) == 12, "BIHFlatNode is expected to be 12 bytes.");
\ No newline at end of file
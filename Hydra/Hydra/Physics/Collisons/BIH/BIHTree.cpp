@@ -3,199 +3,2065 @@
 
 #include "Hydra/Render/Mesh.h"
 #include "Hydra/Core/Math/Box.h"
+#include "Hydra/Core/Math/BoxBatch.h"
+#include "Hydra/Core/Math/Triangle.h"
+#include "Hydra/Physics/Collisons/Testing.h"
+#include "Hydra/Core/Timing.h"
+#include "Hydra/Core/ThreadPool.h"
+#include "Hydra/Core/File.h"
+#include "Hydra/Core/Stream/FileStream.h"
+#include "Hydra/Core/Hash.h"
 
-BIHTree::BIHTree(Mesh * mesh, int maxTrisPerNode) : _MaxTrisPerNode(maxTrisPerNode)
+#include <cfloat>
+#include <cstring>
+#include <xmmintrin.h>
+
+struct BIHFlatStackData
+{
+	int Node;
+	float Min;
+	float Max;
+
+	inline BIHFlatStackData()
+	{
+
+	}
+
+	inline BIHFlatStackData(int node, float min, float max) : Node(node), Min(min), Max(max)
+	{
+
+	}
+};
+
+struct BIHPacketRays
+{
+	BIHRayTraversal* Traversals;
+
+	__m128 Origins[3];
+	__m128 Directions[3];
+	__m128 InvDirections[3];
+
+	// Direction sign shared by all active rays on each axis
+	bool Negative[3];
+
+	__m128 Closest;
+};
+
+struct BIHPacketStackData
+{
+	__m128 Min;
+	__m128 Max;
+	int Node;
+	int Mask;
+
+	inline BIHPacketStackData()
+	{
+
+	}
+
+	inline BIHPacketStackData(int node, int mask, __m128 min, __m128 max) : Min(min), Max(max), Node(node), Mask(mask)
+	{
+
+	}
+};
+
+BIHTree::BIHTree(Mesh * mesh, int maxTrisPerNode, BIHLayout::Enum layout, BIHSplitMethod::Enum splitMethod, ThreadPool* threadPool) : _MaxTrisPerNode(maxTrisPerNode), _Layout(layout), _SplitMethod(splitMethod), _BuildStats(), _BuildCost(-1.0f), _BuildPool(threadPool), _Root(nullptr)
+{
+	InitTriangles(mesh->VertexData, mesh->Indices);
+	ConstructRootNode();
+}
+
+BIHTree::BIHTree(Mesh * mesh) : _MaxTrisPerNode(MAX_TRIS_PER_NODE), _Layout(BIHLayout::Pointer), _SplitMethod(BIHSplitMethod::Centre), _BuildStats(), _BuildCost(-1.0f), _BuildPool(nullptr), _Root(nullptr)
+{
+	InitTriangles(mesh->VertexData, mesh->Indices);
+	ConstructRootNode();
+}
+
+BIHTree::BIHTree(const List<VertexBufferEntry>& vertices, const List<uint32>& indices, int maxTrisPerNode, BIHLayout::Enum layout, BIHSplitMethod::Enum splitMethod, ThreadPool* threadPool) : _MaxTrisPerNode(maxTrisPerNode), _Layout(layout), _SplitMethod(splitMethod), _BuildStats(), _BuildCost(-1.0f), _BuildPool(threadPool), _Root(nullptr)
 {
-	InitTriangles(mesh);
+	InitTriangles(vertices, indices);
 	ConstructRootNode();
 }
 
-BIHTree::BIHTree(Mesh * mesh) : _MaxTrisPerNode(MAX_TRIS_PER_NODE)
-{
-	InitTriangles(mesh);
-	ConstructRootNode();
+BIHTree::BIHTree() : _MaxTrisPerNode(MAX_TRIS_PER_NODE), _Layout(BIHLayout::Flat), _SplitMethod(BIHSplitMethod::Centre), _BuildStats(), _BuildCost(-1.0f), _NumTris(0), _NumPointData(0), _NumTriIndices(0), _PointData(nullptr), _TriIndices(nullptr), _BuildPool(nullptr), _Root(nullptr)
+{
+}
+
+BIHTree::~BIHTree()
+{
+	delete[] _PointData;
+	delete[] _TriIndices;
+
+	delete _Root;
+}
+
+void BIHTree::GetTriangle(int index, Vector3 & v1, Vector3 & v2, Vector3 & v3)
+{
+	int pointIndex = index * 9;
+
+	v1.x = _PointData[pointIndex++];
+	v1.y = _PointData[pointIndex++];
+	v1.z = _PointData[pointIndex++];
+
+	v2.x = _PointData[pointIndex++];
+	v2.y = _PointData[pointIndex++];
+	v2.z = _PointData[pointIndex++];
+
+	v3.x = _PointData[pointIndex++];
+	v3.y = _PointData[pointIndex++];
+	v3.z = _PointData[pointIndex++];
+}
+
+int BIHTree::GetTriangleIndex(int triIndex)
+{
+	return _TriIndices[triIndex];
+}
+
+BIHLayout::Enum BIHTree::GetLayout() const
+{
+	return _Layout;
+}
+
+BIHSplitMethod::Enum BIHTree::GetSplitMethod() const
+{
+	return _SplitMethod;
+}
+
+int BIHTree::GetNodeCount() const
+{
+	return _BuildStats.NodeCount;
+}
+
+const BIHBuildStats& BIHTree::GetBuildStats() const
+{
+	return _BuildStats;
+}
+
+static bool IsSameNode(const BIHNode* a, const BIHNode* b)
+{
+	if (a == nullptr || b == nullptr)
+	{
+		return a == b;
+	}
+
+	if (a->Axis != b->Axis)
+	{
+		return false;
+	}
+
+	if (a->Axis == 3)
+	{
+		return a->LeftIndex == b->LeftIndex && a->RightIndex == b->RightIndex;
+	}
+
+	return memcmp(&a->LeftPlane, &b->LeftPlane, sizeof(float)) == 0 && memcmp(&a->RightPlane, &b->RightPlane, sizeof(float)) == 0 &&
+		IsSameNode(a->Left, b->Left) && IsSameNode(a->Right, b->Right);
+}
+
+bool BIHTree::IsIdentical(const BIHTree& other) const
+{
+	if (_Layout != other._Layout || _NumTris != other._NumTris || _FlatNodes.size() != other._FlatNodes.size())
+	{
+		return false;
+	}
+
+	if (memcmp(_TriIndices, other._TriIndices, sizeof(int) * _NumTriIndices) != 0 || memcmp(_PointData, other._PointData, sizeof(float) * _NumPointData) != 0)
+	{
+		return false;
+	}
+
+	if (_Layout == BIHLayout::Flat)
+	{
+		return _FlatNodes.empty() || memcmp(_FlatNodes.data(), other._FlatNodes.data(), sizeof(BIHFlatNode) * _FlatNodes.size()) == 0;
+	}
+
+	return IsSameNode(_Root, other._Root);
+}
+
+// 'HBIH' read as a little endian uint32
+constexpr uint32 BIH_FILE_MAGIC = 0x48494248;
+
+struct BIHFileHeader
+{
+	uint32 Magic;
+	uint32 Version;
+	uint64 SourceHash;
+
+	int32 MaxTrisPerNode;
+	int32 Layout;
+	int32 SplitMethod;
+
+	int32 NumTris;
+	int32 NodeCount;
+
+	int32 Depth;
+	int32 LeafCount;
+	float AverageLeafSize;
+};
+
+uint64 BIHTree::GetSourceHash(const List<VertexBufferEntry>& vertices, const List<uint32>& indices, int maxTrisPerNode, BIHLayout::Enum layout, BIHSplitMethod::Enum splitMethod)
+{
+	uint64 hash = HASH_SEED;
+
+	// Only the positions end up in the tree, normals or uvs may change without a rebuild
+	for (const VertexBufferEntry& vertex : vertices)
+	{
+		hash = HashBytes(hash, &vertex.Position, sizeof(Vector3));
+	}
+
+	if (!indices.empty())
+	{
+		hash = HashBytes(hash, indices.data(), sizeof(uint32) * indices.size());
+	}
+
+	int32 settings[] = { (int32)vertices.size(), (int32)indices.size(), maxTrisPerNode, (int32)layout, (int32)splitMethod };
+
+	return HashBytes(hash, settings, sizeof(settings));
+}
+
+bool BIHTree::Save(const File& file, uint64 sourceHash) const
+{
+	if (_Layout != BIHLayout::Flat)
+	{
+		Log("BIHTree::Save", file.GetPath(), "Only flat trees can be saved.");
+		return false;
+	}
+
+	BIHFileHeader header = {};
+	header.Magic = BIH_FILE_MAGIC;
+	header.Version = BIH_FILE_VERSION;
+	header.SourceHash = sourceHash;
+	header.MaxTrisPerNode = _MaxTrisPerNode;
+	header.Layout = (int32)_Layout;
+	header.SplitMethod = (int32)_SplitMethod;
+	header.NumTris = _NumTris;
+	header.NodeCount = (int32)_FlatNodes.size();
+	header.Depth = _BuildStats.Depth;
+	header.LeafCount = _BuildStats.LeafCount;
+	header.AverageLeafSize = _BuildStats.AverageLeafSize;
+
+	size_t pointDataSize = sizeof(float) * _NumPointData;
+	size_t triIndicesSize = sizeof(int) * _NumTriIndices;
+	size_t nodesSize = sizeof(BIHFlatNode) * _FlatNodes.size();
+
+	// Same layout Load reads back
+	List<char> data(sizeof(BIHFileHeader) + pointDataSize + triIndicesSize + nodesSize);
+	char* target = data.data();
+
+	memcpy(target, &header, sizeof(BIHFileHeader));
+	target += sizeof(BIHFileHeader);
+
+	memcpy(target, _PointData, pointDataSize);
+	target += pointDataSize;
+
+	memcpy(target, _TriIndices, triIndicesSize);
+	target += triIndicesSize;
+
+	memcpy(target, _FlatNodes.data(), nodesSize);
+
+	FileStream stream = FileStream(file);
+
+	if (!stream.Write(data.data(), data.size()))
+	{
+		Log("BIHTree::Save", file.GetPath(), "Could not write the file.");
+		return false;
+	}
+
+	return true;
+}
+
+// Every node and triangle index of a loaded file must stay inside the arrays and no node may be deeper than the build
+// goes, the traversal does not check them and its stack only has room for BIH_MAX_TREE_DEPTH levels
+static bool IsValidFlatTree(const BIHFlatNode* nodes, int32 nodeCount, const int* triIndices, int32 numTris)
+{
+	if (nodeCount <= 0)
+	{
+		return false;
+	}
+
+	// Children always come after their parent, so one pass in order finds the deepest path to every node
+	List<int32> depths = List<int32>(nodeCount, 0);
+
+	for (int32 i = 0; i < nodeCount; i++)
+	{
+		const BIHFlatNode& node = nodes[i];
+
+		if (node.IsLeaf())
+		{
+			// Inclusive range, empty leaves end right before they start
+			if (node.LeftIndex < 0 || node.RightIndex >= numTris || node.RightIndex < node.LeftIndex - 1)
+			{
+				return false;
+			}
+		}
+		else
+		{
+			// Depth first, the left child is the next node and the right child comes after it
+			if (i + 1 >= nodeCount || node.GetRightChild() <= (uint32)i || node.GetRightChild() >= (uint32)nodeCount)
+			{
+				return false;
+			}
+
+			// The build turns nodes deeper than BIH_MAX_TREE_DEPTH into leaves
+			int32 childDepth = depths[i] + 1;
+
+			if (childDepth > BIH_MAX_TREE_DEPTH + 1)
+			{
+				return false;
+			}
+
+			depths[i + 1] = glm::max(depths[i + 1], childDepth);
+			depths[node.GetRightChild()] = glm::max(depths[node.GetRightChild()], childDepth);
+		}
+	}
+
+	for (int32 i = 0; i < numTris; i++)
+	{
+		if (triIndices[i] < 0 || triIndices[i] >= numTris)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+BIHTree* BIHTree::Load(const File& file, uint64 sourceHash)
+{
+	if (!file.IsExist())
+	{
+		return nullptr;
+	}
+
+	double loadStart = Time::getTime();
+
+	FileStream stream = FileStream(file);
+	Blob* data = stream.Read();
+
+	if (data == nullptr)
+	{
+		return nullptr;
+	}
+
+	BIHFileHeader header;
+	bool valid = data->GetDataSize() >= sizeof(BIHFileHeader);
+
+	if (valid)
+	{
+		memcpy(&header, data->GetData(), sizeof(BIHFileHeader));
+
+		valid = header.Magic == BIH_FILE_MAGIC && header.Version == BIH_FILE_VERSION && header.SourceHash == sourceHash &&
+			header.Layout == BIHLayout::Flat && header.NumTris >= 0 && header.NodeCount >= 0;
+	}
+
+	size_t pointDataSize = valid ? sizeof(float) * header.NumTris * 9 : 0;
+	size_t triIndicesSize = valid ? sizeof(int) * header.NumTris : 0;
+	size_t nodesSize = valid ? sizeof(BIHFlatNode) * header.NodeCount : 0;
+
+	if (!valid || data->GetDataSize() != sizeof(BIHFileHeader) + pointDataSize + triIndicesSize + nodesSize)
+	{
+		delete data;
+
+		Log("BIHTree::Load", file.GetPath(), "Outdated or invalid file, the tree will be rebuilt.");
+		return nullptr;
+	}
+
+	const char* source = data->GetData() + sizeof(BIHFileHeader);
+
+	if (!IsValidFlatTree((const BIHFlatNode*)(source + pointDataSize + triIndicesSize), header.NodeCount, (const int*)(source + pointDataSize), header.NumTris))
+	{
+		delete data;
+
+		Log("BIHTree::Load", file.GetPath(), "Corrupt file, the tree will be rebuilt.");
+		return nullptr;
+	}
+
+	BIHTree* tree = new BIHTree();
+	tree->_MaxTrisPerNode = header.MaxTrisPerNode;
+	tree->_Layout = (BIHLayout::Enum)header.Layout;
+	tree->_SplitMethod = (BIHSplitMethod::Enum)header.SplitMethod;
+
+	tree->_NumTris = header.NumTris;
+	tree->_NumPointData = header.NumTris * 9;
+	tree->_NumTriIndices = header.NumTris;
+
+	tree->_PointData = new float[tree->_NumPointData];
+	memcpy(tree->_PointData, source, pointDataSize);
+	source += pointDataSize;
+
+	tree->_TriIndices = new int[tree->_NumTriIndices];
+	memcpy(tree->_TriIndices, source, triIndicesSize);
+	source += triIndicesSize;
+
+	tree->_FlatNodes.resize(header.NodeCount);
+	memcpy(tree->_FlatNodes.data(), source, nodesSize);
+
+	delete data;
+
+	tree->_BuildStats.NodeCount = header.NodeCount;
+	tree->_BuildStats.Depth = header.Depth;
+	tree->_BuildStats.LeafCount = header.LeafCount;
+	tree->_BuildStats.AverageLeafSize = header.AverageLeafSize;
+	tree->_BuildStats.BuildTime = Time::getTime() - loadStart;
+
+	return tree;
+}
+
+void BIHTree::LogBuildStats(const String& name) const
+{
+	Log("BIHTree::LogBuildStats", name, ToString(_NumTris) + " tris, " + ToString(_BuildStats.BuildTime * 1000.0) + " ms, depth " + ToString(_BuildStats.Depth) + ", " + ToString(_BuildStats.NodeCount) + " nodes, " + ToString(_BuildStats.LeafCount) + " leaves, " + ToString(_BuildStats.AverageLeafSize) + " tris per leaf");
+}
+
+int BIHTree::CollideWithRay(const Ray & r, const Matrix4& worldMatrix, Box* worldBound, CollisionResults & results)
+{
+	return CollideWithRay(r, worldMatrix, glm::inverse(worldMatrix), worldBound, results, BIHQueryMode::AllHits);
+}
+
+int BIHTree::CollideWithRay(const Ray& r, const Matrix4& worldMatrix, const Matrix4& worldToLocal, const Box* worldBound, CollisionResults& results, BIHQueryMode::Enum mode)
+{
+	float tMin;
+	float tMax;
+
+	if (!GetRayRange(r, worldBound, tMin, tMax))
+	{
+		return 0;
+	}
+
+	BIHRayTraversal traversal;
+	PrepareTraversal(traversal, r, worldMatrix, worldToLocal, results, mode);
+
+	return TraverseRay(traversal, tMin, tMax);
+}
+
+int BIHTree::CollideWithRayPacket(const Ray* rays, int rayCount, const Matrix4& worldMatrix, const Matrix4& worldToLocal, const Box* worldBound, CollisionResults* results, BIHQueryMode::Enum mode)
+{
+	int hits = 0;
+	int first = 0;
+
+	if (_Layout == BIHLayout::Flat)
+	{
+		for (; first + BIH_PACKET_SIZE <= rayCount; first += BIH_PACKET_SIZE)
+		{
+			hits += CollidePacket(rays + first, worldMatrix, worldToLocal, worldBound, results + first, mode);
+		}
+	}
+
+	// Rays that do not fill a whole packet
+	for (int i = first; i < rayCount; i++)
+	{
+		hits += CollideWithRay(rays[i], worldMatrix, worldToLocal, worldBound, results[i], mode);
+	}
+
+	return hits;
+}
+
+int BIHTree::TraverseRay(BIHRayTraversal& traversal, float tMin, float tMax)
+{
+	if (_Layout == BIHLayout::Flat)
+	{
+		IntersectFlat(traversal, tMin, tMax);
+	}
+	else
+	{
+		_Root->IntersectWhere(traversal, this, tMin, tMax);
+	}
+
+	if (traversal.Mode == BIHQueryMode::ClosestHit && traversal.ClosestTriangle >= 0)
+	{
+		traversal.Mode = BIHQueryMode::AllHits;
+
+		AddHit(traversal, traversal.ClosestTriangle, traversal.Closest);
+	}
+
+	return traversal.Hits;
+}
+
+bool BIHTree::GetRayRange(const Ray& r, const Box* worldBound, float& tMin, float& tMax) const
+{
+	tMin = 0;
+	tMax = FloatInf;
+
+	if (worldBound && !worldBound->IntersectRay(r, tMin, tMax))
+	{
+		return false;
+	}
+
+	if (r.Limit < FloatInf)
+	{
+		tMax = glm::min(tMax, r.Limit);
+		if (tMin > tMax)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void BIHTree::PrepareTraversal(BIHRayTraversal& traversal, const Ray& r, const Matrix4& worldMatrix, const Matrix4& worldToLocal, CollisionResults& results, BIHQueryMode::Enum mode) const
+{
+	Vector4 localOrigin = worldToLocal * Vector4(r.Origin, 1.0f);
+	Vector4 localDirection = worldToLocal * Vector4(r.Direction, 0.0f);
+
+	traversal.LocalRay.Origin = Vector3(localOrigin.x, localOrigin.y, localOrigin.z) / localOrigin.w;
+	traversal.LocalRay.Direction = Vector3(localDirection.x, localDirection.y, localDirection.z);
+
+	for (int a = 0; a < 3; a++)
+	{
+		traversal.Origins[a] = traversal.LocalRay.Origin[a];
+		traversal.InvDirections[a] = 1.0f / traversal.LocalRay.Direction[a];
+	}
+
+	traversal.WorldRay = &r;
+	traversal.WorldMatrix = &worldMatrix;
+
+	traversal.Mode = mode;
+
+	// Hits the results would not keep cut the walk short like the closest hit does
+	traversal.Closest = GetResultsLimit(results, r.Direction);
+	traversal.ClosestTriangle = -1;
+
+	traversal.Hits = 0;
+	traversal.Results = &results;
+}
+
+void BIHTree::IntersectLeaf(BIHRayTraversal& traversal, int l, int r)
+{
+	Vector3 v1;
+	Vector3 v2;
+	Vector3 v3;
+
+	for (int i = l; i <= r; i++)
+	{
+		GetTriangle(i, v1, v2, v3);
+
+		float t = 0;
+		if (traversal.LocalRay.IntersectWithTriangle(v1, v2, v3, t))
+		{
+			RecordHit(traversal, i, t);
+		}
+	}
+}
+
+void BIHTree::RecordHit(BIHRayTraversal& traversal, int triangle, float t)
+{
+	if (traversal.Mode == BIHQueryMode::ClosestHit)
+	{
+		if (t < traversal.Closest)
+		{
+			traversal.Closest = t;
+			traversal.ClosestTriangle = triangle;
+		}
+	}
+	else if (t < traversal.Closest)
+	{
+		AddHit(traversal, triangle, t);
+
+		traversal.Closest = GetResultsLimit(*traversal.Results, traversal.WorldRay->Direction);
+	}
+}
+
+float BIHTree::GetResultsLimit(const CollisionResults& results, const Vector3& worldDirection)
+{
+	float limit = results.GetMaxDistance();
+
+	// Results measure world distances, the traversal measures in lengths of the ray direction
+	return glm::abs(limit) < FloatInf ? limit / glm::length(worldDirection) : limit;
+}
+
+void BIHTree::AddHit(BIHRayTraversal& traversal, int triangle, float t)
+{
+	Vector3 v1;
+	Vector3 v2;
+	Vector3 v3;
+
+	GetTriangle(triangle, v1, v2, v3);
+
+	const Matrix4& worldMatrix = *traversal.WorldMatrix;
+
+	v1 = worldMatrix * glm::vec4(v1, 1.0f);
+	v2 = worldMatrix * glm::vec4(v2, 1.0f);
+	v3 = worldMatrix * glm::vec4(v3, 1.0f);
+
+	const Vector3& o = traversal.WorldRay->Origin;
+	const Vector3& d = traversal.WorldRay->Direction;
+
+	Vector3 contactPoint = (d * t) + o;
+
+	CollisionResult res;
+	res.IsNull = false;
+	res.ContactNormal = Triangle::ComputeTriangleNormal(v1, v2, v3);
+	res.ContactPoint = contactPoint;
+	res.Distance = glm::distance(o, contactPoint);
+	res.TriangleIndex = GetTriangleIndex(triangle);
+	traversal.Results->AddCollision(res);
+	traversal.Hits++;
+}
+
+struct BIHShapeQuery
+{
+	// Capsule in the local space of the tree, a sphere has both ends at the same point
+	Vector3 Start;
+	Vector3 End;
+	float Radius;
+
+	// The unit world direction in local space, not normalized again so distances along it are world distances
+	Vector3 Direction;
+	float Tolerance;
+
+	// Local units per world unit
+	float LocalScale;
+
+	const Matrix4* WorldMatrix;
+	CollisionResults* Results;
+	int Hits;
+};
+
+int BIHTree::OverlapSphere(const Vector3& center, float radius, const Matrix4& worldMatrix, const Matrix4& worldToLocal, CollisionResults& results)
+{
+	return OverlapCapsule(center, center, radius, worldMatrix, worldToLocal, results);
+}
+
+int BIHTree::OverlapCapsule(const Vector3& start, const Vector3& end, float radius, const Matrix4& worldMatrix, const Matrix4& worldToLocal, CollisionResults& results)
+{
+	BIHShapeQuery query;
+	PrepareShapeQuery(query, start, end, radius, Vector3(), worldMatrix, worldToLocal, results);
+
+	Vector3 min = glm::min(query.Start, query.End) - Vector3(query.Radius);
+	Vector3 max = glm::max(query.Start, query.End) + Vector3(query.Radius);
+
+	bool sphere = start == end;
+	float radiusSq = query.Radius * query.Radius;
+
+	QueryBox(min, max, [&](int l, int r)
+	{
+		Vector3 v1;
+		Vector3 v2;
+		Vector3 v3;
+
+		for (int i = l; i <= r; i++)
+		{
+			GetTriangle(i, v1, v2, v3);
+
+			Vector3 normal = glm::cross(v2 - v1, v3 - v1);
+
+			// Cheap separating axis test first, the closest points are only needed for the contact
+			if (sphere && !Testing::IntersectionSphereTriangle(query.Start, query.Radius, v1, v2, v3, normal))
+			{
+				continue;
+			}
+
+			Vector3 onShape;
+			Vector3 onTriangle;
+			float distanceSq = Testing::ClosestPointsSegmentTriangle(query.Start, query.End, v1, v2, v3, onShape, onTriangle);
+
+			if (distanceSq <= radiusSq)
+			{
+				Vector3 contactNormal = GetShapeNormal(query, onShape, onTriangle, normal);
+
+				// The gap is measured in local space, results are in world units
+				AddShapeHit(query, i, onTriangle, contactNormal, (glm::sqrt(distanceSq) - query.Radius) / query.LocalScale);
+
+				if (results.IsDone())
+				{
+					return false;
+				}
+			}
+		}
+
+		return true;
+	});
+
+	return query.Hits;
+}
+
+int BIHTree::SweepSphere(const Vector3& center, float radius, const Vector3& direction, float maxDistance, const Matrix4& worldMatrix, const Matrix4& worldToLocal, CollisionResults& results, BIHQueryMode::Enum mode)
+{
+	return SweepCapsule(center, center, radius, direction, maxDistance, worldMatrix, worldToLocal, results, mode);
+}
+
+int BIHTree::SweepCapsule(const Vector3& start, const Vector3& end, float radius, const Vector3& direction, float maxDistance, const Matrix4& worldMatrix, const Matrix4& worldToLocal, CollisionResults& results, BIHQueryMode::Enum mode)
+{
+	float directionLength = glm::length(direction);
+
+	if (directionLength <= 0.0f)
+	{
+		return 0;
+	}
+
+	// Along a unit direction the distances the shape moves are world distances, like maxDistance and the results
+	BIHShapeQuery query;
+	PrepareShapeQuery(query, start, end, radius, direction / directionLength, worldMatrix, worldToLocal, results);
+
+	Vector3 move = query.Direction * maxDistance;
+	Vector3 extent = Vector3(query.Radius + query.Tolerance);
+
+	Vector3 min = glm::min(glm::min(query.Start, query.End), glm::min(query.Start + move, query.End + move)) - extent;
+	Vector3 max = glm::max(glm::max(query.Start, query.End), glm::max(query.Start + move, query.End + move)) + extent;
+
+	float closest = glm::min(maxDistance, results.GetMaxDistance());
+	int closestTriangle = -1;
+	Vector3 closestPoint;
+	Vector3 closestNormal;
+
+	QueryBox(min, max, [&](int l, int r)
+	{
+		Vector3 v1;
+		Vector3 v2;
+		Vector3 v3;
+
+		for (int i = l; i <= r; i++)
+		{
+			GetTriangle(i, v1, v2, v3);
+
+			float t;
+			Vector3 onTriangle;
+			Vector3 normal;
+
+			// Contacts after the closest one do not matter in closest hit mode, or once the results would not keep them
+			float limit = mode == BIHQueryMode::ClosestHit ? closest : glm::min(maxDistance, results.GetMaxDistance());
+
+			if (limit < 0.0f)
+			{
+				return false;
+			}
+
+			if (!SweepTriangle(query, v1, v2, v3, limit, t, onTriangle, normal))
+			{
+				continue;
+			}
+
+			if (mode == BIHQueryMode::ClosestHit)
+			{
+				if (closestTriangle < 0 || t < closest)
+				{
+					closest = t;
+					closestTriangle = i;
+					closestPoint = onTriangle;
+					closestNormal = normal;
+				}
+			}
+			else
+			{
+				AddShapeHit(query, i, onTriangle, normal, t);
+			}
+		}
+
+		return true;
+	});
+
+	if (closestTriangle >= 0)
+	{
+		AddShapeHit(query, closestTriangle, closestPoint, closestNormal, closest);
+	}
+
+	return query.Hits;
+}
+
+void BIHTree::PrepareShapeQuery(BIHShapeQuery& query, const Vector3& start, const Vector3& end, float radius, const Vector3& direction, const Matrix4& worldMatrix, const Matrix4& worldToLocal, CollisionResults& results) const
+{
+	// Only uniform scale keeps a sphere a sphere, so any axis gives the scale
+	query.LocalScale = glm::length(Vector3(worldToLocal[0]));
+
+	query.Start = worldToLocal * glm::vec4(start, 1.0f);
+	query.End = worldToLocal * glm::vec4(end, 1.0f);
+	query.Radius = radius * query.LocalScale;
+	query.Direction = worldToLocal * glm::vec4(direction, 0.0f);
+	query.Tolerance = glm::max(query.Radius * BIH_SWEEP_TOLERANCE, FLT_EPSILON);
+
+	query.WorldMatrix = &worldMatrix;
+	query.Results = &results;
+	query.Hits = 0;
+}
+
+bool BIHTree::SweepTriangle(const BIHShapeQuery& query, const Vector3& v1, const Vector3& v2, const Vector3& v3, float maxDistance, float& t, Vector3& onTriangle, Vector3& normal) const
+{
+	Vector3 onShape;
+
+	t = 0.0f;
+
+	// Conservative advancement: the plane between the closest points separates the shape from the triangle,
+	// so the shape can move until it reaches that plane without touching the triangle. Flat contacts take one step.
+	for (int i = 0; i < BIH_SWEEP_MAX_ITERATIONS; i++)
+	{
+		Vector3 move = query.Direction * t;
+
+		float distance = glm::sqrt(Testing::ClosestPointsSegmentTriangle(query.Start + move, query.End + move, v1, v2, v3, onShape, onTriangle));
+		float gap = distance - query.Radius;
+
+		if (gap <= query.Tolerance)
+		{
+			normal = GetShapeNormal(query, onShape, onTriangle, glm::cross(v2 - v1, v3 - v1));
+			return true;
+		}
+
+		float approach = glm::dot(query.Direction, (onTriangle - onShape) / distance);
+
+		if (approach <= 0.0f)
+		{
+			return false;
+		}
+
+		t += gap / approach;
+
+		if (t > maxDistance)
+		{
+			return false;
+		}
+	}
+
+	// Out of steps before the shape got close, it is only grazing the triangle
+	return false;
+}
+
+Vector3 BIHTree::GetShapeNormal(const BIHShapeQuery& query, const Vector3& onShape, const Vector3& onTriangle, const Vector3& triangleNormal) const
+{
+	Vector3 separation = onShape - onTriangle;
+	float lengthSq = glm::dot(separation, separation);
+
+	if (lengthSq > query.Tolerance * query.Tolerance)
+	{
+		return separation / glm::sqrt(lengthSq);
+	}
+
+	// The shape touches the triangle plane, push it out on the side its centre is on
+	Vector3 normal = glm::normalize(triangleNormal);
+	Vector3 center = (query.Start + query.End) * 0.5f;
+
+	return glm::dot(center - onTriangle, normal) < 0.0f ? -normal : normal;
+}
+
+void BIHTree::AddShapeHit(BIHShapeQuery& query, int triangle, const Vector3& onTriangle, const Vector3& normal, float distance)
+{
+	const Matrix4& worldMatrix = *query.WorldMatrix;
+
+	CollisionResult res;
+	res.IsNull = false;
+	res.ContactPoint = worldMatrix * glm::vec4(onTriangle, 1.0f);
+	res.ContactNormal = glm::normalize(Vector3(worldMatrix * glm::vec4(normal, 0.0f)));
+	res.Distance = distance;
+	res.TriangleIndex = GetTriangleIndex(triangle);
+
+	query.Results->AddCollision(res);
+	query.Hits++;
+}
+
+template<typename LeafCallback>
+void BIHTree::QueryBox(const Vector3& min, const Vector3& max, LeafCallback&& leaf)
+{
+	// Left holds everything up to LeftPlane and right everything from RightPlane on, the box visits every side it reaches
+	if (_Layout == BIHLayout::Flat)
+	{
+		int stack[BIH_TRAVERSAL_STACK_SIZE];
+		int stackSize = 0;
+
+		stack[stackSize++] = 0;
+
+		while (stackSize > 0)
+		{
+			int index = stack[--stackSize];
+
+			while (true)
+			{
+				const BIHFlatNode& node = _FlatNodes[index];
+
+				if (node.IsLeaf())
+				{
+					if (!leaf(node.LeftIndex, node.RightIndex))
+					{
+						return;
+					}
+					break;
+				}
+
+				uint32 axis = node.GetAxis();
+				bool left = min[axis] <= node.LeftPlane;
+				bool right = max[axis] >= node.RightPlane;
+
+				if (left && right)
+				{
+					assertCheck(stackSize < BIH_TRAVERSAL_STACK_SIZE);
+					stack[stackSize++] = node.GetRightChild();
+					index = index + 1;
+				}
+				else if (left)
+				{
+					index = index + 1;
+				}
+				else if (right)
+				{
+					index = node.GetRightChild();
+				}
+				else
+				{
+					break;
+				}
+			}
+		}
+	}
+	else
+	{
+		BIHNode* stack[BIH_TRAVERSAL_STACK_SIZE];
+		int stackSize = 0;
+
+		stack[stackSize++] = _Root;
+
+		while (stackSize > 0)
+		{
+			BIHNode* node = stack[--stackSize];
+
+			while (node != nullptr)
+			{
+				if (node->Axis == 3)
+				{
+					if (!leaf(node->LeftIndex, node->RightIndex))
+					{
+						return;
+					}
+					break;
+				}
+
+				int axis = node->Axis;
+				bool left = min[axis] <= node->LeftPlane;
+				bool right = max[axis] >= node->RightPlane;
+
+				if (left && right)
+				{
+					assertCheck(stackSize < BIH_TRAVERSAL_STACK_SIZE);
+					stack[stackSize++] = node->Right;
+					node = node->Left;
+				}
+				else if (left)
+				{
+					node = node->Left;
+				}
+				else if (right)
+				{
+					node = node->Right;
+				}
+				else
+				{
+					break;
+				}
+			}
+		}
+	}
+}
+
+Box BIHTree::CreateBox(int l, int r)
+{
+	Vector3 max = Vector3(-FloatMax, -FloatMax, -FloatMax);
+	Vector3 min = Vector3(FloatMax, FloatMax, FloatMax);
+
+	int chunkCount = GetBuildChunkCount(l, r);
+
+	if (chunkCount == 1)
+	{
+		GetBoundsRange(l, r, min, max);
+	}
+	else
+	{
+		// Min and max do not depend on the order, so merging the chunks gives the same box as one pass
+		List<Vector3> chunkMin(chunkCount, min);
+		List<Vector3> chunkMax(chunkCount, max);
+
+		ForEachBuildChunk(l, r, chunkCount, [this, &chunkMin, &chunkMax](int chunk, int chunkL, int chunkR)
+		{
+			GetBoundsRange(chunkL, chunkR, chunkMin[chunk], chunkMax[chunk]);
+		});
+
+		for (int i = 0; i < chunkCount; i++)
+		{
+			Box::CheckMinMax(min, max, chunkMin[i]);
+			Box::CheckMinMax(min, max, chunkMax[i]);
+		}
+	}
+
+	return Box(BBMM min, max);
+}
+
+void BIHTree::GetBoundsRange(int l, int r, Vector3& min, Vector3& max)
+{
+	Vector3 v1;
+	Vector3 v2;
+	Vector3 v3;
+
+	for (int i = l; i <= r; i++)
+	{
+		GetTriangle(i, v1, v2, v3);
+		Box::CheckMinMax(min, max, v1);
+		Box::CheckMinMax(min, max, v2);
+		Box::CheckMinMax(min, max, v3);
+	}
+}
+
+int BIHTree::PartitionNode(int l, int r, const Box& nodeBbox, const Box& currentBox, int& axis, float& split)
+{
+	if (_SplitMethod == BIHSplitMethod::SAH && FindSAHSplit(l, r, axis, split))
+	{
+		int pivot = SortTriangles(l, r, split, axis);
+		if (pivot == l || pivot == r)
+		{
+			pivot = (r + l) / 2;
+		}
+
+		return pivot;
+	}
+
+	glm::vec3 exteriorExt = nodeBbox.GetExtent();
+	glm::vec3 interiorExt = currentBox.GetExtent();
+
+	exteriorExt -= interiorExt;
+
+	axis = 0;
+	if (exteriorExt.x > exteriorExt.y)
+	{
+		if (exteriorExt.x > exteriorExt.z)
+		{
+			axis = 0;
+		}
+		else
+		{
+			axis = 2;
+		}
+	}
+	else
+	{
+		if (exteriorExt.y > exteriorExt.z)
+		{
+			axis = 1;
+		}
+		else
+		{
+			axis = 2;
+		}
+	}
+	if (exteriorExt == glm::vec3())
+	{
+		axis = 0;
+	}
+
+	split = currentBox.GetOrigin()[axis];
+	int pivot = SortTriangles(l, r, split, axis);
+	if (pivot == l || pivot == r)
+	{
+		pivot = (r + l) / 2;
+	}
+
+	return pivot;
+}
+
+static inline float HalfSurfaceArea(const Vector3& min, const Vector3& max)
+{
+	Vector3 e = glm::max(max - min, Vector3(0.0f));
+
+	return e.x * e.y + e.y * e.z + e.z * e.x;
+}
+
+struct BIHSAHBin
+{
+	Vector3 Min;
+	Vector3 Max;
+	int Count;
+};
+
+struct BIHSAHBinSet
+{
+	BIHSAHBin Bins[3][BIH_SAH_BIN_COUNT];
+
+	BIHSAHBinSet()
+	{
+		for (int a = 0; a < 3; a++)
+		{
+			for (int b = 0; b < BIH_SAH_BIN_COUNT; b++)
+			{
+				Bins[a][b].Min = Vector3(FloatMax);
+				Bins[a][b].Max = Vector3(-FloatMax);
+				Bins[a][b].Count = 0;
+			}
+		}
+	}
+
+	void Merge(const BIHSAHBinSet& other)
+	{
+		for (int a = 0; a < 3; a++)
+		{
+			for (int b = 0; b < BIH_SAH_BIN_COUNT; b++)
+			{
+				Bins[a][b].Min = glm::min(Bins[a][b].Min, other.Bins[a][b].Min);
+				Bins[a][b].Max = glm::max(Bins[a][b].Max, other.Bins[a][b].Max);
+				Bins[a][b].Count += other.Bins[a][b].Count;
+			}
+		}
+	}
+};
+
+void BIHTree::GetCentroidRange(int l, int r, Vector3& min, Vector3& max)
+{
+	Vector3 v1;
+	Vector3 v2;
+	Vector3 v3;
+
+	for (int i = l; i <= r; i++)
+	{
+		GetTriangle(i, v1, v2, v3);
+
+		Vector3 centroid = (v1 + v2 + v3) * (1.0f / 3.0f);
+		min = glm::min(min, centroid);
+		max = glm::max(max, centroid);
+	}
+}
+
+void BIHTree::BinRange(int l, int r, const Vector3& centroidMin, const Vector3& binScale, BIHSAHBinSet& binSet)
+{
+	Vector3 v1;
+	Vector3 v2;
+	Vector3 v3;
+
+	for (int i = l; i <= r; i++)
+	{
+		GetTriangle(i, v1, v2, v3);
+
+		for (int a = 0; a < 3; a++)
+		{
+			// Flat axes get no bins
+			if (binScale[a] == 0.0f)
+			{
+				continue;
+			}
+
+			float centroid = (v1[a] + v2[a] + v3[a]) * (1.0f / 3.0f);
+			int b = glm::min(BIH_SAH_BIN_COUNT - 1, (int)((centroid - centroidMin[a]) * binScale[a]));
+
+			BIHSAHBin& bin = binSet.Bins[a][b];
+			bin.Min = glm::min(glm::min(bin.Min, v1), glm::min(v2, v3));
+			bin.Max = glm::max(glm::max(bin.Max, v1), glm::max(v2, v3));
+			bin.Count++;
+		}
+	}
+}
+
+bool BIHTree::FindSAHSplit(int l, int r, int& axis, float& split)
+{
+	// Bins are laid over the centroid bounds, the triangle bounds only drive the cost
+	Vector3 centroidMin = Vector3(FloatMax);
+	Vector3 centroidMax = Vector3(-FloatMax);
+
+	int chunkCount = GetBuildChunkCount(l, r);
+
+	if (chunkCount == 1)
+	{
+		GetCentroidRange(l, r, centroidMin, centroidMax);
+	}
+	else
+	{
+		List<Vector3> chunkMin(chunkCount, centroidMin);
+		List<Vector3> chunkMax(chunkCount, centroidMax);
+
+		ForEachBuildChunk(l, r, chunkCount, [this, &chunkMin, &chunkMax](int chunk, int chunkL, int chunkR)
+		{
+			GetCentroidRange(chunkL, chunkR, chunkMin[chunk], chunkMax[chunk]);
+		});
+
+		for (int i = 0; i < chunkCount; i++)
+		{
+			centroidMin = glm::min(centroidMin, chunkMin[i]);
+			centroidMax = glm::max(centroidMax, chunkMax[i]);
+		}
+	}
+
+	Vector3 binScale = Vector3(0.0f);
+
+	for (int a = 0; a < 3; a++)
+	{
+		float extent = centroidMax[a] - centroidMin[a];
+
+		if (extent > 0.0f)
+		{
+			binScale[a] = BIH_SAH_BIN_COUNT / extent;
+		}
+	}
+
+	BIHSAHBinSet binSet;
+
+	if (chunkCount == 1)
+	{
+		BinRange(l, r, centroidMin, binScale, binSet);
+	}
+	else
+	{
+		// Chunks are merged in order, which keeps the bins the same as the ones of a single pass
+		List<BIHSAHBinSet> chunkBins(chunkCount);
+
+		ForEachBuildChunk(l, r, chunkCount, [this, &chunkBins, &centroidMin, &binScale](int chunk, int chunkL, int chunkR)
+		{
+			BinRange(chunkL, chunkR, centroidMin, binScale, chunkBins[chunk]);
+		});
+
+		for (int i = 0; i < chunkCount; i++)
+		{
+			binSet.Merge(chunkBins[i]);
+		}
+	}
+
+	float bestCost = FloatMax;
+	int bestAxis = -1;
+	float bestSplit = 0;
+
+	for (int a = 0; a < 3; a++)
+	{
+		if (binScale[a] == 0.0f)
+		{
+			continue;
+		}
+
+		BIHSAHBin* bins = binSet.Bins[a];
+
+		// Sweep from the right to get the cost of everything above each plane
+		float rightCost[BIH_SAH_BIN_COUNT];
+		Vector3 min = Vector3(FloatMax);
+		Vector3 max = Vector3(-FloatMax);
+		int count = 0;
+
+		for (int b = BIH_SAH_BIN_COUNT - 1; b > 0; b--)
+		{
+			min = glm::min(min, bins[b].Min);
+			max = glm::max(max, bins[b].Max);
+			count += bins[b].Count;
+
+			rightCost[b] = count > 0 ? count * HalfSurfaceArea(min, max) : 0.0f;
+		}
+
+		min = Vector3(FloatMax);
+		max = Vector3(-FloatMax);
+		count = 0;
+
+		for (int b = 0; b < BIH_SAH_BIN_COUNT - 1; b++)
+		{
+			min = glm::min(min, bins[b].Min);
+			max = glm::max(max, bins[b].Max);
+			count += bins[b].Count;
+
+			if (count == 0 || count == r - l + 1)
+			{
+				continue;
+			}
+
+			float cost = count * HalfSurfaceArea(min, max) + rightCost[b + 1];
+
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = a;
+				bestSplit = centroidMin[a] + (b + 1) / binScale[a];
+			}
+		}
+	}
+
+	if (bestAxis < 0)
+	{
+		return false;
+	}
+
+	axis = bestAxis;
+	split = bestSplit;
+
+	return true;
+}
+
+void BIHTree::RecordNode(int l, int r, int depth, bool leaf, BIHBuildStats& stats)
+{
+	stats.NodeCount++;
+	stats.Depth = glm::max(stats.Depth, depth);
+
+	if (leaf)
+	{
+		stats.LeafCount++;
+		stats.AverageLeafSize += (float)(r - l + 1);
+	}
+}
+
+static void MergeBuildStats(BIHBuildStats& stats, const BIHBuildStats& other)
+{
+	stats.NodeCount += other.NodeCount;
+	stats.LeafCount += other.LeafCount;
+	stats.Depth = glm::max(stats.Depth, other.Depth);
+
+	// Leaf sizes are whole numbers, so the sum is exact in any order
+	stats.AverageLeafSize += other.AverageLeafSize;
+}
+
+int BIHTree::GetBuildChunkCount(int l, int r) const
+{
+	int count = r - l + 1;
+
+	if (_BuildPool == nullptr || count < BIH_PARALLEL_CHUNK_SIZE * 2)
+	{
+		return 1;
+	}
+
+	return (count + BIH_PARALLEL_CHUNK_SIZE - 1) / BIH_PARALLEL_CHUNK_SIZE;
+}
+
+void BIHTree::ForEachBuildChunk(int l, int r, int chunkCount, const Function<void(int chunk, int l, int r)>& body)
+{
+	_BuildPool->ParallelFor(chunkCount, 1, [l, r, &body](int begin, int end)
+	{
+		for (int chunk = begin; chunk < end; chunk++)
+		{
+			int chunkL = l + chunk * BIH_PARALLEL_CHUNK_SIZE;
+			int chunkR = glm::min(r, chunkL + BIH_PARALLEL_CHUNK_SIZE - 1);
+
+			body(chunk, chunkL, chunkR);
+		}
+	});
+}
+
+bool BIHTree::IsParallelSubtree(int l, int r) const
+{
+	return _BuildPool != nullptr && r - l + 1 >= BIH_PARALLEL_SUBTREE_SIZE;
+}
+
+BIHNode* BIHTree::CreateNode(int l, int r, const Box & nodeBbox, const Box& currentBox, int depth, BIHBuildStats& stats)
+{
+	if ((r - l) < _MaxTrisPerNode || depth > MAX_TREE_DEPTH)
+	{
+		RecordNode(l, r, depth, true, stats);
+
+		return new BIHNode(l, r);
+	}
+
+	int axis;
+	float split;
+
+	int pivot = PartitionNode(l, r, nodeBbox, currentBox, axis, split);
+
+	if (pivot < l)
+	{
+		//Only right
+		Box rbbox = Box(currentBox);
+		SetMinMax(rbbox, true, axis, split);
+		return CreateNode(l, r, rbbox, currentBox, depth + 1, stats);
+	}
+	else if (pivot > r)
+	{
+		//Only left
+		Box lbbox = Box(currentBox);
+		SetMinMax(lbbox, false, axis, split);
+		return CreateNode(l, r, lbbox, currentBox, depth + 1, stats);
+	}
+	else
+	{
+		//Build the node
+		BIHNode* node = new BIHNode(axis);
+
+		RecordNode(l, r, depth, false, stats);
+
+		int leftR = glm::max(l, pivot - 1);
+
+		// The child bounds give the planes and are reused by the children, so every level scans the triangles once
+		Box leftBounds = CreateBox(l, leftR);
+		Box rightBounds = CreateBox(pivot, r);
+
+		//Left child
+		Box lbbox = Box(currentBox);
+		SetMinMax(lbbox, false, axis, split);
+
+		//The left node right border is the plane most right
+		node->SetLeftPlane(GetMinMax(leftBounds, false, axis));
+
+		//Right Child
+		Box rbbox = Box(currentBox);
+		SetMinMax(rbbox, true, axis, split);
+
+		//The right node left border is the plane most left
+		node->SetRightPlane(GetMinMax(rightBounds, true, axis));
+
+		if (IsParallelSubtree(l, r))
+		{
+			// The children work on disjoint triangle ranges, only the stats have to be kept apart
+			BIHBuildStats childStats[2] = {};
+			BIHNode* children[2];
+
+			_BuildPool->ParallelFor(2, 1, [&](int begin, int end)
+			{
+				for (int i = begin; i < end; i++)
+				{
+					children[i] = i == 0 ? CreateNode(l, leftR, lbbox, leftBounds, depth + 1, childStats[0]) : CreateNode(pivot, r, rbbox, rightBounds, depth + 1, childStats[1]);
+				}
+			});
+
+			MergeBuildStats(stats, childStats[0]);
+			MergeBuildStats(stats, childStats[1]);
+
+			node->SetLeftChild(children[0]);
+			node->SetRightChild(children[1]);
+		}
+		else
+		{
+			node->SetLeftChild(CreateNode(l, leftR, lbbox, leftBounds, depth + 1, stats)); //Recursive call
+			node->SetRightChild(CreateNode(pivot, r, rbbox, rightBounds, depth + 1, stats)); //Recursive call
+		}
+
+		return node;
+	}
+
+	return nullptr;
+}
+
+static void AppendFlatNodes(List<BIHFlatNode>& nodes, const List<BIHFlatNode>& subtree, uint32 offset)
+{
+	for (const BIHFlatNode& node : subtree)
+	{
+		nodes.push_back(node);
+
+		if (!node.IsLeaf())
+		{
+			BIHFlatNode& added = nodes.back();
+			added.SetInner(node.GetAxis(), node.LeftPlane, node.RightPlane, node.GetRightChild() + offset);
+		}
+	}
+}
+
+int BIHTree::CreateFlatNode(int l, int r, const Box & nodeBbox, const Box& currentBox, int depth, List<BIHFlatNode>& nodes, BIHBuildStats& stats)
+{
+	int index = (int)nodes.size();
+
+	if ((r - l) < _MaxTrisPerNode || depth > MAX_TREE_DEPTH)
+	{
+		RecordNode(l, r, depth, true, stats);
+
+		nodes.emplace_back();
+		nodes[index].SetLeaf(l, r);
+
+		return index;
+	}
+
+	int axis;
+	float split;
+
+	int pivot = PartitionNode(l, r, nodeBbox, currentBox, axis, split);
+
+	if (pivot < l)
+	{
+		//Only right
+		Box rbbox = Box(currentBox);
+		SetMinMax(rbbox, true, axis, split);
+		return CreateFlatNode(l, r, rbbox, currentBox, depth + 1, nodes, stats);
+	}
+	else if (pivot > r)
+	{
+		//Only left
+		Box lbbox = Box(currentBox);
+		SetMinMax(lbbox, false, axis, split);
+		return CreateFlatNode(l, r, lbbox, currentBox, depth + 1, nodes, stats);
+	}
+
+	nodes.emplace_back();
+
+	RecordNode(l, r, depth, false, stats);
+
+	int leftR = glm::max(l, pivot - 1);
+
+	Box leftBounds = CreateBox(l, leftR);
+	Box rightBounds = CreateBox(pivot, r);
+
+	Box lbbox = Box(currentBox);
+	SetMinMax(lbbox, false, axis, split);
+
+	Box rbbox = Box(currentBox);
+	SetMinMax(rbbox, true, axis, split);
+
+	float leftPlane = GetMinMax(leftBounds, false, axis);
+	float rightPlane = GetMinMax(rightBounds, true, axis);
+
+	int rightChild;
+
+	if (IsParallelSubtree(l, r))
+	{
+		// Each child is built into its own array starting at 0 and moved behind this node afterwards,
+		// which gives the same depth first order as the serial build
+		List<BIHFlatNode> childNodes[2];
+		BIHBuildStats childStats[2] = {};
+
+		_BuildPool->ParallelFor(2, 1, [&](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+			{
+				if (i == 0)
+				{
+					childNodes[0].reserve((leftR - l + 1) * 2);
+					CreateFlatNode(l, leftR, lbbox, leftBounds, depth + 1, childNodes[0], childStats[0]);
+				}
+				else
+				{
+					childNodes[1].reserve((r - pivot + 1) * 2);
+					CreateFlatNode(pivot, r, rbbox, rightBounds, depth + 1, childNodes[1], childStats[1]);
+				}
+			}
+		});
+
+		MergeBuildStats(stats, childStats[0]);
+		MergeBuildStats(stats, childStats[1]);
+
+		rightChild = index + 1 + (int)childNodes[0].size();
+
+		AppendFlatNodes(nodes, childNodes[0], index + 1);
+		AppendFlatNodes(nodes, childNodes[1], rightChild);
+	}
+	else
+	{
+		// Left child is written right after this node, so only the right one needs an index
+		CreateFlatNode(l, leftR, lbbox, leftBounds, depth + 1, nodes, stats);
+		rightChild = CreateFlatNode(pivot, r, rbbox, rightBounds, depth + 1, nodes, stats);
+	}
+
+	nodes[index].SetInner(axis, leftPlane, rightPlane, rightChild);
+
+	return index;
+}
+
+bool BIHTree::Refit(const List<VertexBufferEntry>& vertices, const List<uint32>& indices, float rebuildRatio, ThreadPool* threadPool)
+{
+	if ((int)indices.size() / 3 != _NumTris)
+	{
+		LogError("BIHTree::Refit", ToString((int)indices.size() / 3) + " tris", "A refit needs the same triangles the tree was built from !");
+		return false;
+	}
+
+	// Cost of the tree as it was built, only needed once something refits it
+	if (_BuildCost < 0.0f)
+	{
+		_BuildCost = UpdatePlanes(false);
+	}
+
+	// Triangles keep their place in the tree, only their corners move
+	auto refitTriangles = [this, &vertices, &indices](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			int p = i * 9;
+			int source = _TriIndices[i] * 3;
+
+			for (int k = 0; k < 3; k++)
+			{
+				const Vector3& position = vertices[indices[source + k]].Position;
+
+				_PointData[p++] = position.x;
+				_PointData[p++] = position.y;
+				_PointData[p++] = position.z;
+			}
+		}
+	};
+
+	if (threadPool != nullptr)
+	{
+		threadPool->ParallelFor(_NumTris, BIH_PARALLEL_CHUNK_SIZE, refitTriangles);
+	}
+	else
+	{
+		refitTriangles(0, _NumTris);
+	}
+
+	float cost = UpdatePlanes(true);
+
+	if (cost > _BuildCost * rebuildRatio)
+	{
+		Log("BIHTree::Refit", ToString(cost / glm::max(_BuildCost, FLT_MIN)) + "x cost", "Tree quality dropped too far, rebuilding.");
+
+		Rebuild(vertices, indices, threadPool);
+		return true;
+	}
+
+	return false;
 }
 
-BIHTree::~BIHTree()
+void BIHTree::Rebuild(const List<VertexBufferEntry>& vertices, const List<uint32>& indices, ThreadPool* threadPool)
 {
 	delete[] _PointData;
 	delete[] _TriIndices;
 
 	delete _Root;
+	_Root = nullptr;
+
+	_FlatNodes.clear();
+
+	InitTriangles(vertices, indices);
+
+	_BuildPool = threadPool;
+	ConstructRootNode();
+
+	_BuildCost = -1.0f;
 }
 
-void BIHTree::GetTriangle(int index, Vector3 & v1, Vector3 & v2, Vector3 & v3)
+float BIHTree::UpdatePlanes(bool writePlanes)
 {
-	int pointIndex = index * 9;
+	if (_NumTris == 0)
+	{
+		return 0.0f;
+	}
 
-	v1.x = _PointData[pointIndex++];
-	v1.y = _PointData[pointIndex++];
-	v1.z = _PointData[pointIndex++];
+	Vector3 min;
+	Vector3 max;
+	float cost = 0.0f;
 
-	v2.x = _PointData[pointIndex++];
-	v2.y = _PointData[pointIndex++];
-	v2.z = _PointData[pointIndex++];
+	if (_Layout == BIHLayout::Flat)
+	{
+		RefitFlatNode(0, writePlanes, min, max, cost);
+	}
+	else
+	{
+		RefitNode(_Root, writePlanes, min, max, cost);
+	}
 
-	v3.x = _PointData[pointIndex++];
-	v3.y = _PointData[pointIndex++];
-	v3.z = _PointData[pointIndex++];
+	float rootArea = HalfSurfaceArea(min, max);
+
+	return rootArea > 0.0f ? cost / rootArea : 0.0f;
 }
 
-int BIHTree::GetTriangleIndex(int triIndex)
+void BIHTree::RefitNode(BIHNode* node, bool writePlanes, Vector3& min, Vector3& max, float& cost)
 {
-	return _TriIndices[triIndex];
+	if (node->Axis == 3)
+	{
+		min = Vector3(FloatMax);
+		max = Vector3(-FloatMax);
+
+		GetBoundsRange(node->LeftIndex, node->RightIndex, min, max);
+
+		cost += HalfSurfaceArea(min, max) * (node->RightIndex - node->LeftIndex + 1);
+		return;
+	}
+
+	Vector3 leftMin;
+	Vector3 leftMax;
+	Vector3 rightMin;
+	Vector3 rightMax;
+
+	RefitNode(node->Left, writePlanes, leftMin, leftMax, cost);
+	RefitNode(node->Right, writePlanes, rightMin, rightMax, cost);
+
+	if (writePlanes)
+	{
+		// Through a Box like the build, so refitting unchanged vertices gives back the same planes
+		node->SetLeftPlane(GetMinMax(Box(BBMM leftMin, leftMax), false, node->Axis));
+		node->SetRightPlane(GetMinMax(Box(BBMM rightMin, rightMax), true, node->Axis));
+	}
+
+	min = glm::min(leftMin, rightMin);
+	max = glm::max(leftMax, rightMax);
+
+	cost += HalfSurfaceArea(min, max);
 }
 
-int BIHTree::CollideWithRay(const Ray & r, const Matrix4& worldMatrix, Box* worldBound, CollisionResults & results)
+void BIHTree::RefitFlatNode(int index, bool writePlanes, Vector3& min, Vector3& max, float& cost)
 {
-	if (worldBound)
+	BIHFlatNode& node = _FlatNodes[index];
+
+	if (node.IsLeaf())
+	{
+		min = Vector3(FloatMax);
+		max = Vector3(-FloatMax);
+
+		GetBoundsRange(node.LeftIndex, node.RightIndex, min, max);
+
+		cost += HalfSurfaceArea(min, max) * (node.RightIndex - node.LeftIndex + 1);
+		return;
+	}
+
+	Vector3 leftMin;
+	Vector3 leftMax;
+	Vector3 rightMin;
+	Vector3 rightMax;
+
+	RefitFlatNode(index + 1, writePlanes, leftMin, leftMax, cost);
+	RefitFlatNode(node.GetRightChild(), writePlanes, rightMin, rightMax, cost);
+
+	if (writePlanes)
+	{
+		uint32 axis = node.GetAxis();
+
+		node.SetInner(axis, GetMinMax(Box(BBMM leftMin, leftMax), false, axis), GetMinMax(Box(BBMM rightMin, rightMax), true, axis), node.GetRightChild());
+	}
+
+	min = glm::min(leftMin, rightMin);
+	max = glm::max(leftMax, rightMax);
+
+	cost += HalfSurfaceArea(min, max);
+}
+
+int BIHTree::IntersectFlat(BIHRayTraversal& traversal, float sceneMin, float sceneMax)
+{
+	BIHFlatStackData stack[BIH_TRAVERSAL_STACK_SIZE];
+	int stackSize = 0;
+
+	const float* origins = traversal.Origins;
+	const float* invDirections = traversal.InvDirections;
+
+	const BIHFlatNode* nodes = _FlatNodes.data();
+
+	stack[stackSize++] = BIHFlatStackData(0, sceneMin, sceneMax);
+
+stackloop:
+	while (stackSize > 0)
 	{
-		_BBoxTempRes.Clear();
+		BIHFlatStackData& data = stack[--stackSize];
+
+		int nodeIndex = data.Node;
+		float tMin = data.Min, tMax = glm::min(data.Max, traversal.Closest);
+		if (tMax < tMin)
+		{
+			continue;
+		}
 
-		if (worldBound->CollideWithRay(r, _BBoxTempRes))
+		while (!nodes[nodeIndex].IsLeaf())
 		{
-			float tMin = _BBoxTempRes.GetClosestCollision().Distance;
-			float tMax = _BBoxTempRes.GetFarthestCollision().Distance;
+			const BIHFlatNode& node = nodes[nodeIndex];
+			uint32 a = node.GetAxis();
+
+			float origin = origins[a];
+			float invDirection = invDirections[a];
 
-			if (tMax <= 0)
+			float tNearSplit = (node.LeftPlane - origin) * invDirection;
+			float tFarSplit = (node.RightPlane - origin) * invDirection;
+			int nearNode = nodeIndex + 1;
+			int farNode = (int)node.GetRightChild();
+
+			if (invDirection < 0)
 			{
-				tMax = FloatInf;
+				float tmpSplit = tNearSplit;
+				tNearSplit = tFarSplit;
+				tFarSplit = tmpSplit;
+
+				int tmpNode = nearNode;
+				nearNode = farNode;
+				farNode = tmpNode;
 			}
-			else if (tMin == tMax)
+
+			if (tMin > tNearSplit && tMax < tFarSplit)
 			{
-				tMin = 0;
+				goto stackloop;
 			}
 
-			if (tMin <= 0)
+			if (tMin > tNearSplit)
 			{
-				tMin = 0;
+				tMin = glm::max(tMin, tFarSplit);
+				nodeIndex = farNode;
 			}
-
-			if (r.Limit < FloatInf)
+			else if (tMax < tFarSplit)
 			{
-				tMax = glm::min(tMax, r.Limit);
-				if (tMin > tMax)
-				{
-					return 0;
-				}
+				tMax = glm::min(tMax, tNearSplit);
+				nodeIndex = nearNode;
 			}
+			else
+			{
+				assertCheck(stackSize < BIH_TRAVERSAL_STACK_SIZE);
 
-			return this->_Root->IntersectWhere(r, worldMatrix, this, tMin, tMax, results);
+				stack[stackSize++] = BIHFlatStackData(farNode, glm::max(tMin, tFarSplit), tMax);
+				tMax = glm::min(tMax, tNearSplit);
+				nodeIndex = nearNode;
+			}
 		}
+
+		// a leaf
+		const BIHFlatNode& leaf = nodes[nodeIndex];
+
+		IntersectLeaf(traversal, leaf.LeftIndex, leaf.RightIndex);
 	}
 
-	return 0;
+	return traversal.Hits;
 }
 
-Box BIHTree::CreateBox(int l, int r)
+int BIHTree::CollidePacket(const Ray* rays, const Matrix4& worldMatrix, const Matrix4& worldToLocal, const Box* worldBound, CollisionResults* results, BIHQueryMode::Enum mode)
 {
-	float fmax = FloatMin;
-	float fmin = FloatMax;
+	BIHRayTraversal traversals[BIH_PACKET_SIZE];
 
-	Vector3 max = Vector3(fmin, fmin, fmin);
-	Vector3 min = Vector3(fmax, fmax, fmax);
+	float sceneMin[BIH_PACKET_SIZE];
+	float sceneMax[BIH_PACKET_SIZE];
 
-	Vector3 v1;
-	Vector3 v2;
-	Vector3 v3;
+	int activeMask = 0;
 
-	for (int i = l; i <= r; i++)
+	if (worldBound)
 	{
-		GetTriangle(i, v1, v2, v3);
-		Box::CheckMinMax(min, max, v1);
-		Box::CheckMinMax(min, max, v2);
-		Box::CheckMinMax(min, max, v3);
+		// Same ranges as GetRayRange, with the whole packet clipped against the bound at once
+		uint32 boundMask;
+		BoxBatch::IntersectRays(*worldBound, rays, BIH_PACKET_SIZE, &boundMask, sceneMin, sceneMax);
+
+		activeMask = (int)boundMask;
 	}
 
-	return Box(BBMM min, max);
-}
+	for (int i = 0; i < BIH_PACKET_SIZE; i++)
+	{
+		PrepareTraversal(traversals[i], rays[i], worldMatrix, worldToLocal, results[i], mode);
 
-BIHNode* BIHTree::CreateNode(int l, int r, const Box & nodeBbox, int depth)
-{
-	if ((r - l) < _MaxTrisPerNode || depth > MAX_TREE_DEPTH)
+		if (!worldBound && GetRayRange(rays[i], nullptr, sceneMin[i], sceneMax[i]))
+		{
+			activeMask |= 1 << i;
+		}
+
+		if ((activeMask & (1 << i)) == 0)
+		{
+			sceneMin[i] = 0;
+			sceneMax[i] = -1;
+		}
+	}
+
+	if (activeMask == 0)
 	{
-		return new BIHNode(l, r);
+		return 0;
 	}
-	Box currentBox = CreateBox(l, r);
 
-	glm::vec3 exteriorExt = nodeBbox.GetExtent();
-	glm::vec3 interiorExt = currentBox.GetExtent();
+	BIHPacketRays packet;
+	packet.Traversals = traversals;
+	packet.Closest = _mm_setr_ps(traversals[0].Closest, traversals[1].Closest, traversals[2].Closest, traversals[3].Closest);
 
-	exteriorExt -= interiorExt;
+	bool diverged = false;
 
-	int axis = 0;
-	if (exteriorExt.x > exteriorExt.y)
+	for (int a = 0; a < 3; a++)
 	{
-		if (exteriorExt.x > exteriorExt.z)
-		{
-			axis = 0;
-		}
-		else
+		int negativeMask = 0;
+
+		for (int i = 0; i < BIH_PACKET_SIZE; i++)
 		{
-			axis = 2;
+			if (traversals[i].InvDirections[a] < 0)
+			{
+				negativeMask |= 1 << i;
+			}
 		}
+
+		negativeMask &= activeMask;
+
+		diverged |= negativeMask != 0 && negativeMask != activeMask;
+		packet.Negative[a] = negativeMask != 0;
+
+		packet.Origins[a] = _mm_setr_ps(traversals[0].Origins[a], traversals[1].Origins[a], traversals[2].Origins[a], traversals[3].Origins[a]);
+		packet.Directions[a] = _mm_setr_ps(traversals[0].LocalRay.Direction[a], traversals[1].LocalRay.Direction[a], traversals[2].LocalRay.Direction[a], traversals[3].LocalRay.Direction[a]);
+		packet.InvDirections[a] = _mm_setr_ps(traversals[0].InvDirections[a], traversals[1].InvDirections[a], traversals[2].InvDirections[a], traversals[3].InvDirections[a]);
 	}
-	else
+
+	int hits = 0;
+
+	if (diverged)
 	{
-		if (exteriorExt.y > exteriorExt.z)
+		// The rays would disagree on the near child, walk the tree once per ray
+		for (int i = 0; i < BIH_PACKET_SIZE; i++)
 		{
-			axis = 1;
-		}
-		else
-		{
-			axis = 2;
+			if (activeMask & (1 << i))
+			{
+				hits += TraverseRay(traversals[i], sceneMin[i], sceneMax[i]);
+			}
 		}
-	}
-	if (exteriorExt == glm::vec3())
-	{
-		axis = 0;
-	}
 
-	float split = currentBox.GetOrigin()[axis];
-	int pivot = SortTriangles(l, r, split, axis);
-	if (pivot == l || pivot == r)
-	{
-		pivot = (r + l) / 2;
+		return hits;
 	}
 
-	if (pivot < l)
+	IntersectFlatPacket(packet, activeMask, sceneMin, sceneMax);
+
+	for (int i = 0; i < BIH_PACKET_SIZE; i++)
 	{
-		//Only right
-		Box rbbox = Box(currentBox);
-		SetMinMax(rbbox, true, axis, split);
-		return CreateNode(l, r, rbbox, depth + 1);
+		BIHRayTraversal& traversal = traversals[i];
+
+		if (traversal.Mode == BIHQueryMode::ClosestHit && traversal.ClosestTriangle >= 0)
+		{
+			traversal.Mode = BIHQueryMode::AllHits;
+
+			AddHit(traversal, traversal.ClosestTriangle, traversal.Closest);
+		}
+
+		hits += traversal.Hits;
 	}
-	else if (pivot > r)
+
+	return hits;
+}
+
+// Same walk as IntersectFlat, every lane keeps its own interval and a lane only follows
+// a child when the scalar traversal of that ray would, so both visit the same leaves.
+void BIHTree::IntersectFlatPacket(BIHPacketRays& packet, int activeMask, float* sceneMin, float* sceneMax)
+{
+	BIHPacketStackData stack[BIH_TRAVERSAL_STACK_SIZE];
+	int stackSize = 0;
+
+	const BIHFlatNode* nodes = _FlatNodes.data();
+
+	stack[stackSize++] = BIHPacketStackData(0, activeMask, _mm_loadu_ps(sceneMin), _mm_loadu_ps(sceneMax));
+
+stackloop:
+	while (stackSize > 0)
 	{
-		//Only left
-		Box lbbox = Box(currentBox);
-		SetMinMax(lbbox, false, axis, split);
-		return CreateNode(l, r, lbbox, depth + 1);
+		BIHPacketStackData& data = stack[--stackSize];
+
+		int nodeIndex = data.Node;
+		__m128 tMin = data.Min;
+		__m128 tMax = _mm_min_ps(packet.Closest, data.Max);
+
+		int mask = data.Mask & ~_mm_movemask_ps(_mm_cmplt_ps(tMax, tMin));
+		if (mask == 0)
+		{
+			continue;
+		}
+
+		while (!nodes[nodeIndex].IsLeaf())
+		{
+			const BIHFlatNode& node = nodes[nodeIndex];
+			uint32 a = node.GetAxis();
+
+			__m128 origin = packet.Origins[a];
+			__m128 invDirection = packet.InvDirections[a];
+
+			__m128 tNearSplit = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.LeftPlane), origin), invDirection);
+			__m128 tFarSplit = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.RightPlane), origin), invDirection);
+			int nearNode = nodeIndex + 1;
+			int farNode = (int)node.GetRightChild();
+
+			if (packet.Negative[a])
+			{
+				__m128 tmpSplit = tNearSplit;
+				tNearSplit = tFarSplit;
+				tFarSplit = tmpSplit;
+
+				int tmpNode = nearNode;
+				nearNode = farNode;
+				farNode = tmpNode;
+			}
+
+			// Negated compares so NaN lanes take the same branch as in the scalar walk
+			int nearMask = mask & _mm_movemask_ps(_mm_cmpngt_ps(tMin, tNearSplit));
+			int farMask = mask & _mm_movemask_ps(_mm_cmpnlt_ps(tMax, tFarSplit));
+
+			if (nearMask == 0 && farMask == 0)
+			{
+				goto stackloop;
+			}
+
+			if (nearMask == 0)
+			{
+				tMin = _mm_max_ps(tFarSplit, tMin);
+				nodeIndex = farNode;
+				mask = farMask;
+			}
+			else if (farMask == 0)
+			{
+				tMax = _mm_min_ps(tNearSplit, tMax);
+				nodeIndex = nearNode;
+				mask = nearMask;
+			}
+			else
+			{
+				assertCheck(stackSize < BIH_TRAVERSAL_STACK_SIZE);
+
+				stack[stackSize++] = BIHPacketStackData(farNode, farMask, _mm_max_ps(tFarSplit, tMin), tMax);
+				tMax = _mm_min_ps(tNearSplit, tMax);
+				nodeIndex = nearNode;
+				mask = nearMask;
+			}
+		}
+
+		// a leaf
+		const BIHFlatNode& leaf = nodes[nodeIndex];
+
+		IntersectLeafPacket(packet, mask, leaf.LeftIndex, leaf.RightIndex);
 	}
-	else
+}
+
+// Ray::IntersectWithTriangle for one triangle and four rays. The operations are done in the
+// same order as the scalar version so the distances come out bit for bit the same.
+void BIHTree::IntersectLeafPacket(BIHPacketRays& packet, int activeMask, int l, int r)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 minusOne = _mm_set1_ps(-1.0f);
+	const __m128 epsilon = _mm_set1_ps(FLT_EPSILON);
+	const __m128 minusEpsilon = _mm_set1_ps(-FLT_EPSILON);
+	const __m128 signBit = _mm_set1_ps(-0.0f);
+
+	const __m128& dirX = packet.Directions[0];
+	const __m128& dirY = packet.Directions[1];
+	const __m128& dirZ = packet.Directions[2];
+
+	Vector3 v0;
+	Vector3 v1;
+	Vector3 v2;
+
+	alignas(16) float distances[BIH_PACKET_SIZE];
+
+	for (int i = l; i <= r; i++)
 	{
-		//Build the node
-		BIHNode* node = new BIHNode(axis);
+		GetTriangle(i, v0, v1, v2);
 
-		//Left child
-		Box lbbox = Box(currentBox);
-		SetMinMax(lbbox, false, axis, split);
+		float edge1X = v1.x - v0.x;
+		float edge1Y = v1.y - v0.y;
+		float edge1Z = v1.z - v0.z;
 
-		//The left node right border is the plane most right
-		node->SetLeftPlane(GetMinMax(CreateBox(l, glm::max(l, pivot - 1)), false, axis));
-		node->SetLeftChild(CreateNode(l, glm::max(l, pivot - 1), lbbox, depth + 1)); //Recursive call
+		float edge2X = v2.x - v0.x;
+		float edge2Y = v2.y - v0.y;
+		float edge2Z = v2.z - v0.z;
 
-																					 //Right Child
-		Box rbbox = Box(currentBox);
-		SetMinMax(rbbox, true, axis, split);
-		//The right node left border is the plane most left
-		node->SetRightPlane(GetMinMax(CreateBox(pivot, r), true, axis));
-		node->SetRightChild(CreateNode(pivot, r, rbbox, depth + 1)); //Recursive call
+		__m128 normX = _mm_set1_ps((edge1Y * edge2Z) - (edge1Z * edge2Y));
+		__m128 normY = _mm_set1_ps((edge1Z * edge2X) - (edge1X * edge2Z));
+		__m128 normZ = _mm_set1_ps((edge1X * edge2Y) - (edge1Y * edge2X));
 
-		return node;
-	}
+		__m128 dirDotNorm = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dirX, normX), _mm_mul_ps(dirY, normY)), _mm_mul_ps(dirZ, normZ));
 
-	return nullptr;
+		__m128 positive = _mm_cmpgt_ps(dirDotNorm, epsilon);
+		__m128 negative = _mm_cmplt_ps(dirDotNorm, minusEpsilon);
+
+		// parallel rays drop out here
+		int hitMask = activeMask & _mm_movemask_ps(_mm_or_ps(positive, negative));
+		if (hitMask == 0)
+		{
+			continue;
+		}
+
+		__m128 sign = _mm_or_ps(_mm_and_ps(positive, one), _mm_and_ps(negative, minusOne));
+		dirDotNorm = _mm_xor_ps(dirDotNorm, _mm_and_ps(negative, signBit));
+
+		__m128 diffX = _mm_sub_ps(packet.Origins[0], _mm_set1_ps(v0.x));
+		__m128 diffY = _mm_sub_ps(packet.Origins[1], _mm_set1_ps(v0.y));
+		__m128 diffZ = _mm_sub_ps(packet.Origins[2], _mm_set1_ps(v0.z));
+
+		__m128 e1X = _mm_set1_ps(edge1X);
+		__m128 e1Y = _mm_set1_ps(edge1Y);
+		__m128 e1Z = _mm_set1_ps(edge1Z);
+
+		__m128 e2X = _mm_set1_ps(edge2X);
+		__m128 e2Y = _mm_set1_ps(edge2Y);
+		__m128 e2Z = _mm_set1_ps(edge2Z);
+
+		__m128 diffEdge2X = _mm_sub_ps(_mm_mul_ps(diffY, e2Z), _mm_mul_ps(diffZ, e2Y));
+		__m128 diffEdge2Y = _mm_sub_ps(_mm_mul_ps(diffZ, e2X), _mm_mul_ps(diffX, e2Z));
+		__m128 diffEdge2Z = _mm_sub_ps(_mm_mul_ps(diffX, e2Y), _mm_mul_ps(diffY, e2X));
+
+		__m128 dirDotDiffxEdge2 = _mm_mul_ps(sign, _mm_add_ps(_mm_add_ps(_mm_mul_ps(dirX, diffEdge2X), _mm_mul_ps(dirY, diffEdge2Y)), _mm_mul_ps(dirZ, diffEdge2Z)));
+
+		__m128 edge1xDiffX = _mm_sub_ps(_mm_mul_ps(e1Y, diffZ), _mm_mul_ps(e1Z, diffY));
+		__m128 edge1xDiffY = _mm_sub_ps(_mm_mul_ps(e1Z, diffX), _mm_mul_ps(e1X, diffZ));
+		__m128 edge1xDiffZ = _mm_sub_ps(_mm_mul_ps(e1X, diffY), _mm_mul_ps(e1Y, diffX));
+
+		__m128 dirDotEdge1xDiff = _mm_mul_ps(sign, _mm_add_ps(_mm_add_ps(_mm_mul_ps(dirX, edge1xDiffX), _mm_mul_ps(dirY, edge1xDiffY)), _mm_mul_ps(dirZ, edge1xDiffZ)));
+
+		__m128 diffDotNorm = _mm_mul_ps(_mm_xor_ps(sign, signBit), _mm_add_ps(_mm_add_ps(_mm_mul_ps(diffX, normX), _mm_mul_ps(diffY, normY)), _mm_mul_ps(diffZ, normZ)));
+
+		__m128 inside = _mm_and_ps(_mm_cmpge_ps(dirDotDiffxEdge2, zero), _mm_cmpge_ps(dirDotEdge1xDiff, zero));
+		inside = _mm_and_ps(inside, _mm_cmple_ps(_mm_add_ps(dirDotDiffxEdge2, dirDotEdge1xDiff), dirDotNorm));
+		inside = _mm_and_ps(inside, _mm_cmpge_ps(diffDotNorm, zero));
+
+		hitMask &= _mm_movemask_ps(inside);
+		if (hitMask == 0)
+		{
+			continue;
+		}
+
+		_mm_store_ps(distances, _mm_mul_ps(diffDotNorm, _mm_div_ps(one, dirDotNorm)));
+
+		for (int lane = 0; lane < BIH_PACKET_SIZE; lane++)
+		{
+			if (hitMask & (1 << lane))
+			{
+				RecordHit(packet.Traversals[lane], i, distances[lane]);
+			}
+		}
+
+		packet.Closest = _mm_setr_ps(packet.Traversals[0].Closest, packet.Traversals[1].Closest, packet.Traversals[2].Closest, packet.Traversals[3].Closest);
+	}
 }
 
 void BIHTree::SetMinMax(Box & bbox, bool doMin, int axis, float value)
@@ -215,7 +2081,7 @@ void BIHTree::SetMinMax(Box & bbox, bool doMin, int axis, float value)
 	bbox.SetMinMax(min, max);
 }
 
-float BIHTree::GetMinMax(Box & bbox, bool doMin, int axis)
+float BIHTree::GetMinMax(const Box & bbox, bool doMin, int axis)
 {
 	if (doMin)
 	{
@@ -262,11 +2128,14 @@ void BIHTree::SwapTriangles(int index1, int index2)
 	int p1 = index1 * 9;
 	int p2 = index2 * 9;
 
-	ArrayCopy(_PointData, p1, _BihSwapTmp, 0, 9);
+	// On the stack, subtrees may be sorted on several threads at once
+	float swapTmp[MAX_BIH_SWAP_TMP];
+
+	ArrayCopy(_PointData, p1, swapTmp, 0, 9);
 	// copy p2 to p1
 	ArrayCopy(_PointData, p2, _PointData, p1, 9);
 	// copy tmp to p2
-	ArrayCopy(_BihSwapTmp, 0, _PointData, p2, 9);
+	ArrayCopy(swapTmp, 0, _PointData, p2, 9);
 
 	int tmp2 = _TriIndices[index1];
 	_TriIndices[index1] = _TriIndices[index2];
@@ -284,20 +2153,22 @@ void BIHTree::ArrayCopy(float * src, int srcPos, float * dest, int destPos, int
 	}
 }
 
-void BIHTree::InitTriangles(Mesh* mesh)
+void BIHTree::InitTriangles(const List<VertexBufferEntry>& vertices, const List<uint32>& indices)
 {
-	_NumTris = (int)mesh->Indices.size();
+	_NumTris = (int)indices.size() / 3;
 	_NumPointData = _NumTris * 3 * 3;
 
-	// Fill vertex data
+	// Fill vertex data, triangles are expanded so the tree can reorder them freely
 	_PointData = new float[_NumPointData];
 
 	int p = 0;
-	for (VertexBufferEntry& e : mesh->VertexData)
+	for (int i = 0; i < _NumTris * 3; i++)
 	{
-		_PointData[p++] = e.Position.x;
-		_PointData[p++] = e.Position.y;
-		_PointData[p++] = e.Position.z;
+		const Vector3& position = vertices[indices[i]].Position;
+
+		_PointData[p++] = position.x;
+		_PointData[p++] = position.y;
+		_PointData[p++] = position.z;
 	}
 
 	// Fill index data
@@ -307,12 +2178,39 @@ void BIHTree::InitTriangles(Mesh* mesh)
 
 	for (int i = 0; i < _NumTriIndices; i++)
 	{
-		_TriIndices[i] = (int)mesh->Indices[i];
+		_TriIndices[i] = i;
 	}
 }
 
 void BIHTree::ConstructRootNode()
 {
+	double buildStart = Time::getTime();
+
+	_BuildStats = {};
+
 	Box sceneBbox = CreateBox(0, _NumTris - 1);
-	_Root = CreateNode(0, _NumTris - 1, sceneBbox, 0);
+
+	if (_Layout == BIHLayout::Flat)
+	{
+		// Every leaf holds at least one triangle, so the tree can never have more than 2n - 1 nodes
+		_FlatNodes.reserve(glm::max(1, _NumTris * 2 - 1));
+
+		CreateFlatNode(0, _NumTris - 1, sceneBbox, sceneBbox, 0, _FlatNodes, _BuildStats);
+
+		_FlatNodes.shrink_to_fit();
+	}
+	else
+	{
+		_Root = CreateNode(0, _NumTris - 1, sceneBbox, sceneBbox, 0, _BuildStats);
+	}
+
+	// The pool belongs to the caller and is not needed after the build
+	_BuildPool = nullptr;
+
+	_BuildStats.BuildTime = Time::getTime() - buildStart;
+
+	if (_BuildStats.LeafCount > 0)
+	{
+		_BuildStats.AverageLeafSize /= _BuildStats.LeafCount;
+	}
 }
\ No newline at end of file
@@ -1,22 +1,96 @@
 #pragma once
 
 #include "Hydra/Core/Vector.h"
+#include "Hydra/Core/Function.h"
 #include "Hydra/Physics/Collisons/Ray.h"
 #include "Hydra/Physics/Collisons/CollisionResults.h"
+#include "Hydra/Physics/Collisons/BIH/BIHNode.h"
 
-class BIHNode;
 class Box;
+class File;
 class Mesh;
+class ThreadPool;
+struct VertexBufferEntry;
+struct BIHPacketRays;
+struct BIHSAHBinSet;
+struct BIHShapeQuery;
 
 constexpr int MAX_BIH_SWAP_TMP = 9;
 
+struct BIHLayout
+{
+	enum Enum
+	{
+		// Every node is allocated separately and linked through Left/Right pointers
+		Pointer,
+		// All nodes are written depth first into one contiguous array of BIHFlatNode
+		Flat
+	};
+};
+
+struct BIHSplitMethod
+{
+	enum Enum
+	{
+		// Split at the box centre on the axis with the largest empty extent
+		Centre,
+		// Binned surface area heuristic, slower to build but better balanced on long and thin meshes
+		SAH
+	};
+};
+
+struct BIHBuildStats
+{
+	double BuildTime;
+	int Depth;
+	int NodeCount;
+	int LeafCount;
+	float AverageLeafSize;
+};
+
+constexpr int BIH_SAH_BIN_COUNT = 16;
+
+// With a thread pool, subtrees of at least this many triangles are built on separate threads
+constexpr int BIH_PARALLEL_SUBTREE_SIZE = 16384;
+
+// Bounds and SAH bins of bigger ranges are gathered in chunks of this many triangles in parallel
+constexpr int BIH_PARALLEL_CHUNK_SIZE = 8192;
+
+// Sweeps stop once the shape is closer to a triangle than this fraction of its radius
+constexpr float BIH_SWEEP_TOLERANCE = 1e-3f;
+
+// Advancement steps per swept triangle, grazing contacts can take a few
+constexpr int BIH_SWEEP_MAX_ITERATIONS = 16;
+
+// A refit rebuilds the tree when it makes the tree this much more expensive to traverse than after its build
+constexpr float BIH_REFIT_REBUILD_RATIO = 1.5f;
+
+// Bump when the saved tree format changes, files of other versions are rebuilt
+constexpr uint32 BIH_FILE_VERSION = 1;
+
+// Rays traversed together by CollideWithRayPacket, one SSE lane per ray
+constexpr int BIH_PACKET_SIZE = 4;
+
+// Build settings of the complex colliders of meshes, they are part of the source hash so cached trees are rebuilt when
+// they change
+constexpr int BIH_MESH_COLLIDER_MAX_TRIS_PER_NODE = 21;
+constexpr BIHLayout::Enum BIH_MESH_COLLIDER_LAYOUT = BIHLayout::Flat;
+constexpr BIHSplitMethod::Enum BIH_MESH_COLLIDER_SPLIT_METHOD = BIHSplitMethod::SAH;
+
 class HYDRA_API BIHTree
 {
 private:
-	const int MAX_TREE_DEPTH = 100;
+	const int MAX_TREE_DEPTH = BIH_MAX_TREE_DEPTH;
 	const int MAX_TRIS_PER_NODE = 21;
 
 	int _MaxTrisPerNode;
+	BIHLayout::Enum _Layout;
+	BIHSplitMethod::Enum _SplitMethod;
+
+	BIHBuildStats _BuildStats;
+
+	// Cost of the tree after its last build, relative to the root area. Negative until the first refit.
+	float _BuildCost;
 
 	int _NumTris;
 	int _NumPointData;
@@ -25,32 +99,123 @@ private:
 	float* _PointData;
 	int* _TriIndices;
 
-	float _BihSwapTmp[MAX_BIH_SWAP_TMP];
-
-	CollisionResults _BBoxTempRes;
+	// Only set while the constructor builds the tree
+	ThreadPool* _BuildPool;
 
 	BIHNode* _Root;
 
+	List<BIHFlatNode> _FlatNodes;
+
 public:
-	BIHTree(Mesh* mesh, int maxTrisPerNode);
+	// With a thread pool big trees are built in parallel, the result is the same as the one of the serial build
+	BIHTree(Mesh* mesh, int maxTrisPerNode, BIHLayout::Enum layout = BIHLayout::Pointer, BIHSplitMethod::Enum splitMethod = BIHSplitMethod::Centre, ThreadPool* threadPool = nullptr);
 	BIHTree(Mesh* mesh);
+	BIHTree(const List<VertexBufferEntry>& vertices, const List<uint32>& indices, int maxTrisPerNode, BIHLayout::Enum layout = BIHLayout::Pointer, BIHSplitMethod::Enum splitMethod = BIHSplitMethod::Centre, ThreadPool* threadPool = nullptr);
 	~BIHTree();
 
 	void GetTriangle(int index, Vector3 &v1, Vector3 &v2, Vector3 &v3);
 	int GetTriangleIndex(int triIndex);
 
+	BIHLayout::Enum GetLayout() const;
+	BIHSplitMethod::Enum GetSplitMethod() const;
+	int GetNodeCount() const;
+
+	const BIHBuildStats& GetBuildStats() const;
+	void LogBuildStats(const String& name) const;
+
+	// True when both trees hold the same triangle order and the same nodes bit for bit
+	bool IsIdentical(const BIHTree& other) const;
+
+	// Moves the triangles to the new positions of their vertices and recomputes the planes bottom up in O(n).
+	// The indices have to describe the same triangles the tree was built from. When the surface area cost of
+	// the refitted tree is more than rebuildRatio times the cost after the build, the tree is rebuilt instead.
+	// Returns true when it was rebuilt.
+	bool Refit(const List<VertexBufferEntry>& vertices, const List<uint32>& indices, float rebuildRatio = BIH_REFIT_REBUILD_RATIO, ThreadPool* threadPool = nullptr);
+
+	// Hash of the triangles and build settings, a saved tree is only loaded back when it matches
+	static uint64 GetSourceHash(const List<VertexBufferEntry>& vertices, const List<uint32>& indices, int maxTrisPerNode, BIHLayout::Enum layout, BIHSplitMethod::Enum splitMethod);
+
+	// Writes the reordered triangles and the nodes as they are in memory. Only the flat layout can be saved.
+	bool Save(const File& file, uint64 sourceHash) const;
+
+	// Reads the whole file at once and copies it into place without building anything.
+	// Returns nullptr when the file is missing, of another version or saved for other source data.
+	static BIHTree* Load(const File& file, uint64 sourceHash);
+
 	int CollideWithRay(const Ray& r, const Matrix4& worldMatrix, Box* worldBound, CollisionResults &results);
+
+	// worldToLocal has to be the inverse of worldMatrix. Callers casting many rays against the same
+	// object compute it once, the query itself does not allocate.
+	int CollideWithRay(const Ray& r, const Matrix4& worldMatrix, const Matrix4& worldToLocal, const Box* worldBound, CollisionResults &results, BIHQueryMode::Enum mode = BIHQueryMode::AllHits);
+
+	// Casts the rays in packets of BIH_PACKET_SIZE, results has to hold one entry per ray. Packets only
+	// work on the flat layout and need all rays of a packet to point into the same octant, otherwise
+	// the rays are cast one by one. The hits are the same as the ones of CollideWithRay.
+	int CollideWithRayPacket(const Ray* rays, int rayCount, const Matrix4& worldMatrix, const Matrix4& worldToLocal, const Box* worldBound, CollisionResults* results, BIHQueryMode::Enum mode = BIHQueryMode::AllHits);
+
+	// The shape queries take their shapes in world space and only support a worldMatrix that scales uniformly.
+	// Overlaps add one result per touched triangle, with the closest point on the triangle, the normal that pushes
+	// the shape out of it and the distance between the shape surface and the triangle, negative when they intersect.
+	int OverlapSphere(const Vector3& center, float radius, const Matrix4& worldMatrix, const Matrix4& worldToLocal, CollisionResults& results);
+	int OverlapCapsule(const Vector3& start, const Vector3& end, float radius, const Matrix4& worldMatrix, const Matrix4& worldToLocal, CollisionResults& results);
+
+	// Sweeps move the shape along the direction, which does not need to be normalized, and add the first contact with
+	// every triangle it reaches within maxDistance. The result distance is how far the shape can move before it touches the triangle.
+	int SweepSphere(const Vector3& center, float radius, const Vector3& direction, float maxDistance, const Matrix4& worldMatrix, const Matrix4& worldToLocal, CollisionResults& results, BIHQueryMode::Enum mode = BIHQueryMode::AllHits);
+	int SweepCapsule(const Vector3& start, const Vector3& end, float radius, const Vector3& direction, float maxDistance, const Matrix4& worldMatrix, const Matrix4& worldToLocal, CollisionResults& results, BIHQueryMode::Enum mode = BIHQueryMode::AllHits);
+
+	void IntersectLeaf(BIHRayTraversal& traversal, int l, int r);
 private:
+	BIHTree();
+
 	Box CreateBox(int l, int r);
-	BIHNode* CreateNode(int l, int r, const Box& nodeBbox, int depth);
+	void GetBoundsRange(int l, int r, Vector3& min, Vector3& max);
+	BIHNode* CreateNode(int l, int r, const Box& nodeBbox, const Box& currentBox, int depth, BIHBuildStats& stats);
+	int CreateFlatNode(int l, int r, const Box& nodeBbox, const Box& currentBox, int depth, List<BIHFlatNode>& nodes, BIHBuildStats& stats);
+	int PartitionNode(int l, int r, const Box& nodeBbox, const Box& currentBox, int& axis, float& split);
+	bool FindSAHSplit(int l, int r, int& axis, float& split);
+	void GetCentroidRange(int l, int r, Vector3& min, Vector3& max);
+	void BinRange(int l, int r, const Vector3& centroidMin, const Vector3& binScale, BIHSAHBinSet& binSet);
+	void RecordNode(int l, int r, int depth, bool leaf, BIHBuildStats& stats);
+
+	void Rebuild(const List<VertexBufferEntry>& vertices, const List<uint32>& indices, ThreadPool* threadPool);
+	float UpdatePlanes(bool writePlanes);
+	void RefitNode(BIHNode* node, bool writePlanes, Vector3& min, Vector3& max, float& cost);
+	void RefitFlatNode(int index, bool writePlanes, Vector3& min, Vector3& max, float& cost);
+
+	int GetBuildChunkCount(int l, int r) const;
+	void ForEachBuildChunk(int l, int r, int chunkCount, const Function<void(int chunk, int l, int r)>& body);
+	bool IsParallelSubtree(int l, int r) const;
+
+	bool GetRayRange(const Ray& r, const Box* worldBound, float& tMin, float& tMax) const;
+	void PrepareTraversal(BIHRayTraversal& traversal, const Ray& r, const Matrix4& worldMatrix, const Matrix4& worldToLocal, CollisionResults& results, BIHQueryMode::Enum mode) const;
+	int TraverseRay(BIHRayTraversal& traversal, float tMin, float tMax);
+	void RecordHit(BIHRayTraversal& traversal, int triangle, float t);
+	void AddHit(BIHRayTraversal& traversal, int triangle, float t);
+	static float GetResultsLimit(const CollisionResults& results, const Vector3& worldDirection);
+
+	int IntersectFlat(BIHRayTraversal& traversal, float sceneMin, float sceneMax);
+
+	void PrepareShapeQuery(BIHShapeQuery& query, const Vector3& start, const Vector3& end, float radius, const Vector3& direction, const Matrix4& worldMatrix, const Matrix4& worldToLocal, CollisionResults& results) const;
+	bool SweepTriangle(const BIHShapeQuery& query, const Vector3& v1, const Vector3& v2, const Vector3& v3, float maxDistance, float& t, Vector3& onTriangle, Vector3& normal) const;
+	Vector3 GetShapeNormal(const BIHShapeQuery& query, const Vector3& onShape, const Vector3& onTriangle, const Vector3& triangleNormal) const;
+	void AddShapeHit(BIHShapeQuery& query, int triangle, const Vector3& onTriangle, const Vector3& normal, float distance);
+
+	// Calls leaf with the triangle range of every leaf the box reaches, until leaf returns false
+	template<typename LeafCallback>
+	void QueryBox(const Vector3& min, const Vector3& max, LeafCallback&& leaf);
+
+	int CollidePacket(const Ray* rays, const Matrix4& worldMatrix, const Matrix4& worldToLocal, const Box* worldBound, CollisionResults* results, BIHQueryMode::Enum mode);
+	void IntersectFlatPacket(BIHPacketRays& packet, int activeMask, float* sceneMin, float* sceneMax);
+	void IntersectLeafPacket(BIHPacketRays& packet, int activeMask, int l, int r);
 
 	void SetMinMax(Box& bbox, bool doMin, int axis, float value);
-	float GetMinMax(Box& bbox, bool doMin, int axis);
+	float GetMinMax(const Box& bbox, bool doMin, int axis);
 
 	int SortTriangles(int l, int r, float split, int axis);
 	void SwapTriangles(int index1, int index2);
 	void ArrayCopy(float* src, int srcPos, float* dest, int destPos, int length);
 private:
-	void InitTriangles(Mesh* mesh);
+	void InitTriangles(const List<VertexBufferEntry>& vertices, const List<uint32>& indices);
 	void ConstructRootNode();
 };
\ No newline at end of file
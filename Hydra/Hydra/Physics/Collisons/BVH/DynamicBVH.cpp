@@ -0,0 +1,382 @@
+#include "Hydra/Physics/Collisons/BVH/DynamicBVH.h"
+
+DynamicBVH::DynamicBVH(float margin) : _Root(BVH_NULL_NODE), _FreeList(BVH_NULL_NODE), _ProxyCount(0), _Margin(margin)
+{
+}
+
+int32 DynamicBVH::CreateProxy(const Box& bounds, void* userData)
+{
+	int32 proxy = AllocateNode();
+
+	DynamicBVHNode& node = _Nodes[proxy];
+	node.Min = bounds.GetMin() - Vector3(_Margin);
+	node.Max = bounds.GetMax() + Vector3(_Margin);
+	node.UserData = userData;
+	node.Height = 0;
+
+	InsertLeaf(proxy);
+
+	_ProxyCount++;
+
+	return proxy;
+}
+
+void DynamicBVH::DestroyProxy(int32 proxy)
+{
+	assertCheck(proxy >= 0 && proxy < (int32)_Nodes.size() && _Nodes[proxy].IsLeaf());
+
+	RemoveLeaf(proxy);
+	FreeNode(proxy);
+
+	_ProxyCount--;
+}
+
+bool DynamicBVH::MoveProxy(int32 proxy, const Box& bounds)
+{
+	assertCheck(proxy >= 0 && proxy < (int32)_Nodes.size() && _Nodes[proxy].IsLeaf());
+
+	DynamicBVHNode& node = _Nodes[proxy];
+
+	Vector3 min = bounds.GetMin();
+	Vector3 max = bounds.GetMax();
+
+	if (node.Min.x <= min.x && node.Min.y <= min.y && node.Min.z <= min.z &&
+		node.Max.x >= max.x && node.Max.y >= max.y && node.Max.z >= max.z)
+	{
+		return false;
+	}
+
+	RemoveLeaf(proxy);
+
+	node.Min = min - Vector3(_Margin);
+	node.Max = max + Vector3(_Margin);
+
+	InsertLeaf(proxy);
+
+	return true;
+}
+
+void DynamicBVH::Clear()
+{
+	_Nodes.clear();
+
+	_Root = BVH_NULL_NODE;
+	_FreeList = BVH_NULL_NODE;
+	_ProxyCount = 0;
+}
+
+Box DynamicBVH::GetFatBounds(int32 proxy) const
+{
+	const DynamicBVHNode& node = _Nodes[proxy];
+
+	return Box(BBMM node.Min, node.Max);
+}
+
+int32 DynamicBVH::GetProxyCount() const
+{
+	return _ProxyCount;
+}
+
+int32 DynamicBVH::GetHeight() const
+{
+	if (_Root == BVH_NULL_NODE)
+	{
+		return 0;
+	}
+
+	return _Nodes[_Root].Height;
+}
+
+float DynamicBVH::GetAreaRatio() const
+{
+	if (_Root == BVH_NULL_NODE)
+	{
+		return 0.0f;
+	}
+
+	const DynamicBVHNode& root = _Nodes[_Root];
+	float rootArea = HalfSurfaceArea(root.Min, root.Max);
+
+	float totalArea = 0.0f;
+
+	for (const DynamicBVHNode& node : _Nodes)
+	{
+		if (node.Height > 0)
+		{
+			totalArea += HalfSurfaceArea(node.Min, node.Max);
+		}
+	}
+
+	return rootArea > 0.0f ? totalArea / rootArea : 0.0f;
+}
+
+int32 DynamicBVH::AllocateNode()
+{
+	int32 index;
+
+	if (_FreeList != BVH_NULL_NODE)
+	{
+		index = _FreeList;
+		_FreeList = _Nodes[index].Parent;
+	}
+	else
+	{
+		index = (int32)_Nodes.size();
+		_Nodes.emplace_back();
+	}
+
+	DynamicBVHNode& node = _Nodes[index];
+	node.UserData = nullptr;
+	node.Parent = BVH_NULL_NODE;
+	node.Child1 = BVH_NULL_NODE;
+	node.Child2 = BVH_NULL_NODE;
+	node.Height = 0;
+
+	return index;
+}
+
+void DynamicBVH::FreeNode(int32 index)
+{
+	DynamicBVHNode& node = _Nodes[index];
+	node.Parent = _FreeList;
+	node.Height = -1;
+
+	_FreeList = index;
+}
+
+void DynamicBVH::InsertLeaf(int32 leaf)
+{
+	if (_Root == BVH_NULL_NODE)
+	{
+		_Root = leaf;
+		_Nodes[_Root].Parent = BVH_NULL_NODE;
+		return;
+	}
+
+	// Find the best sibling by walking down the cheapest path, the cost is the surface area added to the tree
+	Vector3 leafMin = _Nodes[leaf].Min;
+	Vector3 leafMax = _Nodes[leaf].Max;
+
+	int32 index = _Root;
+
+	while (!_Nodes[index].IsLeaf())
+	{
+		const DynamicBVHNode& node = _Nodes[index];
+		int32 child1 = node.Child1;
+		int32 child2 = node.Child2;
+
+		float area = HalfSurfaceArea(node.Min, node.Max);
+		float combinedArea = HalfSurfaceArea(glm::min(node.Min, leafMin), glm::max(node.Max, leafMax));
+
+		// Cost of making a new parent for this node and the leaf
+		float cost = 2.0f * combinedArea;
+
+		// Minimum cost of pushing the leaf further down
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		float costs[2];
+		int32 children[2] = { child1, child2 };
+
+		for (int i = 0; i < 2; i++)
+		{
+			const DynamicBVHNode& child = _Nodes[children[i]];
+			float newArea = HalfSurfaceArea(glm::min(child.Min, leafMin), glm::max(child.Max, leafMax));
+
+			if (child.IsLeaf())
+			{
+				costs[i] = newArea + inheritanceCost;
+			}
+			else
+			{
+				costs[i] = (newArea - HalfSurfaceArea(child.Min, child.Max)) + inheritanceCost;
+			}
+		}
+
+		if (cost < costs[0] && cost < costs[1])
+		{
+			break;
+		}
+
+		index = costs[0] < costs[1] ? child1 : child2;
+	}
+
+	int32 sibling = index;
+
+	// Create a new parent
+	int32 oldParent = _Nodes[sibling].Parent;
+	int32 newParent = AllocateNode();
+
+	DynamicBVHNode& parentNode = _Nodes[newParent];
+	parentNode.Parent = oldParent;
+	parentNode.Min = glm::min(_Nodes[sibling].Min, leafMin);
+	parentNode.Max = glm::max(_Nodes[sibling].Max, leafMax);
+	parentNode.Height = _Nodes[sibling].Height + 1;
+	parentNode.Child1 = sibling;
+	parentNode.Child2 = leaf;
+
+	if (oldParent != BVH_NULL_NODE)
+	{
+		if (_Nodes[oldParent].Child1 == sibling)
+		{
+			_Nodes[oldParent].Child1 = newParent;
+		}
+		else
+		{
+			_Nodes[oldParent].Child2 = newParent;
+		}
+	}
+	else
+	{
+		_Root = newParent;
+	}
+
+	_Nodes[sibling].Parent = newParent;
+	_Nodes[leaf].Parent = newParent;
+
+	RefitAncestors(_Nodes[leaf].Parent);
+}
+
+void DynamicBVH::RemoveLeaf(int32 leaf)
+{
+	if (leaf == _Root)
+	{
+		_Root = BVH_NULL_NODE;
+		return;
+	}
+
+	int32 parent = _Nodes[leaf].Parent;
+	int32 grandParent = _Nodes[parent].Parent;
+	int32 sibling = _Nodes[parent].Child1 == leaf ? _Nodes[parent].Child2 : _Nodes[parent].Child1;
+
+	if (grandParent != BVH_NULL_NODE)
+	{
+		// The sibling takes the place of the parent
+		if (_Nodes[grandParent].Child1 == parent)
+		{
+			_Nodes[grandParent].Child1 = sibling;
+		}
+		else
+		{
+			_Nodes[grandParent].Child2 = sibling;
+		}
+
+		_Nodes[sibling].Parent = grandParent;
+		FreeNode(parent);
+
+		RefitAncestors(grandParent);
+	}
+	else
+	{
+		_Root = sibling;
+		_Nodes[sibling].Parent = BVH_NULL_NODE;
+		FreeNode(parent);
+	}
+}
+
+void DynamicBVH::RefitAncestors(int32 index)
+{
+	while (index != BVH_NULL_NODE)
+	{
+		index = Balance(index);
+
+		DynamicBVHNode& node = _Nodes[index];
+		const DynamicBVHNode& child1 = _Nodes[node.Child1];
+		const DynamicBVHNode& child2 = _Nodes[node.Child2];
+
+		node.Height = 1 + glm::max(child1.Height, child2.Height);
+		node.Min = glm::min(child1.Min, child2.Min);
+		node.Max = glm::max(child1.Max, child2.Max);
+
+		index = node.Parent;
+	}
+}
+
+// Rotates the taller child up when the subtree heights differ by more than one, returns the new root of the subtree
+int32 DynamicBVH::Balance(int32 iA)
+{
+	DynamicBVHNode* A = &_Nodes[iA];
+
+	if (A->IsLeaf() || A->Height < 2)
+	{
+		return iA;
+	}
+
+	int32 iB = A->Child1;
+	int32 iC = A->Child2;
+
+	DynamicBVHNode* B = &_Nodes[iB];
+	DynamicBVHNode* C = &_Nodes[iC];
+
+	int32 balance = C->Height - B->Height;
+
+	if (balance > 1 || balance < -1)
+	{
+		// Rotate the higher child (E) up, A becomes its child
+		bool rotateC = balance > 1;
+
+		int32 iE = rotateC ? iC : iB;
+		int32 iOther = rotateC ? iB : iC;
+
+		DynamicBVHNode* E = &_Nodes[iE];
+		DynamicBVHNode* other = &_Nodes[iOther];
+
+		int32 iF = E->Child1;
+		int32 iG = E->Child2;
+
+		DynamicBVHNode* F = &_Nodes[iF];
+		DynamicBVHNode* G = &_Nodes[iG];
+
+		// Swap A and E
+		E->Child1 = iA;
+		E->Parent = A->Parent;
+		A->Parent = iE;
+
+		if (E->Parent != BVH_NULL_NODE)
+		{
+			if (_Nodes[E->Parent].Child1 == iA)
+			{
+				_Nodes[E->Parent].Child1 = iE;
+			}
+			else
+			{
+				_Nodes[E->Parent].Child2 = iE;
+			}
+		}
+		else
+		{
+			_Root = iE;
+		}
+
+		// The taller grand child stays with E, the other one goes to A
+		int32 iKeep = F->Height > G->Height ? iF : iG;
+		int32 iMove = F->Height > G->Height ? iG : iF;
+
+		DynamicBVHNode* keep = &_Nodes[iKeep];
+		DynamicBVHNode* move = &_Nodes[iMove];
+
+		E->Child2 = iKeep;
+
+		if (rotateC)
+		{
+			A->Child2 = iMove;
+		}
+		else
+		{
+			A->Child1 = iMove;
+		}
+
+		move->Parent = iA;
+
+		A->Min = glm::min(other->Min, move->Min);
+		A->Max = glm::max(other->Max, move->Max);
+		A->Height = 1 + glm::max(other->Height, move->Height);
+
+		E->Min = glm::min(A->Min, keep->Min);
+		E->Max = glm::max(A->Max, keep->Max);
+		E->Height = 1 + glm::max(A->Height, keep->Height);
+
+		return iE;
+	}
+
+	return iA;
+}
@@ -0,0 +1,322 @@
+#pragma once
+
+#include "Hydra/Core/Common.h"
+#include "Hydra/Core/Vector.h"
+#include "Hydra/Core/Math/Box.h"
+#include "Hydra/Core/Math/Frustum.h"
+#include "Hydra/Physics/Collisons/Ray.h"
+
+constexpr int32 BVH_NULL_NODE = -1;
+
+// The tree is kept balanced by rotations, so its height stays logarithmic and a fixed stack is enough for queries
+constexpr int BVH_QUERY_STACK_SIZE = 256;
+
+struct DynamicBVHNode
+{
+	// Fattened bounds, leaves only have to be reinserted once their object leaves them
+	Vector3 Min;
+	Vector3 Max;
+
+	void* UserData;
+
+	// Next free node while the node is in the free list
+	int32 Parent;
+	int32 Child1;
+	int32 Child2;
+
+	// 0 for leaves, -1 for free nodes
+	int32 Height;
+
+	FORCEINLINE bool IsLeaf() const
+	{
+		return Child1 == BVH_NULL_NODE;
+	}
+};
+
+// Dynamic bounding volume hierarchy over axis aligned boxes. Every object is a leaf (proxy), proxies
+// can be inserted, removed and moved at any time, the inner nodes are refit and rotated on the way.
+class HYDRA_API DynamicBVH
+{
+private:
+	List<DynamicBVHNode> _Nodes;
+
+	int32 _Root;
+	int32 _FreeList;
+	int32 _ProxyCount;
+
+	float _Margin;
+
+public:
+	// Leaf bounds are grown by margin on every side
+	DynamicBVH(float margin = 0.1f);
+
+	int32 CreateProxy(const Box& bounds, void* userData);
+	void DestroyProxy(int32 proxy);
+
+	// Returns true when the proxy left its fat bounds and was reinserted
+	bool MoveProxy(int32 proxy, const Box& bounds);
+
+	void Clear();
+
+	FORCEINLINE void* GetUserData(int32 proxy) const
+	{
+		return _Nodes[proxy].UserData;
+	}
+
+	Box GetFatBounds(int32 proxy) const;
+
+	int32 GetProxyCount() const;
+	int32 GetHeight() const;
+
+	// Sum of the inner node surfaces over the root surface, grows as the tree degrades
+	float GetAreaRatio() const;
+
+	// Calls callback(proxy) for every proxy whose fat bounds overlap the box, return false from it to stop
+	template<typename Callback>
+	void QueryOverlap(const Box& bounds, Callback&& callback) const;
+
+	// Calls callback(proxy) for every proxy whose fat bounds are at least partially inside the frustum
+	template<typename Callback>
+	void QueryFrustum(const Frustum& frustum, Callback&& callback) const;
+
+	// Calls callback(proxy, tNear) for every proxy whose fat bounds the ray enters before maxDistance, near
+	// subtrees first. The callback returns the new max distance, so closest hit searches can shrink it.
+	// A negative value stops the query.
+	template<typename Callback>
+	void QueryRay(const Ray& ray, float maxDistance, Callback&& callback) const;
+
+private:
+	int32 AllocateNode();
+	void FreeNode(int32 node);
+
+	void InsertLeaf(int32 leaf);
+	void RemoveLeaf(int32 leaf);
+
+	int32 Balance(int32 node);
+	void RefitAncestors(int32 node);
+
+	template<typename Callback>
+	void ReportSubtree(int32 node, Callback& callback) const;
+
+	FORCEINLINE static float HalfSurfaceArea(const Vector3& min, const Vector3& max)
+	{
+		Vector3 d = max - min;
+		return d.x * d.y + d.y * d.z + d.z * d.x;
+	}
+
+	FORCEINLINE static bool Overlaps(const DynamicBVHNode& node, const Vector3& min, const Vector3& max)
+	{
+		return node.Min.x <= max.x && node.Max.x >= min.x &&
+			node.Min.y <= max.y && node.Max.y >= min.y &&
+			node.Min.z <= max.z && node.Max.z >= min.z;
+	}
+
+	FORCEINLINE static bool IntersectRay(const DynamicBVHNode& node, const Vector3& origin, const Vector3& invDirection, float maxDistance, float& tNear)
+	{
+		Vector3 t1 = (node.Min - origin) * invDirection;
+		Vector3 t2 = (node.Max - origin) * invDirection;
+
+		Vector3 tMin = glm::min(t1, t2);
+		Vector3 tMax = glm::max(t1, t2);
+
+		tNear = glm::max(glm::max(tMin.x, tMin.y), glm::max(tMin.z, 0.0f));
+		float tFar = glm::min(glm::min(tMax.x, tMax.y), glm::min(tMax.z, maxDistance));
+
+		return tNear <= tFar;
+	}
+};
+
+template<typename Callback>
+void DynamicBVH::QueryOverlap(const Box& bounds, Callback&& callback) const
+{
+	if (_Root == BVH_NULL_NODE)
+	{
+		return;
+	}
+
+	Vector3 min = bounds.GetMin();
+	Vector3 max = bounds.GetMax();
+
+	int32 stack[BVH_QUERY_STACK_SIZE];
+	int stackSize = 0;
+
+	stack[stackSize++] = _Root;
+
+	while (stackSize > 0)
+	{
+		const DynamicBVHNode& node = _Nodes[stack[--stackSize]];
+
+		if (!Overlaps(node, min, max))
+		{
+			continue;
+		}
+
+		if (node.IsLeaf())
+		{
+			if (!callback((int32)(&node - _Nodes.data())))
+			{
+				return;
+			}
+		}
+		else
+		{
+			assertCheck(stackSize + 2 <= BVH_QUERY_STACK_SIZE);
+
+			stack[stackSize++] = node.Child1;
+			stack[stackSize++] = node.Child2;
+		}
+	}
+}
+
+template<typename Callback>
+void DynamicBVH::QueryFrustum(const Frustum& frustum, Callback&& callback) const
+{
+	if (_Root == BVH_NULL_NODE)
+	{
+		return;
+	}
+
+	int32 stack[BVH_QUERY_STACK_SIZE];
+	int stackSize = 0;
+
+	stack[stackSize++] = _Root;
+
+	while (stackSize > 0)
+	{
+		int32 index = stack[--stackSize];
+		const DynamicBVHNode& node = _Nodes[index];
+
+		FrustumTest::Enum test = frustum.TestBox(node.Min, node.Max);
+
+		if (test == FrustumTest::Outside)
+		{
+			continue;
+		}
+
+		// Everything below a node that is fully inside is visible, the planes do not have to be tested again
+		if (test == FrustumTest::Inside || node.IsLeaf())
+		{
+			ReportSubtree(index, callback);
+		}
+		else
+		{
+			assertCheck(stackSize + 2 <= BVH_QUERY_STACK_SIZE);
+
+			stack[stackSize++] = node.Child1;
+			stack[stackSize++] = node.Child2;
+		}
+	}
+}
+
+template<typename Callback>
+void DynamicBVH::QueryRay(const Ray& ray, float maxDistance, Callback&& callback) const
+{
+	if (_Root == BVH_NULL_NODE)
+	{
+		return;
+	}
+
+	Vector3 origin = ray.Origin;
+	Vector3 invDirection = 1.0f / ray.Direction;
+
+	float tNear;
+
+	if (!IntersectRay(_Nodes[_Root], origin, invDirection, maxDistance, tNear))
+	{
+		return;
+	}
+
+	struct RayStackEntry
+	{
+		int32 Node;
+		float Distance;
+	};
+
+	RayStackEntry stack[BVH_QUERY_STACK_SIZE];
+	int stackSize = 0;
+
+	stack[stackSize++] = { _Root, tNear };
+
+	while (stackSize > 0)
+	{
+		RayStackEntry entry = stack[--stackSize];
+
+		// maxDistance may have shrunk since the entry was pushed
+		if (entry.Distance > maxDistance)
+		{
+			continue;
+		}
+
+		const DynamicBVHNode& node = _Nodes[entry.Node];
+
+		if (node.IsLeaf())
+		{
+			maxDistance = callback(entry.Node, entry.Distance);
+
+			if (maxDistance < 0.0f)
+			{
+				return;
+			}
+
+			continue;
+		}
+
+		float tNear1;
+		float tNear2;
+
+		bool hit1 = IntersectRay(_Nodes[node.Child1], origin, invDirection, maxDistance, tNear1);
+		bool hit2 = IntersectRay(_Nodes[node.Child2], origin, invDirection, maxDistance, tNear2);
+
+		assertCheck(stackSize + 2 <= BVH_QUERY_STACK_SIZE);
+
+		// The nearer child is pushed last so it is visited first
+		if (hit1 && hit2)
+		{
+			if (tNear1 < tNear2)
+			{
+				stack[stackSize++] = { node.Child2, tNear2 };
+				stack[stackSize++] = { node.Child1, tNear1 };
+			}
+			else
+			{
+				stack[stackSize++] = { node.Child1, tNear1 };
+				stack[stackSize++] = { node.Child2, tNear2 };
+			}
+		}
+		else if (hit1)
+		{
+			stack[stackSize++] = { node.Child1, tNear1 };
+		}
+		else if (hit2)
+		{
+			stack[stackSize++] = { node.Child2, tNear2 };
+		}
+	}
+}
+
+template<typename Callback>
+void DynamicBVH::ReportSubtree(int32 root, Callback& callback) const
+{
+	int32 stack[BVH_QUERY_STACK_SIZE];
+	int stackSize = 0;
+
+	stack[stackSize++] = root;
+
+	while (stackSize > 0)
+	{
+		int32 index = stack[--stackSize];
+		const DynamicBVHNode& node = _Nodes[index];
+
+		if (node.IsLeaf())
+		{
+			callback(index);
+		}
+		else
+		{
+			assertCheck(stackSize + 2 <= BVH_QUERY_STACK_SIZE);
+
+			stack[stackSize++] = node.Child1;
+			stack[stackSize++] = node.Child2;
+		}
+	}
+}
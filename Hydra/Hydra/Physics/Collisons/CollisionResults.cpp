@@ -1,29 +1,92 @@
 #include "Hydra/Physics/Collisons/CollisionResults.h"
-#include "Hydra/Core/Sort.h"
 
-int compareCollisionResults(const CollisionResult left, const CollisionResult right)
+#include <algorithm>
+
+static bool CompareCollisionResults(const CollisionResult& left, const CollisionResult& right)
 {
-	return SORT_MIN_MAX(left.Distance, right.Distance);
+	return left.Distance < right.Distance;
 }
 
-CollisionResults::CollisionResults() : _results()
+CollisionResults::CollisionResults(CollisionResultMode::Enum mode, int maxResults) : _mode(mode), _maxResults(glm::max(maxResults, 1)), _count(0), _overflow()
 {
 }
 
-void CollisionResults::Clear()
+void CollisionResults::SetMode(CollisionResultMode::Enum mode, int maxResults)
 {
-	_results.clear();
+	_mode = mode;
+	_maxResults = glm::max(maxResults, 1);
+
+	Clear();
 }
 
-void CollisionResults::AddCollision(CollisionResult result)
+CollisionResultMode::Enum CollisionResults::GetMode() const
 {
-	_results.push_back(result);
+	return _mode;
+}
+
+void CollisionResults::Clear()
+{
+	_count = 0;
+	_overflow.clear();
 	_sorted = false;
 }
 
-int CollisionResults::Size()
+void CollisionResults::AddCollision(const CollisionResult& result)
+{
+	switch (_mode)
+	{
+	case CollisionResultMode::All:
+		Append(result);
+		_sorted = false;
+		break;
+	case CollisionResultMode::Closest:
+		if (_count == 0)
+		{
+			Append(result);
+		}
+		else if (result.Distance < _inlineResults[0].Distance)
+		{
+			_inlineResults[0] = result;
+		}
+		_sorted = true;
+		break;
+	case CollisionResultMode::Any:
+		if (_count == 0)
+		{
+			Append(result);
+		}
+		_sorted = true;
+		break;
+	case CollisionResultMode::TopK:
+		InsertSorted(result);
+		_sorted = true;
+		break;
+	}
+}
+
+int CollisionResults::Size() const
+{
+	return _count;
+}
+
+float CollisionResults::GetMaxDistance() const
 {
-	return _results.size();
+	switch (_mode)
+	{
+	case CollisionResultMode::Closest:
+		return _count > 0 ? _inlineResults[0].Distance : FloatInf;
+	case CollisionResultMode::Any:
+		return _count > 0 ? -FloatInf : FloatInf;
+	case CollisionResultMode::TopK:
+		return _count == _maxResults ? GetData()[_count - 1].Distance : FloatInf;
+	default:
+		return FloatInf;
+	}
+}
+
+bool CollisionResults::IsDone() const
+{
+	return _mode == CollisionResultMode::Any && _count > 0;
 }
 
 CollisionResult CollisionResults::GetClosestCollision()
@@ -32,12 +95,25 @@ CollisionResult CollisionResults::GetClosestCollision()
 	{
 		return CollisionResult();
 	}
-	if (!_sorted)
+
+	const CollisionResult* data = GetData();
+
+	if (_sorted)
 	{
-		MergeSort<CollisionResult>(_results, compareCollisionResults);
-		_sorted = true;
+		return data[0];
 	}
-	return _results[0];
+
+	// A scan instead of a sort, the first of equally near results wins like after a stable sort
+	int closest = 0;
+	for (int i = 1; i < _count; i++)
+	{
+		if (data[i].Distance < data[closest].Distance)
+		{
+			closest = i;
+		}
+	}
+
+	return data[closest];
 }
 
 CollisionResult CollisionResults::GetFarthestCollision()
@@ -46,12 +122,24 @@ CollisionResult CollisionResults::GetFarthestCollision()
 	{
 		return CollisionResult();
 	}
-	if (!_sorted)
+
+	const CollisionResult* data = GetData();
+
+	if (_sorted)
 	{
-		MergeSort<CollisionResult>(_results, compareCollisionResults);
-		_sorted = true;
+		return data[_count - 1];
 	}
-	return _results[Size() - 1];
+
+	int farthest = 0;
+	for (int i = 1; i < _count; i++)
+	{
+		if (data[i].Distance >= data[farthest].Distance)
+		{
+			farthest = i;
+		}
+	}
+
+	return data[farthest];
 }
 
 CollisionResult CollisionResults::GetCollision(int index)
@@ -62,10 +150,9 @@ CollisionResult CollisionResults::GetCollision(int index)
 	}
 	if (!_sorted)
 	{
-		MergeSort<CollisionResult>(_results, compareCollisionResults);
-		_sorted = true;
+		Sort();
 	}
-	return _results[index];
+	return GetData()[index];
 }
 
 CollisionResult CollisionResults::GetCollisonDirect(int index)
@@ -74,5 +161,70 @@ CollisionResult CollisionResults::GetCollisonDirect(int index)
 	{
 		return CollisionResult();
 	}
-	return _results[index];
+	return GetData()[index];
+}
+
+CollisionResult* CollisionResults::GetData()
+{
+	return _overflow.empty() ? _inlineResults : _overflow.data();
+}
+
+const CollisionResult* CollisionResults::GetData() const
+{
+	return _overflow.empty() ? _inlineResults : _overflow.data();
+}
+
+void CollisionResults::Append(const CollisionResult& result)
+{
+	if (_count < COLLISION_RESULTS_INLINE_SIZE)
+	{
+		_inlineResults[_count++] = result;
+		return;
+	}
+
+	if (_overflow.empty())
+	{
+		_overflow.insert(_overflow.end(), _inlineResults, _inlineResults + _count);
+	}
+
+	_overflow.push_back(result);
+	_count++;
+}
+
+void CollisionResults::InsertSorted(const CollisionResult& result)
+{
+	if (_count == _maxResults)
+	{
+		CollisionResult* data = GetData();
+
+		if (!(result.Distance < data[_count - 1].Distance))
+		{
+			return;
+		}
+
+		// Drop the farthest one to make room
+		_count--;
+
+		if (!_overflow.empty())
+		{
+			_overflow.pop_back();
+		}
+	}
+
+	Append(result);
+
+	// Move it down in front of the farther ones, equally near results keep their order
+	CollisionResult* data = GetData();
+	for (int i = _count - 1; i > 0 && result.Distance < data[i - 1].Distance; i--)
+	{
+		std::swap(data[i], data[i - 1]);
+	}
+}
+
+void CollisionResults::Sort()
+{
+	CollisionResult* data = GetData();
+
+	std::stable_sort(data, data + _count, CompareCollisionResults);
+	_sorted = true;
 }
\ No newline at end of file
@@ -16,18 +16,65 @@ struct CollisionResult
 	int TriangleIndex;
 };
 
+// Results stored inside CollisionResults before any memory is allocated
+constexpr int COLLISION_RESULTS_INLINE_SIZE = 4;
+
+struct CollisionResultMode
+{
+	enum Enum
+	{
+		// Every result is kept
+		All,
+		// Only the nearest result is kept
+		Closest,
+		// The first result is kept and the query stops right after it
+		Any,
+		// The nearest MaxResults results are kept, sorted by distance
+		TopK
+	};
+};
+
+// Queries check GetMaxDistance and IsDone while they run, so the closest, any and top k modes
+// also cut the search short. Results past the inline buffer go to a list that keeps its memory
+// across Clear, so a collector reused between queries stops allocating.
 class HYDRA_API CollisionResults
 {
 public:
-	CollisionResults();
+	CollisionResults(CollisionResultMode::Enum mode = CollisionResultMode::All, int maxResults = 1);
+
+	// Also clears the results
+	void SetMode(CollisionResultMode::Enum mode, int maxResults = 1);
+	CollisionResultMode::Enum GetMode() const;
+
 	void Clear();
-	void AddCollision(CollisionResult result);
-	int Size();
+	void AddCollision(const CollisionResult& result);
+	int Size() const;
+
+	// Results at or past this distance can not change the kept results anymore
+	float GetMaxDistance() const;
+
+	// True once nothing added later can change the kept results
+	bool IsDone() const;
+
 	CollisionResult GetClosestCollision();
 	CollisionResult GetFarthestCollision();
 	CollisionResult GetCollision(int index);
 	CollisionResult GetCollisonDirect(int index);
 private:
-	List<CollisionResult> _results;
+	CollisionResult* GetData();
+	const CollisionResult* GetData() const;
+	void Append(const CollisionResult& result);
+	void InsertSorted(const CollisionResult& result);
+	void Sort();
+
+	CollisionResultMode::Enum _mode;
+	int _maxResults;
+	int _count;
+
+	CollisionResult _inlineResults[COLLISION_RESULTS_INLINE_SIZE];
+
+	// Holds all results once they do not fit into the inline buffer anymore
+	List<CollisionResult> _overflow;
+
 	bool _sorted = false;
 };
\ No newline at end of file
@@ -40,7 +40,7 @@ public:
 		}
 
 		Vector3 AB = B - A;
-		Vector3 BC = B - C;
+		Vector3 BC = C - B;
 		Vector3 CA = A - C;
 
 		float d1 = ab - aa;
@@ -52,7 +52,7 @@ public:
 		float e3 = glm::dot(CA, CA);
 
 		Vector3 Q1 = (A * e1) - (AB * d1);
-		Vector3 Q2 = (B * e2) - (CA * d2);
+		Vector3 Q2 = (B * e2) - (BC * d2);
 		Vector3 Q3 = (C * e3) - (CA * d3);
 
 		Vector3 QC = (C * e1) - Q1;
@@ -73,4 +73,184 @@ public:
 
 		return true;
 	}
+
+	// Closest point to p on the triangle abc
+	inline static Vector3 ClosestPointTriangle(const Vector3& p, const Vector3& a, const Vector3& b, const Vector3& c)
+	{
+		Vector3 ab = b - a;
+		Vector3 ac = c - a;
+		Vector3 ap = p - a;
+
+		float d1 = glm::dot(ab, ap);
+		float d2 = glm::dot(ac, ap);
+
+		if (d1 <= 0.0f && d2 <= 0.0f)
+		{
+			return a;
+		}
+
+		Vector3 bp = p - b;
+		float d3 = glm::dot(ab, bp);
+		float d4 = glm::dot(ac, bp);
+
+		if (d3 >= 0.0f && d4 <= d3)
+		{
+			return b;
+		}
+
+		float vc = d1 * d4 - d3 * d2;
+
+		if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+		{
+			return a + ab * (d1 / (d1 - d3));
+		}
+
+		Vector3 cp = p - c;
+		float d5 = glm::dot(ab, cp);
+		float d6 = glm::dot(ac, cp);
+
+		if (d6 >= 0.0f && d5 <= d6)
+		{
+			return c;
+		}
+
+		float vb = d5 * d2 - d1 * d6;
+
+		if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+		{
+			return a + ac * (d2 / (d2 - d6));
+		}
+
+		float va = d3 * d6 - d5 * d4;
+
+		if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+		{
+			return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+		}
+
+		float denom = 1.0f / (va + vb + vc);
+
+		return a + ab * (vb * denom) + ac * (vc * denom);
+	}
+
+	// Closest points between the segments p1q1 and p2q2, returns their squared distance
+	inline static float ClosestPointsSegmentSegment(const Vector3& p1, const Vector3& q1, const Vector3& p2, const Vector3& q2, Vector3& c1, Vector3& c2)
+	{
+		const float epsilon = 1e-12f;
+
+		Vector3 d1 = q1 - p1;
+		Vector3 d2 = q2 - p2;
+		Vector3 r = p1 - p2;
+
+		float a = glm::dot(d1, d1);
+		float e = glm::dot(d2, d2);
+		float f = glm::dot(d2, r);
+
+		float s = 0.0f;
+		float t = 0.0f;
+
+		if (a <= epsilon && e <= epsilon)
+		{
+			c1 = p1;
+			c2 = p2;
+
+			return glm::dot(c1 - c2, c1 - c2);
+		}
+
+		if (a <= epsilon)
+		{
+			t = glm::clamp(f / e, 0.0f, 1.0f);
+		}
+		else
+		{
+			float c = glm::dot(d1, r);
+
+			if (e <= epsilon)
+			{
+				s = glm::clamp(-c / a, 0.0f, 1.0f);
+			}
+			else
+			{
+				float b = glm::dot(d1, d2);
+				float denom = a * e - b * b;
+
+				// Parallel segments take any s, the clamp below fixes t
+				s = denom != 0.0f ? glm::clamp((b * f - c * e) / denom, 0.0f, 1.0f) : 0.0f;
+				t = (b * s + f) / e;
+
+				if (t < 0.0f)
+				{
+					t = 0.0f;
+					s = glm::clamp(-c / a, 0.0f, 1.0f);
+				}
+				else if (t > 1.0f)
+				{
+					t = 1.0f;
+					s = glm::clamp((b - c) / a, 0.0f, 1.0f);
+				}
+			}
+		}
+
+		c1 = p1 + d1 * s;
+		c2 = p2 + d2 * t;
+
+		return glm::dot(c1 - c2, c1 - c2);
+	}
+
+	// Closest points between the segment pq and the triangle abc, returns their squared distance
+	inline static float ClosestPointsSegmentTriangle(const Vector3& p, const Vector3& q, const Vector3& a, const Vector3& b, const Vector3& c, Vector3& onSegment, Vector3& onTriangle)
+	{
+		Vector3 n = glm::cross(b - a, c - a);
+
+		float dp = glm::dot(p - a, n);
+		float dq = glm::dot(q - a, n);
+
+		// A segment crossing the plane inside the triangle touches it
+		if (dp != dq && ((dp <= 0.0f && dq >= 0.0f) || (dp >= 0.0f && dq <= 0.0f)))
+		{
+			Vector3 x = p + (q - p) * (dp / (dp - dq));
+
+			if (glm::dot(glm::cross(b - x, c - x), n) >= 0.0f && glm::dot(glm::cross(c - x, a - x), n) >= 0.0f && glm::dot(glm::cross(a - x, b - x), n) >= 0.0f)
+			{
+				onSegment = x;
+				onTriangle = x;
+
+				return 0.0f;
+			}
+		}
+
+		// Otherwise the closest points are on an end of the segment or on an edge of the triangle
+		onSegment = p;
+		onTriangle = ClosestPointTriangle(p, a, b, c);
+		float best = glm::dot(onSegment - onTriangle, onSegment - onTriangle);
+
+		Vector3 pointQ = ClosestPointTriangle(q, a, b, c);
+		float distance = glm::dot(q - pointQ, q - pointQ);
+
+		if (distance < best)
+		{
+			best = distance;
+			onSegment = q;
+			onTriangle = pointQ;
+		}
+
+		const Vector3* corners[] = { &a, &b, &c };
+
+		for (int i = 0; i < 3; i++)
+		{
+			Vector3 c1;
+			Vector3 c2;
+
+			distance = ClosestPointsSegmentSegment(p, q, *corners[i], *corners[(i + 1) % 3], c1, c2);
+
+			if (distance < best)
+			{
+				best = distance;
+				onSegment = c1;
+				onTriangle = c2;
+			}
+		}
+
+		return best;
+	}
 };
\ No newline at end of file
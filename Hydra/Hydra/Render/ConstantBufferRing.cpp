@@ -0,0 +1,151 @@
+#include "ConstantBufferRing.h"
+
+#include "Hydra/Core/Log.h"
+
+#include <algorithm>
+#include <cstring>
+
+ConstantBufferRing::ConstantBufferRing()
+	: _RenderInterface(nullptr), _Buffer(nullptr), _Size(0), _Head(0), _StagingSize(0), _MappedBytes(0), _MapCount(0), _LastFrameMappedBytes(0), _LastFrameMapCount(0)
+{
+}
+
+ConstantBufferRing::~ConstantBufferRing()
+{
+	Release();
+}
+
+void ConstantBufferRing::Initialize(NVRHI::IRendererInterface* renderInterface, uint32 size)
+{
+	Release();
+
+	_RenderInterface = renderInterface;
+
+	if (!_RenderInterface->supportsConstantBufferOffsets())
+	{
+		Log("ConstantBufferRing::Initialize", "Constant buffer offsets are not supported, constants are written per material.");
+		return;
+	}
+
+	_Size = size;
+	_Buffer = _RenderInterface->createConstantBuffer(NVRHI::ConstantBufferDesc(_Size, "ConstantBufferRing"), nullptr);
+
+	// The first map of a dynamic buffer has to discard
+	_Head = _Size;
+}
+
+void ConstantBufferRing::Release()
+{
+	if (_Buffer)
+	{
+		_RenderInterface->destroyConstantBuffer(_Buffer);
+		_Buffer = nullptr;
+	}
+
+	_Size = 0;
+	_Head = 0;
+	_StagingSize = 0;
+}
+
+bool ConstantBufferRing::IsAvailable() const
+{
+	return _Buffer != nullptr;
+}
+
+void ConstantBufferRing::BeginFrame()
+{
+	_LastFrameMappedBytes = _MappedBytes;
+	_LastFrameMapCount = _MapCount;
+
+	_MappedBytes = 0;
+	_MapCount = 0;
+}
+
+uint32 ConstantBufferRing::Allocate(const void* data, uint32 size)
+{
+	uint32 offset = _StagingSize;
+	uint32 alignedSize = (size + NVRHI::CONSTANT_BUFFER_OFFSET_ALIGNMENT - 1) & ~(NVRHI::CONSTANT_BUFFER_OFFSET_ALIGNMENT - 1);
+
+	_StagingSize += alignedSize;
+
+	if (_Staging.size() < _StagingSize)
+	{
+		_Staging.resize(std::max((size_t)_StagingSize, _Staging.size() * 2));
+	}
+
+	memcpy(_Staging.data() + offset, data, size);
+
+	return offset;
+}
+
+uint32 ConstantBufferRing::Flush()
+{
+	if (_StagingSize == 0 || _Buffer == nullptr)
+	{
+		return 0;
+	}
+
+	bool discard = false;
+
+	if (_StagingSize > _Size)
+	{
+		uint32 size = _Size;
+
+		while (size < _StagingSize)
+		{
+			size *= 2;
+		}
+
+		Log("ConstantBufferRing::Flush", ToString(size), "Growing the ring.");
+
+		_RenderInterface->destroyConstantBuffer(_Buffer);
+
+		_Size = size;
+		_Buffer = _RenderInterface->createConstantBuffer(NVRHI::ConstantBufferDesc(_Size, "ConstantBufferRing"), nullptr);
+
+		discard = true;
+	}
+	else if (_Head + _StagingSize > _Size)
+	{
+		discard = true;
+	}
+
+	if (discard)
+	{
+		_Head = 0;
+	}
+
+	uint8* mapped = (uint8*)_RenderInterface->mapConstantBuffer(_Buffer, discard);
+
+	uint32 offset = _Head;
+
+	if (mapped != nullptr)
+	{
+		memcpy(mapped + offset, _Staging.data(), _StagingSize);
+
+		_RenderInterface->unmapConstantBuffer(_Buffer);
+	}
+
+	_MappedBytes += _StagingSize;
+	_MapCount++;
+
+	_Head += _StagingSize;
+	_StagingSize = 0;
+
+	return offset;
+}
+
+NVRHI::ConstantBufferHandle ConstantBufferRing::GetBuffer() const
+{
+	return _Buffer;
+}
+
+uint32 ConstantBufferRing::GetMappedBytes() const
+{
+	return _LastFrameMappedBytes;
+}
+
+int ConstantBufferRing::GetMapCount() const
+{
+	return _LastFrameMapCount;
+}
\ No newline at end of file
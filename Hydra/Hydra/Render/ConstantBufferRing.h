@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Hydra/Core/Library.h"
+#include "Hydra/Core/Common.h"
+#include "Hydra/Core/Container.h"
+#include "Hydra/Render/Pipeline/GFSDK_NVRHI.h"
+
+// Size the ring starts with, it doubles when the data of one flush does not fit
+#define CONSTANT_BUFFER_RING_DEFAULT_SIZE (4 * 1024 * 1024)
+
+// One big dynamic constant buffer for constants that only live for a frame. Draws allocate aligned slices, which are
+// staged on the CPU and uploaded with a single map per flush, then bound by offset. The GPU buffer is filled front to
+// back without overwriting what earlier flushes wrote, and discarded when it wraps around.
+// Needs NVRHI::IRendererInterface::supportsConstantBufferOffsets, IsAvailable is false otherwise.
+class HYDRA_API ConstantBufferRing
+{
+private:
+	NVRHI::IRendererInterface* _RenderInterface;
+	NVRHI::ConstantBufferHandle _Buffer;
+	uint32 _Size;
+	uint32 _Head;
+
+	List<uint8> _Staging;
+	uint32 _StagingSize;
+
+	uint32 _MappedBytes;
+	int _MapCount;
+
+	uint32 _LastFrameMappedBytes;
+	int _LastFrameMapCount;
+
+public:
+	ConstantBufferRing();
+	~ConstantBufferRing();
+
+	void Initialize(NVRHI::IRendererInterface* renderInterface, uint32 size = CONSTANT_BUFFER_RING_DEFAULT_SIZE);
+	void Release();
+
+	bool IsAvailable() const;
+
+	// Starts counting the maps of a new frame
+	void BeginFrame();
+
+	// Stages a copy of the data and returns its offset in the staged data
+	uint32 Allocate(const void* data, uint32 size);
+
+	// Uploads everything staged since the last flush and returns the offset the staged data starts at in the buffer
+	uint32 Flush();
+
+	NVRHI::ConstantBufferHandle GetBuffer() const;
+
+	// Bytes mapped and number of maps in the last frame that finished
+	uint32 GetMappedBytes() const;
+	int GetMapCount() const;
+};
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "Hydra/EngineContext.h"
 #include "Hydra/Render/Material.h"
+#include "Hydra/Render/Pipeline/BindingHelpers.h"
 #include "Hydra/Render/VertexBuffer.h"
 #include "Hydra/Framework/StaticMesh.h"
 
@@ -75,6 +76,15 @@ void FDrawState::SetMaterial(MaterialInterface* materialInterface)
 	_State.PS.shader = materialInterface->GetRawShader(NVRHI::ShaderType::SHADER_PIXEL);
 }
 
+void FDrawState::SetConstantBuffer(uint32 slot, NVRHI::ConstantBufferHandle buffer, uint32 offset, uint32 size)
+{
+	NVRHI::BindConstantBuffer(_State.VS, slot, buffer, offset, size);
+	NVRHI::BindConstantBuffer(_State.HS, slot, buffer, offset, size);
+	NVRHI::BindConstantBuffer(_State.DS, slot, buffer, offset, size);
+	NVRHI::BindConstantBuffer(_State.GS, slot, buffer, offset, size);
+	NVRHI::BindConstantBuffer(_State.PS, slot, buffer, offset, size);
+}
+
 void FDrawState::SetInputLayout(NVRHI::InputLayoutHandle inputLayout)
 {
 	_State.inputLayout = inputLayout;
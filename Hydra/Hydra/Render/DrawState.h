@@ -28,6 +28,9 @@ public:
 	void SetDepthTarget(NVRHI::TextureHandle target);
 
 	void SetMaterial(MaterialInterface* materialInterface);
+
+	// Binds a constant buffer, or a range of it, to a slot of every graphics stage. Used for the engine constants.
+	void SetConstantBuffer(uint32 slot, NVRHI::ConstantBufferHandle buffer, uint32 offset = 0, uint32 size = 0);
 	void SetInputLayout(NVRHI::InputLayoutHandle inputLayout);
 
 	void SetIndexBuffer(NVRHI::BufferHandle buffer);
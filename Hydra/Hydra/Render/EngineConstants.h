@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Hydra/Core/Common.h"
+#include "Hydra/Core/Vector.h"
+
+// Constant buffer slots the renderer binds itself, declared in Assets/Shaders/Input/EngineConstants.hlsli.
+// Materials do not create buffers for these slots, they only hold their own parameters.
+#define ENGINE_VIEW_CONSTANTS_SLOT 12
+#define ENGINE_OBJECT_CONSTANTS_SLOT 13
+
+// Names of the cbuffers in EngineConstants.hlsli, a buffer is only left to the renderer when both name and slot match
+#define ENGINE_VIEW_CONSTANTS_NAME "ViewConstants"
+#define ENGINE_OBJECT_CONSTANTS_NAME "ObjectConstants"
+
+// Written once per view
+struct FViewConstants
+{
+	Matrix4 ProjectionMatrix;
+	Matrix4 ViewMatrix;
+};
+
+// Written for every object drawn, instanced draws use the identity and take the matrix from the instance buffer
+struct FObjectConstants
+{
+	Matrix4 ModelMatrix;
+};
+
+inline bool IsEngineConstantBufferSlot(uint32 slot)
+{
+	return slot == ENGINE_VIEW_CONSTANTS_SLOT || slot == ENGINE_OBJECT_CONSTANTS_SLOT;
+}
+
+inline bool IsEngineConstantBuffer(const String& name, uint32 slot)
+{
+	return (name == ENGINE_VIEW_CONSTANTS_NAME && slot == ENGINE_VIEW_CONSTANTS_SLOT) || (name == ENGINE_OBJECT_CONSTANTS_NAME && slot == ENGINE_OBJECT_CONSTANTS_SLOT);
+}
\ No newline at end of file
@@ -28,6 +28,10 @@ FGraphics::~FGraphics()
 FGraphics::FGraphics(EngineContext* context) : _Context(context)
 {
 	_BlitMaterial = new MaterialInterface("Blit", MakeShared<Technique>(context, "Assets/Shaders/Blit.hlsl", true));
+
+	_TextureParam = MaterialParam::GetId("_Texture");
+	_DirectionParam = MaterialParam::GetId("_Direction");
+	_TexSizeParam = MaterialParam::GetId("_TexSize");
 	//_BlitMaterial = Material::CreateOrGet("Assets/Shaders/Blit.hlsl", true, true);
 	//_BlurMaterial = Material::CreateOrGet("Assets/Shaders/PostProcess/GaussianBlur.hlsl", true, true);
 }
@@ -52,7 +56,7 @@ void FGraphics::Blit(TexturePtr pSource, TexturePtr pDest)
 	state.renderState.depthStencilState.depthEnable = false;
 	state.renderState.rasterState.cullMode = NVRHI::RasterState::CULL_NONE;
 
-	_BlitMaterial->SetTexture("_Texture", pSource);
+	_BlitMaterial->SetTexture(_TextureParam, pSource);
 
 	ApplyMaterialParameters(state, _BlitMaterial);
 
@@ -83,10 +87,10 @@ void FGraphics::BlurTexture(TexturePtr pSource, TexturePtr pDest)
 	// Horizontal blur
 	Composite(_BlurMaterial, [this, pSource, width, height](NVRHI::DrawCallState& state)
 	{
-		_BlurMaterial->SetTexture("_Texture", pSource);
+		_BlurMaterial->SetTexture(_TextureParam, pSource);
 
-		_BlurMaterial->SetVector2("_Direction", Vector2(1, 0));
-		_BlurMaterial->SetVector2("_TexSize", Vector2(width, height));
+		_BlurMaterial->SetVector2(_DirectionParam, Vector2(1, 0));
+		_BlurMaterial->SetVector2(_TexSizeParam, Vector2(width, height));
 
 		ApplyMaterialParameters(state, _BlurMaterial);
 
@@ -95,10 +99,10 @@ void FGraphics::BlurTexture(TexturePtr pSource, TexturePtr pDest)
 	// Vertical blur
 	Composite(_BlurMaterial, [this, pSource, width, height](NVRHI::DrawCallState& state)
 	{
-		_BlurMaterial->SetTexture("_Texture", GetRenderTarget("G_MEM_BLUR_PASS"));
+		_BlurMaterial->SetTexture(_TextureParam, GetRenderTarget("G_MEM_BLUR_PASS"));
 
-		_BlurMaterial->SetVector2("_Direction", Vector2(0, 1));
-		_BlurMaterial->SetVector2("_TexSize", Vector2(width, height));
+		_BlurMaterial->SetVector2(_DirectionParam, Vector2(0, 1));
+		_BlurMaterial->SetVector2(_TexSizeParam, Vector2(width, height));
 
 		ApplyMaterialParameters(state, _BlurMaterial);
 
@@ -142,9 +146,9 @@ void FGraphics::Composite(MaterialInterface* material, Function<void(NVRHI::Draw
 
 void FGraphics::Composite(MaterialInterface* material, TexturePtr slot0Texture, TexturePtr pDest)
 {
-	Composite(material, [material, slot0Texture](NVRHI::DrawCallState& state)
+	Composite(material, [this, material, slot0Texture](NVRHI::DrawCallState& state)
 	{
-		material->SetTexture("_Texture", slot0Texture);
+		material->SetTexture(_TextureParam, slot0Texture);
 	}, pDest);
 }
 
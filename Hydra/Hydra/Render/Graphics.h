@@ -51,6 +51,10 @@ private:
 
 	MaterialInterface* _BlitMaterial;
 	MaterialInterface* _BlurMaterial;
+
+	MaterialParamId _TextureParam;
+	MaterialParamId _DirectionParam;
+	MaterialParamId _TexSizeParam;
 public:
 	FGraphics(EngineContext* context);
 	~FGraphics();
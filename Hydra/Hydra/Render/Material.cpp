@@ -8,13 +8,11 @@
 Map<String, SharedPtr<Technique>> MaterialInterface::_TechniqueCache;
 Map<String, MaterialInterface*> MaterialInterface::AllMaterialInterfaces;
 
-MaterialInterface::MaterialInterface(const String & name, SharedPtr<Technique> technique) : Name(name), _Technique(technique), IsInternalMaterialInterface(false)
+MaterialInterface::MaterialInterface(const String & name, SharedPtr<Technique> technique) : Name(name), _Technique(technique), _VariantKey(0), _HasPendingShaders(false), _TechniqueRevision(technique->GetRevision()), _HasNewParamIndices(false), IsInternalMaterialInterface(false)
 {
 	if (_Technique->IsPrecompiled())
 	{
-		Map<String, String> emptyDefs;
-
-		List<Shader*> newShaders = _Technique->GetShaders(emptyDefs, false);
+		List<Shader*> newShaders = _Technique->GetShaders((ShaderVariantKey)0, false);
 
 		SetActiveShaderVars(newShaders, 0);
 
@@ -27,13 +25,22 @@ MaterialInterface::MaterialInterface(const String & name, SharedPtr<Technique> t
 
 MaterialInterface::~MaterialInterface()
 {
-	ITER(_Variables, it)
+	for (Var* var : _Variables)
 	{
-		delete[] it->second->Data;
+		if (var != nullptr)
+		{
+			delete[] var->Data;
+			delete var;
+		}
 	}
 
 	_Variables.clear();
 
+	ReleaseShaderVars();
+}
+
+void MaterialInterface::ReleaseShaderVars()
+{
 	ITER(_ShaderVarsForVaryingShaders, it0)
 	{
 		ITER(it0->second, it1)
@@ -53,135 +60,261 @@ MaterialInterface::~MaterialInterface()
 			delete vars;
 		}
 	}
+
+	_ShaderVarsForVaryingShaders.clear();
+	_ActiveShaderVars.clear();
 }
 
 void MaterialInterface::SetInt(const String& name, const int& i)
 {
-	SetVariable<int>(name, VarType::Int, i);
+	SetInt(MaterialParam::GetId(name), i);
+}
+
+void MaterialInterface::SetInt(MaterialParamId id, const int& i)
+{
+	SetVariable<int>(id, VarType::Int, i);
 }
 
 bool MaterialInterface::GetInt(const String& name, int* outInt)
 {
-	return GetVariable(name, VarType::Int, outInt);
+	return GetInt(MaterialParam::GetId(name), outInt);
+}
+
+bool MaterialInterface::GetInt(MaterialParamId id, int* outInt)
+{
+	return GetVariable(id, VarType::Int, outInt);
 }
 
 void MaterialInterface::SetUInt(const String& name, const unsigned int & i)
 {
-	SetVariable<unsigned int>(name, VarType::UInt, i);
+	SetUInt(MaterialParam::GetId(name), i);
+}
+
+void MaterialInterface::SetUInt(MaterialParamId id, const unsigned int & i)
+{
+	SetVariable<unsigned int>(id, VarType::UInt, i);
 }
 
 bool MaterialInterface::GetUInt(const String& name, unsigned int * outInt)
 {
-	return GetVariable(name, VarType::UInt, outInt);
+	return GetUInt(MaterialParam::GetId(name), outInt);
+}
+
+bool MaterialInterface::GetUInt(MaterialParamId id, unsigned int * outInt)
+{
+	return GetVariable(id, VarType::UInt, outInt);
 }
 
 void MaterialInterface::SetFloat(const String& name, const float& f)
 {
-	SetVariable<float>(name, VarType::Float, f);
+	SetFloat(MaterialParam::GetId(name), f);
+}
+
+void MaterialInterface::SetFloat(MaterialParamId id, const float& f)
+{
+	SetVariable<float>(id, VarType::Float, f);
 }
 
 bool MaterialInterface::GetFloat(const String& name, float* outFloat)
 {
-	return GetVariable<float>(name, VarType::Float, outFloat);
+	return GetFloat(MaterialParam::GetId(name), outFloat);
+}
+
+bool MaterialInterface::GetFloat(MaterialParamId id, float* outFloat)
+{
+	return GetVariable<float>(id, VarType::Float, outFloat);
 }
 
 void MaterialInterface::SetBool(const String& name, const bool& b)
 {
-	SetVariable(name, VarType::Bool, b);
+	SetBool(MaterialParam::GetId(name), b);
+}
+
+void MaterialInterface::SetBool(MaterialParamId id, const bool& b)
+{
+	SetVariable(id, VarType::Bool, b);
 }
 
 bool MaterialInterface::GetBool(const String& name, bool* outBool)
 {
-	return GetVariable<bool>(name, VarType::Bool, outBool);
+	return GetBool(MaterialParam::GetId(name), outBool);
+}
+
+bool MaterialInterface::GetBool(MaterialParamId id, bool* outBool)
+{
+	return GetVariable<bool>(id, VarType::Bool, outBool);
 }
 
 void MaterialInterface::SetVector2(const String& name, const Vector2& vec)
 {
-	SetVariable(name, VarType::Vector2, vec);
+	SetVector2(MaterialParam::GetId(name), vec);
+}
+
+void MaterialInterface::SetVector2(MaterialParamId id, const Vector2& vec)
+{
+	SetVariable(id, VarType::Vector2, vec);
 }
 
 bool MaterialInterface::GetVector2(const String& name, Vector2* outVec)
 {
-	return GetVariable<Vector2>(name, VarType::Vector2, outVec);
+	return GetVector2(MaterialParam::GetId(name), outVec);
+}
+
+bool MaterialInterface::GetVector2(MaterialParamId id, Vector2* outVec)
+{
+	return GetVariable<Vector2>(id, VarType::Vector2, outVec);
 }
 
 void MaterialInterface::SetVector3(const String& name, const Vector3& vec)
 {
-	SetVariable(name, VarType::Vector3, vec);
+	SetVector3(MaterialParam::GetId(name), vec);
+}
+
+void MaterialInterface::SetVector3(MaterialParamId id, const Vector3& vec)
+{
+	SetVariable(id, VarType::Vector3, vec);
 }
 
 bool MaterialInterface::GetVector3(const String & name, Vector3* outVec)
 {
-	return GetVariable<Vector3>(name, VarType::Vector3, outVec);
+	return GetVector3(MaterialParam::GetId(name), outVec);
+}
+
+bool MaterialInterface::GetVector3(MaterialParamId id, Vector3* outVec)
+{
+	return GetVariable<Vector3>(id, VarType::Vector3, outVec);
 }
 
 void MaterialInterface::SetVector4(const String& name, const Vector4& vec)
 {
-	SetVariable(name, VarType::Vector4, vec);
+	SetVector4(MaterialParam::GetId(name), vec);
+}
+
+void MaterialInterface::SetVector4(MaterialParamId id, const Vector4& vec)
+{
+	SetVariable(id, VarType::Vector4, vec);
 }
 
 bool MaterialInterface::GetVector4(const String& name, Vector4* outVec)
 {
-	return GetVariable<Vector4>(name, VarType::Vector4, outVec);
+	return GetVector4(MaterialParam::GetId(name), outVec);
+}
+
+bool MaterialInterface::GetVector4(MaterialParamId id, Vector4* outVec)
+{
+	return GetVariable<Vector4>(id, VarType::Vector4, outVec);
 }
 
 void MaterialInterface::SetVector4Array(const String & name, Vector4* vecArr, size_t arrSize)
 {
-	SetVariable(name, VarType::Vector4Array, vecArr, sizeof(Vector4) * arrSize);
+	SetVector4Array(MaterialParam::GetId(name), vecArr, arrSize);
+}
+
+void MaterialInterface::SetVector4Array(MaterialParamId id, Vector4* vecArr, size_t arrSize)
+{
+	SetVariable(id, VarType::Vector4Array, vecArr, sizeof(Vector4) * arrSize);
 }
 
 bool MaterialInterface::GetVector4Array(const String & name, Vector4* vector, size_t arrSize)
 {
-	return GetVariable(name, VarType::Vector4Array, vector, false, sizeof(Vector4) * arrSize);
+	return GetVector4Array(MaterialParam::GetId(name), vector, arrSize);
+}
+
+bool MaterialInterface::GetVector4Array(MaterialParamId id, Vector4* vector, size_t arrSize)
+{
+	return GetVariable(id, VarType::Vector4Array, vector, false, sizeof(Vector4) * arrSize);
 }
 
 void MaterialInterface::SetMatrix3(const String& name, const Matrix3& mat)
 {
-	SetVariable(name, VarType::Matrix3, mat);
+	SetMatrix3(MaterialParam::GetId(name), mat);
+}
+
+void MaterialInterface::SetMatrix3(MaterialParamId id, const Matrix3& mat)
+{
+	SetVariable(id, VarType::Matrix3, mat);
 }
 
 bool MaterialInterface::GetMatrix3(const String& name, Matrix3* outMat)
 {
-	return GetVariable<Matrix3>(name, VarType::Matrix3, outMat);
+	return GetMatrix3(MaterialParam::GetId(name), outMat);
+}
+
+bool MaterialInterface::GetMatrix3(MaterialParamId id, Matrix3* outMat)
+{
+	return GetVariable<Matrix3>(id, VarType::Matrix3, outMat);
 }
 
 void MaterialInterface::SetMatrix4(const String& name, const Matrix4& mat)
 {
-	SetVariable(name, VarType::Matrix4, mat);
+	SetMatrix4(MaterialParam::GetId(name), mat);
+}
+
+void MaterialInterface::SetMatrix4(MaterialParamId id, const Matrix4& mat)
+{
+	SetVariable(id, VarType::Matrix4, mat);
 }
 
 bool MaterialInterface::GetMatrix4(const String& name, Matrix4* outMat)
 {
-	return GetVariable<Matrix4>(name, VarType::Matrix4, outMat);
+	return GetMatrix4(MaterialParam::GetId(name), outMat);
+}
+
+bool MaterialInterface::GetMatrix4(MaterialParamId id, Matrix4* outMat)
+{
+	return GetVariable<Matrix4>(id, VarType::Matrix4, outMat);
 }
 
 void MaterialInterface::SetStruct(const String & name, StorageStruct & s, size_t size)
 {
-	SetVariable(name, VarType::StorageStruct, (void*)(&s), size);
+	SetStruct(MaterialParam::GetId(name), s, size);
+}
+
+void MaterialInterface::SetStruct(MaterialParamId id, StorageStruct & s, size_t size)
+{
+	SetVariable(id, VarType::StorageStruct, (void*)(&s), size);
 }
 
 void MaterialInterface::SetStructArray(const String & name, void* s, size_t size)
 {
-	SetVariable(name, VarType::StorageStructArray, s, size);
+	SetStructArray(MaterialParam::GetId(name), s, size);
+}
+
+void MaterialInterface::SetStructArray(MaterialParamId id, void* s, size_t size)
+{
+	SetVariable(id, VarType::StorageStructArray, s, size);
 }
 
 void MaterialInterface::SetTexture(const String& name, NVRHI::TextureHandle texture)
 {
-	if (_TextureVariables.find(name) == _TextureVariables.end())
+	SetTexture(MaterialParam::GetId(name), texture);
+}
+
+void MaterialInterface::SetTexture(MaterialParamId id, NVRHI::TextureHandle texture)
+{
+	if (id == MATERIAL_PARAM_INVALID_ID)
 	{
-		_TextureVariables[name] = {};
+		return;
 	}
 
-	TextureVar& var = _TextureVariables[name];
+	TextureVar& var = _TextureVariables[AddParamIndex(id)];
+	var.IsSet = true;
 	var.Handle = texture;
 	var.HasChnaged = true;
 }
 
 NVRHI::TextureHandle MaterialInterface::GetTexture(const String& name)
 {
-	if (_TextureVariables.find(name) != _TextureVariables.end())
+	return GetTexture(MaterialParam::GetId(name));
+}
+
+NVRHI::TextureHandle MaterialInterface::GetTexture(MaterialParamId id)
+{
+	uint32 index = GetParamIndex(id);
+
+	if (index != MATERIAL_PARAM_INVALID_INDEX && _TextureVariables[index].IsSet)
 	{
-		return _TextureVariables[name].Handle;
+		return _TextureVariables[index].Handle;
 	}
 
 	return nullptr;
@@ -189,43 +322,69 @@ NVRHI::TextureHandle MaterialInterface::GetTexture(const String& name)
 
 void MaterialInterface::SetSampler(const String& name, NVRHI::SamplerHandle sampler)
 {
-	if (_SamplerVariables.find(name) == _SamplerVariables.end())
+	SetSampler(MaterialParam::GetId(name), sampler);
+}
+
+void MaterialInterface::SetSampler(MaterialParamId id, NVRHI::SamplerHandle sampler)
+{
+	if (id == MATERIAL_PARAM_INVALID_ID)
 	{
-		_SamplerVariables[name] = {};
+		return;
 	}
 
-	SamplerVar& var = _SamplerVariables[name];
+	SamplerVar& var = _SamplerVariables[AddParamIndex(id)];
+	var.IsSet = true;
 	var.Handle = sampler;
 	var.HasChnaged = true;
 }
 
 NVRHI::SamplerHandle MaterialInterface::GetSampler(const String& name)
 {
-	if (_SamplerVariables.find(name) != _SamplerVariables.end())
+	return GetSampler(MaterialParam::GetId(name));
+}
+
+NVRHI::SamplerHandle MaterialInterface::GetSampler(MaterialParamId id)
+{
+	uint32 index = GetParamIndex(id);
+
+	if (index != MATERIAL_PARAM_INVALID_INDEX && _SamplerVariables[index].IsSet)
 	{
-		return _SamplerVariables[name].Handle;
+		return _SamplerVariables[index].Handle;
 	}
 
 	return nullptr;
 }
 
-void MaterialInterface::SetBuffer(const String & name, NVRHI::BufferHandle buffer)
+void MaterialInterface::SetBuffer(const String& name, NVRHI::BufferHandle buffer)
 {
-	if (_BufferVariables.find(name) == _BufferVariables.end())
+	SetBuffer(MaterialParam::GetId(name), buffer);
+}
+
+void MaterialInterface::SetBuffer(MaterialParamId id, NVRHI::BufferHandle buffer)
+{
+	if (id == MATERIAL_PARAM_INVALID_ID)
 	{
-		_BufferVariables[name] = {};
+		return;
 	}
 
-	BufferVar& var = _BufferVariables[name];
+	BufferVar& var = _BufferVariables[AddParamIndex(id)];
+	var.IsSet = true;
 	var.Handle = buffer;
 	var.HasChnaged = true;
 }
 
-NVRHI::BufferHandle MaterialInterface::GetBuffer(const String & name)
+NVRHI::BufferHandle MaterialInterface::GetBuffer(const String& name)
+{
+	return GetBuffer(MaterialParam::GetId(name));
+}
+
+NVRHI::BufferHandle MaterialInterface::GetBuffer(MaterialParamId id)
 {
-	if (_BufferVariables.find(name) != _BufferVariables.end())
+	uint32 index = GetParamIndex(id);
+
+	if (index != MATERIAL_PARAM_INVALID_INDEX && _BufferVariables[index].IsSet)
 	{
-		return _BufferVariables[name].Handle;
+		return _BufferVariables[index].Handle;
 	}
 
 	return nullptr;
@@ -233,19 +392,31 @@ NVRHI::BufferHandle MaterialInterface::GetBuffer(const String & name)
 
 Var* MaterialInterface::GetRawVar(const String & name)
 {
-	if (_Variables.find(name) != _Variables.end())
+	return GetRawVar(MaterialParam::GetId(name));
+}
+
+Var* MaterialInterface::GetRawVar(MaterialParamId id)
+{
+	uint32 index = GetParamIndex(id);
+
+	if (index != MATERIAL_PARAM_INVALID_INDEX)
 	{
-		return _Variables[name];
+		return _Variables[index];
 	}
 	return nullptr;
 }
 
 unsigned char* MaterialInterface::GetRawVarData(const String & name)
 {
-	if (_Variables.find(name) != _Variables.end())
-	{
-		Var* var = _Variables[name];
+	return GetRawVarData(MaterialParam::GetId(name));
+}
+
+unsigned char* MaterialInterface::GetRawVarData(MaterialParamId id)
+{
+	Var* var = GetRawVar(id);
 
+	if (var != nullptr)
+	{
 		return var->Data;
 	}
 	return nullptr;
@@ -265,58 +436,101 @@ Map<String, VarType::Type> MaterialInterface::GetVarTypes()
 
 void MaterialInterface::SetDefine(const String& name, const String& value)
 {
-	bool updateShader = false;
+	ShaderVariantKey oldBit = 0;
 
 	auto it = _Defines.find(name);
 
 	if (it != _Defines.end())
 	{
-		if (_Defines[name] != value)
+		if (it->second == value)
 		{
-			updateShader = true;
+			return;
 		}
-		_Defines[name] = value;
+
+		oldBit = _Technique->GetDefineBit(name, it->second);
 	}
-	else
+
+	_Defines[name] = value;
+
+	ShaderVariantKey variantKey = (_VariantKey & ~oldBit) | _Technique->GetDefineBit(name, value);
+
+	// Like another value that enables the same keyword
+	if (variantKey == _VariantKey && !_ActiveShaders.empty())
 	{
-		updateShader = true;
-		_Defines[name] = value;
+		return;
 	}
 
-	if (updateShader)
-	{
-		_ActiveShaders.clear();
+	_VariantKey = variantKey;
+	_HasPendingShaders = true;
 
-		uint32 shadersId = _Technique->GetDefinesHash(_Defines);
+	UpdatePendingShaders();
+}
 
-		List<Shader*> newShaders = _Technique->GetShaders(_Defines, false);
+void MaterialInterface::ActivateShaders(List<Shader*>& shaders, ShaderVariantKey packId)
+{
+	_ActiveShaders.clear();
 
-		SetActiveShaderVars(newShaders, shadersId);
+	SetActiveShaderVars(shaders, packId);
 
-		for (Shader* shader : newShaders)
-		{
-			_ActiveShaders[shader->GetType()] = shader;
-		}
+	for (Shader* shader : shaders)
+	{
+		_ActiveShaders[shader->GetType()] = shader;
+	}
 
-		ITER(_Variables, it)
+	for (Var* var : _Variables)
+	{
+		if (var != nullptr)
 		{
-			it->second->HasChnaged = true;
+			var->HasChnaged = true;
 		}
+	}
 
-		ITER(_TextureVariables, it)
-		{
-			it->second.HasChnaged = true;
-		}
+	for (TextureVar& var : _TextureVariables)
+	{
+		var.HasChnaged = true;
+	}
 
-		ITER(_SamplerVariables, it)
-		{
-			it->second.HasChnaged = true;
-		}
+	for (SamplerVar& var : _SamplerVariables)
+	{
+		var.HasChnaged = true;
+	}
+}
+
+void MaterialInterface::UpdatePendingShaders()
+{
+	// The technique swapped in reloaded shaders and deleted the old ones, the reflection may have changed too
+	if (_TechniqueRevision != _Technique->GetRevision())
+	{
+		_TechniqueRevision = _Technique->GetRevision();
+
+		_ActiveShaders.clear();
+		ReleaseShaderVars();
+
+		_HasPendingShaders = true;
+	}
+
+	List<Shader*>* newShaders = _Technique->RequestShaders(_VariantKey);
+
+	if (newShaders != nullptr)
+	{
+		_HasPendingShaders = false;
+
+		ActivateShaders(*newShaders, _VariantKey);
+	}
+	else if (_ActiveShaders.empty())
+	{
+		// Nothing to draw with until the variant is compiled, the one without defines is the fallback
+		ActivateShaders(_Technique->GetShaders((ShaderVariantKey)0, false), 0);
 	}
 }
 
 Shader* MaterialInterface::GetShader(const NVRHI::ShaderType::Enum & type)
 {
+	if (_HasPendingShaders || _TechniqueRevision != _Technique->GetRevision())
+	{
+		UpdatePendingShaders();
+	}
+
 	auto it = _ActiveShaders.find(type);
 
 	if (it != _ActiveShaders.end())
@@ -339,11 +553,37 @@ NVRHI::ShaderHandle MaterialInterface::GetRawShader(const NVRHI::ShaderType::Enu
 	return nullptr;
 }
 
-void MaterialInterface::ApplyParams(NVRHI::DispatchState & state)
+void MaterialInterface::UpdateConstantBuffers()
 {
-	//TODO: Optimize this method
+	if (_HasPendingShaders || _TechniqueRevision != _Technique->GetRevision())
+	{
+		UpdatePendingShaders();
+	}
+
+	if (_HasNewParamIndices)
+	{
+		ResolveAllParamIndices();
+	}
+
+	CopyChangedVariables();
 
-	// Prepare constant buffers
+	for (Map<NVRHI::ShaderType::Enum, ShaderVars*>::iterator it0 = _ActiveShaderVars.begin(); it0 != _ActiveShaderVars.end(); it0++)
+	{
+		ShaderVars* vars = it0->second;
+
+		for (int i = 0; i < vars->ConstantBufferCount; i++)
+		{
+			if (vars->ConstantBuffers[i].MarkUpdate)
+			{
+				_Technique->GetEngineContext()->GetRenderInterface()->writeConstantBuffer(vars->ConstantBuffers[i].ConstantBuffer, vars->ConstantBuffers[i].LocalDataBuffer, vars->ConstantBuffers[i].Size);
+				vars->ConstantBuffers[i].MarkUpdate = false;
+			}
+		}
+	}
+}
+
+void MaterialInterface::CopyChangedVariables()
+{
 	_VarsToMarkClean.clear();
 
 	for (Map<NVRHI::ShaderType::Enum, ShaderVars*>::iterator it0 = _ActiveShaderVars.begin(); it0 != _ActiveShaderVars.end(); it0++)
@@ -351,14 +591,11 @@ void MaterialInterface::ApplyParams(NVRHI::DispatchState & state)
 		ShaderVars* vars = it0->second;
 
 		// Write variable data to constant buffer
-		for (FastMap<String, RawShaderVariable>::iterator it1 = vars->Variables.begin(); it1 != vars->Variables.end(); it1++)
+		for (RawShaderVariable& var : vars->Variables)
 		{
-			String name = it1->first;
-			RawShaderVariable& var = it1->second;
-
-			if (_Variables.find(name) != _Variables.end())
+			if (var.MaterialIndex != MATERIAL_PARAM_INVALID_INDEX && _Variables[var.MaterialIndex] != nullptr)
 			{
-				Var* localVar = _Variables[name];
+				Var* localVar = _Variables[var.MaterialIndex];
 
 				if (localVar->HasChnaged)
 				{
@@ -376,15 +613,21 @@ void MaterialInterface::ApplyParams(NVRHI::DispatchState & state)
 				}
 			}
 		}
+	}
 
-		for (int i = 0; i < vars->ConstantBufferCount; i++)
-		{
-			if (vars->ConstantBuffers[i].MarkUpdate)
-			{
-				_Technique->GetEngineContext()->GetRenderInterface()->writeConstantBuffer(vars->ConstantBuffers[i].ConstantBuffer, vars->ConstantBuffers[i].LocalDataBuffer, vars->ConstantBuffers[i].Size);
-				vars->ConstantBuffers[i].MarkUpdate = false;
-			}
-		}
+	for (Var* var : _VarsToMarkClean)
+	{
+		var->HasChnaged = false;
+	}
+}
+
+void MaterialInterface::ApplyParams(NVRHI::DispatchState & state)
+{
+	UpdateConstantBuffers();
+
+	for (Map<NVRHI::ShaderType::Enum, ShaderVars*>::iterator it0 = _ActiveShaderVars.begin(); it0 != _ActiveShaderVars.end(); it0++)
+	{
+		ShaderVars* vars = it0->second;
 
 		NVRHI::PipelineStageBindings* bindigs = &state;
 
@@ -396,13 +639,11 @@ void MaterialInterface::ApplyParams(NVRHI::DispatchState & state)
 		}
 
 
-		for (FastMap<String, RawShaderTextureDefine>::iterator it = vars->TextureDefines.begin(); it != vars->TextureDefines.end(); it++)
+		for (RawShaderTextureDefine& texDefine : vars->TextureDefines)
 		{
-			RawShaderTextureDefine& texDefine = it->second;
-
-			if (_TextureVariables.find(it->first) != _TextureVariables.end())
+			if (texDefine.MaterialIndex != MATERIAL_PARAM_INVALID_INDEX && _TextureVariables[texDefine.MaterialIndex].IsSet)
 			{
-				texDefine.TextureHandle = _TextureVariables[it->first].Handle;
+				texDefine.TextureHandle = _TextureVariables[texDefine.MaterialIndex].Handle;
 			}
 
 			bool writable = false;
@@ -415,25 +656,21 @@ void MaterialInterface::ApplyParams(NVRHI::DispatchState & state)
 			NVRHI::BindTexture(*bindigs, texDefine.BindIndex, texDefine.TextureHandle, writable);
 		}
 
-		for (FastMap<String, RawShaderSamplerDefine>::iterator it = vars->SamplerDefines.begin(); it != vars->SamplerDefines.end(); it++)
+		for (RawShaderSamplerDefine& samDefine : vars->SamplerDefines)
 		{
-			RawShaderSamplerDefine& samDefine = it->second;
-
-			if (_SamplerVariables.find(it->first) != _SamplerVariables.end())
+			if (samDefine.MaterialIndex != MATERIAL_PARAM_INVALID_INDEX && _SamplerVariables[samDefine.MaterialIndex].IsSet)
 			{
-				samDefine.SamplerHandle = _SamplerVariables[it->first].Handle;
+				samDefine.SamplerHandle = _SamplerVariables[samDefine.MaterialIndex].Handle;
 			}
 
-			NVRHI::BindSampler(*bindigs, samDefine.BindIndex, it->second.SamplerHandle);
+			NVRHI::BindSampler(*bindigs, samDefine.BindIndex, samDefine.SamplerHandle);
 		}
 
-		for (auto& it : vars->BufferDefines)
+		for (RawShaderBuffer& buffDefine : vars->BufferDefines)
 		{
-			RawShaderBuffer& buffDefine = it.second;
-
-			if (_BufferVariables.find(it.first) != _BufferVariables.end())
+			if (buffDefine.MaterialIndex != MATERIAL_PARAM_INVALID_INDEX && _BufferVariables[buffDefine.MaterialIndex].IsSet)
 			{
-				buffDefine.Buffer = _BufferVariables[it.first].Handle;
+				buffDefine.Buffer = _BufferVariables[buffDefine.MaterialIndex].Handle;
 			}
 
 			bool writable = false;
@@ -446,60 +683,16 @@ void MaterialInterface::ApplyParams(NVRHI::DispatchState & state)
 			NVRHI::BindBuffer(*bindigs, buffDefine.BindIndex, buffDefine.Buffer, writable);
 		}
 	}
-
-	for (Var* var : _VarsToMarkClean)
-	{
-		var->HasChnaged = false;
-	}
 }
 
 void MaterialInterface::ApplyParams(NVRHI::DrawCallState& state)
 {
-	//TODO: Optimize this method
-
-	// Prepare constant buffers
-	_VarsToMarkClean.clear();
+	UpdateConstantBuffers();
 
 	for (Map<NVRHI::ShaderType::Enum, ShaderVars*>::iterator it0 = _ActiveShaderVars.begin(); it0 != _ActiveShaderVars.end(); it0++)
 	{
 		ShaderVars* vars = it0->second;
 
-		// Write variable data to constant buffer
-		for (FastMap<String, RawShaderVariable>::iterator it1 = vars->Variables.begin(); it1 != vars->Variables.end(); it1++)
-		{
-			String name = it1->first;
-			RawShaderVariable& var = it1->second;
-
-			if (_Variables.find(name) != _Variables.end())
-			{
-				Var* localVar = _Variables[name];
-
-				if (localVar->HasChnaged)
-				{
-					_VarsToMarkClean.push_back(localVar);
-
-					if (var.Size != localVar->DataSize)
-					{
-						LogError("Variable(" + ToString(localVar->DataSize) + ") size is not coresponding with source size(" + ToString(var.Size) + ") !");
-						continue;
-					}
-
-					memcpy(vars->ConstantBuffers[var.ConstantBufferIndex].LocalDataBuffer + var.ByteOffset, localVar->Data, localVar->DataSize);
-
-					vars->ConstantBuffers[var.ConstantBufferIndex].MarkUpdate = true;
-				}
-			}
-		}
-
-		for (int i = 0; i < vars->ConstantBufferCount; i++)
-		{
-			if (vars->ConstantBuffers[i].MarkUpdate)
-			{
-				_Technique->GetEngineContext()->GetRenderInterface()->writeConstantBuffer(vars->ConstantBuffers[i].ConstantBuffer, vars->ConstantBuffers[i].LocalDataBuffer, vars->ConstantBuffers[i].Size);
-				vars->ConstantBuffers[i].MarkUpdate = false;
-			}
-		}
-
 		NVRHI::PipelineStageBindings* bindigs = GetPipelineStageBindingsForShaderType(state, vars->ShaderType);
 
 		if (bindigs == nullptr) continue;
@@ -510,49 +703,36 @@ void MaterialInterface::ApplyParams(NVRHI::DrawCallState& state)
 		}
 
 
-		for (FastMap<String, RawShaderTextureDefine>::iterator it = vars->TextureDefines.begin(); it != vars->TextureDefines.end(); it++)
+		for (RawShaderTextureDefine& texDefine : vars->TextureDefines)
 		{
-			RawShaderTextureDefine& texDefine = it->second;
-
-			if (_TextureVariables.find(it->first) != _TextureVariables.end())
+			if (texDefine.MaterialIndex != MATERIAL_PARAM_INVALID_INDEX && _TextureVariables[texDefine.MaterialIndex].IsSet)
 			{
-				texDefine.TextureHandle = _TextureVariables[it->first].Handle;
+				texDefine.TextureHandle = _TextureVariables[texDefine.MaterialIndex].Handle;
 			}
 
 			NVRHI::BindTexture(*bindigs, texDefine.BindIndex, texDefine.TextureHandle);
 		}
 
-		for (FastMap<String, RawShaderSamplerDefine>::iterator it = vars->SamplerDefines.begin(); it != vars->SamplerDefines.end(); it++)
+		for (RawShaderSamplerDefine& samDefine : vars->SamplerDefines)
 		{
-			RawShaderSamplerDefine& samDefine = it->second;
-
-			if (_SamplerVariables.find(it->first) != _SamplerVariables.end())
+			if (samDefine.MaterialIndex != MATERIAL_PARAM_INVALID_INDEX && _SamplerVariables[samDefine.MaterialIndex].IsSet)
 			{
-				samDefine.SamplerHandle = _SamplerVariables[it->first].Handle;
+				samDefine.SamplerHandle = _SamplerVariables[samDefine.MaterialIndex].Handle;
 			}
 
-			NVRHI::BindSampler(*bindigs, it->second.BindIndex, it->second.SamplerHandle);
+			NVRHI::BindSampler(*bindigs, samDefine.BindIndex, samDefine.SamplerHandle);
 		}
 
-		for (auto& it : vars->BufferDefines)
+		for (RawShaderBuffer& buffDefine : vars->BufferDefines)
 		{
-			RawShaderBuffer& buffDefine = it.second;
-
-			if (_BufferVariables.find(it.first) != _BufferVariables.end())
+			if (buffDefine.MaterialIndex != MATERIAL_PARAM_INVALID_INDEX && _BufferVariables[buffDefine.MaterialIndex].IsSet)
 			{
-				buffDefine.Buffer = _BufferVariables[it.first].Handle;
+				buffDefine.Buffer = _BufferVariables[buffDefine.MaterialIndex].Handle;
 			}
 
 			NVRHI::BindBuffer(*bindigs, buffDefine.BindIndex, buffDefine.Buffer, false);
 		}
 	}
-
-	for (Var* var : _VarsToMarkClean)
-	{
-		var->HasChnaged = false;
-	}
-
-
 }
 
 SharedPtr<Technique> MaterialInterface::GetTechnique()
@@ -585,7 +765,7 @@ NVRHI::PipelineStageBindings* MaterialInterface::GetPipelineStageBindingsForShad
 	}
 }
 
-void MaterialInterface::SetActiveShaderVars(List<Shader*>& shaders, uint32 packId)
+void MaterialInterface::SetActiveShaderVars(List<Shader*>& shaders, ShaderVariantKey packId)
 {
 	if (_ShaderVarsForVaryingShaders.find(packId) != _ShaderVarsForVaryingShaders.end())
 	{
@@ -599,6 +779,8 @@ void MaterialInterface::SetActiveShaderVars(List<Shader*>& shaders, uint32 packI
 		{
 			ShaderVars* vars = shader->CreateShaderVars();
 
+			ResolveParamIndices(vars);
+
 			for (int i = 0; i < vars->ConstantBufferCount; i++)
 			{
 				RawShaderConstantBuffer& cbuffer = vars->ConstantBuffers[i];
@@ -616,18 +798,25 @@ void MaterialInterface::SetActiveShaderVars(List<Shader*>& shaders, uint32 packI
 	}
 }
 
-bool MaterialInterface::SetVariable(const String & name, const VarType::Type & type, const void* data, size_t size)
+bool MaterialInterface::SetVariable(MaterialParamId id, const VarType::Type & type, const void* data, size_t size)
 {
-	Var* var = nullptr;
-
-	if (_Variables.find(name) != _Variables.end())
+	if (id == MATERIAL_PARAM_INVALID_ID)
 	{
-		var = _Variables[name];
+		return false;
 	}
-	else
+
+	uint32 index = AddParamIndex(id);
+
+	Var* var = _Variables[index];
+	bool isNew = false;
+
+	if (var == nullptr)
 	{
+		isNew = true;
+
 		var = new Var();
-		var->Name = name;
+		var->Id = id;
+		var->Name = MaterialParam::GetName(id);
 		var->Type = type;
 		var->DataSize = size;
 		var->Data = new unsigned char[size];
@@ -635,21 +824,96 @@ bool MaterialInterface::SetVariable(const String & name, const VarType::Type & t
 
 	if (var->Type != type)
 	{
-		LogError("MaterialInterface::SetVariable", name + ", " + ToString((int)type), "Type cannot be chnaged from(" + ToString((int)var->Type) + ") to(" + ToString((int)type) + ") !");
+		LogError("MaterialInterface::SetVariable", var->Name + ", " + ToString((int)type), "Type cannot be chnaged from(" + ToString((int)var->Type) + ") to(" + ToString((int)type) + ") !");
 		return false;
 	}
 
 	if (var->DataSize != size)
 	{
-		LogError("MaterialInterface::SetVariable", name + ", " + ToString((int)type), "Illegal type detected ! Old data size(" + ToString(var->DataSize) + ") new(" + ToString(size) + ")");
+		LogError("MaterialInterface::SetVariable", var->Name + ", " + ToString((int)type), "Illegal type detected ! Old data size(" + ToString(var->DataSize) + ") new(" + ToString(size) + ")");
 		return false;
 	}
 
-	memcpy(var->Data, data, size);
+	// Setting the value a variable already has does not upload the constant buffer again
+	if (isNew || memcmp(var->Data, data, size) != 0)
+	{
+		memcpy(var->Data, data, size);
 
-	var->HasChnaged = true;
+		var->HasChnaged = true;
+	}
 
-	_Variables[name] = var;
+	_Variables[index] = var;
 
 	return true;
+}
+
+uint32 MaterialInterface::GetParamIndex(MaterialParamId id) const
+{
+	auto iter = _ParamIndices.find(id);
+
+	if (iter != _ParamIndices.end())
+	{
+		return iter->second;
+	}
+
+	return MATERIAL_PARAM_INVALID_INDEX;
+}
+
+uint32 MaterialInterface::AddParamIndex(MaterialParamId id)
+{
+	auto iter = _ParamIndices.find(id);
+
+	if (iter != _ParamIndices.end())
+	{
+		return iter->second;
+	}
+
+	uint32 index = (uint32)_Variables.size();
+
+	_ParamIndices[id] = index;
+
+	_Variables.push_back(nullptr);
+	_TextureVariables.push_back(TextureVar());
+	_SamplerVariables.push_back(SamplerVar());
+	_BufferVariables.push_back(BufferVar());
+
+	_HasNewParamIndices = true;
+
+	return index;
+}
+
+void MaterialInterface::ResolveParamIndices(ShaderVars* vars)
+{
+	for (RawShaderVariable& var : vars->Variables)
+	{
+		var.MaterialIndex = GetParamIndex(var.Id);
+	}
+
+	for (RawShaderTextureDefine& define : vars->TextureDefines)
+	{
+		define.MaterialIndex = GetParamIndex(define.Id);
+	}
+
+	for (RawShaderSamplerDefine& define : vars->SamplerDefines)
+	{
+		define.MaterialIndex = GetParamIndex(define.Id);
+	}
+
+	for (RawShaderBuffer& define : vars->BufferDefines)
+	{
+		define.MaterialIndex = GetParamIndex(define.Id);
+	}
+}
+
+void MaterialInterface::ResolveAllParamIndices()
+{
+	ITER(_ShaderVarsForVaryingShaders, it0)
+	{
+		ITER(it0->second, it1)
+		{
+			ResolveParamIndices(it1->second);
+		}
+	}
+
+	_HasNewParamIndices = false;
 }
\ No newline at end of file
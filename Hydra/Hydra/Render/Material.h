@@ -8,6 +8,7 @@
 #include <d3d11.h>
 
 #include "Hydra/Render/VarType.h"
+#include "Hydra/Render/MaterialParam.h"
 
 #include "Hydra/Assets/Asset.h"
 
@@ -22,6 +23,7 @@ struct StorageStruct
 
 struct Var
 {
+	MaterialParamId Id;
 	String Name;
 	VarType::Type Type;
 	unsigned char* Data;
@@ -31,18 +33,21 @@ struct Var
 
 struct TextureVar
 {
+	bool IsSet;
 	NVRHI::TextureHandle Handle;
 	bool HasChnaged;
 };
 
 struct SamplerVar
 {
+	bool IsSet;
 	NVRHI::SamplerHandle Handle;
 	bool HasChnaged;
 };
 
 struct BufferVar
 {
+	bool IsSet;
 	NVRHI::BufferHandle Handle;
 	bool HasChnaged;
 };
@@ -55,15 +60,34 @@ private:
 
 	SharedPtr<Technique> _Technique;
 
-	Map<String, Var*> _Variables;
-	Map<String, TextureVar> _TextureVariables;
-	Map<String, SamplerVar> _SamplerVariables;
-	Map<String, BufferVar> _BufferVariables;
+	// Compact index of every parameter the material set, the tables below only grow with those and not with every
+	// name interned by any material or shader
+	FastMap<MaterialParamId, uint32> _ParamIndices;
+
+	// Set when a parameter got an index after the shader vars were resolved against the tables
+	bool _HasNewParamIndices;
+
+	// Indexed by the compact index, null for parameters that are not variables
+	List<Var*> _Variables;
+
+	// Indexed by the compact index too, IsSet tells which ones the material set
+	List<TextureVar> _TextureVariables;
+	List<SamplerVar> _SamplerVariables;
+	List<BufferVar> _BufferVariables;
 
 	Map<NVRHI::ShaderType::Enum, Shader*> _ActiveShaders;
 	Map<String, String> _Defines;
 
-	Map<uint32, Map<NVRHI::ShaderType::Enum, ShaderVars*>> _ShaderVarsForVaryingShaders;
+	// Key of the current defines, kept up to date one define at a time
+	ShaderVariantKey _VariantKey;
+
+	// Set while the variant for the current defines compiles, the shaders that were active are used until it is ready
+	bool _HasPendingShaders;
+
+	// Revision of the technique the shaders and vars are from
+	uint32 _TechniqueRevision;
+
+	FastMap<ShaderVariantKey, Map<NVRHI::ShaderType::Enum, ShaderVars*>> _ShaderVarsForVaryingShaders;
 	Map<NVRHI::ShaderType::Enum, ShaderVars*> _ActiveShaderVars;
 
 	List<Var*> _VarsToMarkClean;
@@ -78,50 +102,82 @@ public:
 	MaterialInterface(const String& name, SharedPtr<Technique> technique);
 	~MaterialInterface();
 
+	// Every parameter can be set by name or by the id MaterialParam::GetId returns for the name. The name overloads
+	// lock and hash the name on every call, anything set per frame should resolve the id once and use it.
 	void SetInt(const String& name, const int& i);
 	bool GetInt(const String& name, int* outInt);
+	void SetInt(MaterialParamId id, const int& i);
+	bool GetInt(MaterialParamId id, int* outInt);
 
 	void SetUInt(const String& name, const unsigned int& i);
 	bool GetUInt(const String& name, unsigned int* outInt);
+	void SetUInt(MaterialParamId id, const unsigned int& i);
+	bool GetUInt(MaterialParamId id, unsigned int* outInt);
 
 	void SetFloat(const String& name, const float& f);
 	bool GetFloat(const String& name, float* outFloat);
+	void SetFloat(MaterialParamId id, const float& f);
+	bool GetFloat(MaterialParamId id, float* outFloat);
 
 	void SetBool(const String& name, const bool& b);
 	bool GetBool(const String& name, bool* outBool);
+	void SetBool(MaterialParamId id, const bool& b);
+	bool GetBool(MaterialParamId id, bool* outBool);
 
 	void SetVector2(const String& name, const Vector2& vec);
 	bool GetVector2(const String& name, Vector2* outVec);
+	void SetVector2(MaterialParamId id, const Vector2& vec);
+	bool GetVector2(MaterialParamId id, Vector2* outVec);
 
 	void SetVector3(const String& name, const Vector3& vec);
 	bool GetVector3(const String& name, Vector3* outVec);
+	void SetVector3(MaterialParamId id, const Vector3& vec);
+	bool GetVector3(MaterialParamId id, Vector3* outVec);
 
 	void SetVector4(const String& name, const Vector4& vec);
 	bool GetVector4(const String& name, Vector4* outVec);
+	void SetVector4(MaterialParamId id, const Vector4& vec);
+	bool GetVector4(MaterialParamId id, Vector4* outVec);
 
 	void SetVector4Array(const String& name, Vector4* vecArr, size_t arrSize);
 	bool GetVector4Array(const String& name, Vector4* vector, size_t arrSize);
+	void SetVector4Array(MaterialParamId id, Vector4* vecArr, size_t arrSize);
+	bool GetVector4Array(MaterialParamId id, Vector4* vector, size_t arrSize);
 
 	void SetMatrix3(const String& name, const Matrix3& mat);
 	bool GetMatrix3(const String& name, Matrix3* outMat);
+	void SetMatrix3(MaterialParamId id, const Matrix3& mat);
+	bool GetMatrix3(MaterialParamId id, Matrix3* outMat);
 
 	void SetMatrix4(const String& name, const Matrix4& mat);
 	bool GetMatrix4(const String& name, Matrix4* outMat);
+	void SetMatrix4(MaterialParamId id, const Matrix4& mat);
+	bool GetMatrix4(MaterialParamId id, Matrix4* outMat);
 
 	void SetStruct(const String& name, StorageStruct& s, size_t size);
 	void SetStructArray(const String& name, void* s, size_t size);
+	void SetStruct(MaterialParamId id, StorageStruct& s, size_t size);
+	void SetStructArray(MaterialParamId id, void* s, size_t size);
 
 	void SetTexture(const String& name, NVRHI::TextureHandle texture);
 	NVRHI::TextureHandle GetTexture(const String& name);
+	void SetTexture(MaterialParamId id, NVRHI::TextureHandle texture);
+	NVRHI::TextureHandle GetTexture(MaterialParamId id);
 
 	void SetSampler(const String& name, NVRHI::SamplerHandle sampler);
 	NVRHI::SamplerHandle GetSampler(const String& name);
+	void SetSampler(MaterialParamId id, NVRHI::SamplerHandle sampler);
+	NVRHI::SamplerHandle GetSampler(MaterialParamId id);
 
 	void SetBuffer(const String& name, NVRHI::BufferHandle buffer);
 	NVRHI::BufferHandle GetBuffer(const String& name);
+	void SetBuffer(MaterialParamId id, NVRHI::BufferHandle buffer);
+	NVRHI::BufferHandle GetBuffer(MaterialParamId id);
 
 	Var* GetRawVar(const String& name);
 	unsigned char* GetRawVarData(const String& name);
+	Var* GetRawVar(MaterialParamId id);
+	unsigned char* GetRawVarData(MaterialParamId id);
 
 	Map<String, VarType::Type> GetVarTypes();
 
@@ -130,6 +186,9 @@ public:
 	Shader* GetShader(const NVRHI::ShaderType::Enum& type);
 	NVRHI::ShaderHandle GetRawShader(const NVRHI::ShaderType::Enum& type);
 
+	// Writes the variables changed since the last call to the constant buffers, without binding anything
+	void UpdateConstantBuffers();
+
 	void ApplyParams(NVRHI::DispatchState& state);
 	void ApplyParams(NVRHI::DrawCallState& state);
 
@@ -139,12 +198,31 @@ private:
 
 	NVRHI::PipelineStageBindings* GetPipelineStageBindingsForShaderType(NVRHI::DrawCallState& state, const NVRHI::ShaderType::Enum& type);
 
-	void SetActiveShaderVars(List<Shader*>& shaders, uint32 packId);
+	void SetActiveShaderVars(List<Shader*>& shaders, ShaderVariantKey packId);
+	void ActivateShaders(List<Shader*>& shaders, ShaderVariantKey packId);
 
-	bool SetVariable(const String& name, const VarType::Type& type, const void* data, size_t size);
+	// Switches to the variant of the current defines once the technique finished compiling it, or after it was reloaded
+	void UpdatePendingShaders();
+
+	// Deletes the vars and constant buffers of every variant used so far
+	void ReleaseShaderVars();
+
+	// Copies variables changed since the last call into the local data of their constant buffers and marks those for upload
+	void CopyChangedVariables();
+
+	uint32 GetParamIndex(MaterialParamId id) const;
+
+	// Returns the index of the parameter, adds a slot to every table the first time the material sets it
+	uint32 AddParamIndex(MaterialParamId id);
+
+	// Caches the index of every parameter the shader reads in its vars, so applying them does not look anything up
+	void ResolveParamIndices(ShaderVars* vars);
+	void ResolveAllParamIndices();
+
+	bool SetVariable(MaterialParamId id, const VarType::Type& type, const void* data, size_t size);
 
 	template <typename T>
-	inline bool GetVariable(const String name, const VarType::Type& type, T* outData, bool autoSize = true, size_t customSize = 0)
+	inline bool GetVariable(MaterialParamId id, const VarType::Type& type, T* outData, bool autoSize = true, size_t customSize = 0)
 	{
 		size_t size = sizeof(T);
 
@@ -153,19 +231,21 @@ private:
 			size = customSize;
 		}
 
-		if (_Variables.find(name) != _Variables.end())
+		uint32 index = GetParamIndex(id);
+
+		if (index != MATERIAL_PARAM_INVALID_INDEX && _Variables[index] != nullptr)
 		{
-			Var* var = _Variables[name];
+			Var* var = _Variables[index];
 
 			if (var->Type != type)
 			{
-				LogError("Material::GetVariable", name + ", " + ToString((int)type), "Type cannot be chnaged from(" + ToString((int)var->Type) + ") to(" + ToString((int)type) + ") !");
+				LogError("Material::GetVariable", var->Name + ", " + ToString((int)type), "Type cannot be chnaged from(" + ToString((int)var->Type) + ") to(" + ToString((int)type) + ") !");
 				return false;
 			}
 
 			if (var->DataSize != size)
 			{
-				LogError("Material::GetVariable", name + ", " + ToString((int)type), "Illegal type detected ! Old data size(" + ToString(var->DataSize) + ") new(" + ToString(size) + ")");
+				LogError("Material::GetVariable", var->Name + ", " + ToString((int)type), "Illegal type detected ! Old data size(" + ToString(var->DataSize) + ") new(" + ToString(size) + ")");
 				return false;
 			}
 
@@ -178,11 +258,11 @@ private:
 	}
 
 	template <typename T>
-	inline bool SetVariable(const String name, const VarType::Type& type, T data)
+	inline bool SetVariable(MaterialParamId id, const VarType::Type& type, T data)
 	{
 		void* rawData = (void*)(&data);
 		size_t size = sizeof(data);
 
-		return SetVariable(name, type, rawData, size);
+		return SetVariable(id, type, rawData, size);
 	}
 };
\ No newline at end of file
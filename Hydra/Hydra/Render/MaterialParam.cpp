@@ -0,0 +1,43 @@
+#include "MaterialParam.h"
+
+FastMap<String, MaterialParamId> MaterialParam::_Ids;
+List<String> MaterialParam::_Names;
+std::mutex MaterialParam::_Mutex;
+
+MaterialParamId MaterialParam::GetId(const String& name)
+{
+	std::lock_guard<std::mutex> lock(_Mutex);
+
+	auto iter = _Ids.find(name);
+
+	if (iter != _Ids.end())
+	{
+		return iter->second;
+	}
+
+	MaterialParamId id = (MaterialParamId)_Names.size();
+
+	_Ids[name] = id;
+	_Names.push_back(name);
+
+	return id;
+}
+
+String MaterialParam::GetName(MaterialParamId id)
+{
+	std::lock_guard<std::mutex> lock(_Mutex);
+
+	if (id >= _Names.size())
+	{
+		return String_None;
+	}
+
+	return _Names[id];
+}
+
+uint32 MaterialParam::GetCount()
+{
+	std::lock_guard<std::mutex> lock(_Mutex);
+
+	return (uint32)_Names.size();
+}
\ No newline at end of file
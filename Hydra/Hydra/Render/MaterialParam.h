@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Hydra/Core/Library.h"
+#include "Hydra/Core/Common.h"
+#include "Hydra/Core/Container.h"
+
+#include <mutex>
+
+// Handle of a material parameter name, resolve it once and use it to set parameters without hashing strings
+typedef uint32 MaterialParamId;
+
+#define MATERIAL_PARAM_INVALID_ID 0xFFFFFFFF
+
+// Index of a parameter the material never set
+#define MATERIAL_PARAM_INVALID_INDEX 0xFFFFFFFF
+
+// Interns parameter names of materials and shaders. Ids are small and dense, and the same for every material and
+// shader for as long as the engine runs, so they index flat tables directly.
+class HYDRA_API MaterialParam
+{
+private:
+	static FastMap<String, MaterialParamId> _Ids;
+	static List<String> _Names;
+	static std::mutex _Mutex;
+
+public:
+	// Returns the id of the name, a new one the first time the name is seen
+	static MaterialParamId GetId(const String& name);
+
+	static String GetName(MaterialParamId id);
+
+	// Number of ids handed out so far, every id is lower
+	static uint32 GetCount();
+};
\ No newline at end of file
@@ -25,7 +25,7 @@ Mesh::~Mesh()
 void Mesh::UpdateBounds()
 {
 	float floatMax = FloatMax;
-	float floatMin = FloatMin;
+	float floatMin = -FloatMax;
 
 	Vector3 maxBounds = Vector3(floatMin, floatMin, floatMin);
 	Vector3 minBounds = Vector3(floatMax, floatMax, floatMax);
@@ -204,13 +204,13 @@ void Mesh::SmoothMesh()
 	}
 }
 
-void Mesh::CreateComplexCollider()
+void Mesh::CreateComplexCollider(ThreadPool* threadPool)
 {
 	if (_ComplexCollider == nullptr)
 	{
 		UpdateBounds();
 
-		_ComplexCollider = new BIHTree(this);
+		_ComplexCollider = new BIHTree(this, BIH_MESH_COLLIDER_MAX_TRIS_PER_NODE, BIH_MESH_COLLIDER_LAYOUT, BIH_MESH_COLLIDER_SPLIT_METHOD, threadPool);
 	}
 }
 
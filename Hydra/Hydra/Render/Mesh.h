@@ -20,6 +20,7 @@ struct PrimitiveType
 class BIHTree;
 
 class EngineContext;
+class ThreadPool;
 
 // This is old mesh class
 class HYDRA_API Mesh : public Resource
@@ -50,7 +51,7 @@ public:
 
 	void SmoothMesh();
 
-	void CreateComplexCollider();
+	void CreateComplexCollider(ThreadPool* threadPool = nullptr);
 	BIHTree* GetComplexCollider();
 
 	void UpdateBuffers(EngineContext* context);
@@ -0,0 +1,714 @@
+#include "Hydra/Render/MeshSimplifier.h"
+#include "Hydra/Framework/StaticMeshResources.h"
+
+#include <algorithm>
+#include <numeric>
+#include <cfloat>
+
+static const uint32 SimplifierInvalid = 0xFFFFFFFF;
+
+// Upper triangle of the symmetric 4x4 matrix summing the squared distances to a set of planes
+struct SimplifierQuadric
+{
+	double A00, A01, A02, A03, A11, A12, A13, A22, A23, A33;
+};
+
+struct SimplifierEdge
+{
+	uint32 A;
+	uint32 B;
+};
+
+struct SimplifierCollapse
+{
+	uint32 From;
+	uint32 To;
+	double Cost;
+};
+
+static void AddPlane(SimplifierQuadric& q, const Vector3& normal, float distance, double weight)
+{
+	double a = normal.x;
+	double b = normal.y;
+	double c = normal.z;
+	double d = distance;
+
+	q.A00 += weight * a * a; q.A01 += weight * a * b; q.A02 += weight * a * c; q.A03 += weight * a * d;
+	q.A11 += weight * b * b; q.A12 += weight * b * c; q.A13 += weight * b * d;
+	q.A22 += weight * c * c; q.A23 += weight * c * d;
+	q.A33 += weight * d * d;
+}
+
+static void AddQuadric(SimplifierQuadric& q, const SimplifierQuadric& other)
+{
+	q.A00 += other.A00; q.A01 += other.A01; q.A02 += other.A02; q.A03 += other.A03;
+	q.A11 += other.A11; q.A12 += other.A12; q.A13 += other.A13;
+	q.A22 += other.A22; q.A23 += other.A23;
+	q.A33 += other.A33;
+}
+
+static double EvaluateQuadric(const SimplifierQuadric& q, const Vector3& point)
+{
+	double x = point.x;
+	double y = point.y;
+	double z = point.z;
+
+	return q.A00 * x * x + 2.0 * q.A01 * x * y + 2.0 * q.A02 * x * z + 2.0 * q.A03 * x
+		+ q.A11 * y * y + 2.0 * q.A12 * y * z + 2.0 * q.A13 * y
+		+ q.A22 * z * z + 2.0 * q.A23 * z
+		+ q.A33;
+}
+
+static bool IsEdgeLess(const SimplifierEdge& left, const SimplifierEdge& right)
+{
+	return left.A < right.A || (left.A == right.A && left.B < right.B);
+}
+
+static uint32 ResolveVertex(List<uint32>& vertexRemap, uint32 vertex)
+{
+	uint32 target = vertex;
+
+	while (vertexRemap[target] != target)
+	{
+		target = vertexRemap[target];
+	}
+
+	// Shorten the chain for the next lookups
+	while (vertexRemap[vertex] != target)
+	{
+		uint32 next = vertexRemap[vertex];
+		vertexRemap[vertex] = target;
+		vertex = next;
+	}
+
+	return target;
+}
+
+// Vertices with equal positions share a group, the collapses move whole groups
+static void WeldPositions(const List<Vector3>& positions, List<uint32>& groups, List<Vector3>& groupPositions)
+{
+	uint32 vertexCount = (uint32)positions.size();
+
+	List<uint32> order(vertexCount);
+	std::iota(order.begin(), order.end(), 0);
+
+	std::sort(order.begin(), order.end(), [&](uint32 left, uint32 right)
+	{
+		const Vector3& a = positions[left];
+		const Vector3& b = positions[right];
+
+		return a.x < b.x || (a.x == b.x && (a.y < b.y || (a.y == b.y && a.z < b.z)));
+	});
+
+	groups.resize(vertexCount);
+	groupPositions.clear();
+
+	for (uint32 i = 0; i < vertexCount; i++)
+	{
+		uint32 vertex = order[i];
+
+		if (i == 0 || positions[vertex] != positions[order[i - 1]])
+		{
+			groupPositions.push_back(positions[vertex]);
+		}
+
+		groups[vertex] = (uint32)groupPositions.size() - 1;
+	}
+}
+
+// Simplify on welded vertices, pinned groups never move but other groups may collapse onto them
+static void SimplifyGroups(const List<uint32>& groups, const List<Vector3>& groupPositions, const List<uint8>& pinned, List<uint32>& indices, uint32 targetTriangleCount)
+{
+	uint32 vertexCount = (uint32)groups.size();
+	uint32 groupCount = (uint32)groupPositions.size();
+
+	if (indices.size() / 3 <= targetTriangleCount)
+	{
+		return;
+	}
+
+	// Vertices of every position as a linked list
+	List<uint32> firstWedge(groupCount, SimplifierInvalid);
+	List<uint32> nextWedge(vertexCount, SimplifierInvalid);
+
+	for (uint32 vertex = 0; vertex < vertexCount; vertex++)
+	{
+		nextWedge[vertex] = firstWedge[groups[vertex]];
+		firstWedge[groups[vertex]] = vertex;
+	}
+
+	List<uint32> vertexRemap(vertexCount);
+	std::iota(vertexRemap.begin(), vertexRemap.end(), 0);
+
+	List<uint32> wedgeTargets(vertexCount, SimplifierInvalid);
+
+	// Resolves collapsed vertices and drops the triangles that lost an area
+	auto compactTriangles = [&]()
+	{
+		size_t count = 0;
+
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			uint32 a = ResolveVertex(vertexRemap, indices[i]);
+			uint32 b = ResolveVertex(vertexRemap, indices[i + 1]);
+			uint32 c = ResolveVertex(vertexRemap, indices[i + 2]);
+
+			if (groups[a] == groups[b] || groups[b] == groups[c] || groups[a] == groups[c])
+			{
+				continue;
+			}
+
+			indices[count++] = a;
+			indices[count++] = b;
+			indices[count++] = c;
+		}
+
+		indices.resize(count);
+	};
+
+	List<SimplifierEdge> edges;
+
+	// Edges between positions, sorted, one entry per triangle using the edge
+	auto buildEdges = [&]()
+	{
+		edges.clear();
+		edges.reserve(indices.size());
+
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				uint32 a = groups[indices[i + k]];
+				uint32 b = groups[indices[i + (k + 1) % 3]];
+
+				edges.push_back({ glm::min(a, b), glm::max(a, b) });
+			}
+		}
+
+		std::sort(edges.begin(), edges.end(), IsEdgeLess);
+	};
+
+	compactTriangles();
+
+	// Plane of every triangle, weighted by its area, and planes standing on the open borders
+	List<SimplifierQuadric> quadrics(groupCount, SimplifierQuadric());
+
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		const Vector3& p0 = groupPositions[groups[indices[i]]];
+		const Vector3& p1 = groupPositions[groups[indices[i + 1]]];
+		const Vector3& p2 = groupPositions[groups[indices[i + 2]]];
+
+		Vector3 normal = glm::cross(p1 - p0, p2 - p0);
+		float length = glm::length(normal);
+
+		if (length == 0.0f)
+		{
+			continue;
+		}
+
+		normal /= length;
+		float distance = -glm::dot(normal, p0);
+
+		for (int k = 0; k < 3; k++)
+		{
+			AddPlane(quadrics[groups[indices[i + k]]], normal, distance, length * 0.5);
+		}
+	}
+
+	// A border edge is one that a single triangle uses
+	buildEdges();
+
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		const Vector3& p0 = groupPositions[groups[indices[i]]];
+		const Vector3& p1 = groupPositions[groups[indices[i + 1]]];
+		const Vector3& p2 = groupPositions[groups[indices[i + 2]]];
+
+		Vector3 normal = glm::cross(p1 - p0, p2 - p0);
+
+		if (glm::dot(normal, normal) == 0.0f)
+		{
+			continue;
+		}
+
+		normal = glm::normalize(normal);
+
+		for (int k = 0; k < 3; k++)
+		{
+			uint32 a = groups[indices[i + k]];
+			uint32 b = groups[indices[i + (k + 1) % 3]];
+
+			SimplifierEdge key = { glm::min(a, b), glm::max(a, b) };
+			auto range = std::equal_range(edges.begin(), edges.end(), key, IsEdgeLess);
+
+			if (range.second - range.first != 1)
+			{
+				continue;
+			}
+
+			Vector3 edge = groupPositions[b] - groupPositions[a];
+			Vector3 borderNormal = glm::cross(edge, normal);
+			float length = glm::length(borderNormal);
+
+			if (length == 0.0f)
+			{
+				continue;
+			}
+
+			borderNormal /= length;
+			float distance = -glm::dot(borderNormal, groupPositions[a]);
+			double weight = glm::dot(edge, edge) * MESH_SIMPLIFIER_BORDER_WEIGHT;
+
+			AddPlane(quadrics[a], borderNormal, distance, weight);
+			AddPlane(quadrics[b], borderNormal, distance, weight);
+		}
+	}
+
+	List<uint8> border(groupCount);
+	List<uint8> locked(groupCount);
+	List<uint32> adjacencyOffsets(groupCount + 1);
+	List<uint32> adjacency;
+	List<SimplifierCollapse> collapses;
+	List<uint32> movedWedges;
+
+	uint32 triangleCount = (uint32)indices.size() / 3;
+
+	while (triangleCount > targetTriangleCount)
+	{
+		buildEdges();
+
+		// Positions on an open border may only move along it
+		std::fill(border.begin(), border.end(), 0);
+
+		for (size_t i = 0; i < edges.size();)
+		{
+			size_t end = i + 1;
+			while (end < edges.size() && edges[end].A == edges[i].A && edges[end].B == edges[i].B)
+			{
+				end++;
+			}
+
+			if (end - i != 2)
+			{
+				border[edges[i].A] = 1;
+				border[edges[i].B] = 1;
+			}
+
+			i = end;
+		}
+
+		// Triangles around every position
+		std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+
+		for (uint32 index : indices)
+		{
+			adjacencyOffsets[groups[index] + 1]++;
+		}
+		for (uint32 g = 0; g < groupCount; g++)
+		{
+			adjacencyOffsets[g + 1] += adjacencyOffsets[g];
+		}
+
+		adjacency.resize(indices.size());
+
+		{
+			List<uint32> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+			for (size_t i = 0; i < indices.size(); i++)
+			{
+				adjacency[fill[groups[indices[i]]]++] = (uint32)(i / 3);
+			}
+		}
+
+		// Cheapest direction of every edge
+		collapses.clear();
+
+		for (size_t i = 0; i < edges.size();)
+		{
+			size_t end = i + 1;
+			while (end < edges.size() && edges[end].A == edges[i].A && edges[end].B == edges[i].B)
+			{
+				end++;
+			}
+
+			size_t uses = end - i;
+			uint32 a = edges[i].A;
+			uint32 b = edges[i].B;
+
+			i = end;
+
+			// Edges shared by more than two triangles stay
+			if (uses > 2)
+			{
+				continue;
+			}
+
+			bool borderEdge = uses == 1;
+
+			bool aToB = (!border[a] || borderEdge) && !pinned[a];
+			bool bToA = (!border[b] || borderEdge) && !pinned[b];
+
+			if (!aToB && !bToA)
+			{
+				continue;
+			}
+
+			SimplifierQuadric sum = quadrics[a];
+			AddQuadric(sum, quadrics[b]);
+
+			double costAToB = aToB ? EvaluateQuadric(sum, groupPositions[b]) : DBL_MAX;
+			double costBToA = bToA ? EvaluateQuadric(sum, groupPositions[a]) : DBL_MAX;
+
+			if (costAToB <= costBToA)
+			{
+				collapses.push_back({ a, b, costAToB });
+			}
+			else
+			{
+				collapses.push_back({ b, a, costBToA });
+			}
+		}
+
+		std::sort(collapses.begin(), collapses.end(), [](const SimplifierCollapse& left, const SimplifierCollapse& right)
+		{
+			return left.Cost < right.Cost;
+		});
+
+		std::fill(locked.begin(), locked.end(), 0);
+
+		// Every collapse removes about two triangles. A position is only touched once per pass,
+		// so the triangles around it are still the ones the adjacency lists were built from.
+		uint32 collapseGoal = (triangleCount - targetTriangleCount) / 2 + 1;
+		uint32 collapsed = 0;
+
+		for (const SimplifierCollapse& collapse : collapses)
+		{
+			if (collapsed >= collapseGoal)
+			{
+				break;
+			}
+
+			uint32 from = collapse.From;
+			uint32 to = collapse.To;
+
+			if (locked[from] || locked[to])
+			{
+				continue;
+			}
+
+			const Vector3& target = groupPositions[to];
+
+			bool valid = true;
+			uint32 removed = 0;
+
+			movedWedges.clear();
+
+			for (uint32 k = adjacencyOffsets[from]; k < adjacencyOffsets[from + 1] && valid; k++)
+			{
+				uint32 triangle = adjacency[k];
+
+				uint32 corners[3];
+				uint32 cornerGroups[3];
+
+				for (int c = 0; c < 3; c++)
+				{
+					corners[c] = ResolveVertex(vertexRemap, indices[triangle * 3 + c]);
+					cornerGroups[c] = groups[corners[c]];
+				}
+
+				if (cornerGroups[0] == cornerGroups[1] || cornerGroups[1] == cornerGroups[2] || cornerGroups[0] == cornerGroups[2])
+				{
+					continue;
+				}
+
+				// A neighbour that already moved in this pass would make the flip check below use stale positions
+				if (locked[cornerGroups[0]] || locked[cornerGroups[1]] || locked[cornerGroups[2]])
+				{
+					valid = false;
+					break;
+				}
+
+				int fromCorner = cornerGroups[0] == from ? 0 : (cornerGroups[1] == from ? 1 : 2);
+				int toCorner = cornerGroups[0] == to ? 0 : (cornerGroups[1] == to ? 1 : (cornerGroups[2] == to ? 2 : -1));
+
+				if (toCorner >= 0)
+				{
+					// The triangle goes away, its vertex at the target is where the collapsing vertex ends up
+					if (wedgeTargets[corners[fromCorner]] == SimplifierInvalid)
+					{
+						wedgeTargets[corners[fromCorner]] = corners[toCorner];
+					}
+
+					removed++;
+					continue;
+				}
+
+				movedWedges.push_back(corners[fromCorner]);
+
+				const Vector3& p0 = groupPositions[cornerGroups[0]];
+				const Vector3& p1 = groupPositions[cornerGroups[1]];
+				const Vector3& p2 = groupPositions[cornerGroups[2]];
+
+				Vector3 before = glm::cross(p1 - p0, p2 - p0);
+
+				Vector3 moved[3] = { p0, p1, p2 };
+				moved[fromCorner] = target;
+
+				Vector3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+
+				// Reject flips and also folds that turn a face too far, those show up as spikes in lower LODs
+				if (glm::dot(before, after) <= MESH_SIMPLIFIER_MIN_NORMAL_DOT * glm::length(before) * glm::length(after))
+				{
+					valid = false;
+				}
+			}
+
+			// Every vertex of the position that stays in use needs a vertex at the target, otherwise a seam would tear
+			for (size_t k = 0; k < movedWedges.size() && valid; k++)
+			{
+				if (wedgeTargets[movedWedges[k]] == SimplifierInvalid)
+				{
+					valid = false;
+				}
+			}
+
+			for (uint32 wedge = firstWedge[from]; wedge != SimplifierInvalid; wedge = nextWedge[wedge])
+			{
+				if (valid && wedgeTargets[wedge] != SimplifierInvalid)
+				{
+					vertexRemap[wedge] = wedgeTargets[wedge];
+				}
+
+				wedgeTargets[wedge] = SimplifierInvalid;
+			}
+
+			if (!valid)
+			{
+				continue;
+			}
+
+			AddQuadric(quadrics[to], quadrics[from]);
+
+			for (uint32 k = adjacencyOffsets[from]; k < adjacencyOffsets[from + 1]; k++)
+			{
+				for (int c = 0; c < 3; c++)
+				{
+					locked[groups[ResolveVertex(vertexRemap, indices[adjacency[k] * 3 + c])]] = 1;
+				}
+			}
+
+			locked[from] = 1;
+			locked[to] = 1;
+
+			triangleCount -= glm::min(removed, triangleCount);
+			collapsed++;
+		}
+
+		if (collapsed == 0)
+		{
+			break;
+		}
+
+		compactTriangles();
+
+		triangleCount = (uint32)indices.size() / 3;
+	}
+}
+
+void MeshSimplifier::Simplify(const List<Vector3>& positions, List<uint32>& indices, uint32 targetTriangleCount)
+{
+	if (indices.size() / 3 <= targetTriangleCount)
+	{
+		return;
+	}
+
+	List<uint32> groups;
+	List<Vector3> groupPositions;
+	WeldPositions(positions, groups, groupPositions);
+
+	SimplifyGroups(groups, groupPositions, List<uint8>(groupPositions.size(), 0), indices, targetTriangleCount);
+}
+
+void MeshSimplifier::GenerateLODs(FStaticMeshRenderData& renderData, const List<float>& triangleRatios)
+{
+	if (renderData.LODResources.empty())
+	{
+		return;
+	}
+
+	// LODs generated before are replaced
+	renderData.LODResources.resize(1);
+
+	List<uint32> groups;
+	List<Vector3> groupPositions;
+	List<uint32> groupSections;
+	List<uint8> pinned;
+
+	// Vertex and group of the source LOD to the ones of the section, or SimplifierInvalid
+	List<uint32> localVertices;
+	List<uint32> localGroupIds;
+
+	List<uint32> sectionVertices;
+	List<uint32> sectionGroups;
+	List<Vector3> sectionGroupPositions;
+	List<uint8> sectionPinned;
+	List<uint32> sectionIndices;
+
+	for (size_t i = 0; i < triangleRatios.size() && (int)renderData.LODResources.size() < MAX_STATIC_MESH_LODS; i++)
+	{
+		float ratio = glm::clamp(triangleRatios[i], 0.0f, 1.0f);
+
+		const FStaticMeshLODResources& baseLod = renderData.LODResources[0];
+		const FStaticMeshLODResources& sourceLod = renderData.LODResources.back();
+
+		List<Vector3> positions(sourceLod.VertexData.size());
+
+		for (size_t v = 0; v < positions.size(); v++)
+		{
+			positions[v] = sourceLod.VertexData[v].Position;
+		}
+
+		// One weld for all sections of the LOD
+		WeldPositions(positions, groups, groupPositions);
+
+		uint32 groupCount = (uint32)groupPositions.size();
+
+		// Positions used by more than one section stay where they are, otherwise the sections would pull apart at their seams
+		groupSections.assign(groupCount, SimplifierInvalid);
+		pinned.assign(groupCount, 0);
+
+		for (uint32 s = 0; s < (uint32)sourceLod.Sections.size(); s++)
+		{
+			const FStaticMeshSection& section = sourceLod.Sections[s];
+
+			for (uint32 k = section.FirstIndex; k < section.FirstIndex + section.NumTriangles; k++)
+			{
+				uint32 group = groups[sourceLod.Indices[k]];
+
+				if (groupSections[group] == SimplifierInvalid)
+				{
+					groupSections[group] = s;
+				}
+				else if (groupSections[group] != s)
+				{
+					pinned[group] = 1;
+				}
+			}
+		}
+
+		localVertices.assign(sourceLod.VertexData.size(), SimplifierInvalid);
+		localGroupIds.assign(groupCount, SimplifierInvalid);
+
+		FStaticMeshLODResources lod = {};
+
+		// The triangle density on screen stays about the same when the screen size follows the square root of the ratio
+		lod.ScreenSize = glm::sqrt(ratio);
+
+		for (size_t s = 0; s < sourceLod.Sections.size(); s++)
+		{
+			const FStaticMeshSection& sourceSection = sourceLod.Sections[s];
+
+			// The section is simplified on its own vertices and groups, numbered from zero, so every section only
+			// costs as much as it is big. NumTriangles holds the index count of the section.
+			sectionVertices.clear();
+			sectionGroups.clear();
+			sectionGroupPositions.clear();
+			sectionPinned.clear();
+			sectionIndices.clear();
+
+			for (uint32 k = sourceSection.FirstIndex; k < sourceSection.FirstIndex + sourceSection.NumTriangles; k++)
+			{
+				uint32 vertex = sourceLod.Indices[k];
+
+				if (localVertices[vertex] == SimplifierInvalid)
+				{
+					uint32 group = groups[vertex];
+
+					if (localGroupIds[group] == SimplifierInvalid)
+					{
+						localGroupIds[group] = (uint32)sectionGroupPositions.size();
+						sectionGroupPositions.push_back(groupPositions[group]);
+						sectionPinned.push_back(pinned[group]);
+					}
+
+					localVertices[vertex] = (uint32)sectionVertices.size();
+					sectionVertices.push_back(vertex);
+					sectionGroups.push_back(localGroupIds[group]);
+				}
+
+				sectionIndices.push_back(localVertices[vertex]);
+			}
+
+			uint32 baseTriangles = baseLod.Sections[s].NumTriangles / 3;
+			SimplifyGroups(sectionGroups, sectionGroupPositions, sectionPinned, sectionIndices, (uint32)glm::ceil(baseTriangles * ratio));
+
+			for (uint32& index : sectionIndices)
+			{
+				index = sectionVertices[index];
+			}
+
+			// Only reset what the section used
+			for (uint32 vertex : sectionVertices)
+			{
+				localVertices[vertex] = SimplifierInvalid;
+				localGroupIds[groups[vertex]] = SimplifierInvalid;
+			}
+
+			FStaticMeshSection section = sourceSection;
+			section.FirstIndex = (uint32)lod.Indices.size();
+			section.NumTriangles = (uint32)sectionIndices.size();
+
+			lod.Indices.insert(lod.Indices.end(), sectionIndices.begin(), sectionIndices.end());
+			lod.Sections.push_back(section);
+		}
+
+		if (lod.Indices.size() >= sourceLod.Indices.size())
+		{
+			Log("MeshSimplifier::GenerateLODs", ToString((int)renderData.LODResources.size()), "The mesh does not get any simpler, no more LODs are generated.");
+			break;
+		}
+
+		// Keep only the vertices still in use, in the order of the sections
+		List<uint32> vertexRemap(sourceLod.VertexData.size(), SimplifierInvalid);
+
+		for (uint32& index : lod.Indices)
+		{
+			if (vertexRemap[index] == SimplifierInvalid)
+			{
+				vertexRemap[index] = (uint32)lod.VertexData.size();
+				lod.VertexData.push_back(sourceLod.VertexData[index]);
+			}
+
+			index = vertexRemap[index];
+		}
+
+		lod.LastIndex = 0;
+
+		for (FStaticMeshSection& section : lod.Sections)
+		{
+			section.MinVertexIndex = SimplifierInvalid;
+			section.MaxVertexIndex = 0;
+
+			for (uint32 k = section.FirstIndex; k < section.FirstIndex + section.NumTriangles; k++)
+			{
+				section.MinVertexIndex = glm::min(section.MinVertexIndex, lod.Indices[k]);
+				section.MaxVertexIndex = glm::max(section.MaxVertexIndex, lod.Indices[k] + 1);
+			}
+
+			if (section.NumTriangles == 0)
+			{
+				section.MinVertexIndex = 0;
+			}
+
+			if (section.MaxVertexIndex > 0)
+			{
+				lod.LastIndex = glm::max(lod.LastIndex, section.MaxVertexIndex - 1);
+			}
+		}
+
+		Log("MeshSimplifier::GenerateLODs", ToString((int)renderData.LODResources.size()), ToString((int)lod.Indices.size() / 3) + " triangles, " + ToString((int)lod.VertexData.size()) + " vertices");
+
+		renderData.LODResources.push_back(lod);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Hydra/Core/Library.h"
+#include "Hydra/Core/Common.h"
+#include "Hydra/Core/Vector.h"
+
+class FStaticMeshRenderData;
+
+// Weight of the planes that keep open borders in place, relative to the planes of the triangles
+#define MESH_SIMPLIFIER_BORDER_WEIGHT 10.0
+
+// Cosine of the largest angle a triangle normal may turn by in one collapse
+#define MESH_SIMPLIFIER_MIN_NORMAL_DOT 0.25f
+
+// Quadric error edge collapse. Vertices split at uv or normal seams are welded by position for the collapses,
+// a position only collapses when every one of its vertices has a matching vertex at the target, so seams and hard
+// edges keep their shape and the result only uses vertices of the input. Meshes without any shared vertices do not simplify.
+class HYDRA_API MeshSimplifier
+{
+public:
+	// Collapses edges of the triangle list, which indexes positions, until at most targetTriangleCount triangles
+	// are left or no edge can collapse without flipping a triangle
+	static void Simplify(const List<Vector3>& positions, List<uint32>& indices, uint32 targetTriangleCount);
+
+	// Adds a LOD for every ratio, the triangle count of the LOD relative to LOD 0. Each LOD is simplified from the one
+	// before it, section by section, so sections and their materials stay the same. Positions used by more than one
+	// section never move, so sections stay closed at their seams. Stops once a LOD does not get smaller.
+	static void GenerateLODs(FStaticMeshRenderData& renderData, const List<float>& triangleRatios);
+};
\ No newline at end of file
@@ -15,7 +15,7 @@
 
 namespace NVRHI
 {
-    inline void BindConstantBuffer(PipelineStageBindings& ds, uint32_t slot, ConstantBufferHandle cb)
+    inline void BindConstantBuffer(PipelineStageBindings& ds, uint32_t slot, ConstantBufferHandle cb, uint32_t offset = 0, uint32_t size = 0)
     {
         uint32_t idx;
         for (idx = 0; idx < ds.constantBufferBindingCount; idx++)
@@ -29,6 +29,8 @@ namespace NVRHI
         auto& binding = ds.constantBuffers[idx];
         binding.slot = slot;
         binding.buffer = cb;
+        binding.offset = offset;
+        binding.size = size;
         if (!cb)
         {
             //remove null
@@ -645,10 +645,18 @@ namespace NVRHI
     // Bindings
     //////////////////////////////////////////////////////////////////////////
 
+    // 16 constants of 16 bytes, the granularity of constant buffer offsets in D3D 11.1
+    static const uint32_t CONSTANT_BUFFER_OFFSET_ALIGNMENT = 256;
+
     struct ConstantBufferBinding
     {
         ConstantBufferHandle buffer;
         uint32_t slot;
+
+        // Range of the buffer the shader sees, in bytes. A size of 0 binds the whole buffer.
+        // Offsets must be multiples of CONSTANT_BUFFER_OFFSET_ALIGNMENT and need supportsConstantBufferOffsets().
+        uint32_t offset;
+        uint32_t size;
     };
 
     struct SamplerBinding
@@ -897,6 +905,14 @@ namespace NVRHI
         virtual void writeConstantBuffer(ConstantBufferHandle b, const void* data, size_t dataSize) = 0;
         virtual void destroyConstantBuffer(ConstantBufferHandle b) = 0;
 
+        // Maps the whole buffer for writing. Without discard the contents stay and the caller must only write ranges
+        // the GPU does not read anymore. Only valid when supportsConstantBufferOffsets() is true.
+        virtual void* mapConstantBuffer(ConstantBufferHandle b, bool discard) = 0;
+        virtual void unmapConstantBuffer(ConstantBufferHandle b) = 0;
+
+        // Constant buffers can be bound by range and mapped without discarding, D3D 11.1 and up
+        virtual bool supportsConstantBufferOffsets() = 0;
+
         virtual ShaderHandle createShader(const ShaderDesc& d, const void* binary, const size_t binarySize) = 0;
         virtual void destroyShader(ShaderHandle s) = 0;
 
@@ -16,6 +16,7 @@
 #include "Hydra/Render/Material.h"
 #include "Hydra/Render/Technique.h"
 #include "Hydra/Render/Shader.h"
+#include "Hydra/Render/ShaderCache.h"
 
 #include "Hydra/Render/Graphics.h"
 #include "Hydra/Render/DrawState.h"
@@ -25,6 +26,9 @@
 #include "Hydra/Render/View/SceneView.h"
 #include "Hydra/Render/View/ViewPort.h"
 
+#include "Hydra/Core/Math/Frustum.h"
+#include "Hydra/Core/ThreadPool.h"
+
 InputLayoutDefininition InputLayoutDefs[11]{
 	{"POSITION", offsetof(VertexBufferEntry, Position) },
 	{"TEXCOORD", offsetof(VertexBufferEntry, TexCoord) },
@@ -41,7 +45,8 @@ InputLayoutDefininition InputLayoutDefs[11]{
 };
 
 MainRenderView::MainRenderView(EngineContext* context, HydraEngine* engine) 
-	: IVisualController(context), Engine(engine), _ScreenRenderViewport(nullptr)
+	: IVisualController(context), Engine(engine), _ScreenRenderViewport(nullptr), _InstanceBuffer(nullptr), _InstanceBufferSize(0),
+	_ViewConstantsOffset(0), _ViewConstantBuffer(nullptr), _ObjectConstantBuffer(nullptr)
 {
 }
 
@@ -59,12 +64,21 @@ void MainRenderView::OnCreated()
 	Engine->InitializeAssetManager(Context->GetAssetManager());
 
 	Context->GetAssetManager()->LoadProjectFiles();
+	Context->GetAssetManager()->WatchShaderFiles(File(ASSET_MANAGER_SHADER_FOLDER));
 
 	RenderInterface = Context->GetRenderInterface();
 	Graphics = Context->GetGraphics();
 
 	_DefaultMaterial = Context->GetAssetManager()->GetMaterial("Assets/Materials/Default.mat");
 
+	_ConstantRing.Initialize(RenderInterface);
+
+	if (!_ConstantRing.IsAvailable())
+	{
+		_ViewConstantBuffer = RenderInterface->createConstantBuffer(NVRHI::ConstantBufferDesc(sizeof(FViewConstants), "ViewConstants"), nullptr);
+		_ObjectConstantBuffer = RenderInterface->createConstantBuffer(NVRHI::ConstantBufferDesc(sizeof(FObjectConstants), "ObjectConstants"), nullptr);
+	}
+
 	Engine->GetWorld()->OnCameraComponentAdded += EVENT_ARGS(MainRenderView, OnCameraAdded, HCameraComponent*);
 	Engine->GetWorld()->OnCameraComponentRemoved += EVENT_ARGS(MainRenderView, OnCameraRemoved, HCameraComponent*);
 
@@ -76,15 +90,49 @@ void MainRenderView::OnCreated()
 #endif
 
 	Engine->SceneInit();
+
+	// Everything the project and the scene use is compiled now, the cache is saved when the engine shuts down
+	ShaderCache* shaderCache = Context->GetShaderCache();
+	const FShaderCacheStats& shaderCacheStats = shaderCache->GetStats();
+
+	Log("MainRenderView::OnCreated", "Shader cache: " + ToString(shaderCacheStats.Hits) + " hits, " + ToString(shaderCacheStats.Misses) + " misses, " +
+		ToString(shaderCacheStats.CompileTime) + "s compiling, " + ToString(shaderCacheStats.CompileTimeSaved) + "s saved.");
 }
 
 void MainRenderView::OnDestroy()
 {
+	_ConstantRing.Release();
+
+	if (_ViewConstantBuffer)
+	{
+		RenderInterface->destroyConstantBuffer(_ViewConstantBuffer);
+		_ViewConstantBuffer = nullptr;
+	}
+
+	if (_ObjectConstantBuffer)
+	{
+		RenderInterface->destroyConstantBuffer(_ObjectConstantBuffer);
+		_ObjectConstantBuffer = nullptr;
+	}
 
+	if (_InstanceBuffer)
+	{
+		RenderInterface->destroyBuffer(_InstanceBuffer);
+		_InstanceBuffer = nullptr;
+		_InstanceBufferSize = 0;
+	}
 }
 
 void MainRenderView::OnRender(NVRHI::TextureHandle mainRenderTarget)
 {
+	_CullingStats = FCullingStats();
+	_RenderQueueStats = FRenderQueueStats();
+
+	_ConstantRing.BeginFrame();
+
+	// Reloaded shaders are swapped in before anything is drawn, materials pick them up on their next draw
+	Context->GetAssetManager()->UpdateShaderFiles();
+
 	ITER(_SceneViewForCameras, it)
 	{
 		RenderSceneViewFromCamera(it->second, it->first);
@@ -124,6 +172,8 @@ void MainRenderView::OnTick(float Delta)
 
 		actor->Tick(Delta);
 	}
+
+	world->UpdatePrimitiveBounds();
 }
 
 void MainRenderView::OnResize(uint32 width, uint32 height, uint32 sampleCount)
@@ -141,6 +191,21 @@ void MainRenderView::OnResize(uint32 width, uint32 height, uint32 sampleCount)
 	Graphics->ResizeRenderTarget("HGameView", width, height);
 }
 
+const FCullingStats& MainRenderView::GetCullingStats() const
+{
+	return _CullingStats;
+}
+
+const FRenderQueueStats& MainRenderView::GetRenderQueueStats() const
+{
+	return _RenderQueueStats;
+}
+
+const ConstantBufferRing& MainRenderView::GetConstantBufferRing() const
+{
+	return _ConstantRing;
+}
+
 void MainRenderView::OnCameraAdded(HCameraComponent* cmp)
 {
 	FSceneView* sceneView = new FSceneView();
@@ -284,6 +349,25 @@ NVRHI::InputLayoutHandle MainRenderView::GetInputLayoutForMaterial(MaterialInter
 
 	if (technique->GetInputLayoutID(ID))
 	{
+		auto revision = _InputLayoutRevisions.find(technique.get());
+
+		if (revision == _InputLayoutRevisions.end())
+		{
+			_InputLayoutRevisions[technique.get()] = technique->GetRevision();
+		}
+		else if (revision->second != technique->GetRevision())
+		{
+			revision->second = technique->GetRevision();
+
+			auto layout = _InputLayoutMap.find(ID);
+
+			if (layout != _InputLayoutMap.end())
+			{
+				RenderInterface->destroyInputLayout(layout->second);
+				_InputLayoutMap.erase(layout);
+			}
+		}
+
 		auto iter = _InputLayoutMap.find(ID);
 
 		if (iter != _InputLayoutMap.end())
@@ -303,30 +387,127 @@ NVRHI::InputLayoutHandle MainRenderView::GetInputLayoutForMaterial(MaterialInter
 	return nullptr;
 }
 
-void MainRenderView::UpdateMaterialGlobalVariables(MaterialInterface* materialInterface, HPrimitiveComponent* component, HCameraComponent* camera)
+void MainRenderView::UpdateComponent(HSceneComponent* component, float Delta)
+{
+	component->Tick(Delta);
+}
+
+void MainRenderView::CullComponents(FSceneView* view, HCameraComponent* camera)
 {
-	Matrix4& projectionMatrix = camera->GetProjectionMatrix();
-	Matrix4& viewMatrix = camera->GetViewMatrix();
-	Matrix4& modelMatrix = component->GetTransformMatrix();
+	FWorld* world = Engine->GetWorld();
 
-	materialInterface->SetMatrix4("_ProjectionMatrix", projectionMatrix);
-	materialInterface->SetMatrix4("_ViewMatrix", viewMatrix);
+	Frustum frustum(camera->GetProjectionViewMatrix());
 
-	materialInterface->SetMatrix4("_ModelMatrix", modelMatrix);
-}
+	// The tree only knows the fattened bounds, what it returns still needs the exact test
+	_CullCandidates.clear();
+	world->QueryFrustum(frustum, _CullCandidates);
 
-void MainRenderView::UpdateComponent(HSceneComponent* component, float Delta)
-{
-	component->Tick(Delta);
+	int candidateCount = (int)_CullCandidates.size();
+
+	_CullBounds.Clear();
+	_CullBounds.Reserve(candidateCount);
+
+	for (HPrimitiveComponent* component : _CullCandidates)
+	{
+		_CullBounds.Add(component->GetCachedWorldBounds());
+	}
+
+	_CullMask.resize(BoxBatch::GetMaskSize(candidateCount));
+
+	// Every task owns whole mask words, so no two tasks write the same word
+	auto cullRange = [&](int begin, int end)
+	{
+		_CullBounds.IntersectFrustum(frustum, _CullMask.data(), begin * 32, (end - begin) * 32);
+	};
+
+	ThreadPool* threadPool = Context->GetThreadPool();
+
+	if (threadPool && candidateCount >= MAIN_RENDER_VIEW_PARALLEL_CULL_SIZE)
+	{
+		threadPool->ParallelFor((int)_CullMask.size(), MAIN_RENDER_VIEW_CULL_WORDS_PER_TASK, cullRange);
+	}
+	else
+	{
+		cullRange(0, (int)_CullMask.size());
+	}
+
+	_VisibleComponents.clear();
+
+	Matrix4 projection = camera->GetProjectionMatrix();
+	Vector3 viewOrigin = glm::inverse(camera->GetViewMatrix())[3];
+
+	for (int i = 0; i < candidateCount; i++)
+	{
+		if ((_CullMask[i / 32] & (1u << (i % 32))) == 0)
+		{
+			continue;
+		}
+
+		HPrimitiveComponent* component = _CullCandidates[i];
+		const Box& bounds = component->GetCachedWorldBounds();
+
+		Vector3 toBounds = bounds.Origin - viewOrigin;
+		float distanceSq = glm::dot(toBounds, toBounds);
+
+		if (component->LDMaxDrawDistance > 0.0f && distanceSq > component->LDMaxDrawDistance * component->LDMaxDrawDistance)
+		{
+			_CullingStats.DistanceCulled++;
+			continue;
+		}
+
+		FVisiblePrimitive visible;
+		visible.Component = component;
+		visible.LOD = 0;
+		visible.DistanceSq = distanceSq;
+
+		HStaticMeshComponent* meshComponent = component->SafeCast<HStaticMeshComponent>();
+
+		if (meshComponent && meshComponent->GetStaticMesh() && meshComponent->GetStaticMesh()->RenderData)
+		{
+			float screenSize = ComputeBoundsScreenSize(glm::length(bounds.Extent), glm::sqrt(distanceSq), projection);
+
+			auto lastLOD = view->LastLODs.find(component);
+
+			visible.LOD = meshComponent->GetStaticMesh()->RenderData->GetLODIndex(screenSize, lastLOD != view->LastLODs.end() ? lastLOD->second : 0);
+			_PickedLODs[component] = visible.LOD;
+		}
+
+		_VisibleComponents.push_back(visible);
+	}
+
+	view->LastLODs.swap(_PickedLODs);
+	_PickedLODs.clear();
+
+	_CullingStats.Candidates += candidateCount;
+	_CullingStats.Visible += (int)_VisibleComponents.size();
+	_CullingStats.Culled += (int)world->GetPrimitiveComponents().size() - (int)_VisibleComponents.size();
 }
 
 void MainRenderView::RenderSceneViewFromCamera(FSceneView* view, HCameraComponent* camera)
 {
 	RenderManager* renderManager = Context->GetRenderManager();
 
-	const List<HPrimitiveComponent*>& components = Engine->GetWorld()->GetPrimitiveComponents();
+	CullComponents(view, camera);
+
+	QueueVisibleComponents(view);
+
+	BuildDrawBatches();
 
-	//TODO: Batching
+	FViewConstants viewConstants;
+	viewConstants.ProjectionMatrix = camera->GetProjectionMatrix();
+	viewConstants.ViewMatrix = camera->GetViewMatrix();
+
+	bool useConstantRing = _ConstantRing.IsAvailable();
+	uint32 constantBase = 0;
+
+	if (useConstantRing)
+	{
+		constantBase = WriteEngineConstants(viewConstants);
+	}
+	else
+	{
+		RenderInterface->writeConstantBuffer(_ViewConstantBuffer, &viewConstants, sizeof(FViewConstants));
+	}
 
 	FDrawState drawState;
 
@@ -338,13 +519,85 @@ void MainRenderView::RenderSceneViewFromCamera(FSceneView* view, HCameraComponen
 	drawState.SetTarget(0, view->RenderTexture);
 	drawState.SetDepthTarget(view->DepthTexture);
 
-	for (HPrimitiveComponent* cmp : components)
+	if (_InstanceData.size() > 0)
+	{
+		drawState.SetInstanceBuffer(_InstanceBuffer);
+	}
+
+	// Materials never bind the engine slots, so these stay bound for every draw of the view
+	if (useConstantRing)
+	{
+		drawState.SetConstantBuffer(ENGINE_VIEW_CONSTANTS_SLOT, _ConstantRing.GetBuffer(), constantBase + _ViewConstantsOffset, sizeof(FViewConstants));
+	}
+	else
 	{
-		//drawState.SetInstanceBuffer(nullptr);
+		drawState.SetConstantBuffer(ENGINE_VIEW_CONSTANTS_SLOT, _ViewConstantBuffer);
+		drawState.SetConstantBuffer(ENGINE_OBJECT_CONSTANTS_SLOT, _ObjectConstantBuffer);
+	}
+
+	// Draws come sorted by state, only what differs from the draw before is set again
+	const FRenderQueueItem* last = nullptr;
+
+	for (const FDrawBatch& batch : _DrawBatches)
+	{
+		const FRenderQueueItem& item = _RenderQueue.Get(batch.First);
+
+		if (last == nullptr || last->Buffers != item.Buffers)
+		{
+			drawState.SetVertexBuffer(item.Buffers->VertexBuffer);
+			drawState.SetIndexBuffer(item.Buffers->IndexBuffer);
+		}
+
+		if (last == nullptr || last->Material != item.Material)
+		{
+			// Only uploads the material constant buffers when one of its parameters changed
+			drawState.SetMaterial(item.Material);
+
+			if (last == nullptr || last->MaterialTechnique != item.MaterialTechnique)
+			{
+				drawState.SetInputLayout(GetInputLayoutForMaterial(item.Material));
+			}
+		}
+
+		if (NeedsObjectConstants(last, item))
+		{
+			if (useConstantRing)
+			{
+				drawState.SetConstantBuffer(ENGINE_OBJECT_CONSTANTS_SLOT, _ConstantRing.GetBuffer(), constantBase + batch.ObjectConstantsOffset, sizeof(FObjectConstants));
+			}
+			else
+			{
+				// Instanced draws take their model matrix from the instance buffer
+				FObjectConstants objectConstants;
+				objectConstants.ModelMatrix = item.Instanced ? Matrix4(1.0f) : item.Component->GetTransformMatrix();
+
+				RenderInterface->writeConstantBuffer(_ObjectConstantBuffer, &objectConstants, sizeof(FObjectConstants));
+			}
+		}
+
+		drawState.Draw(Context->GetRenderInterface(), item.FirstIndex, item.IndexCount, batch.StartInstance, batch.Count);
+
+		_CullingStats.LODDraws[item.LOD] += batch.Count;
+
+		drawState.SetClearFlags(false, false, false);
+
+		last = &item;
+	}
+}
+
+void MainRenderView::QueueVisibleComponents(FSceneView* view)
+{
+	_RenderQueue.Clear();
+
+	uint32 targetID = _RenderQueue.GetStateID(view->RenderTexture);
+
+	for (const FVisiblePrimitive& visible : _VisibleComponents)
+	{
+		HPrimitiveComponent* cmp = visible.Component;
 
 		if (HStaticMeshComponent* staticMeshComponent = cmp->SafeCast<HStaticMeshComponent>())
 		{
-			HStaticMesh* mesh = staticMeshComponent->StaticMesh;
+			HStaticMesh* mesh = staticMeshComponent->GetStaticMesh();
 
 			if (!mesh)
 			{
@@ -361,7 +614,7 @@ void MainRenderView::RenderSceneViewFromCamera(FSceneView* view, HCameraComponen
 			List<FStaticMeshLODResources>& lodResource = renderData->LODResources;
 			size_t lodCount = lodResource.size();
 
-			int lod = 0; //TODO: Managing lod
+			int lod = visible.LOD;
 
 			if (lodCount == 0 || lod < 0 || lod > lodCount - 1)
 			{
@@ -382,9 +635,6 @@ void MainRenderView::RenderSceneViewFromCamera(FSceneView* view, HCameraComponen
 				continue;
 			}
 
-			drawState.SetVertexBuffer(bufferData->VertexBuffer);
-			drawState.SetIndexBuffer(bufferData->IndexBuffer);
-
 			for (FStaticMeshSection& section : lodData.Sections)
 			{
 				FStaticMaterial& staticMaterial = mesh->StaticMaterials[section.MaterialIndex];
@@ -396,20 +646,165 @@ void MainRenderView::RenderSceneViewFromCamera(FSceneView* view, HCameraComponen
 					materialInterface = _DefaultMaterial;
 				}
 
-				if (materialInterface != nullptr)
+				if (materialInterface == nullptr)
 				{
-					UpdateMaterialGlobalVariables(materialInterface, cmp, camera);
+					continue;
+				}
 
-					drawState.SetMaterial(materialInterface);
-					drawState.SetInputLayout(GetInputLayoutForMaterial(materialInterface));
+				Technique* technique = materialInterface->GetTechnique().get();
 
-					drawState.Draw(Context->GetRenderInterface(), section.FirstIndex, section.NumTriangles, 0, 1);
+				technique->UpdateInputLayoutID(_InputLayoutHashID, _InputLayoutMaxID);
 
-					drawState.SetClearFlags(false, false, false);
-				}
+				FRenderQueueItem item;
+				item.Component = cmp;
+				item.Material = materialInterface;
+				item.MaterialTechnique = technique;
+				item.InputLayoutID = 0;
+				item.Buffers = bufferData;
+				item.FirstIndex = section.FirstIndex;
+				item.IndexCount = section.NumTriangles;
+				item.LOD = lod;
+				item.Instanced = technique->SupportsInstancing();
+
+				technique->GetInputLayoutID(item.InputLayoutID);
+
+				uint32 techniqueID = _RenderQueue.GetStateID(technique);
+				uint32 materialID = _RenderQueue.GetStateID(materialInterface);
+
+				// Copies of a section are kept together so they become one draw, the section is the same for every copy of the LOD
+				uint64 sortKey = item.Instanced
+					? FRenderQueue::MakeBatchSortKey(targetID, techniqueID, item.InputLayoutID, materialID, _RenderQueue.GetStateID(&section))
+					: FRenderQueue::MakeSortKey(targetID, techniqueID, item.InputLayoutID, materialID, visible.DistanceSq);
+
+				_RenderQueue.Add(sortKey, item);
+			}
+		}
+	}
+
+	_RenderQueueStats.Draws += (int)_RenderQueue.Size();
+	_RenderQueueStats.UnsortedStateChanges += _RenderQueue.CountStateChanges(true);
+
+	_RenderQueue.Sort();
+
+	_RenderQueueStats.StateChanges += _RenderQueue.CountStateChanges(false);
+}
+
+void MainRenderView::BuildDrawBatches()
+{
+	_DrawBatches.clear();
+	_InstanceData.clear();
+
+	uint32 count = (uint32)_RenderQueue.Size();
+
+	for (uint32 i = 0; i < count;)
+	{
+		const FRenderQueueItem& item = _RenderQueue.Get(i);
+
+		FDrawBatch batch;
+		batch.First = i;
+		batch.Count = 1;
+		batch.StartInstance = 0;
+		batch.ObjectConstantsOffset = 0;
+
+		if (item.Instanced)
+		{
+			while (i + batch.Count < count && FRenderQueue::CanInstance(item, _RenderQueue.Get(i + batch.Count)))
+			{
+				batch.Count++;
+			}
+
+			batch.StartInstance = (uint32)_InstanceData.size();
+
+			for (uint32 k = 0; k < batch.Count; k++)
+			{
+				_InstanceData.push_back(_RenderQueue.Get(i + k).Component->GetTransformMatrix());
 			}
 		}
+
+		_DrawBatches.push_back(batch);
+
+		i += batch.Count;
+	}
+
+	_RenderQueueStats.DrawCalls += (int)_DrawBatches.size();
+
+	if (_InstanceData.size() == 0)
+	{
+		return;
+	}
+
+	if (_InstanceData.size() > _InstanceBufferSize)
+	{
+		if (_InstanceBuffer)
+		{
+			RenderInterface->destroyBuffer(_InstanceBuffer);
+		}
+
+		_InstanceBufferSize = MAIN_RENDER_VIEW_MIN_INSTANCE_BUFFER_SIZE;
+
+		while (_InstanceBufferSize < _InstanceData.size())
+		{
+			_InstanceBufferSize *= 2;
+		}
+
+		NVRHI::BufferDesc instanceBufferDesc;
+		instanceBufferDesc.isVertexBuffer = true;
+		instanceBufferDesc.isCPUWritable = true;
+		instanceBufferDesc.byteSize = uint32_t(_InstanceBufferSize * sizeof(Matrix4));
+
+		_InstanceBuffer = RenderInterface->createBuffer(instanceBufferDesc, nullptr);
 	}
+
+	// One discarding write per view, every batch draws from its own range
+	RenderInterface->writeBuffer(_InstanceBuffer, _InstanceData.data(), _InstanceData.size() * sizeof(Matrix4));
+}
+
+uint32 MainRenderView::WriteEngineConstants(const FViewConstants& viewConstants)
+{
+	_ViewConstantsOffset = _ConstantRing.Allocate(&viewConstants, sizeof(FViewConstants));
+
+	// Instanced draws take their model matrix from the instance buffer, they all share the identity
+	FObjectConstants identity;
+	identity.ModelMatrix = Matrix4(1.0f);
+
+	uint32 identityOffset = _ConstantRing.Allocate(&identity, sizeof(FObjectConstants));
+
+	const FRenderQueueItem* last = nullptr;
+
+	// Same walk as the draw loop, so a batch gets constants exactly where the draw loop binds new ones
+	for (FDrawBatch& batch : _DrawBatches)
+	{
+		const FRenderQueueItem& item = _RenderQueue.Get(batch.First);
+
+		if (NeedsObjectConstants(last, item))
+		{
+			if (item.Instanced)
+			{
+				batch.ObjectConstantsOffset = identityOffset;
+			}
+			else
+			{
+				FObjectConstants objectConstants;
+				objectConstants.ModelMatrix = item.Component->GetTransformMatrix();
+
+				batch.ObjectConstantsOffset = _ConstantRing.Allocate(&objectConstants, sizeof(FObjectConstants));
+			}
+		}
+
+		last = &item;
+	}
+
+	return _ConstantRing.Flush();
+}
+
+bool MainRenderView::NeedsObjectConstants(const FRenderQueueItem* last, const FRenderQueueItem& item)
+{
+	if (last == nullptr || last->Instanced != item.Instanced)
+	{
+		return true;
+	}
+
+	return !item.Instanced && last->Component != item.Component;
 }
 
 void MainRenderView::BlitFromViewportToTarget(FViewPort* viewPort, NVRHI::TextureHandle target)
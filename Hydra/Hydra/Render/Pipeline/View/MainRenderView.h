@@ -1,6 +1,11 @@
 #pragma once
 
 #include "Hydra/Render/Pipeline/DeviceManager.h"
+#include "Hydra/Core/Math/BoxBatch.h"
+#include "Hydra/Framework/StaticMeshResources.h"
+#include "Hydra/Render/RenderQueue.h"
+#include "Hydra/Render/ConstantBufferRing.h"
+#include "Hydra/Render/EngineConstants.h"
 
 class HydraEngine;
 class HPrimitiveComponent;
@@ -11,12 +16,64 @@ class FSceneView;
 class FViewPort;
 
 class MaterialInterface;
+class Technique;
 
 namespace NVRHI
 {
 	class IRendererInterface;
 }
 
+// Culling runs on the thread pool once this many components are in the frustum tree query
+constexpr int MAIN_RENDER_VIEW_PARALLEL_CULL_SIZE = 2048;
+
+// Mask words, of 32 components each, one culling task tests at least
+constexpr int MAIN_RENDER_VIEW_CULL_WORDS_PER_TASK = 16;
+
+// Matrices the instance buffer holds at least, it grows in powers of two from there
+constexpr uint32 MAIN_RENDER_VIEW_MIN_INSTANCE_BUFFER_SIZE = 1024;
+
+struct FCullingStats
+{
+	// Components the frustum query of the world returned, the tree works on fattened bounds
+	int Candidates = 0;
+
+	// Components whose world bounds are at least partially inside the frustum
+	int Visible = 0;
+
+	// Primitive components of the world that were not drawn
+	int Culled = 0;
+
+	// Components inside the frustum but further away than their LDMaxDrawDistance
+	int DistanceCulled = 0;
+
+	// Mesh sections drawn with each LOD, instances of one draw call count one by one
+	int LODDraws[MAX_STATIC_MESH_LODS] = {};
+};
+
+struct FVisiblePrimitive
+{
+	HPrimitiveComponent* Component;
+
+	// LOD picked for the component in the culling pass
+	int32 LOD;
+
+	// Squared distance from the camera to the center of the bounds
+	float DistanceSq;
+};
+
+struct FDrawBatch
+{
+	// Position of the first draw in the sorted render queue, the other ones follow it
+	uint32 First;
+	uint32 Count;
+
+	// Offset of the first matrix in the instance buffer, for instanced draws
+	uint32 StartInstance;
+
+	// Offset of the object constants in the data staged to the ring for the view, set when the batch needs new ones
+	uint32 ObjectConstantsOffset;
+};
+
 class MainRenderView : public IVisualController
 {
 private:
@@ -32,6 +89,39 @@ private:
 	Map<String, uint32> _InputLayoutHashID;
 	uint32 _InputLayoutMaxID;
 
+	// Revision of every technique when its input layout was last looked up, a reloaded one gets its layout created
+	// again from the new vertex shader
+	FastMap<Technique*, uint32> _InputLayoutRevisions;
+
+	// Kept between frames so culling does not allocate once the lists are big enough
+	List<HPrimitiveComponent*> _CullCandidates;
+	BoxBatch _CullBounds;
+	List<uint32> _CullMask;
+	List<FVisiblePrimitive> _VisibleComponents;
+
+	// Filled with the LODs picked this frame and swapped with the ones of the view, so only visible components stay in there
+	FastMap<HPrimitiveComponent*, int32> _PickedLODs;
+
+	FRenderQueue _RenderQueue;
+	List<FDrawBatch> _DrawBatches;
+
+	// Model matrices of every instanced draw of the view, written to the instance buffer at once
+	List<Matrix4> _InstanceData;
+	NVRHI::BufferHandle _InstanceBuffer;
+	uint32 _InstanceBufferSize;
+
+	// View and object constants of a view are staged here and uploaded with one map, then bound by offset
+	ConstantBufferRing _ConstantRing;
+	uint32 _ViewConstantsOffset;
+
+	// Written for every view and object instead when the ring is not available
+	NVRHI::ConstantBufferHandle _ViewConstantBuffer;
+	NVRHI::ConstantBufferHandle _ObjectConstantBuffer;
+
+	// Summed over all cameras of the last frame
+	FCullingStats _CullingStats;
+	FRenderQueueStats _RenderQueueStats;
+
 public:
 	HydraEngine* Engine;
 
@@ -45,6 +135,10 @@ public:
 	void OnTick(float Delta);
 	void OnResize(uint32 width, uint32 height, uint32 sampleCount);
 
+	const FCullingStats& GetCullingStats() const;
+	const FRenderQueueStats& GetRenderQueueStats() const;
+	const ConstantBufferRing& GetConstantBufferRing() const;
+
 private:
 	void OnCameraAdded(HCameraComponent* cmp);
 	void OnCameraRemoved(HCameraComponent* cmp);
@@ -55,12 +149,24 @@ private:
 private:
 	NVRHI::InputLayoutHandle GetInputLayoutForMaterial(MaterialInterface* materialInterface);
 
-private:
-	void UpdateMaterialGlobalVariables(MaterialInterface* materialInterface, HPrimitiveComponent* component, HCameraComponent* camera);
-
 private:
 	void UpdateComponent(HSceneComponent* component, float Delta);
 
+	// Fills _VisibleComponents with the primitive components inside the frustum and draw distance of the camera, and picks their LOD
+	void CullComponents(FSceneView* view, HCameraComponent* camera);
+
+	// Fills the render queue with a draw for every section of the visible components and sorts it
+	void QueueVisibleComponents(FSceneView* view);
+
+	// Merges consecutive queued draws of the same section and material into instanced batches and uploads their matrices
+	void BuildDrawBatches();
+
+	// Writes the view constants and the object constants of every batch that needs new ones to the ring, returns where they start in its buffer
+	uint32 WriteEngineConstants(const FViewConstants& viewConstants);
+
+	// Whether the object constants of the batch before do not fit the batch of item
+	static bool NeedsObjectConstants(const FRenderQueueItem* last, const FRenderQueueItem& item);
+
 	void RenderSceneViewFromCamera(FSceneView* view, HCameraComponent* camera);
 
 	void BlitFromViewportToTarget(FViewPort* viewPort, NVRHI::TextureHandle target);
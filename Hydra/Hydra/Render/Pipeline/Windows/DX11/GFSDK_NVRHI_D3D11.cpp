@@ -133,8 +133,9 @@ namespace NVRHI
         RendererInterfaceD3D11* parent;
         ULONG refCount;
         ComPtr<ID3D11Buffer> buffer;
+        uint32_t byteSize;
 
-        ConstantBuffer(RendererInterfaceD3D11* _parent) : parent(_parent), refCount(1) { }
+        ConstantBuffer(RendererInterfaceD3D11* _parent) : parent(_parent), refCount(1), byteSize(0) { }
         ULONG AddRef() override { return ++refCount; }
         ULONG Release() override { ULONG result = --refCount; if (result == 0) parent->destroyConstantBuffer(this); return result; }
     };
@@ -344,9 +345,18 @@ namespace NVRHI
         , errorCB(errorCB)
         , nvapiIsInitalized(false)
         , insideRenderingPass(false)
+        , constantBufferOffsetsSupported(false)
     {
         this->context->GetDevice(&device);
 
+        //Binding constant buffers by range and mapping them without discard both need D3D 11.1
+        if (SUCCEEDED(context->QueryInterface(IID_PPV_ARGS(&context1))))
+        {
+            D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+            if (SUCCEEDED(device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))))
+                constantBufferOffsetsSupported = options.ConstantBufferOffsetting && options.MapNoOverwriteOnDynamicConstantBuffer;
+        }
+
 #if NVRHI_D3D11_WITH_NVAPI
         //We need to use NVAPI to set resource hints for SLI
         nvapiIsInitalized = NvAPI_Initialize() == NVAPI_OK;
@@ -791,6 +801,7 @@ namespace NVRHI
 
         ConstantBuffer* buffer = new ConstantBuffer(this);
         buffer->buffer = constantBuffer;
+        buffer->byteSize = d.byteSize;
         return buffer;
     }
 
@@ -812,6 +823,32 @@ namespace NVRHI
         delete b;
     }
 
+    void* RendererInterfaceD3D11::mapConstantBuffer(ConstantBufferHandle b, bool discard)
+    {
+        CHECK_ERROR(constantBufferOffsetsSupported, "Mapping constant buffers needs D3D 11.1");
+
+        ID3D11Buffer* constantBuffer = static_cast<ConstantBuffer*>(b)->buffer.Get();
+
+        D3D11_MAPPED_SUBRESOURCE mappedData;
+        if (FAILED(context->Map(constantBuffer, 0, discard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE, 0, &mappedData)))
+        {
+            CHECK_ERROR(false, "Map failed");
+            return nullptr;
+        }
+
+        return mappedData.pData;
+    }
+
+    void RendererInterfaceD3D11::unmapConstantBuffer(ConstantBufferHandle b)
+    {
+        context->Unmap(static_cast<ConstantBuffer*>(b)->buffer.Get(), 0);
+    }
+
+    bool RendererInterfaceD3D11::supportsConstantBufferOffsets()
+    {
+        return constantBufferOffsetsSupported;
+    }
+
 
     ShaderHandle RendererInterfaceD3D11::createShader(const ShaderDesc& d, const void* binary, const size_t binarySize)
     {
@@ -1697,6 +1734,11 @@ namespace NVRHI
             ID3D11Buffer* constantBuffers[D3D11_COMMONSHADER_CONSTANT_BUFFER_REGISTER_COUNT] = { 0 };
             UINT minCB = D3D11_COMMONSHADER_CONSTANT_BUFFER_REGISTER_COUNT, maxCB = 0;
 
+            //Ranges in 16 byte constants, only used when a binding asks for a range
+            UINT firstConstants[D3D11_COMMONSHADER_CONSTANT_BUFFER_REGISTER_COUNT] = { 0 };
+            UINT numConstants[D3D11_COMMONSHADER_CONSTANT_BUFFER_REGISTER_COUNT] = { 0 };
+            bool hasConstantBufferRanges = false;
+
             ID3D11SamplerState* samplers[D3D11_COMMONSHADER_SAMPLER_REGISTER_COUNT] = { 0 };
             UINT minSS = D3D11_COMMONSHADER_SAMPLER_REGISTER_COUNT, maxSS = 0;
 
@@ -1762,14 +1804,25 @@ namespace NVRHI
             //bind Constant buffers
             for (uint32_t i = 0; i < bindings->constantBufferBindingCount; i++)
             {
-                UINT slot = (UINT)bindings->constantBuffers[i].slot;
-                ID3D11Buffer* cbuffer = static_cast<ConstantBuffer*>(bindings->constantBuffers[i].buffer)->buffer.Get();
+                const ConstantBufferBinding& binding = bindings->constantBuffers[i];
+                UINT slot = (UINT)binding.slot;
+                ConstantBuffer* cbuffer = static_cast<ConstantBuffer*>(binding.buffer);
 
-                constantBuffers[slot] = cbuffer;
+                constantBuffers[slot] = cbuffer->buffer.Get();
                 minCB = std::min<UINT>(slot, minCB);
                 maxCB = std::max<UINT>(slot, maxCB);
+
+                //Whole buffers in a ranged call are bound as a range covering all of them, rounded up to 16 constants
+                UINT byteSize = binding.size != 0 ? binding.size : cbuffer->byteSize;
+                firstConstants[slot] = binding.offset / 16;
+                numConstants[slot] = ((byteSize + CONSTANT_BUFFER_OFFSET_ALIGNMENT - 1) / CONSTANT_BUFFER_OFFSET_ALIGNMENT) * 16;
+
+                if (binding.size != 0)
+                    hasConstantBufferRanges = true;
             }
 
+            CHECK_ERROR(!hasConstantBufferRanges || constantBufferOffsetsSupported, "Constant buffer ranges need D3D 11.1");
+
             switch (stage)
             {
             case ShaderType::SHADER_VERTEX:
@@ -1784,7 +1837,12 @@ namespace NVRHI
 
                 //Apply them to the context
                 if (maxCB >= minCB)
-                    context->VSSetConstantBuffers(minCB, maxCB - minCB + 1, constantBuffers + minCB);
+                {
+                    if (hasConstantBufferRanges)
+                        context1->VSSetConstantBuffers1(minCB, maxCB - minCB + 1, constantBuffers + minCB, firstConstants + minCB, numConstants + minCB);
+                    else
+                        context->VSSetConstantBuffers(minCB, maxCB - minCB + 1, constantBuffers + minCB);
+                }
 
                 if (maxSRV >= minSRV)
                     context->VSSetShaderResources(minSRV, maxSRV - minSRV + 1, shaderResourceViews + minSRV);
@@ -1806,7 +1864,12 @@ namespace NVRHI
 
                 //Apply them to the context
                 if (maxCB >= minCB)
-                    context->GSSetConstantBuffers(minCB, maxCB - minCB + 1, constantBuffers + minCB);
+                {
+                    if (hasConstantBufferRanges)
+                        context1->GSSetConstantBuffers1(minCB, maxCB - minCB + 1, constantBuffers + minCB, firstConstants + minCB, numConstants + minCB);
+                    else
+                        context->GSSetConstantBuffers(minCB, maxCB - minCB + 1, constantBuffers + minCB);
+                }
 
                 if (maxSRV >= minSRV)
                     context->GSSetShaderResources(minSRV, maxSRV - minSRV + 1, shaderResourceViews + minSRV);
@@ -1828,7 +1891,12 @@ namespace NVRHI
 
                 //Apply them to the context
                 if (maxCB >= minCB)
-                    context->HSSetConstantBuffers(minCB, maxCB - minCB + 1, constantBuffers + minCB);
+                {
+                    if (hasConstantBufferRanges)
+                        context1->HSSetConstantBuffers1(minCB, maxCB - minCB + 1, constantBuffers + minCB, firstConstants + minCB, numConstants + minCB);
+                    else
+                        context->HSSetConstantBuffers(minCB, maxCB - minCB + 1, constantBuffers + minCB);
+                }
 
                 if (maxSRV >= minSRV)
                     context->HSSetShaderResources(minSRV, maxSRV - minSRV + 1, shaderResourceViews + minSRV);
@@ -1850,7 +1918,12 @@ namespace NVRHI
 
                 //Apply them to the context
                 if (maxCB >= minCB)
-                    context->DSSetConstantBuffers(minCB, maxCB - minCB + 1, constantBuffers + minCB);
+                {
+                    if (hasConstantBufferRanges)
+                        context1->DSSetConstantBuffers1(minCB, maxCB - minCB + 1, constantBuffers + minCB, firstConstants + minCB, numConstants + minCB);
+                    else
+                        context->DSSetConstantBuffers(minCB, maxCB - minCB + 1, constantBuffers + minCB);
+                }
 
                 if (maxSRV >= minSRV)
                     context->DSSetShaderResources(minSRV, maxSRV - minSRV + 1, shaderResourceViews + minSRV);
@@ -1872,7 +1945,12 @@ namespace NVRHI
 
                 //Apply them to the context
                 if (maxCB >= minCB)
-                    context->PSSetConstantBuffers(minCB, maxCB - minCB + 1, constantBuffers + minCB);
+                {
+                    if (hasConstantBufferRanges)
+                        context1->PSSetConstantBuffers1(minCB, maxCB - minCB + 1, constantBuffers + minCB, firstConstants + minCB, numConstants + minCB);
+                    else
+                        context->PSSetConstantBuffers(minCB, maxCB - minCB + 1, constantBuffers + minCB);
+                }
 
                 if (maxSRV >= minSRV)
                     context->PSSetShaderResources(minSRV, maxSRV - minSRV + 1, shaderResourceViews + minSRV);
@@ -75,6 +75,7 @@ namespace NVRHI
     RendererInterfaceD3D11& operator=(const RendererInterfaceD3D11& other); //undefined
   protected:
     ComPtr<ID3D11DeviceContext> context;
+    ComPtr<ID3D11DeviceContext1> context1;
     ComPtr<ID3D11Device> device;
     IErrorCallback* errorCB;
     bool nvapiIsInitalized;
@@ -94,6 +95,7 @@ namespace NVRHI
 	std::mutex mutex;
 
     bool insideRenderingPass;
+    bool constantBufferOffsetsSupported;
     
     D3D11_BLEND convertBlendValue(BlendState::BlendValue value);
     D3D11_BLEND_OP convertBlendOp(BlendState::BlendOp value);
@@ -143,6 +145,9 @@ namespace NVRHI
     virtual ConstantBufferHandle createConstantBuffer(const ConstantBufferDesc& d, const void* data);
     virtual void writeConstantBuffer(ConstantBufferHandle b, const void* data, size_t dataSize);
     virtual void destroyConstantBuffer(ConstantBufferHandle b);
+    virtual void* mapConstantBuffer(ConstantBufferHandle b, bool discard);
+    virtual void unmapConstantBuffer(ConstantBufferHandle b);
+    virtual bool supportsConstantBufferOffsets();
 
     virtual ShaderHandle createShader(const ShaderDesc& d, const void* binary, const size_t binarySize);
     virtual ShaderHandle createShaderFromAPIInterface(ShaderType::Enum shaderType, const void* apiInterface);
@@ -0,0 +1,224 @@
+#include "RenderQueue.h"
+
+#include "Hydra/Render/MeshBufferDataInternal.h"
+
+#include <algorithm>
+#include <cstring>
+
+void FRenderQueue::Clear()
+{
+	_Items.clear();
+	_Keys.clear();
+	_Order.clear();
+
+	// Ids are handed out again every frame, so they stay small and a freed object whose address is reused gets a new one
+	_StateIDs.clear();
+}
+
+void FRenderQueue::Add(uint64 sortKey, const FRenderQueueItem& item)
+{
+	_Order.push_back((uint32)_Items.size());
+	_Items.push_back(item);
+	_Keys.push_back(sortKey);
+}
+
+void FRenderQueue::Sort()
+{
+	size_t count = _Items.size();
+
+	if (count < 2)
+	{
+		return;
+	}
+
+	if (count < RENDER_QUEUE_RADIX_SORT_MIN_SIZE)
+	{
+		const List<uint64>& keys = _Keys;
+
+		std::sort(_Order.begin(), _Order.end(), [&keys](uint32 a, uint32 b)
+		{
+			return keys[a] < keys[b] || (keys[a] == keys[b] && a < b);
+		});
+
+		return;
+	}
+
+	RadixSort();
+}
+
+size_t FRenderQueue::Size() const
+{
+	return _Items.size();
+}
+
+const FRenderQueueItem& FRenderQueue::Get(size_t index) const
+{
+	return _Items[_Order[index]];
+}
+
+uint32 FRenderQueue::GetStateID(const void* state)
+{
+	auto iter = _StateIDs.find(state);
+
+	if (iter != _StateIDs.end())
+	{
+		return iter->second;
+	}
+
+	uint32 id = (uint32)_StateIDs.size();
+
+	_StateIDs[state] = id;
+
+	return id;
+}
+
+int FRenderQueue::CountStateChanges(bool inAddOrder) const
+{
+	int changes = 0;
+
+	for (size_t i = 1; i < _Items.size(); i++)
+	{
+		if (inAddOrder)
+		{
+			changes += CountStateChanges(_Items[i - 1], _Items[i]);
+		}
+		else
+		{
+			changes += CountStateChanges(Get(i - 1), Get(i));
+		}
+	}
+
+	return changes;
+}
+
+uint64 FRenderQueue::MakeSortKey(uint32 targetID, uint32 techniqueID, uint32 inputLayoutID, uint32 materialID, float depth)
+{
+	// Bits of a non negative float sort like the float itself, the top ones keep the exponent and most of the mantissa
+	uint32 depthBits;
+	depth = depth > 0.0f ? depth : 0.0f;
+	memcpy(&depthBits, &depth, sizeof(uint32));
+
+	return MakeKey(targetID, techniqueID, inputLayoutID, materialID, depthBits >> (32 - RENDER_QUEUE_ORDER_BITS));
+}
+
+uint64 FRenderQueue::MakeBatchSortKey(uint32 targetID, uint32 techniqueID, uint32 inputLayoutID, uint32 materialID, uint32 batchID)
+{
+	return MakeKey(targetID, techniqueID, inputLayoutID, materialID, batchID);
+}
+
+bool FRenderQueue::CanInstance(const FRenderQueueItem& first, const FRenderQueueItem& other)
+{
+	return first.Instanced && other.Instanced &&
+		first.Material == other.Material &&
+		first.Buffers == other.Buffers &&
+		first.FirstIndex == other.FirstIndex &&
+		first.IndexCount == other.IndexCount;
+}
+
+void FRenderQueue::RadixSort()
+{
+	// Least significant byte first, every pass is stable so the order of equal keys is the order they were added
+	uint32 count = (uint32)_Keys.size();
+
+	uint32 histograms[8][256];
+	memset(histograms, 0, sizeof(histograms));
+
+	for (uint32 i = 0; i < count; i++)
+	{
+		uint64 key = _Keys[i];
+
+		for (int pass = 0; pass < 8; pass++)
+		{
+			histograms[pass][(key >> (pass * 8)) & 0xFF]++;
+		}
+	}
+
+	// The keys are copied in the current order, they stay indexed by item
+	_SortKeys[0].resize(count);
+	_SortKeys[1].resize(count);
+	_SortOrder.resize(count);
+
+	for (uint32 i = 0; i < count; i++)
+	{
+		_SortKeys[0][i] = _Keys[_Order[i]];
+	}
+
+	uint64* srcKeys = _SortKeys[0].data();
+	uint32* srcOrder = _Order.data();
+	uint64* dstKeys = _SortKeys[1].data();
+	uint32* dstOrder = _SortOrder.data();
+
+	for (int pass = 0; pass < 8; pass++)
+	{
+		uint32* histogram = histograms[pass];
+
+		// All keys share this byte, the pass would not move anything
+		if (histogram[(srcKeys[0] >> (pass * 8)) & 0xFF] == count)
+		{
+			continue;
+		}
+
+		uint32 offset = 0;
+
+		for (int bucket = 0; bucket < 256; bucket++)
+		{
+			uint32 bucketSize = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += bucketSize;
+		}
+
+		for (uint32 i = 0; i < count; i++)
+		{
+			uint32 destination = histogram[(srcKeys[i] >> (pass * 8)) & 0xFF]++;
+
+			dstKeys[destination] = srcKeys[i];
+			dstOrder[destination] = srcOrder[i];
+		}
+
+		std::swap(srcKeys, dstKeys);
+		std::swap(srcOrder, dstOrder);
+	}
+
+	if (srcOrder != _Order.data())
+	{
+		memcpy(_Order.data(), srcOrder, count * sizeof(uint32));
+	}
+}
+
+uint64 FRenderQueue::MakeKey(uint32 targetID, uint32 techniqueID, uint32 inputLayoutID, uint32 materialID, uint32 order)
+{
+	uint64 key = targetID & ((1u << RENDER_QUEUE_TARGET_BITS) - 1);
+	key = (key << RENDER_QUEUE_TECHNIQUE_BITS) | (techniqueID & ((1u << RENDER_QUEUE_TECHNIQUE_BITS) - 1));
+	key = (key << RENDER_QUEUE_INPUT_LAYOUT_BITS) | (inputLayoutID & ((1u << RENDER_QUEUE_INPUT_LAYOUT_BITS) - 1));
+	key = (key << RENDER_QUEUE_MATERIAL_BITS) | (materialID & ((1u << RENDER_QUEUE_MATERIAL_BITS) - 1));
+	key = (key << RENDER_QUEUE_ORDER_BITS) | (order & ((1u << RENDER_QUEUE_ORDER_BITS) - 1));
+
+	return key;
+}
+
+int FRenderQueue::CountStateChanges(const FRenderQueueItem& last, const FRenderQueueItem& item)
+{
+	int changes = 0;
+
+	if (last.MaterialTechnique != item.MaterialTechnique)
+	{
+		changes++;
+	}
+
+	if (last.Material != item.Material)
+	{
+		changes++;
+	}
+
+	if (last.InputLayoutID != item.InputLayoutID)
+	{
+		changes++;
+	}
+
+	if (last.Buffers != item.Buffers)
+	{
+		changes += 2;
+	}
+
+	return changes;
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "Hydra/Core/Library.h"
+#include "Hydra/Core/Common.h"
+#include "Hydra/Core/Container.h"
+
+class HPrimitiveComponent;
+class MaterialInterface;
+class Technique;
+struct FMeshBufferDataInternal;
+
+// Bits of the sort key per field, from the most significant one down. Draws are sorted by render target, then
+// technique, input layout, material and at last front to back by depth, or by batch for draws that get instanced.
+// Ids that do not fit wrap around, which only makes the order worse, the draw loop compares the real state.
+#define RENDER_QUEUE_TARGET_BITS 6
+#define RENDER_QUEUE_TECHNIQUE_BITS 10
+#define RENDER_QUEUE_INPUT_LAYOUT_BITS 6
+#define RENDER_QUEUE_MATERIAL_BITS 18
+#define RENDER_QUEUE_ORDER_BITS 24
+
+// Below this many draws the keys are sorted with std::sort, the radix passes do not pay off
+#define RENDER_QUEUE_RADIX_SORT_MIN_SIZE 128
+
+struct FRenderQueueItem
+{
+	HPrimitiveComponent* Component;
+	MaterialInterface* Material;
+	Technique* MaterialTechnique;
+	uint32 InputLayoutID;
+
+	FMeshBufferDataInternal* Buffers;
+	uint32 FirstIndex;
+	uint32 IndexCount;
+
+	int32 LOD;
+
+	// The model matrix comes from the instance buffer, so draws of the same section can share one draw call
+	bool Instanced;
+};
+
+struct FRenderQueueStats
+{
+	// Mesh sections queued
+	int Draws = 0;
+
+	// Draw calls issued for them once instanced
+	int DrawCalls = 0;
+
+	// Technique, material, input layout and buffer changes between consecutive draws, as issued after sorting
+	int StateChanges = 0;
+
+	// The same count for the draws in the order they were queued
+	int UnsortedStateChanges = 0;
+};
+
+class HYDRA_API FRenderQueue
+{
+private:
+	List<FRenderQueueItem> _Items;
+	List<uint64> _Keys;
+	List<uint32> _Order;
+
+	// Ping pong buffers of the radix sort, kept so sorting does not allocate every frame
+	List<uint64> _SortKeys[2];
+	List<uint32> _SortOrder;
+
+	FastMap<const void*, uint32> _StateIDs;
+
+public:
+	void Clear();
+
+	void Add(uint64 sortKey, const FRenderQueueItem& item);
+
+	// Orders the items by their keys, before that they are in the order they were added
+	void Sort();
+
+	size_t Size() const;
+	const FRenderQueueItem& Get(size_t index) const;
+
+	// Small id for a render target, technique or material, the same until the queue is cleared
+	uint32 GetStateID(const void* state);
+
+	// Counts the state changes between consecutive draws, in the order they were added or in the current order
+	int CountStateChanges(bool inAddOrder) const;
+
+	// Depth is any non negative value that grows with the distance to the camera, like the squared distance
+	static uint64 MakeSortKey(uint32 targetID, uint32 techniqueID, uint32 inputLayoutID, uint32 materialID, float depth);
+
+	// Same as MakeSortKey, but keeps draws with the same batch id next to each other instead of ordering them by depth
+	static uint64 MakeBatchSortKey(uint32 targetID, uint32 techniqueID, uint32 inputLayoutID, uint32 materialID, uint32 batchID);
+
+	// Whether both draws can be one instanced draw call
+	static bool CanInstance(const FRenderQueueItem& first, const FRenderQueueItem& other);
+
+private:
+	void RadixSort();
+
+	static uint64 MakeKey(uint32 targetID, uint32 techniqueID, uint32 inputLayoutID, uint32 materialID, uint32 order);
+
+	static int CountStateChanges(const FRenderQueueItem& last, const FRenderQueueItem& item);
+};
\ No newline at end of file
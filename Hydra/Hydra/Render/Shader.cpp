@@ -1,16 +1,22 @@
 #include "Hydra/Render/Shader.h"
 
 #include "Hydra/EngineContext.h"
+#include "Hydra/Render/EngineConstants.h"
 
 #include <d3d11.h>
 #include <d3dcompiler.h>
 
 Shader::Shader(const String& name, const NVRHI::ShaderType::Enum& type, NVRHI::ShaderHandle shaderHandle, ID3DBlob* shaderBlob)
-	: _Name(name), _Type(type), _Handle(shaderHandle), _Blob(shaderBlob), _LocalShaderVarCache(nullptr)
+	: _Name(name), _Type(type), _Handle(shaderHandle), _Blob(shaderBlob), _LocalShaderVarCache(nullptr), _HasInputDefinitions(false)
 {
 	Initialize();
 }
 
+Shader::Shader(const String& name, const NVRHI::ShaderType::Enum& type, NVRHI::ShaderHandle shaderHandle, ID3DBlob* shaderBlob, ShaderVars* reflection, const List<ShaderVertexInputDefinition>& inputDefinitions)
+	: _Name(name), _Type(type), _Handle(shaderHandle), _Blob(shaderBlob), _LocalShaderVarCache(reflection), _InputDefinitions(inputDefinitions), _HasInputDefinitions(true)
+{
+}
+
 Shader::~Shader()
 {
 	if (_Blob)
@@ -53,6 +59,16 @@ ShaderVars* Shader::CreateShaderVars()
 	return new ShaderVars(*_LocalShaderVarCache);
 }
 
+const ShaderVars* Shader::GetReflection()
+{
+	if (_LocalShaderVarCache == nullptr)
+	{
+		Initialize();
+	}
+
+	return _LocalShaderVarCache;
+}
+
 DXGI_FORMAT GetDXGIFormat(D3D11_SIGNATURE_PARAMETER_DESC& pd)
 {
 	BYTE mask = pd.Mask;
@@ -96,6 +112,11 @@ DXGI_FORMAT GetDXGIFormat(D3D11_SIGNATURE_PARAMETER_DESC& pd)
 
 List<ShaderVertexInputDefinition> Shader::GetInputLayoutDefinitions(NVRHI::IRendererInterface* renderInterface)
 {
+	if (_HasInputDefinitions)
+	{
+		return _InputDefinitions;
+	}
+
 	List<ShaderVertexInputDefinition> definitions;
 
 	if (_Blob == nullptr || _Handle == nullptr || _Type != NVRHI::ShaderType::SHADER_VERTEX)
@@ -135,6 +156,7 @@ List<ShaderVertexInputDefinition> Shader::GetInputLayoutDefinitions(NVRHI::IRend
 		def.SemanticIndex = semanticIndex;
 		def.Format = renderInterface->GetFormatFromDXGI(format);
 		def.Instanced = isPerInstance;
+		def.Used = paramDesc.ReadWriteMask != 0;
 
 		definitions.emplace_back(def);
 	}
@@ -143,6 +165,9 @@ List<ShaderVertexInputDefinition> Shader::GetInputLayoutDefinitions(NVRHI::IRend
 
 	reflection->Release();
 
+	_InputDefinitions = definitions;
+	_HasInputDefinitions = true;
+
 	return definitions;
 }
 
@@ -190,11 +215,22 @@ void Shader::Initialize()
 			define.Index = static_cast<int>(_LocalShaderVarCache->TextureDefines.size());
 			define.IsWritable = bindDesc.Type == D3D_SIT_UAV_RWSTRUCTURED;
 			define.Buffer = nullptr;
+			define.Id = MaterialParam::GetId(bufferDesc.Name);
 
-			_LocalShaderVarCache->BufferDefines[bufferDesc.Name] = define;
+			_LocalShaderVarCache->BufferDefines.push_back(define);
 		}
-		else
+		else if (!IsEngineConstantBuffer(bufferDesc.Name, bindDesc.BindPoint))
 		{
+			// Still created for the material so its variables are not lost, but the renderer binds over it
+			if (IsEngineConstantBufferSlot(bindDesc.BindPoint))
+			{
+				LogError("Shader::Initialize", _Name + ", " + bufferDesc.Name + ", " + ToString(bindDesc.BindPoint), "Constant buffer uses a slot reserved for the engine constants !");
+			}
+			else if (String(bufferDesc.Name) == ENGINE_VIEW_CONSTANTS_NAME || String(bufferDesc.Name) == ENGINE_OBJECT_CONSTANTS_NAME)
+			{
+				LogError("Shader::Initialize", _Name + ", " + bufferDesc.Name + ", " + ToString(bindDesc.BindPoint), "Engine constant buffer is not bound to its reserved slot !");
+			}
+
 			constantBufferRealCount++;
 		}
 	}
@@ -205,7 +241,7 @@ void Shader::Initialize()
 
 	int constantBufferIndex = 0;
 
-	for (int i = 0; i < _LocalShaderVarCache->ConstantBufferCount; i++)
+	for (unsigned int i = 0; i < shaderDesc.ConstantBuffers; i++)
 	{
 		ID3D11ShaderReflectionConstantBuffer* cb = reflection->GetConstantBufferByIndex(i);
 
@@ -215,7 +251,8 @@ void Shader::Initialize()
 		D3D11_SHADER_INPUT_BIND_DESC bindDesc;
 		reflection->GetResourceBindingDescByName(bufferDesc.Name, &bindDesc);
 
-		if (bindDesc.Type == D3D_SIT_UAV_RWSTRUCTURED)
+		// Structured buffers are bound as buffers, the view and object constants by the renderer
+		if (bindDesc.Type == D3D_SIT_UAV_RWSTRUCTURED || bindDesc.Type == D3D_SIT_STRUCTURED || IsEngineConstantBuffer(bufferDesc.Name, bindDesc.BindPoint))
 		{
 			continue;
 		}
@@ -234,6 +271,7 @@ void Shader::Initialize()
 			var->GetDesc(&varDesc);
 
 			RawShaderVariable varStruct = {};
+			varStruct.Id = MaterialParam::GetId(varDesc.Name);
 			varStruct.ConstantBufferIndex = constantBufferIndex;
 			varStruct.ByteOffset = varDesc.StartOffset;
 			varStruct.Size = varDesc.Size;
@@ -275,7 +313,7 @@ void Shader::Initialize()
 				memberType->GetDesc(&memberTypeDesc);
 			}*/
 
-			_LocalShaderVarCache->Variables[varDesc.Name] = varStruct;
+			_LocalShaderVarCache->Variables.push_back(varStruct);
 		}
 
 		constantBufferIndex++;
@@ -312,8 +350,9 @@ void Shader::Initialize()
 			define.Index = static_cast<int>(_LocalShaderVarCache->TextureDefines.size());
 			define.TextureHandle = nullptr;
 			define.IsWritable = resourceDesc.Type == D3D_SIT_UAV_RWTYPED;
+			define.Id = MaterialParam::GetId(resourceDesc.Name);
 
-			_LocalShaderVarCache->TextureDefines[resourceDesc.Name] = define;
+			_LocalShaderVarCache->TextureDefines.push_back(define);
 
 			break;
 		}
@@ -328,8 +367,9 @@ void Shader::Initialize()
 			RawShaderSamplerDefine define = {};
 			define.BindIndex = resourceDesc.BindPoint;
 			define.Index = static_cast<int>(_LocalShaderVarCache->SamplerDefines.size());
+			define.Id = MaterialParam::GetId(resourceDesc.Name);
 
-			_LocalShaderVarCache->SamplerDefines[resourceDesc.Name] = define;
+			_LocalShaderVarCache->SamplerDefines.push_back(define);
 
 			break;
 		}
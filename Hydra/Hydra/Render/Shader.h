@@ -5,10 +5,14 @@
 #include "Hydra/Core/Common.h"
 #include "Hydra/Render/Pipeline/GFSDK_NVRHI.h"
 #include "Hydra/Render/VarType.h"
+#include "Hydra/Render/MaterialParam.h"
 #include "Hydra/Render/ShaderVertexInputDefinition.h"
 
 struct RawShaderVariable
 {
+	MaterialParamId Id;
+	// Index of the parameter in the tables of the material that owns these vars, set by the material
+	uint32 MaterialIndex;
 	unsigned int ByteOffset;
 	unsigned int Size;
 	unsigned int ConstantBufferIndex;
@@ -27,6 +31,8 @@ struct RawShaderConstantBuffer
 
 struct RawShaderTextureDefine
 {
+	MaterialParamId Id;
+	uint32 MaterialIndex;
 	unsigned int Index;
 	unsigned int BindIndex;
 	NVRHI::TextureHandle TextureHandle;
@@ -35,6 +41,8 @@ struct RawShaderTextureDefine
 
 struct RawShaderBuffer
 {
+	MaterialParamId Id;
+	uint32 MaterialIndex;
 	String Name;
 	unsigned int Size;
 	unsigned int Index;
@@ -45,6 +53,8 @@ struct RawShaderBuffer
 
 struct RawShaderSamplerDefine
 {
+	MaterialParamId Id;
+	uint32 MaterialIndex;
 	unsigned int Index;
 	unsigned int BindIndex;
 	NVRHI::SamplerHandle SamplerHandle;
@@ -57,10 +67,11 @@ struct ShaderVars
 	RawShaderConstantBuffer* ConstantBuffers;
 	int ConstantBufferCount;
 
-	FastMap<String, RawShaderTextureDefine> TextureDefines;
-	FastMap<String, RawShaderSamplerDefine> SamplerDefines;
-	FastMap<String, RawShaderVariable> Variables;
-	FastMap<String, RawShaderBuffer> BufferDefines;
+	// Flat tables of the parameters the shader reads, applying a material walks them and indexes its values by id
+	List<RawShaderTextureDefine> TextureDefines;
+	List<RawShaderSamplerDefine> SamplerDefines;
+	List<RawShaderVariable> Variables;
+	List<RawShaderBuffer> BufferDefines;
 
 	Map<String, VarType::Type> VariableTypes;
 };
@@ -75,8 +86,14 @@ private:
 
 	ShaderVars* _LocalShaderVarCache;
 
+	List<ShaderVertexInputDefinition> _InputDefinitions;
+	bool _HasInputDefinitions;
+
 public:
 	Shader(const String& name, const NVRHI::ShaderType::Enum& type, NVRHI::ShaderHandle shaderHandle, ID3DBlob* shaderBlob);
+
+	// Takes the reflection data of a cached variant instead of reflecting the blob, the shader owns the vars
+	Shader(const String& name, const NVRHI::ShaderType::Enum& type, NVRHI::ShaderHandle shaderHandle, ID3DBlob* shaderBlob, ShaderVars* reflection, const List<ShaderVertexInputDefinition>& inputDefinitions);
 	~Shader();
 
 	NVRHI::ShaderHandle GetRaw();
@@ -86,6 +103,9 @@ public:
 
 	ShaderVars* CreateShaderVars();
 
+	// The reflected parameters CreateShaderVars copies
+	const ShaderVars* GetReflection();
+
 	List<ShaderVertexInputDefinition> GetInputLayoutDefinitions(NVRHI::IRendererInterface* renderInterface);
 
 private:
@@ -0,0 +1,488 @@
+#include "Hydra/Render/ShaderCache.h"
+
+#include "Hydra/Core/Log.h"
+#include "Hydra/Core/Hash.h"
+#include "Hydra/Core/Stream/FileStream.h"
+#include "Hydra/Render/Shader.h"
+
+#include <d3dcompiler.h>
+
+#include <cstring>
+#include <fstream>
+
+// 'HSCH' read as a little endian uint32
+constexpr uint32 SHADER_CACHE_FILE_MAGIC = 0x48435348;
+
+struct ShaderCacheFileHeader
+{
+	uint32 Magic;
+	uint32 Version;
+	uint32 EntryCount;
+};
+
+struct ShaderCacheEntryHeader
+{
+	uint64 Key;
+	double CompileTime;
+	uint32 BytecodeSize;
+	uint32 ReflectionSize;
+	uint32 UnusedRuns;
+};
+
+template<typename T> static inline void WriteValue(List<uint8>& out, const T& value)
+{
+	const uint8* bytes = (const uint8*)&value;
+	out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+static inline void WriteString(List<uint8>& out, const String& value)
+{
+	WriteValue(out, (uint32)value.size());
+	out.insert(out.end(), value.begin(), value.end());
+}
+
+// Reads what WriteValue and WriteString wrote, every read past the end fails and leaves the reader invalid
+class ShaderCacheReader
+{
+private:
+	const uint8* _Data;
+	size_t _Size;
+	size_t _Offset;
+	bool _Valid;
+
+public:
+	ShaderCacheReader(const uint8* data, size_t size) : _Data(data), _Size(size), _Offset(0), _Valid(true)
+	{
+
+	}
+
+	template<typename T> T Read()
+	{
+		T value = {};
+
+		if (_Valid && _Offset + sizeof(T) <= _Size)
+		{
+			memcpy(&value, _Data + _Offset, sizeof(T));
+			_Offset += sizeof(T);
+		}
+		else
+		{
+			_Valid = false;
+		}
+
+		return value;
+	}
+
+	String ReadString()
+	{
+		uint32 size = Read<uint32>();
+
+		if (!_Valid || _Offset + size > _Size)
+		{
+			_Valid = false;
+			return String_None;
+		}
+
+		String value = String((const char*)_Data + _Offset, size);
+		_Offset += size;
+
+		return value;
+	}
+
+	void ReadBytes(List<uint8>& out, size_t size)
+	{
+		if (!_Valid || _Offset + size > _Size)
+		{
+			_Valid = false;
+			return;
+		}
+
+		out.assign(_Data + _Offset, _Data + _Offset + size);
+		_Offset += size;
+	}
+
+	// Counts of the tables, a count that cannot fit in the remaining data is broken
+	uint32 ReadCount()
+	{
+		uint32 count = Read<uint32>();
+
+		if (count > _Size - _Offset)
+		{
+			_Valid = false;
+			return 0;
+		}
+
+		return count;
+	}
+
+	bool IsValid() const
+	{
+		return _Valid;
+	}
+
+	bool IsAtEnd() const
+	{
+		return _Offset == _Size;
+	}
+};
+
+ShaderCache::ShaderCache() : _Dirty(false)
+{
+}
+
+bool ShaderCache::Load(const File& file)
+{
+	_Entries.clear();
+	_Dirty = false;
+
+	if (!file.IsExist())
+	{
+		return false;
+	}
+
+	FileStream stream = FileStream(file);
+	Blob* data = stream.Read();
+
+	if (data == nullptr)
+	{
+		return false;
+	}
+
+	ShaderCacheReader reader = ShaderCacheReader((const uint8*)data->GetData(), data->GetDataSize());
+
+	ShaderCacheFileHeader header = reader.Read<ShaderCacheFileHeader>();
+
+	bool valid = reader.IsValid() && header.Magic == SHADER_CACHE_FILE_MAGIC && header.Version == SHADER_CACHE_FILE_VERSION;
+
+	for (uint32 i = 0; valid && i < header.EntryCount; i++)
+	{
+		ShaderCacheEntryHeader entryHeader = reader.Read<ShaderCacheEntryHeader>();
+
+		FShaderCacheEntry& entry = _Entries[entryHeader.Key];
+		entry.CompileTime = entryHeader.CompileTime;
+		entry.UnusedRuns = entryHeader.UnusedRuns;
+		entry.Used = false;
+
+		reader.ReadBytes(entry.Bytecode, entryHeader.BytecodeSize);
+		reader.ReadBytes(entry.Reflection, entryHeader.ReflectionSize);
+
+		valid = reader.IsValid();
+	}
+
+	delete data;
+
+	if (!valid || !reader.IsAtEnd())
+	{
+		_Entries.clear();
+
+		Log("ShaderCache::Load", file.GetPath(), "Outdated or invalid file, the shaders will be recompiled.");
+		return false;
+	}
+
+	Log("ShaderCache::Load", file.GetPath(), "Loaded " + ToString(_Entries.size()) + " shader variants.");
+
+	return true;
+}
+
+bool ShaderCache::Save(const File& file)
+{
+	// The ages are counted from the loaded ones, so saving again in the same run writes the same file
+	bool changed = _Dirty;
+	uint32 entryCount = 0;
+
+	ITER(_Entries, it)
+	{
+		const FShaderCacheEntry& entry = it->second;
+		uint32 unusedRuns = entry.Used ? 0 : entry.UnusedRuns + 1;
+
+		changed = changed || unusedRuns != entry.UnusedRuns;
+
+		if (unusedRuns <= SHADER_CACHE_MAX_UNUSED_RUNS)
+		{
+			entryCount++;
+		}
+	}
+
+	if (!changed)
+	{
+		return true;
+	}
+
+	std::ofstream stream(file.GetPath(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+	if (!stream.is_open())
+	{
+		LogError("ShaderCache::Save", file.GetPath(), "Could not open the file for writing !");
+		return false;
+	}
+
+	ShaderCacheFileHeader header = {};
+	header.Magic = SHADER_CACHE_FILE_MAGIC;
+	header.Version = SHADER_CACHE_FILE_VERSION;
+	header.EntryCount = entryCount;
+
+	stream.write((const char*)&header, sizeof(ShaderCacheFileHeader));
+
+	ITER(_Entries, it)
+	{
+		const FShaderCacheEntry& entry = it->second;
+		uint32 unusedRuns = entry.Used ? 0 : entry.UnusedRuns + 1;
+
+		if (unusedRuns > SHADER_CACHE_MAX_UNUSED_RUNS)
+		{
+			continue;
+		}
+
+		ShaderCacheEntryHeader entryHeader = {};
+		entryHeader.Key = it->first;
+		entryHeader.CompileTime = entry.CompileTime;
+		entryHeader.BytecodeSize = (uint32)entry.Bytecode.size();
+		entryHeader.ReflectionSize = (uint32)entry.Reflection.size();
+		entryHeader.UnusedRuns = unusedRuns;
+
+		stream.write((const char*)&entryHeader, sizeof(ShaderCacheEntryHeader));
+		stream.write((const char*)entry.Bytecode.data(), entry.Bytecode.size());
+		stream.write((const char*)entry.Reflection.data(), entry.Reflection.size());
+	}
+
+	_Dirty = !stream.good();
+
+	if (!_Dirty)
+	{
+		Log("ShaderCache::Save", file.GetPath(), "Saved " + ToString(entryCount) + " of " + ToString(_Entries.size()) + " shader variants.");
+	}
+
+	return !_Dirty;
+}
+
+const FShaderCacheEntry* ShaderCache::Find(uint64 key)
+{
+	auto iter = _Entries.find(key);
+
+	if (iter == _Entries.end())
+	{
+		_Stats.Misses++;
+
+		return nullptr;
+	}
+
+	_Stats.Hits++;
+	_Stats.CompileTimeSaved += iter->second.CompileTime;
+
+	iter->second.Used = true;
+
+	return &iter->second;
+}
+
+void ShaderCache::Store(uint64 key, const void* bytecode, size_t bytecodeSize, const ShaderVars& vars, const List<ShaderVertexInputDefinition>& inputDefinitions, double compileTime)
+{
+	FShaderCacheEntry& entry = _Entries[key];
+	entry.CompileTime = compileTime;
+	entry.UnusedRuns = 0;
+	entry.Used = true;
+	entry.Bytecode.assign((const uint8*)bytecode, (const uint8*)bytecode + bytecodeSize);
+	entry.Reflection.clear();
+
+	// Parameters are stored by name, their ids are only valid while the engine runs
+	List<uint8>& out = entry.Reflection;
+
+	WriteValue(out, (uint32)vars.ShaderType);
+
+	WriteValue(out, (uint32)vars.ConstantBufferCount);
+
+	for (int i = 0; i < vars.ConstantBufferCount; i++)
+	{
+		const RawShaderConstantBuffer& constantBuffer = vars.ConstantBuffers[i];
+
+		WriteString(out, constantBuffer.Name);
+		WriteValue(out, (uint32)constantBuffer.Size);
+		WriteValue(out, (uint32)constantBuffer.BindIndex);
+	}
+
+	WriteValue(out, (uint32)vars.Variables.size());
+
+	for (const RawShaderVariable& variable : vars.Variables)
+	{
+		WriteString(out, MaterialParam::GetName(variable.Id));
+		WriteValue(out, (uint32)variable.ByteOffset);
+		WriteValue(out, (uint32)variable.Size);
+		WriteValue(out, (uint32)variable.ConstantBufferIndex);
+	}
+
+	WriteValue(out, (uint32)vars.TextureDefines.size());
+
+	for (const RawShaderTextureDefine& define : vars.TextureDefines)
+	{
+		WriteString(out, MaterialParam::GetName(define.Id));
+		WriteValue(out, (uint32)define.Index);
+		WriteValue(out, (uint32)define.BindIndex);
+		WriteValue(out, (uint8)define.IsWritable);
+	}
+
+	WriteValue(out, (uint32)vars.SamplerDefines.size());
+
+	for (const RawShaderSamplerDefine& define : vars.SamplerDefines)
+	{
+		WriteString(out, MaterialParam::GetName(define.Id));
+		WriteValue(out, (uint32)define.Index);
+		WriteValue(out, (uint32)define.BindIndex);
+	}
+
+	WriteValue(out, (uint32)vars.BufferDefines.size());
+
+	for (const RawShaderBuffer& define : vars.BufferDefines)
+	{
+		WriteString(out, define.Name);
+		WriteValue(out, (uint32)define.Size);
+		WriteValue(out, (uint32)define.Index);
+		WriteValue(out, (uint32)define.BindIndex);
+		WriteValue(out, (uint8)define.IsWritable);
+	}
+
+	WriteValue(out, (uint32)vars.VariableTypes.size());
+
+	for (Map<String, VarType::Type>::const_iterator it = vars.VariableTypes.begin(); it != vars.VariableTypes.end(); it++)
+	{
+		WriteString(out, it->first);
+		WriteValue(out, (int32)it->second);
+	}
+
+	WriteValue(out, (uint32)inputDefinitions.size());
+
+	for (const ShaderVertexInputDefinition& definition : inputDefinitions)
+	{
+		WriteString(out, definition.SemanticName);
+		WriteValue(out, (int32)definition.SemanticIndex);
+		WriteValue(out, (int32)definition.Format);
+		WriteValue(out, (uint8)definition.Instanced);
+		WriteValue(out, (uint8)definition.Used);
+	}
+
+	_Stats.CompileTime += compileTime;
+
+	_Dirty = true;
+}
+
+const FShaderCacheStats& ShaderCache::GetStats() const
+{
+	return _Stats;
+}
+
+uint64 ShaderCache::MakeKey(uint64 sourceHash, const Map<String, String>& defines, const String& entryPoint, const String& profile, uint32 compileFlags)
+{
+	uint64 hash = HashBytes(HASH_SEED, &sourceHash, sizeof(uint64));
+
+	for (Map<String, String>::const_iterator it = defines.begin(); it != defines.end(); it++)
+	{
+		hash = HashString(hash, it->first);
+		hash = HashString(hash, it->second);
+	}
+
+	hash = HashString(hash, entryPoint);
+	hash = HashString(hash, profile);
+	hash = HashBytes(hash, &compileFlags, sizeof(uint32));
+
+	// Another compiler can produce different bytecode for the same input
+	uint32 compilerVersion = D3D_COMPILER_VERSION;
+
+	return HashBytes(hash, &compilerVersion, sizeof(uint32));
+}
+
+ShaderVars* ShaderCache::ReadReflection(const FShaderCacheEntry& entry, List<ShaderVertexInputDefinition>& outInputDefinitions)
+{
+	ShaderCacheReader reader = ShaderCacheReader(entry.Reflection.data(), entry.Reflection.size());
+
+	ShaderVars* vars = new ShaderVars();
+
+	vars->ShaderType = (NVRHI::ShaderType::Enum)reader.Read<uint32>();
+
+	vars->ConstantBufferCount = (int)reader.ReadCount();
+	vars->ConstantBuffers = new RawShaderConstantBuffer[vars->ConstantBufferCount];
+
+	for (int i = 0; i < vars->ConstantBufferCount; i++)
+	{
+		RawShaderConstantBuffer& constantBuffer = vars->ConstantBuffers[i];
+
+		constantBuffer.Name = reader.ReadString();
+		constantBuffer.Size = reader.Read<uint32>();
+		constantBuffer.BindIndex = reader.Read<uint32>();
+		constantBuffer.ConstantBuffer = nullptr;
+		constantBuffer.LocalDataBuffer = nullptr;
+		constantBuffer.MarkUpdate = false;
+	}
+
+	vars->Variables.resize(reader.ReadCount());
+
+	for (RawShaderVariable& variable : vars->Variables)
+	{
+		variable.Id = MaterialParam::GetId(reader.ReadString());
+		variable.ByteOffset = reader.Read<uint32>();
+		variable.Size = reader.Read<uint32>();
+		variable.ConstantBufferIndex = reader.Read<uint32>();
+	}
+
+	vars->TextureDefines.resize(reader.ReadCount());
+
+	for (RawShaderTextureDefine& define : vars->TextureDefines)
+	{
+		define.Id = MaterialParam::GetId(reader.ReadString());
+		define.Index = reader.Read<uint32>();
+		define.BindIndex = reader.Read<uint32>();
+		define.IsWritable = reader.Read<uint8>() != 0;
+		define.TextureHandle = nullptr;
+	}
+
+	vars->SamplerDefines.resize(reader.ReadCount());
+
+	for (RawShaderSamplerDefine& define : vars->SamplerDefines)
+	{
+		define.Id = MaterialParam::GetId(reader.ReadString());
+		define.Index = reader.Read<uint32>();
+		define.BindIndex = reader.Read<uint32>();
+		define.SamplerHandle = nullptr;
+	}
+
+	vars->BufferDefines.resize(reader.ReadCount());
+
+	for (RawShaderBuffer& define : vars->BufferDefines)
+	{
+		define.Name = reader.ReadString();
+		define.Id = MaterialParam::GetId(define.Name);
+		define.Size = reader.Read<uint32>();
+		define.Index = reader.Read<uint32>();
+		define.BindIndex = reader.Read<uint32>();
+		define.IsWritable = reader.Read<uint8>() != 0;
+		define.Buffer = nullptr;
+	}
+
+	uint32 typeCount = reader.ReadCount();
+
+	for (uint32 i = 0; i < typeCount; i++)
+	{
+		String name = reader.ReadString();
+		vars->VariableTypes[name] = (VarType::Type)reader.Read<int32>();
+	}
+
+	outInputDefinitions.resize(reader.ReadCount());
+
+	for (ShaderVertexInputDefinition& definition : outInputDefinitions)
+	{
+		definition.SemanticName = reader.ReadString();
+		definition.SemanticIndex = reader.Read<int32>();
+		definition.Format = (NVRHI::Format::Enum)reader.Read<int32>();
+		definition.Instanced = reader.Read<uint8>() != 0;
+		definition.Used = reader.Read<uint8>() != 0;
+	}
+
+	if (!reader.IsValid() || !reader.IsAtEnd())
+	{
+		delete[] vars->ConstantBuffers;
+		delete vars;
+
+		outInputDefinitions.clear();
+
+		return nullptr;
+	}
+
+	return vars;
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Hydra/Core/Library.h"
+#include "Hydra/Core/Common.h"
+#include "Hydra/Core/Container.h"
+#include "Hydra/Core/File.h"
+#include "Hydra/Render/ShaderVertexInputDefinition.h"
+
+struct ShaderVars;
+
+// Compiled variants of every technique, next to the shaders they come from
+#define SHADER_CACHE_FILE "Assets/Shaders/Variants.cache"
+
+// Bump when the file layout or the stored reflection data changes, files of other versions are ignored
+#define SHADER_CACHE_FILE_VERSION 2
+
+// Entries not used by this many runs in a row are dropped from the file, so variants of old sources and removed
+// shaders do not pile up while the ones of scenes that were not opened lately stay cached
+#define SHADER_CACHE_MAX_UNUSED_RUNS 16
+
+struct FShaderCacheStats
+{
+	// Variants found in the cache
+	int Hits = 0;
+
+	// Variants that had to be compiled
+	int Misses = 0;
+
+	// Seconds spent compiling the misses
+	double CompileTime = 0.0;
+
+	// Seconds the hits took to compile when they were added to the cache
+	double CompileTimeSaved = 0.0;
+};
+
+struct FShaderCacheEntry
+{
+	List<uint8> Bytecode;
+
+	// What Shader::Initialize and Shader::GetInputLayoutDefinitions reflect from the bytecode, see ReadReflection
+	List<uint8> Reflection;
+
+	double CompileTime;
+
+	// Runs in a row that did not use the entry, as of the last load
+	uint32 UnusedRuns;
+
+	// Hit or stored this run
+	bool Used;
+};
+
+// Compiled shader variants with their reflection data, keyed by a hash of everything the compiler sees: the source and
+// its includes, the defines, the entry point, the profile, the compile flags and the compiler version. Kept in a single file between runs,
+// so a launch with unchanged shaders compiles nothing.
+class HYDRA_API ShaderCache
+{
+private:
+	FastMap<uint64, FShaderCacheEntry> _Entries;
+	bool _Dirty;
+
+	FShaderCacheStats _Stats;
+
+public:
+	ShaderCache();
+
+	// Replaces the entries with the ones of the file, false when it is missing or outdated
+	bool Load(const File& file);
+
+	// Writes the entries if variants were added or the unused ones aged, see SHADER_CACHE_MAX_UNUSED_RUNS
+	bool Save(const File& file);
+
+	// Returns the cached variant and counts a hit, or counts a miss and returns null
+	const FShaderCacheEntry* Find(uint64 key);
+
+	// Adds a variant that was just compiled
+	void Store(uint64 key, const void* bytecode, size_t bytecodeSize, const ShaderVars& vars, const List<ShaderVertexInputDefinition>& inputDefinitions, double compileTime);
+
+	const FShaderCacheStats& GetStats() const;
+
+	// The source hash covers the code and everything it includes, see ShaderIncludeCache::HashSource
+	static uint64 MakeKey(uint64 sourceHash, const Map<String, String>& defines, const String& entryPoint, const String& profile, uint32 compileFlags);
+
+	// Rebuilds the reflection data stored with a variant, the caller owns the returned vars. Null if the data is broken.
+	static ShaderVars* ReadReflection(const FShaderCacheEntry& entry, List<ShaderVertexInputDefinition>& outInputDefinitions);
+};
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "Hydra/Render/ShaderIncludeCache.h"
+
+#include "Hydra/Core/Log.h"
+#include "Hydra/Core/Hash.h"
+#include "Hydra/Core/Stream/FileStream.h"
+
+static void CollectIncludes(ShaderIncludeCache& cache, uint64& hash, const String& source, const File& directory, Set<String>& visited)
+{
+	for (const String& sourceLine : SplitString(source, '\n'))
+	{
+		size_t start = sourceLine.find_first_not_of(" \t");
+
+		if (start == String::npos || sourceLine.compare(start, 8, "#include") != 0)
+		{
+			continue;
+		}
+
+		size_t nameStart = sourceLine.find('"', start + 8);
+		size_t nameEnd = nameStart != String::npos ? sourceLine.find('"', nameStart + 1) : String::npos;
+
+		if (nameEnd == String::npos)
+		{
+			continue;
+		}
+
+		String name = sourceLine.substr(nameStart + 1, nameEnd - nameStart - 1);
+
+		SharedPtr<FShaderInclude> include = cache.Get(name, directory);
+
+		if (include == nullptr)
+		{
+			hash = HashString(hash, name);
+			continue;
+		}
+
+		hash = HashString(hash, include->Path.GetPath());
+
+		if (visited.find(include->Path.GetPath()) != visited.end())
+		{
+			continue;
+		}
+
+		visited.insert(include->Path.GetPath());
+
+		hash = HashBytes(hash, &include->Hash, sizeof(uint64));
+
+		CollectIncludes(cache, hash, include->Content, include->Path.GetParentFile(), visited);
+	}
+}
+
+SharedPtr<FShaderInclude> ShaderIncludeCache::Get(const String& name, const File& directory)
+{
+	File file = File(name);
+
+	if (!file.IsExist())
+	{
+		file = File(directory, name);
+	}
+
+	std::lock_guard<std::mutex> lock(_Mutex);
+
+	auto iter = _Includes.find(file.GetPath());
+
+	if (iter != _Includes.end())
+	{
+		return iter->second;
+	}
+
+	if (!file.IsExist())
+	{
+		return nullptr;
+	}
+
+	FileStream stream = FileStream(file);
+	Blob* data = stream.Read();
+
+	if (data == nullptr)
+	{
+		return nullptr;
+	}
+
+	SharedPtr<FShaderInclude> include = MakeShared<FShaderInclude>();
+	include->Path = file;
+	include->Content = String(data->GetData(), data->GetDataSize());
+	include->Hash = HashString(HASH_SEED, include->Content);
+
+	delete data;
+
+	_Includes[file.GetPath()] = include;
+
+	return include;
+}
+
+void ShaderIncludeCache::Invalidate(const File& file)
+{
+	std::lock_guard<std::mutex> lock(_Mutex);
+
+	_Includes.erase(file.GetPath());
+}
+
+void ShaderIncludeCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(_Mutex);
+
+	_Includes.clear();
+}
+
+uint64 ShaderIncludeCache::HashSource(const String& source, const File& sourceFile, Set<String>& outDependencies)
+{
+	uint64 hash = HashString(HASH_SEED, source);
+
+	outDependencies.clear();
+	CollectIncludes(*this, hash, source, sourceFile.GetParentFile(), outDependencies);
+
+	return hash;
+}
+
+ShaderIncludeHandler::ShaderIncludeHandler(ShaderIncludeCache* cache, const File& sourceFile) : _Cache(cache), _SourceDirectory(sourceFile.GetParentFile())
+{
+}
+
+HRESULT __stdcall ShaderIncludeHandler::Open(D3D_INCLUDE_TYPE includeType, LPCSTR fileName, LPCVOID parentData, LPCVOID* outData, UINT* outBytes)
+{
+	File directory = _SourceDirectory;
+
+	auto parent = _Opened.find(parentData);
+
+	if (parent != _Opened.end())
+	{
+		directory = parent->second->Path.GetParentFile();
+	}
+
+	SharedPtr<FShaderInclude> include = _Cache->Get(fileName, directory);
+
+	if (include == nullptr)
+	{
+		LogError("ShaderIncludeHandler::Open", fileName, "Include not found !");
+		return E_FAIL;
+	}
+
+	_Opened[include->Content.data()] = include;
+
+	*outData = include->Content.data();
+	*outBytes = (UINT)include->Content.size();
+
+	return S_OK;
+}
+
+HRESULT __stdcall ShaderIncludeHandler::Close(LPCVOID data)
+{
+	// Kept until the compile is done, nested includes still look up the directory of their parent
+	return S_OK;
+}
\ No newline at end of file
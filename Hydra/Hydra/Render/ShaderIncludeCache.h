@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Hydra/Core/Library.h"
+#include "Hydra/Core/Common.h"
+#include "Hydra/Core/Container.h"
+#include "Hydra/Core/File.h"
+#include "Hydra/Core/SmartPointer.h"
+
+#include <d3dcommon.h>
+#include <mutex>
+
+struct FShaderInclude
+{
+	File Path;
+	String Content;
+	uint64 Hash;
+};
+
+// Contents of the files shaders include, read once and shared by every technique and compile. Includes are looked up
+// like the standard include handler of the compiler does, from the working directory and then from the directory of the
+// including file. Safe to use from the compile workers.
+class HYDRA_API ShaderIncludeCache
+{
+private:
+	FastMap<String, SharedPtr<FShaderInclude>> _Includes;
+	std::mutex _Mutex;
+
+public:
+	// Null if the file does not exist
+	SharedPtr<FShaderInclude> Get(const String& name, const File& directory);
+
+	// The next Get of the file reads it again, includes handed out before stay valid
+	void Invalidate(const File& file);
+	void Clear();
+
+	// Hash of the source and of everything it includes, recursively, and the files it depends on. #include lines are
+	// collected without preprocessing, so includes in disabled #if blocks count too.
+	uint64 HashSource(const String& source, const File& sourceFile, Set<String>& outDependencies);
+};
+
+// Include handler for D3DCompile that reads through a ShaderIncludeCache, one per compile
+class ShaderIncludeHandler : public ID3DInclude
+{
+private:
+	ShaderIncludeCache* _Cache;
+	File _SourceDirectory;
+
+	// Includes opened by this compile, to find the directory of the including file and to keep their content alive
+	Map<const void*, SharedPtr<FShaderInclude>> _Opened;
+
+public:
+	ShaderIncludeHandler(ShaderIncludeCache* cache, const File& sourceFile);
+
+	HRESULT __stdcall Open(D3D_INCLUDE_TYPE includeType, LPCSTR fileName, LPCVOID parentData, LPCVOID* outData, UINT* outBytes) override;
+	HRESULT __stdcall Close(LPCVOID data) override;
+};
\ No newline at end of file
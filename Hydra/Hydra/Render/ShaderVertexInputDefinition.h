@@ -10,6 +10,9 @@ struct ShaderVertexInputDefinition
 	NVRHI::Format::Enum Format;
 	bool Instanced;
 
+	// Whether the shader reads the input at all, layouts do not depend on it
+	bool Used;
+
 	inline bool operator==(const ShaderVertexInputDefinition& other)
 	{
 		return SemanticName == other.SemanticName && SemanticIndex == other.SemanticIndex && Format == other.Format && Instanced == other.Instanced;
@@ -8,6 +8,25 @@
 #include "Hydra/EngineContext.h"
 
 #include "Hydra/Render/Shader.h"
+#include "Hydra/Render/ShaderCache.h"
+#include "Hydra/Render/ShaderIncludeCache.h"
+
+#include "Hydra/Core/Timing.h"
+#include "Hydra/Core/ThreadPool.h"
+#include "Hydra/Core/Hash.h"
+
+#include <atomic>
+#include <cstring>
+
+static UINT GetCompileFlags()
+{
+	UINT flags = D3DCOMPILE_ENABLE_STRICTNESS;
+#if defined( DEBUG ) || defined( _DEBUG )
+	flags |= D3DCOMPILE_DEBUG;
+#endif
+
+	return flags;
+}
 
 HRESULT CompileShaderFromString(_In_ const String& shaderSource, _In_ const String& name, _In_ const D3D_SHADER_MACRO* macros, _In_ ID3DInclude* include, _In_ LPCSTR entryPoint, _In_ LPCSTR profile, _Outptr_ ID3DBlob** blob)
 {
@@ -16,14 +35,11 @@ HRESULT CompileShaderFromString(_In_ const String& shaderSource, _In_ const Stri
 
 	*blob = nullptr;
 
-	UINT flags = D3DCOMPILE_ENABLE_STRICTNESS;
-#if defined( DEBUG ) || defined( _DEBUG )
-	flags |= D3DCOMPILE_DEBUG;
-#endif
+	UINT flags = GetCompileFlags();
 
 	ID3DBlob* shaderBlob = nullptr;
 	ID3DBlob* errorBlob = nullptr;
-	HRESULT hr = D3DCompile(shaderSource.c_str(), shaderSource.length(), name.c_str(), macros, D3D_COMPILE_STANDARD_FILE_INCLUDE, entryPoint, profile, flags, 0, &shaderBlob, &errorBlob);
+	HRESULT hr = D3DCompile(shaderSource.c_str(), shaderSource.length(), name.c_str(), macros, include != nullptr ? include : D3D_COMPILE_STANDARD_FILE_INCLUDE, entryPoint, profile, flags, 0, &shaderBlob, &errorBlob);
 	if (FAILED(hr))
 	{
 		if (errorBlob)
@@ -43,58 +59,272 @@ HRESULT CompileShaderFromString(_In_ const String& shaderSource, _In_ const Stri
 	return hr;
 }
 
-Technique::Technique(EngineContext* context, const File& file, bool precompile) : _Context(context), _Source(file), _Precompile(precompile), _NextDefineId(0), _HasInputLayoutID(false), _CanCreateInputLayoutID(false), _VertexShaderInternal(nullptr)
+// One stage of a variant. A worker only touches the stage it claimed, the rest is read by the thread that started the
+// variant once the stage is done.
+struct FShaderStageCompile
+{
+	NVRHI::ShaderType::Enum Type;
+	String EntryPoint;
+	String Profile;
+
+	// Only the keywords the stage declares are defined
+	ShaderVariantKey StageKey;
+	Map<String, String> Defines;
+
+	uint64 CacheKey;
+
+	// Another variant already has the shader for the stage key, nothing is compiled
+	bool Shared;
+
+	// Stages found in the shader cache are not compiled, they come with their reflection
+	ShaderVars* CachedReflection;
+	List<ShaderVertexInputDefinition> CachedInputDefinitions;
+
+	ID3DBlob* Blob;
+	double CompileTime;
+
+	std::atomic<bool> Claimed;
+};
+
+struct FShaderVariantCompile
+{
+	ShaderVariantKey Key;
+	bool Recompile;
+
+	// Copies, workers may still compile after the technique reloaded its source
+	String Code;
+	String Name;
+	String Path;
+
+	File Source;
+	ShaderIncludeCache* IncludeCache;
+
+	List<FShaderStageCompile> Stages;
+
+	std::atomic<int> RemainingStages;
+	std::atomic<bool> Failed;
+	bool Finished;
+
+	std::mutex Mutex;
+	std::condition_variable StagesDone;
+
+	~FShaderVariantCompile()
+	{
+		// Only left when the technique went away before picking the variant up
+		for (FShaderStageCompile& stage : Stages)
+		{
+			if (stage.Blob)
+			{
+				stage.Blob->Release();
+			}
+
+			delete stage.CachedReflection;
+		}
+	}
+};
+
+static void CompileStage(FShaderVariantCompile& variant, FShaderStageCompile& stage)
+{
+	if (stage.Claimed.exchange(true))
+	{
+		return;
+	}
+
+	D3D_SHADER_MACRO* macros = new D3D_SHADER_MACRO[stage.Defines.size() + 1];
+
+	int i = 0;
+
+	for (Map<String, String>::iterator it = stage.Defines.begin(); it != stage.Defines.end(); it++)
+	{
+		macros[i++] = { it->first.c_str(), it->second.c_str() };
+	}
+
+	macros[i] = { NULL, NULL }; // IMPORTANT ! (If not defined function D3DCompile throws an wierd error)
+
+	ShaderIncludeHandler includeHandler = ShaderIncludeHandler(variant.IncludeCache, variant.Source);
+
+	double compileStart = Time::getTime();
+
+	HRESULT hr = CompileShaderFromString(variant.Code, variant.Name, macros, variant.IncludeCache != nullptr ? &includeHandler : NULL, stage.EntryPoint.c_str(), stage.Profile.c_str(), &stage.Blob);
+
+	stage.CompileTime = Time::getTime() - compileStart;
+
+	delete[] macros;
+
+	if (FAILED(hr))
+	{
+		printf("Failed compiling shader (%s, %s) %08X\n", variant.Path.c_str(), stage.EntryPoint.c_str(), hr);
+
+		variant.Failed = true;
+	}
+
+	if (--variant.RemainingStages == 0)
+	{
+		std::lock_guard<std::mutex> lock(variant.Mutex);
+		variant.StagesDone.notify_all();
+	}
+}
+
+// Stages no worker started yet are not compiled anymore, nothing may wait for the variant afterwards
+static void CancelVariant(FShaderVariantCompile& variant)
+{
+	for (FShaderStageCompile& stage : variant.Stages)
+	{
+		stage.Claimed = true;
+	}
+}
+
+Technique::Technique(EngineContext* context, const File& file, bool precompile) : _Context(context), _Source(file), _Precompile(precompile), _KeywordBits(0), _SourceHash(0), _Revision(0), _RetiredVertexShader(nullptr), _Reloading(false), _HasInputLayoutID(false), _SupportsInstancing(false), _CanCreateInputLayoutID(false), _VertexShaderInternal(nullptr)
 {
 	ReadShaderSource();
 }
 
 Technique::~Technique()
 {
-	ITER(_VaryingShaders, it)
+	ITER(_PendingVariants, it)
 	{
-		for (Shader* shader : it->second)
-		{
-			NVRHI::ShaderHandle sHandle = shader->GetRaw();
+		CancelVariant(*it->second);
+	}
 
-			if (sHandle)
-			{
-				_Context->GetRenderInterface()->destroyShader(sHandle);
-			}
+	ITER(_StageShaders, it)
+	{
+		ITER(it->second, it1)
+		{
+			DestroyShader(it1->second);
+		}
+	}
 
-			delete shader;
+	ITER(_RetiredStageShaders, it)
+	{
+		ITER(it->second, it1)
+		{
+			DestroyShader(it1->second);
 		}
 	}
 
+	for (Shader* shader : _DiscardedShaders)
+	{
+		DestroyShader(shader);
+	}
+
+	_StageShaders.clear();
 	_VaryingShaders.clear();
 }
 
-uint32 Technique::GetDefinesHash(Map<String, String>& defines)
+ShaderVariantKey Technique::GetVariantKey(const Map<String, String>& defines)
 {
-	uint32 hash = 0;
+	ShaderVariantKey key = 0;
 
-	for (Map<String, String>::iterator it = defines.begin(); it != defines.end(); it++)
+	for (Map<String, String>::const_iterator it = defines.begin(); it != defines.end(); it++)
 	{
-		hash |= GetDefineHash(it->first, it->second);
+		key |= GetDefineBit(it->first, it->second);
 	}
 
-	return hash;
+	return key;
 }
 
-uint32 Technique::GetDefineHash(const String& define, const String& value)
+ShaderVariantKey Technique::GetDefineBit(const String& define, const String& value)
 {
+	auto keyword = _DefineBitIndices.find(define);
+
+	if (keyword != _DefineBitIndices.end())
+	{
+		return IsKeywordEnabled(value) ? 1ull << keyword->second : 0;
+	}
+
 	String fullDef = define + "#" + value;
-	if (_DefineHashes.find(fullDef) != _DefineHashes.end())
+
+	auto iter = _DefineBitIndices.find(fullDef);
+
+	if (iter != _DefineBitIndices.end())
+	{
+		return 1ull << iter->second;
+	}
+
+	if (_DefineBits.size() >= TECHNIQUE_MAX_DEFINE_BITS)
+	{
+		LogError("Technique::GetDefineBit", _Source.GetPath(), "No variant key bit left for " + fullDef + ", it is ignored !");
+		return 0;
+	}
+
+	uint32 bit = (uint32)_DefineBits.size();
+
+	_DefineBits.push_back({ define, value, false });
+	_DefineBitIndices[fullDef] = bit;
+
+	return 1ull << bit;
+}
+
+ShaderVariantKey Technique::GetStageKey(const NVRHI::ShaderType::Enum& type, ShaderVariantKey variantKey) const
+{
+	// Define values are kept for every stage, there is no telling which stages read them
+	ShaderVariantKey stageBits = ~_KeywordBits;
+
+	auto stage = _StageKeywordBits.find(type);
+
+	if (stage != _StageKeywordBits.end())
 	{
-		return _DefineHashes[fullDef];
+		stageBits |= stage->second;
+	}
+
+	auto allStages = _StageKeywordBits.find(NVRHI::ShaderType::GRAPHIC_SHADERS_NUM);
+
+	if (allStages != _StageKeywordBits.end())
+	{
+		stageBits |= allStages->second;
+	}
+
+	return variantKey & stageBits;
+}
+
+Map<String, String> Technique::GetStageDefines(ShaderVariantKey stageKey) const
+{
+	Map<String, String> defines;
+
+	for (uint32 bit = 0; bit < _DefineBits.size(); bit++)
+	{
+		if (stageKey & (1ull << bit))
+		{
+			const FTechniqueDefineBit& define = _DefineBits[bit];
+
+			defines[define.Name] = define.IsKeyword ? "1" : define.Value;
+		}
+	}
+
+	return defines;
+}
+
+void Technique::AddKeyword(const String& name, const NVRHI::ShaderType::Enum& type)
+{
+	auto iter = _DefineBitIndices.find(name);
+
+	uint32 bit;
+
+	if (iter != _DefineBitIndices.end())
+	{
+		bit = iter->second;
 	}
 	else
 	{
-		int id = _NextDefineId++;
+		if (_DefineBits.size() >= TECHNIQUE_MAX_DEFINE_BITS)
+		{
+			LogError("Technique::AddKeyword", _Source.GetPath(), "Too many keywords, " + name + " is ignored !");
+			return;
+		}
 
-		_DefineHashes[fullDef] = 1 << id;
+		bit = (uint32)_DefineBits.size();
 
-		return id;
+		_DefineBits.push_back({ name, String_None, true });
+		_DefineBitIndices[name] = bit;
 	}
+
+	_KeywordBits |= 1ull << bit;
+	_StageKeywordBits[type] |= 1ull << bit;
+}
+
+bool Technique::IsKeywordEnabled(const String& value)
+{
+	return !value.empty() && value != "0" && value != "false";
 }
 
 void Technique::UpdateInputLayoutID(Map<String, uint32>& hashMap, uint32& maxIndex)
@@ -121,6 +351,11 @@ void Technique::UpdateInputLayoutID(Map<String, uint32>& hashMap, uint32& maxInd
 					for (ShaderVertexInputDefinition& definition : _ShaderVertexInputDefinitons)
 					{
 						hash += definition.ToHash();
+
+						if (definition.Instanced && definition.Used)
+						{
+							_SupportsInstancing = true;
+						}
 					}
 
 					auto iter = hashMap.find(hash);
@@ -156,6 +391,11 @@ bool Technique::GetInputLayoutID(uint32& out_ID) const
 	return false;
 }
 
+bool Technique::SupportsInstancing() const
+{
+	return _SupportsInstancing;
+}
+
 NVRHI::InputLayoutHandle Technique::CreateInputLayout(InputLayoutDefininition* inputDef, int count)
 {
 	if (_HasInputLayoutID == false)
@@ -198,85 +438,303 @@ NVRHI::InputLayoutHandle Technique::CreateInputLayout(InputLayoutDefininition* i
 
 List<Shader*>& Technique::GetShaders(Map<String, String>& defines, bool recompile)
 {
-	uint32 defineHash = GetDefinesHash(defines);
+	return GetShaders(GetVariantKey(defines), recompile);
+}
+
+List<Shader*>& Technique::GetShaders(ShaderVariantKey variantKey, bool recompile)
+{
+	auto pending = _PendingVariants.find(variantKey);
 
-	if (_VaryingShaders.find(defineHash) != _VaryingShaders.end() && !recompile)
+	if (pending != _PendingVariants.end())
 	{
-		return _VaryingShaders[defineHash];
+		SharedPtr<FShaderVariantCompile> variant = pending->second;
+
+		WaitForVariant(*variant);
+		FinishVariant(*variant);
 	}
-	else
+
+	auto iter = _VaryingShaders.find(variantKey);
+
+	if (iter != _VaryingShaders.end() && !recompile)
 	{
-		Log("Compiling shader", _Source.GetPath());
+		return iter->second;
+	}
+
+	SharedPtr<FShaderVariantCompile> variant = StartVariant(variantKey, recompile);
 
-		if (_VaryingShaders.find(defineHash) != _VaryingShaders.end())
+	WaitForVariant(*variant);
+
+	return FinishVariant(*variant);
+}
+
+List<Shader*>* Technique::RequestShaders(ShaderVariantKey variantKey)
+{
+	auto pending = _PendingVariants.find(variantKey);
+
+	if (pending == _PendingVariants.end())
+	{
+		auto iter = _VaryingShaders.find(variantKey);
+
+		if (iter != _VaryingShaders.end())
 		{
-			for (Shader* shader : _VaryingShaders[defineHash])
-			{
-				delete shader;
-			}
+			return &iter->second;
+		}
 
-			_VaryingShaders[defineHash].clear();
+		SharedPtr<FShaderVariantCompile> variant = StartVariant(variantKey, false);
+
+		// Every stage came from the shader cache or another variant
+		if (variant->RemainingStages == 0)
+		{
+			return &FinishVariant(*variant);
 		}
 
-		ITER(_ShaderTypes, it)
+		return nullptr;
+	}
+
+	if (pending->second->RemainingStages == 0)
+	{
+		SharedPtr<FShaderVariantCompile> variant = pending->second;
+
+		return &FinishVariant(*variant);
+	}
+
+	return nullptr;
+}
+
+void Technique::WarmUp(List<Map<String, String>>& variants)
+{
+	List<SharedPtr<FShaderVariantCompile>> started;
+
+	// Everything is queued first, so the pool works on all variants at once
+	for (Map<String, String>& defines : variants)
+	{
+		ShaderVariantKey variantKey = GetVariantKey(defines);
+
+		auto pending = _PendingVariants.find(variantKey);
+
+		if (pending != _PendingVariants.end())
+		{
+			started.push_back(pending->second);
+		}
+		else if (_VaryingShaders.find(variantKey) == _VaryingShaders.end())
 		{
-			NVRHI::ShaderType::Enum type = it->first;
-			String entryPoint = it->second;
+			started.push_back(StartVariant(variantKey, false));
+		}
+	}
 
-			D3D_SHADER_MACRO* macros = new D3D_SHADER_MACRO[defines.size() + 1];
+	for (SharedPtr<FShaderVariantCompile>& variant : started)
+	{
+		WaitForVariant(*variant);
+		FinishVariant(*variant);
+	}
+}
+
+bool Technique::HasPendingShaders() const
+{
+	return !_PendingVariants.empty();
+}
+
+bool Technique::IsPrecompiled() const
+{
+	return _Precompile;
+}
+
+EngineContext* Technique::GetEngineContext()
+{
+	return _Context;
+}
+
+const File& Technique::GetSource() const
+{
+	return _Source;
+}
 
-			int i = 0;
+bool Technique::DependsOn(const File& file) const
+{
+	return file == _Source || _Dependencies.find(file.GetPath()) != _Dependencies.end();
+}
+
+void Technique::Reload()
+{
+	List<ShaderVariantKey> variantKeys;
 
-			for (Map<String, String>::iterator it = defines.begin(); it != defines.end(); it++)
+	ITER(_VaryingShaders, it)
+	{
+		variantKeys.push_back(it->first);
+	}
+
+	// Compiles of the previous source are dropped and started again from the new one
+	ITER(_PendingVariants, it)
+	{
+		if (_VaryingShaders.find(it->first) == _VaryingShaders.end())
+		{
+			variantKeys.push_back(it->first);
+		}
+
+		CancelVariant(*it->second);
+	}
+
+	_PendingVariants.clear();
+	_ReloadVariants.clear();
+
+	if (_Reloading)
+	{
+		// The source changed again before these were swapped in, the ones requested meanwhile may be in use
+		ITER(_StageShaders, it)
+		{
+			ITER(it->second, it1)
 			{
-				macros[i++] = { it->first.c_str(), it->second.c_str() };
+				_DiscardedShaders.push_back(it1->second);
 			}
+		}
+
+		_StageShaders.clear();
+		_VaryingShaders.clear();
+	}
+	else
+	{
+		_RetiredStageShaders = std::move(_StageShaders);
+		_RetiredVaryingShaders = std::move(_VaryingShaders);
+		_RetiredVertexShader = _VertexShaderInternal;
+
+		// The previous shaders are compiled from this, it goes back with them if the new source does not compile
+		_RetiredSource.StageKeywordBits = _StageKeywordBits;
+		_RetiredSource.KeywordBits = _KeywordBits;
+		_RetiredSource.ShaderTypes = _ShaderTypes;
+		_RetiredSource.ShaderCode = _ShaderCode;
+		_RetiredSource.SourceHash = _SourceHash;
+		_RetiredSource.Dependencies = _Dependencies;
+
+		_StageShaders.clear();
+		_VaryingShaders.clear();
+
+		_Reloading = true;
+	}
+
+	ReadShaderSource();
+
+	for (ShaderVariantKey variantKey : variantKeys)
+	{
+		_ReloadVariants.push_back(StartVariant(variantKey, false));
+	}
+
+	Log("Technique::Reload", _Source.GetPath(), "Recompiling " + ToString((int)variantKeys.size()) + " variants.");
+}
+
+bool Technique::UpdateReload()
+{
+	if (!_Reloading)
+	{
+		return false;
+	}
 
-			macros[i] = { NULL, NULL }; // IMPORTANT ! (If not defined function D3DCompile throws an wierd error)
+	bool failed = false;
 
-			ID3DBlob* shaderBlob = nullptr;
-			HRESULT hr = CompileShaderFromString(_ShaderCode, _Source.GetName(), macros, NULL, entryPoint.c_str(), GetFeatureLevelForShaderType(type).c_str(), &shaderBlob);
+	for (SharedPtr<FShaderVariantCompile>& variant : _ReloadVariants)
+	{
+		if (variant->RemainingStages > 0)
+		{
+			return false;
+		}
 
-			if (FAILED(hr))
+		failed = failed || variant->Failed;
+	}
+
+	if (failed)
+	{
+		for (SharedPtr<FShaderVariantCompile>& variant : _ReloadVariants)
+		{
+			auto pending = _PendingVariants.find(variant->Key);
+
+			if (pending != _PendingVariants.end() && pending->second == variant)
 			{
-				printf("Failed compiling vertex shader (%s) %08X\n", _Source.GetPath().c_str(), hr);
-				continue;
+				_PendingVariants.erase(pending);
 			}
+		}
 
-			NVRHI::ShaderHandle shaderHandle = _Context->GetRenderInterface()->createShader(NVRHI::ShaderDesc(type), shaderBlob->GetBufferPointer(), shaderBlob->GetBufferSize());
-
-			if (shaderHandle != nullptr)
+		ITER(_StageShaders, it)
+		{
+			ITER(it->second, it1)
 			{
-				Shader* shader = new Shader(_Source.GetName(), type, shaderHandle, shaderBlob);
+				_DiscardedShaders.push_back(it1->second);
+			}
+		}
 
-				if (type == NVRHI::ShaderType::SHADER_VERTEX)
-				{
-					_CanCreateInputLayoutID = true;
+		_StageShaders = std::move(_RetiredStageShaders);
+		_VaryingShaders = std::move(_RetiredVaryingShaders);
+		_VertexShaderInternal = _RetiredVertexShader;
 
-					_VertexShaderInternal = shader;
-				}
+		// Variants requested later are compiled from the source the kept shaders match
+		_StageKeywordBits = std::move(_RetiredSource.StageKeywordBits);
+		_KeywordBits = _RetiredSource.KeywordBits;
+		_ShaderTypes = std::move(_RetiredSource.ShaderTypes);
+		_ShaderCode = std::move(_RetiredSource.ShaderCode);
+		_SourceHash = _RetiredSource.SourceHash;
+		_Dependencies = std::move(_RetiredSource.Dependencies);
+
+		LogError("Technique::UpdateReload", _Source.GetPath(), "Reloaded shaders did not compile, keeping the previous ones !");
+	}
+	else
+	{
+		for (SharedPtr<FShaderVariantCompile>& variant : _ReloadVariants)
+		{
+			FinishVariant(*variant);
+		}
 
-				_VaryingShaders[defineHash].emplace_back(shader);
+		ITER(_RetiredStageShaders, it)
+		{
+			ITER(it->second, it1)
+			{
+				_DiscardedShaders.push_back(it1->second);
 			}
-		};
+		}
+
+		FastMap<ShaderVariantKey, Shader*>& vertexShaders = _StageShaders[NVRHI::ShaderType::SHADER_VERTEX];
+		_VertexShaderInternal = vertexShaders.empty() ? nullptr : vertexShaders.begin()->second;
 
-		return _VaryingShaders[defineHash];
+		// The vertex inputs may have changed, they are reflected again from the new vertex shader
+		_HasInputLayoutID = false;
+		_ShaderVertexInputDefinitons.clear();
+		_SupportsInstancing = false;
+
+		Log("Technique::UpdateReload", _Source.GetPath(), "Swapped in " + ToString((int)_ReloadVariants.size()) + " variants.");
 	}
+
+	for (Shader* shader : _DiscardedShaders)
+	{
+		DestroyShader(shader);
+	}
+
+	_ReloadVariants.clear();
+	_RetiredStageShaders.clear();
+	_RetiredVaryingShaders.clear();
+	_RetiredVertexShader = nullptr;
+	_RetiredSource = FTechniqueSource();
+	_DiscardedShaders.clear();
+
+	_Reloading = false;
+	_Revision++;
+
+	return true;
 }
 
-bool Technique::IsPrecompiled() const
+bool Technique::IsReloading() const
 {
-	return _Precompile;
+	return _Reloading;
 }
 
-EngineContext* Technique::GetEngineContext()
+uint32 Technique::GetRevision() const
 {
-	return _Context;
+	return _Revision;
 }
 
 void Technique::ReadShaderSource()
 {
 	_ShaderTypes.clear();
+
+	// Keywords keep their bits when the source is read again, keys the materials hold stay valid
+	_StageKeywordBits.clear();
+	_KeywordBits = 0;
 	_ShaderCode = String_None;
 
 	List<String> shaderLines = _Source.ReadLines();
@@ -312,6 +770,11 @@ void Technique::ReadShaderSource()
 								_ShaderTypes[shaderType] = paramValue;
 							}
 
+							if (paramName == "kw")
+							{
+								AddKeyword(paramValue, NVRHI::ShaderType::GRAPHIC_SHADERS_NUM);
+							}
+
 							if (paramName == "rs")
 							{
 								//_RenderStage = paramValue;
@@ -326,16 +789,19 @@ void Technique::ReadShaderSource()
 							String paramValue0 = paramSplit[1];
 							String paramValue1 = paramSplit[2];
 
-							/*if (paramName == "kw")
+							if (paramName == "kw")
 							{
 								NVRHI::ShaderType::Enum shaderType = GetShaderTypeByName(paramValue0);
-								shaderSource->Keywords[shaderType].push_back(paramValue1);
 
-								std::cout << paramValue0 << " : " << paramValue1 << std::endl;
-
-								shaderSource->KeywordIndexMap[paramValue1] = 1 << nextKeywordId;
-								nextKeywordId++;
-							}*/
+								if (shaderType != NVRHI::ShaderType::GRAPHIC_SHADERS_NUM)
+								{
+									AddKeyword(paramValue1, shaderType);
+								}
+								else
+								{
+									LogError("Technique::ReadShaderSource", _Source.GetPath(), "Unknown stage " + paramValue0 + " for keyword " + paramValue1);
+								}
+							}
 						}
 					}
 					else
@@ -350,6 +816,264 @@ void Technique::ReadShaderSource()
 			_ShaderCode += line + "\r\n";
 		}
 	}
+
+	if (ShaderIncludeCache* includeCache = _Context->GetShaderIncludeCache())
+	{
+		_SourceHash = includeCache->HashSource(_ShaderCode, _Source, _Dependencies);
+	}
+	else
+	{
+		// The compiler reads the includes itself then, only the code can tell the sources apart
+		_SourceHash = HashString(HASH_SEED, _ShaderCode);
+		_Dependencies.clear();
+	}
+}
+
+SharedPtr<FShaderVariantCompile> Technique::StartVariant(ShaderVariantKey variantKey, bool recompile)
+{
+	ShaderCache* shaderCache = _Context->GetShaderCache();
+
+	SharedPtr<FShaderVariantCompile> variant = MakeShared<FShaderVariantCompile>();
+	variant->Key = variantKey;
+	variant->Recompile = recompile;
+	variant->Code = _ShaderCode;
+	variant->Name = _Source.GetName();
+	variant->Path = _Source.GetPath();
+	variant->Source = _Source;
+	variant->IncludeCache = _Context->GetShaderIncludeCache();
+	variant->Stages = List<FShaderStageCompile>(_ShaderTypes.size());
+	variant->RemainingStages = 0;
+	variant->Failed = false;
+	variant->Finished = false;
+
+	int stageIndex = 0;
+
+	ITER(_ShaderTypes, it)
+	{
+		FShaderStageCompile& stage = variant->Stages[stageIndex++];
+		stage.Type = it->first;
+		stage.EntryPoint = it->second;
+		stage.Profile = GetFeatureLevelForShaderType(stage.Type);
+		stage.StageKey = GetStageKey(stage.Type, variantKey);
+		stage.CacheKey = 0;
+		stage.Shared = false;
+		stage.CachedReflection = nullptr;
+		stage.Blob = nullptr;
+		stage.CompileTime = 0.0;
+		stage.Claimed = false;
+
+		if (!recompile)
+		{
+			FastMap<ShaderVariantKey, Shader*>& stageShaders = _StageShaders[stage.Type];
+
+			if (stageShaders.find(stage.StageKey) != stageShaders.end())
+			{
+				stage.Shared = true;
+				stage.Claimed = true;
+				continue;
+			}
+		}
+
+		stage.Defines = GetStageDefines(stage.StageKey);
+		stage.CacheKey = ShaderCache::MakeKey(_SourceHash, stage.Defines, stage.EntryPoint, stage.Profile, GetCompileFlags());
+
+		// A recompile was asked for because something the key does not cover changed, the cached variant is replaced
+		const FShaderCacheEntry* cacheEntry = shaderCache != nullptr && !recompile ? shaderCache->Find(stage.CacheKey) : nullptr;
+
+		if (cacheEntry != nullptr)
+		{
+			stage.CachedReflection = ShaderCache::ReadReflection(*cacheEntry, stage.CachedInputDefinitions);
+
+			if (stage.CachedReflection != nullptr && SUCCEEDED(D3DCreateBlob(cacheEntry->Bytecode.size(), &stage.Blob)))
+			{
+				memcpy(stage.Blob->GetBufferPointer(), cacheEntry->Bytecode.data(), cacheEntry->Bytecode.size());
+
+				stage.Claimed = true;
+				continue;
+			}
+
+			delete stage.CachedReflection;
+			stage.CachedReflection = nullptr;
+		}
+
+		variant->RemainingStages++;
+	}
+
+	if (variant->RemainingStages > 0)
+	{
+		Log("Compiling shader", _Source.GetPath(), ToString((int)variant->RemainingStages) + " stages");
+
+		ThreadPool* threadPool = _Context->GetThreadPool();
+
+		for (FShaderStageCompile& stage : variant->Stages)
+		{
+			if (stage.Claimed)
+			{
+				continue;
+			}
+
+			FShaderStageCompile* stagePtr = &stage;
+
+			threadPool->Enqueue([variant, stagePtr]()
+			{
+				CompileStage(*variant, *stagePtr);
+			});
+		}
+	}
+
+	_PendingVariants[variantKey] = variant;
+
+	return variant;
+}
+
+void Technique::WaitForVariant(FShaderVariantCompile& variant)
+{
+	// Stages no worker picked up yet are compiled here, so waiting never depends on a busy pool
+	for (FShaderStageCompile& stage : variant.Stages)
+	{
+		CompileStage(variant, stage);
+	}
+
+	std::unique_lock<std::mutex> lock(variant.Mutex);
+	variant.StagesDone.wait(lock, [&variant]() { return variant.RemainingStages == 0; });
+}
+
+List<Shader*>& Technique::FinishVariant(FShaderVariantCompile& variant)
+{
+	List<Shader*>& shaders = _VaryingShaders[variant.Key];
+
+	if (variant.Finished)
+	{
+		return shaders;
+	}
+
+	variant.Finished = true;
+
+	// The shaders are owned by _StageShaders, the list only refers to them
+	shaders.clear();
+
+	ShaderCache* shaderCache = _Context->GetShaderCache();
+
+	for (FShaderStageCompile& stage : variant.Stages)
+	{
+		FastMap<ShaderVariantKey, Shader*>& stageShaders = _StageShaders[stage.Type];
+
+		auto existing = stageShaders.find(stage.StageKey);
+
+		Shader* shader = nullptr;
+
+		if (stage.Shared)
+		{
+			if (existing != stageShaders.end())
+			{
+				shader = existing->second;
+			}
+		}
+		else if (stage.Blob != nullptr)
+		{
+			ID3DBlob* shaderBlob = stage.Blob;
+			ShaderVars* cachedReflection = stage.CachedReflection;
+
+			// The shader takes both over
+			stage.Blob = nullptr;
+			stage.CachedReflection = nullptr;
+
+			// Another variant with the same stage key finished first
+			if (existing != stageShaders.end() && !variant.Recompile)
+			{
+				delete cachedReflection;
+				shaderBlob->Release();
+
+				shader = existing->second;
+			}
+			else
+			{
+				NVRHI::ShaderHandle shaderHandle = _Context->GetRenderInterface()->createShader(NVRHI::ShaderDesc(stage.Type), shaderBlob->GetBufferPointer(), shaderBlob->GetBufferSize());
+
+				if (shaderHandle == nullptr)
+				{
+					delete cachedReflection;
+					shaderBlob->Release();
+					continue;
+				}
+
+				if (cachedReflection != nullptr)
+				{
+					shader = new Shader(variant.Name, stage.Type, shaderHandle, shaderBlob, cachedReflection, stage.CachedInputDefinitions);
+				}
+				else
+				{
+					shader = new Shader(variant.Name, stage.Type, shaderHandle, shaderBlob);
+
+					if (shaderCache != nullptr && shader->GetReflection() != nullptr)
+					{
+						shaderCache->Store(stage.CacheKey, shaderBlob->GetBufferPointer(), shaderBlob->GetBufferSize(), *shader->GetReflection(), shader->GetInputLayoutDefinitions(_Context->GetRenderInterface()), stage.CompileTime);
+					}
+				}
+
+				if (existing != stageShaders.end())
+				{
+					ReplaceStageShader(existing->second, shader);
+				}
+
+				stageShaders[stage.StageKey] = shader;
+			}
+		}
+
+		if (shader == nullptr)
+		{
+			continue;
+		}
+
+		if (stage.Type == NVRHI::ShaderType::SHADER_VERTEX)
+		{
+			_CanCreateInputLayoutID = true;
+
+			_VertexShaderInternal = shader;
+		}
+
+		shaders.emplace_back(shader);
+	}
+
+	auto pending = _PendingVariants.find(variant.Key);
+
+	if (pending != _PendingVariants.end() && pending->second.get() == &variant)
+	{
+		_PendingVariants.erase(pending);
+	}
+
+	return shaders;
+}
+
+void Technique::ReplaceStageShader(Shader* oldShader, Shader* newShader)
+{
+	ITER(_VaryingShaders, it)
+	{
+		for (Shader*& shader : it->second)
+		{
+			if (shader == oldShader)
+			{
+				shader = newShader;
+			}
+		}
+	}
+
+	if (_VertexShaderInternal == oldShader)
+	{
+		_VertexShaderInternal = newShader;
+	}
+
+	DestroyShader(oldShader);
+}
+
+void Technique::DestroyShader(Shader* shader)
+{
+	if (shader->GetRaw())
+	{
+		_Context->GetRenderInterface()->destroyShader(shader->GetRaw());
+	}
+
+	delete shader;
 }
 
 NVRHI::ShaderType::Enum Technique::GetShaderTypeByName(const String& name)
@@ -2,6 +2,7 @@
 
 #include "Hydra/Core/Common.h"
 #include "Hydra/Core/File.h"
+#include "Hydra/Core/SmartPointer.h"
 
 #include "Hydra/Render/ShaderVertexInputDefinition.h"
 #include "Hydra/Render/InputLayoutDefinition.h"
@@ -9,6 +10,34 @@
 
 class Shader;
 class EngineContext;
+struct FShaderVariantCompile;
+
+// One bit per keyword and per value of other defines, the shaders of a technique are looked up by it
+typedef uint64 ShaderVariantKey;
+
+// Keywords and define values a technique can tell apart
+#define TECHNIQUE_MAX_DEFINE_BITS 64
+
+struct FTechniqueDefineBit
+{
+	String Name;
+
+	// Empty for keywords, they are defined as 1 when enabled and not at all otherwise
+	String Value;
+
+	bool IsKeyword;
+};
+
+// What ReadShaderSource reads from the source, kept aside while a reload compiles
+struct FTechniqueSource
+{
+	Map<NVRHI::ShaderType::Enum, ShaderVariantKey> StageKeywordBits;
+	ShaderVariantKey KeywordBits;
+	Map<NVRHI::ShaderType::Enum, String> ShaderTypes;
+	String ShaderCode;
+	uint64 SourceHash;
+	Set<String> Dependencies;
+};
 
 class HYDRA_API Technique
 {
@@ -18,39 +47,128 @@ private:
 	File _Source;
 	bool _Precompile;
 
-	Map<String, uint32> _DefineHashes;
-	int _NextDefineId;
+	// Indexed by bit. Keywords declared with #pragma hydra kw come first in the order they are declared, values of other
+	// defines get the following bits when they are first used.
+	List<FTechniqueDefineBit> _DefineBits;
+
+	// Keywords by name, other defines by name#value
+	Map<String, uint32> _DefineBitIndices;
+
+	// Keyword bits each stage declares, the ones declared for every stage are under GRAPHIC_SHADERS_NUM
+	Map<NVRHI::ShaderType::Enum, ShaderVariantKey> _StageKeywordBits;
+	ShaderVariantKey _KeywordBits;
 
 	Map<NVRHI::ShaderType::Enum, String> _ShaderTypes;
 	String _ShaderCode;
 
-	Map<uint32, List<Shader*>> _VaryingShaders;
+	// Hash of the code and its includes, the shader cache key of every variant starts with it
+	uint64 _SourceHash;
+
+	// Files the source includes, directly or through other includes
+	Set<String> _Dependencies;
+
+	// Changes when the source is reloaded and the shaders of every variant are replaced
+	uint32 _Revision;
+
+	FastMap<ShaderVariantKey, List<Shader*>> _VaryingShaders;
+
+	// Owns the shaders, by stage and stage key. Variants that only differ in keywords a stage strips share its shader.
+	Map<NVRHI::ShaderType::Enum, FastMap<ShaderVariantKey, Shader*>> _StageShaders;
+
+	// Variants whose stages are compiled on the thread pool, moved to _VaryingShaders once picked up
+	FastMap<ShaderVariantKey, SharedPtr<FShaderVariantCompile>> _PendingVariants;
+
+	// Variants recompiled from the reloaded source. The shaders materials draw with meanwhile are kept aside and put
+	// back if the new source does not compile.
+	List<SharedPtr<FShaderVariantCompile>> _ReloadVariants;
+	Map<NVRHI::ShaderType::Enum, FastMap<ShaderVariantKey, Shader*>> _RetiredStageShaders;
+	FastMap<ShaderVariantKey, List<Shader*>> _RetiredVaryingShaders;
+	Shader* _RetiredVertexShader;
+	FTechniqueSource _RetiredSource;
+	bool _Reloading;
+
+	// Deleted when UpdateReload swaps, materials may still hold them until the revision changes
+	List<Shader*> _DiscardedShaders;
 
 	List<ShaderVertexInputDefinition> _ShaderVertexInputDefinitons;
 	bool _CanCreateInputLayoutID;
 	bool _HasInputLayoutID;
 	uint8 _InputLayoutID;
+	bool _SupportsInstancing;
 	Shader* _VertexShaderInternal;
 public:
 	Technique(EngineContext* context, const File& file, bool precompile);
 	~Technique();
 
-	uint32 GetDefinesHash(Map<String, String>& defines);
-	uint32 GetDefineHash(const String& define, const String& value);
+	ShaderVariantKey GetVariantKey(const Map<String, String>& defines);
 
+	// Bit the define sets in the variant key, 0 for a disabled keyword. Keywords are enabled by any value but "", "0"
+	// and "false", so a key can be updated for a single define without going over all of them.
+	ShaderVariantKey GetDefineBit(const String& define, const String& value);
+
+	// The part of the variant key a stage is compiled with, keywords the stage does not declare are stripped
+	ShaderVariantKey GetStageKey(const NVRHI::ShaderType::Enum& type, ShaderVariantKey variantKey) const;
+
+	// Compiles the stages of the variant in parallel if needed and returns once they are done
 	List<Shader*>& GetShaders(Map<String, String>& defines, bool recompile);
+	List<Shader*>& GetShaders(ShaderVariantKey variantKey, bool recompile);
+
+	// Returns the variant if it is ready, otherwise starts compiling it on the thread pool and returns null.
+	// Calling it again picks the variant up once its stages are done. Techniques are only used from the render thread.
+	List<Shader*>* RequestShaders(ShaderVariantKey variantKey);
+
+	// Compiles every variant of the list at once and returns when all are done, for loading screens
+	void WarmUp(List<Map<String, String>>& variants);
+
+	bool HasPendingShaders() const;
 
 	void UpdateInputLayoutID(Map<String, uint32>& hashMap, uint32& maxIndex);
 
 	bool GetInputLayoutID(uint32& out_ID) const;
 
+	// True once the input layout is known and the vertex shader reads a per instance input, draws can then be instanced
+	bool SupportsInstancing() const;
+
 	NVRHI::InputLayoutHandle CreateInputLayout(InputLayoutDefininition* inputDef, int count);
 
 	bool IsPrecompiled() const;
 
+	const File& GetSource() const;
+
+	// Whether the file is the source or one of the files it includes
+	bool DependsOn(const File& file) const;
+
+	// Reads the source again and starts recompiling every variant compiled so far on the thread pool. Nothing waits for
+	// the compiles, the old shaders stay in use until UpdateReload swaps the new ones in.
+	void Reload();
+
+	// Called once per frame before drawing. When every reloaded variant is compiled, the new shaders replace the old
+	// ones, which are deleted, and the revision changes. If a stage failed to compile the old shaders are kept instead.
+	// Returns true on the frame either happens.
+	bool UpdateReload();
+
+	bool IsReloading() const;
+
+	// Changes every time reloaded shaders are swapped in, materials request their shaders again when it does
+	uint32 GetRevision() const;
+
 	EngineContext* GetEngineContext();
 
 private:
+	SharedPtr<FShaderVariantCompile> StartVariant(ShaderVariantKey variantKey, bool recompile);
+	void WaitForVariant(FShaderVariantCompile& variant);
+
+	// Creates the shaders of a compiled variant, recompiled stages replace their old shader in every variant
+	List<Shader*>& FinishVariant(FShaderVariantCompile& variant);
+
+	void ReplaceStageShader(Shader* oldShader, Shader* newShader);
+	void DestroyShader(Shader* shader);
+
+	Map<String, String> GetStageDefines(ShaderVariantKey stageKey) const;
+
+	void AddKeyword(const String& name, const NVRHI::ShaderType::Enum& type);
+	static bool IsKeywordEnabled(const String& value);
+
 	void ReadShaderSource();
 	NVRHI::ShaderType::Enum GetShaderTypeByName(const String& name);
 	String GetFeatureLevelForShaderType(const NVRHI::ShaderType::Enum& type);
@@ -61,12 +61,17 @@ void TextureLayoutDef::Add(const String& name, const String shaderDefname, NVRHI
 }
 
 void TextureLayoutDef::ApplyToMaterial(const String& name, MaterialInterface* material, const String& shaderVarName)
+{
+	ApplyToMaterial(name, material, MaterialParam::GetId(shaderVarName));
+}
+
+void TextureLayoutDef::ApplyToMaterial(const String& name, MaterialInterface* material, MaterialParamId shaderVar)
 {
 	if (LayoutDefs.find(name) != LayoutDefs.end())
 	{
 		TextureLayout& layout = LayoutDefs[name];
 
 		material->SetDefine(layout.ShaderDefName, layout.ComponentDef);
-		material->SetTexture(shaderVarName, layout.Texture);
+		material->SetTexture(shaderVar, layout.Texture);
 	}
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "Hydra/Core/Container.h"
 #include "Hydra/Core/SmartPointer.h"
 #include "Hydra/Render/Pipeline/GFSDK_NVRHI.h"
+#include "Hydra/Render/MaterialParam.h"
 
 class MaterialInterface;
 
@@ -32,6 +33,7 @@ public:
 	void Add(const String& name, const String shaderDefname, NVRHI::TextureHandle texture, const String& componentDef);
 
 	void ApplyToMaterial(const String& name, MaterialInterface* material, const String& shaderVarName);
+	void ApplyToMaterial(const String& name, MaterialInterface* material, MaterialParamId shaderVar);
 };
 
 DEFINE_PTR(TextureLayoutDef)
\ No newline at end of file
@@ -1,7 +1,10 @@
 #pragma once
 
+#include "Hydra/Core/Container.h"
 #include "Hydra/Render/Pipeline/GFSDK_NVRHI.h"
 
+class HPrimitiveComponent;
+
 class FSceneView
 {
 public:
@@ -10,4 +13,7 @@ public:
 
 	int Width;
 	int Height;
+
+	// LOD of every component drawn in this view last frame, the next pick starts from it
+	FastMap<HPrimitiveComponent*, int32> LastLODs;
 };
\ No newline at end of file
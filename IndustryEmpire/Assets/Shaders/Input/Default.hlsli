@@ -10,4 +10,22 @@ struct VS_Input
 	float3 tangent : TANGENT;
 	float3 binormal : BINORMAL;
 	float4x4 instanceMatrix : WORLD_PER_INSTANCE;
-};
\ No newline at end of file
+};
+
+static float4x4 Identity = {
+	{ 1, 0, 0, 0 },
+	{ 0, 1, 0, 0 },
+	{ 0, 0, 1, 0 },
+	{ 0, 0, 0, 1 }
+};
+
+// Draws without an instance buffer read an all zero instance matrix, those only use the model matrix
+float4x4 GetInstanceMatrix(float4x4 instanceMatrix)
+{
+	if (all(instanceMatrix[0] == 0) && all(instanceMatrix[1] == 0) && all(instanceMatrix[2] == 0) && all(instanceMatrix[3] == 0))
+	{
+		return Identity;
+	}
+
+	return instanceMatrix;
+}
\ No newline at end of file
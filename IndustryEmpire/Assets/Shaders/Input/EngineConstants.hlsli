@@ -0,0 +1,14 @@
+#pragma pack_matrix( column_major )
+
+// Bound by the renderer, the slots match ENGINE_VIEW_CONSTANTS_SLOT and ENGINE_OBJECT_CONSTANTS_SLOT in Hydra/Render/EngineConstants.h
+
+cbuffer ViewConstants : register(b12)
+{
+	float4x4 _ProjectionMatrix;
+	float4x4 _ViewMatrix;
+};
+
+cbuffer ObjectConstants : register(b13)
+{
+	float4x4 _ModelMatrix;
+};
\ No newline at end of file
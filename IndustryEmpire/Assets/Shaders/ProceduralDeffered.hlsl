@@ -1,6 +1,7 @@
 #pragma hydra vert:MainVS pixel:MainPS
 
 #include "Assets/Shaders/Utils/Texturing.hlsli"
+#include "Assets/Shaders/Input/EngineConstants.hlsli"
 
 #pragma pack_matrix( column_major )
 
@@ -12,17 +13,6 @@ struct PS_Input
 	float3 positionWS : WSPOSITION0;
 };
 
-cbuffer GlobalConstants : register(b0)
-{
-	float4x4 g_ProjectionMatrix;
-	float4x4 g_ViewMatrix;
-}
-
-cbuffer ModelConstants : register(b1)
-{
-	float4x4 g_ModelMatrix;
-}
-
 struct VoxelBuffer
 {
 	float4 Position;
@@ -37,9 +27,9 @@ PS_Input MainVS(uint id : SV_VertexID)
 
 	float4 pos = _Buffer[id].Position;
 
-	OUT.positionWS = mul(g_ModelMatrix, pos).xyz;
+	OUT.positionWS = mul(_ModelMatrix, pos).xyz;
 
-	OUT.position = mul(mul(mul(g_ProjectionMatrix, g_ViewMatrix), g_ModelMatrix), pos);
+	OUT.position = mul(mul(mul(_ProjectionMatrix, _ViewMatrix), _ModelMatrix), pos);
 
 	OUT.normal = normalize(_Buffer[id].Normal);
 
@@ -1,6 +1,6 @@
 #pragma hydra vert:MainVS pixel:MainPS
 
-#pragma pack_matrix( column_major )
+#include "Assets/Shaders/Input/EngineConstants.hlsli"
 
 struct FullScreenQuadOutput
 {
@@ -8,13 +8,6 @@ struct FullScreenQuadOutput
 	float2 uv           : TEXCOORD;
 };
 
-cbuffer Globals
-{
-	float4x4 _ProjectionMatrix;
-	float4x4 _ViewMatrix;
-	float4x4 _ModelMatrix;
-};
-
 FullScreenQuadOutput MainVS(uint id : SV_VertexID)
 {
 	FullScreenQuadOutput OUT;
@@ -1,6 +1,7 @@
 #pragma hydra vert:MainVS pixel:MainPS
 
 #include "Assets/Shaders/Input/Default.hlsli"
+#include "Assets/Shaders/Input/EngineConstants.hlsli"
 
 struct PS_Input
 {
@@ -8,18 +9,14 @@ struct PS_Input
 	float3 positionLS : WSPOSITION1;
 };
 
-cbuffer Globals
-{
-	float4x4 _ProjectionMatrix;
-	float4x4 _ViewMatrix;
-	float4x4 _ModelMatrix;
-};
-
 PS_Input MainVS(in VS_Input input, uint id : SV_VertexID)
 {
 	PS_Input OUT;
 
-	OUT.position = mul(mul(mul(_ProjectionMatrix, _ViewMatrix), _ModelMatrix), float4(input.position.xyz, 1.0));
+	// The renderer draws this instanced, the model matrix of the object is the instance matrix
+	float4x4 modelMatrix = mul(GetInstanceMatrix(input.instanceMatrix), _ModelMatrix);
+
+	OUT.position = mul(mul(mul(_ProjectionMatrix, _ViewMatrix), modelMatrix), float4(input.position.xyz, 1.0));
 
 	OUT.positionLS = input.position.xyz;
 
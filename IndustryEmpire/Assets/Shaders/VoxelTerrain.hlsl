@@ -45,7 +45,7 @@ cbuffer VertexBufferVars
 PS_Input OnMainVS(in VS_Input input, in PS_Input output)
 {
 	//float4 clipPlane = float4(0, 10, 0, -1);
-	//output.clip = dot(mul(g_ModelMatrix, input.position), clipPlane);
+	//output.clip = dot(mul(_ModelMatrix, input.position), clipPlane);
 	uint2 pos_xy = (uint2)input.texCoord2;
 
 	float x = pos_xy.x;
@@ -10,24 +10,15 @@ struct PS_Input
 };
 
 #include "Assets/Shaders/Input/Default.hlsli"
+#include "Assets/Shaders/Input/EngineConstants.hlsli"
 
 cbuffer GlobalConstants : register(b0)
 {
-	float4x4 g_ProjectionMatrix;
-	float4x4 g_ViewMatrix;
-	float4x4 g_ModelMatrix;
 	float3x3 g_NormalMatrix;
 	float2 space0;
 	float3 g_TestColor;
 }
 
-static float4x4 Identity = {
-	{ 1, 0, 0, 0 },
-	{ 0, 1, 0, 0 },
-	{ 0, 0, 1, 0 },
-	{ 0, 0, 0, 1 }
-};
-
 SamplerState DefaultSampler : register(s0);
 Texture2D Map_Albedo : register(t0);
 
@@ -35,20 +26,12 @@ PS_Input MainVS(VS_Input input, unsigned int InstanceID : SV_InstanceID, uint id
 {
 	PS_Input output;
 
-	float4x4 instanceMatrix = input.instanceMatrix;
-	if (instanceMatrix[0][0] == 0 && instanceMatrix[0][1] == 0 && instanceMatrix[0][2] == 0 && instanceMatrix[0][3] == 0 &&
-		instanceMatrix[1][0] == 0 && instanceMatrix[1][1] == 0 && instanceMatrix[1][2] == 0 && instanceMatrix[1][3] == 0 &&
-		instanceMatrix[2][0] == 0 && instanceMatrix[2][1] == 0 && instanceMatrix[2][2] == 0 && instanceMatrix[2][3] == 0 &&
-		instanceMatrix[3][0] == 0 && instanceMatrix[3][1] == 0 && instanceMatrix[3][2] == 0 && instanceMatrix[3][3] == 0)
-	{
-		instanceMatrix = Identity;
-	}
 
-	float4x4 modelMatrix = mul(instanceMatrix, g_ModelMatrix);
+	float4x4 modelMatrix = mul(GetInstanceMatrix(input.instanceMatrix), _ModelMatrix);
 
-	float4 viewPos = mul(mul(g_ViewMatrix, modelMatrix), float4(input.position.xyz, 1.0f));
+	float4 viewPos = mul(mul(_ViewMatrix, modelMatrix), float4(input.position.xyz, 1.0f));
 
-	output.position = mul(g_ProjectionMatrix, viewPos);
+	output.position = mul(_ProjectionMatrix, viewPos);
 	output.positionWS = viewPos;
 	output.texCoord = input.texCoord;
 
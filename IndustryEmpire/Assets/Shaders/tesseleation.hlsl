@@ -1,4 +1,5 @@
 #include "Assets/Shaders/Input/Default.hlsli"
+#include "Assets/Shaders/Input/EngineConstants.hlsli"
 
 #pragma hydra vert:ColorVertexShader hull:ColorHullShader dom:ColorDomainShader pixel:ColorPixelShader
 
@@ -88,13 +89,6 @@ HullOutputType ColorHullShader(InputPatch<HullInputType, 3> patch, uint pointId
 // Domain Shader
 ////////////////////////////////////////////////////////////////////////////////
 
-cbuffer GlobalConstants : register(b0)
-{
-	float4x4 g_ProjectionMatrix;
-	float4x4 g_ViewMatrix;
-	float4x4 g_ModelMatrix;
-}
-
 struct PixelInputType
 {
 	float4 position : SV_POSITION;
@@ -111,14 +105,14 @@ PixelInputType ColorDomainShader(ConstantOutputType input, float3 uvwCoord : SV_
 	// Determine the position of the new vertex.
 	vertexPosition = uvwCoord.x * patch[0].position + uvwCoord.y * patch[1].position + uvwCoord.z * patch[2].position;
 
-	float4 viewPos = mul(mul(g_ViewMatrix, g_ModelMatrix), float4(vertexPosition, 1.0f));
+	float4 viewPos = mul(mul(_ViewMatrix, _ModelMatrix), float4(vertexPosition, 1.0f));
 
-	output.position = mul(g_ProjectionMatrix, viewPos);
+	output.position = mul(_ProjectionMatrix, viewPos);
 
 	// Calculate the position of the new vertex against the world, view, and projection matrices.
-	/*output.position = mul(float4(vertexPosition, 1.0f), g_ModelMatrix);
-	output.position = mul(output.position, g_ViewMatrix);
-	output.position = mul(output.position, g_ProjectionMatrix);**/
+	/*output.position = mul(float4(vertexPosition, 1.0f), _ModelMatrix);
+	output.position = mul(output.position, _ViewMatrix);
+	output.position = mul(output.position, _ProjectionMatrix);**/
 
 	// Send the input color into the pixel shader.
 	output.color = patch[0].color;
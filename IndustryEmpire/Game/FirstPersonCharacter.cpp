@@ -3,6 +3,7 @@
 
 #include "Hydra/Framework/Components/CameraComponent.h"
 #include "Hydra/Framework/Components/StaticMeshComponent.h"
+#include "Hydra/Framework/World.h"
 
 void FirstPersonCharacter::InitializeComponents()
 {
@@ -45,15 +46,52 @@ void FirstPersonCharacter::BeginPlay()
 }
 
 static float moveSpeed = 0.5f;
+static float collisionRadius = 0.25f;
+
+// Kept between the sphere and the surface so the next sweep does not start touching it
+static float collisionSkin = 0.01f;
 
 void FirstPersonCharacter::MoveForwardBackward(float val)
 {
-	AddLocation(GetForwardVector() * val * -moveSpeed);
+	MoveWithCollision(GetForwardVector() * val * -moveSpeed);
 }
 
 void FirstPersonCharacter::MoveLeftRight(float val)
 {
-	AddLocation(GetLeftVector() * val * -moveSpeed);
+	MoveWithCollision(GetLeftVector() * val * -moveSpeed);
+}
+
+void FirstPersonCharacter::MoveWithCollision(const Vector3& delta)
+{
+	Vector3 remaining = delta;
+
+	// A few slides are enough to get out of corners
+	for (int i = 0; i < 3; i++)
+	{
+		float length = glm::length(remaining);
+
+		if (length <= collisionSkin * 0.1f)
+		{
+			return;
+		}
+
+		Vector3 direction = remaining / length;
+
+		FRaycastHit hit;
+
+		if (!World->SweepSphere(GetLocation(), collisionRadius, direction, length, hit))
+		{
+			AddLocation(remaining);
+			return;
+		}
+
+		float travel = glm::max(hit.Distance - collisionSkin, 0.0f);
+		AddLocation(direction * travel);
+
+		// Whatever is left of the move goes along the surface
+		remaining = direction * (length - travel);
+		remaining -= hit.Normal * glm::dot(remaining, hit.Normal);
+	}
 }
 
 void FirstPersonCharacter::LookUpDown(float val)
@@ -70,6 +108,8 @@ void FirstPersonCharacter::LookUpDown(float val)
 	{
 		RotX = 90.0f;
 	}
+
+	RootComponent->MarkTransformDirty();
 }
 
 void FirstPersonCharacter::LookLeftRight(float val)
@@ -82,6 +122,8 @@ void FirstPersonCharacter::LookLeftRight(float val)
 	{
 		RotY = glm::mod(RotY, 360.0f);
 	}
+
+	RootComponent->MarkTransformDirty();
 }
 
 void FirstPersonCharacter::Escape()
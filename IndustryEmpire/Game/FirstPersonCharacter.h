@@ -22,6 +22,9 @@ public:
 	void MoveForwardBackward(float val);
 	void MoveLeftRight(float val);
 
+	// Moves by delta but stops at the level geometry and slides along it
+	void MoveWithCollision(const Vector3& delta);
+
 	void LookUpDown(float val);
 	void LookLeftRight(float val);
 
@@ -8,6 +8,56 @@
 
 #include "GeneratedHeaders/GameClassDatabase.generated.h"
 
+#ifdef INDUSTRY_EMPIRE_BENCHMARKS
+#include "Hydra/Framework/StaticMesh.h"
+#include "Hydra/Framework/StaticMeshResources.h"
+#include "Hydra/Render/Mesh.h"
+#include "Hydra/Physics/Collisons/BIH/BIHBenchmark.h"
+
+static String BenchmarkMeshes[]{
+	"Assets/BasicShapes/Sphere.FBX",
+	"Assets/BasicShapes/Cylinder.FBX",
+	"Assets/BasicShapes/Cone.FBX",
+	"Assets/BasicShapes/Cube.FBX",
+	"Assets/BasicShapes/Plane.FBX"
+};
+
+static void RunColliderBenchmarks(EngineContext* context)
+{
+	for (const String& path : BenchmarkMeshes)
+	{
+		HStaticMesh* staticMesh = context->GetAssetManager()->GetMesh(path);
+
+		if (!staticMesh || !staticMesh->RenderData || staticMesh->RenderData->LODResources.size() == 0)
+		{
+			continue;
+		}
+
+		FStaticMeshLODResources& lod = staticMesh->RenderData->LODResources[0];
+
+		Mesh mesh;
+		mesh.VertexData = lod.VertexData;
+		mesh.Indices = lod.Indices;
+
+		BIHBenchmark::CompareLayouts(path, &mesh, 100000);
+		BIHBenchmark::CompareSplitMethods(path, &mesh, 100000);
+		BIHBenchmark::ComparePackets(path, &mesh, 100000);
+
+		// Every sweep marches over all triangles, so a few hundred are plenty
+		BIHBenchmark::CompareSweeps(path, &mesh, 256);
+	}
+
+	// 500k triangles, big enough for the parallel build and the refit to matter
+	Mesh terrain;
+	BIHBenchmark::CreateTerrain(terrain, 500);
+
+	BIHBenchmark::CompareParallelBuild("Terrain", &terrain, context->GetThreadPool());
+	BIHBenchmark::CompareRefit("Terrain", &terrain, 100000, context->GetThreadPool());
+
+	BIHBenchmark::CompareBoxBatch("Boxes", 4096, 2048);
+}
+#endif
+
 IndustryEmpire::IndustryEmpire()
 {
 	Game_InitializeClassDatabase();
@@ -21,4 +71,8 @@ void IndustryEmpire::SceneInit()
 	//World->SpawnActor<ACubeActor>("Cube2", Vector3(0, 0, 1.5f), Vector3());
 
 	World->OverrideGameMode<HGameModeBase>();
+
+#ifdef INDUSTRY_EMPIRE_BENCHMARKS
+	RunColliderBenchmarks(Context);
+#endif
 }